@@ -25,10 +25,12 @@
   * This function is the only constructor of the buffer source.
   *
   * @param inputBuffer The input buffer to read from
+  * @param length The size of the input buffer in bytes, or -1 if unknown, in
+  *               which case reads are not bounds checked.
   *****************************************************************************/
 
-CalBufferSource::CalBufferSource(void* inputBuffer)
-  : mInputBuffer(inputBuffer), mOffset(0)
+CalBufferSource::CalBufferSource(void* inputBuffer, int length)
+  : mInputBuffer(inputBuffer), mOffset(0), mLength(length)
 {
 }
 
@@ -71,6 +73,23 @@ void CalBufferSource::setError() const
    CalError::setLastError(CalError::NULL_BUFFER, __FILE__, __LINE__);
 }
 
+ /*****************************************************************************/
+/** Checks whether a number of bytes is left in the buffer.
+  *
+  * @param length The number of bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if the bytes can be read
+  *         \li \b false if not
+  *****************************************************************************/
+
+bool CalBufferSource::hasBytes(int length) const
+{
+   if (mLength < 0) return true;
+
+   return (length >= 0) && (mOffset <= (unsigned int)mLength) && ((unsigned int)length <= mLength - mOffset);
+}
+
  /*****************************************************************************/
 /** Reads a number of bytes.
   *
@@ -87,7 +106,7 @@ void CalBufferSource::setError() const
 bool CalBufferSource::readBytes(void* pBuffer, int length)
 {
    //Check that the buffer and the target are usable
-   if (!ok() || (pBuffer == NULL)) return false;
+   if (!ok() || (pBuffer == NULL) || !hasBytes(length)) return false;
    
    bool result = CalPlatform::readBytes( ((char*)mInputBuffer+mOffset), pBuffer, length );
    mOffset += length;
@@ -110,7 +129,7 @@ bool CalBufferSource::readBytes(void* pBuffer, int length)
 bool CalBufferSource::readFloat(float& value)
 {
    //Check that the buffer is usable
-   if (!ok()) return false;
+   if (!ok() || !hasBytes(4)) return false;
 
    bool result = CalPlatform::readFloat( ((char*)mInputBuffer+mOffset), value );
    mOffset += 4;
@@ -133,7 +152,7 @@ bool CalBufferSource::readFloat(float& value)
 bool CalBufferSource::readInteger(int& value)
 {
    //Check that the buffer is usable
-   if (!ok()) return false;
+   if (!ok() || !hasBytes(4)) return false;
 
    bool result = CalPlatform::readInteger( ((char*)mInputBuffer+mOffset), value );
    mOffset += 4;
@@ -164,3 +183,42 @@ bool CalBufferSource::readString(std::string& strValue)
    
    return result;
 }
+
+ /*****************************************************************************/
+/** Sets the error code and message related to a buffer reader.
+  *
+  *****************************************************************************/
+
+void CalBufferReader::setError() const
+{
+   CalError::setLastError(mBuffer == NULL ? CalError::NULL_BUFFER : CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+}
+
+ /*****************************************************************************/
+/** Reads a string.
+  *
+  * This function reads a length-prefixed, zero-terminated string.
+  *
+  * @param value A reference to the string into which the data is read.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalBufferReader::readString(std::string& strValue)
+{
+   int length;
+   if (!readInteger(length) || !hasBytes(length))
+   {
+      mOk = false;
+      return false;
+   }
+
+   // stop at the terminator, which is part of the length
+   const char* pString = mBuffer;
+   mBuffer += length;
+   strValue.assign(pString, strnlen(pString, length));
+
+   return true;
+}
@@ -17,6 +17,7 @@
 
 #include "calglobal.h"
 #include "caldatasource.h"
+#include <climits>
 #if 0
 #include <istream>
 #else
@@ -35,7 +36,7 @@
 class CAL3D_API CalBufferSource : public CalDataSource
 {
 public:
-   CalBufferSource(void* inputBuffer);
+   CalBufferSource(void* inputBuffer, int length = -1);
    virtual ~CalBufferSource();
 
    virtual bool ok() const;
@@ -49,9 +50,128 @@ protected:
 
    void* mInputBuffer;
    unsigned int mOffset;   
+   int mLength;
+
+   bool hasBytes(int length) const;
 
 private:
    CalBufferSource(); //Can't use this
 };
 
+/**
+ * CalBufferReader class.
+ *
+ * This is a non-virtual counterpart of CalBufferSource with the same read
+ * functions, all of them inline. The loader is instantiated for it, so reads
+ * from memory compile down to a bounds check and a copy. Blocks of fields are
+ * read with readBytes()/readWords() and checked only once. Once a read fails,
+ * all following reads fail as well.
+ */
+
+class CAL3D_API CalBufferReader
+{
+public:
+   CalBufferReader(const void* inputBuffer, int length)
+     : mBuffer((const char*)inputBuffer), mEnd((const char*)inputBuffer + length), mOk(inputBuffer != NULL && length >= 0)
+   {
+   }
+
+   bool ok() const { return mOk; }
+   void setError() const;
+
+   bool hasBytes(int length) const
+   {
+      return mOk && (length >= 0) && (length <= mEnd - mBuffer);
+   }
+
+   bool hasRecords(int count, int size) const
+   {
+      return mOk && (count >= 0) && (size > 0) && (count <= (mEnd - mBuffer) / size);
+   }
+
+   bool readBytes(void* pBuffer, int length)
+   {
+      if(!hasBytes(length)) { mOk = false; return false; }
+      memcpy(pBuffer, mBuffer, length);
+      mBuffer += length;
+      return true;
+   }
+
+   bool readWords(void* pBuffer, int count)
+   {
+      if((count < 0) || (count > INT_MAX / 4) || !readBytes(pBuffer, count * 4)) { mOk = false; return false; }
+#ifdef CAL3D_BIG_ENDIAN
+      CalPlatform::swapWords(pBuffer, count);
+#endif
+      return true;
+   }
+
+   bool readFloat(float& value) { return readWords(&value, 1); }
+   bool readInteger(int& value) { return readWords(&value, 1); }
+   bool readString(std::string& strValue);
+
+   const char* getPosition() const { return mBuffer; }
+
+   bool skipBytes(int length)
+   {
+      if(!hasBytes(length)) { mOk = false; return false; }
+      mBuffer += length;
+      return true;
+   }
+
+protected:
+   const char* mBuffer;
+   const char* mEnd;
+   bool mOk;
+};
+
+/**
+ * CalBufferWriter class.
+ *
+ * This is the write counterpart of CalBufferReader. It appends the fields to
+ * a memory buffer, so the saver can assemble a whole section in memory and
+ * hand it to the file in one write. All write functions are inline and
+ * cannot fail.
+ */
+
+class CAL3D_API CalBufferWriter
+{
+public:
+   CalBufferWriter(std::vector<char>& outputBuffer)
+     : mBuffer(outputBuffer)
+   {
+   }
+
+   int getSize() const { return mBuffer.size(); }
+
+   void writeBytes(const void* pBuffer, int length)
+   {
+      const char* pData = (const char*)pBuffer;
+      mBuffer.insert(mBuffer.end(), pData, pData + length);
+   }
+
+   void writeWords(const void* pBuffer, int count)
+   {
+#ifdef CAL3D_BIG_ENDIAN
+      int offset = mBuffer.size();
+      writeBytes(pBuffer, count * 4);
+      CalPlatform::swapWords(&mBuffer[offset], count);
+#else
+      writeBytes(pBuffer, count * 4);
+#endif
+   }
+
+   void writeFloat(float value) { writeWords(&value, 1); }
+   void writeInteger(int value) { writeWords(&value, 1); }
+
+   void writeString(const std::string& strValue)
+   {
+      writeInteger(strValue.size() + 1);
+      writeBytes(strValue.c_str(), strValue.size() + 1);
+   }
+
+protected:
+   std::vector<char>& mBuffer;
+};
+
 #endif
@@ -15,20 +15,34 @@
 // Includes                                                                   //
 //****************************************************************************//
 
+#include "calarena.h"
+#include "calasync.h"
+#include "calbake.h"
 #include "calbone.h"
+#include "calcache.h"
+#include "calcloth.h"
 #include "calcoreanim.h"
 #include "calcorebone.h"
+#include "calcorecloth.h"
 #include "calcorekey.h"
 #include "calcoremodel.h"
 #include "calcoresub.h"
 #include "calcoretrack.h"
 #include "calerror.h"
+#include "calincloader.h"
 #include "calloader.h"
+#include "callod.h"
+#include "calmapfile.h"
 #include "calmatrix.h"
 #include "calmodel.h"
+#include "calnametable.h"
+#include "calpack.h"
+#include "calpackwriter.h"
+#include "calpose.h"
 #include "calquat.h"
 #include "calsaver.h"
 #include "calsub.h"
+#include "calvcache.h"
 #include "calvector.h"
 
 #endif
@@ -0,0 +1,221 @@
+//****************************************************************************//
+// arena.cpp                                                                  //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calarena.h"
+#include "calerror.h"
+
+// alignment of every allocation, enough for any scalar and for SSE vectors
+static const size_t ARENA_ALIGNMENT = 16;
+
+// the block size doubles with every new block up to this limit
+static const size_t ARENA_MAX_BLOCK_SIZE = 1024 * 1024;
+
+static inline size_t alignSize(size_t size)
+{
+  return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+ /*****************************************************************************/
+/** Constructs the arena instance.
+  *
+  * This function is the default constructor of the arena instance.
+  *****************************************************************************/
+
+CalArena::CalArena()
+{
+  m_pBlock = 0;
+  m_pCurrent = 0;
+  m_pEnd = 0;
+  m_blockSize = 16384;
+  m_allocatedSize = 0;
+  m_usedSize = 0;
+}
+
+ /*****************************************************************************/
+/** Destructs the arena instance.
+  *
+  * This function is the destructor of the arena instance.
+  *****************************************************************************/
+
+CalArena::~CalArena()
+{
+  destroy();
+}
+
+ /*****************************************************************************/
+/** Adds a block to the arena.
+  *
+  * This function allocates a new block and makes it the current one.
+  *
+  * @param size The usable size of the block in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalArena::addBlock(size_t size)
+{
+  size_t headerSize;
+  headerSize = alignSize(sizeof(Block));
+
+  Block *pBlock;
+  pBlock = (Block *)malloc(headerSize + size);
+  if(pBlock == 0)
+  {
+    CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__, "CalArena::addBlock");
+    return false;
+  }
+
+  pBlock->pNext = m_pBlock;
+  pBlock->size = size;
+  m_pBlock = pBlock;
+
+  m_pCurrent = (char *)pBlock + headerSize;
+  m_pEnd = m_pCurrent + size;
+  m_allocatedSize += size;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Allocates memory.
+  *
+  * This function returns a chunk of memory from the current block, and starts
+  * a new block if the current one is too small. The memory is aligned to 16
+  * bytes and stays valid until the arena is destroyed.
+  *
+  * @param size The size of the memory chunk in bytes.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the memory chunk
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+void *CalArena::allocate(size_t size)
+{
+  size = alignSize(size);
+
+  if((size_t)(m_pEnd - m_pCurrent) < size)
+  {
+    size_t blockSize;
+    blockSize = (size > m_blockSize) ? size : m_blockSize;
+    if(!addBlock(blockSize)) return 0;
+
+    // grow the following blocks to keep the block count low
+    if(m_blockSize < ARENA_MAX_BLOCK_SIZE) m_blockSize *= 2;
+  }
+
+  void *pMemory;
+  pMemory = m_pCurrent;
+  m_pCurrent += size;
+  m_usedSize += size;
+
+  return pMemory;
+}
+
+ /*****************************************************************************/
+/** Creates the arena instance.
+  *
+  * This function creates the arena instance. No memory is allocated until the
+  * first allocation.
+  *
+  * @param blockSize The size of the first block in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalArena::create(size_t blockSize)
+{
+  m_blockSize = alignSize(blockSize);
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the arena instance.
+  *
+  * This function frees all blocks of the arena instance at once. All memory
+  * handed out by the arena becomes invalid.
+  *****************************************************************************/
+
+void CalArena::destroy()
+{
+  while(m_pBlock != 0)
+  {
+    Block *pNext;
+    pNext = m_pBlock->pNext;
+    free(m_pBlock);
+    m_pBlock = pNext;
+  }
+
+  m_pCurrent = 0;
+  m_pEnd = 0;
+  m_allocatedSize = 0;
+  m_usedSize = 0;
+}
+
+ /*****************************************************************************/
+/** Returns the allocated size.
+  *
+  * This function returns the total size of all blocks of the arena instance.
+  *
+  * @return The allocated size in bytes.
+  *****************************************************************************/
+
+size_t CalArena::getAllocatedSize()
+{
+  return m_allocatedSize;
+}
+
+ /*****************************************************************************/
+/** Returns the used size.
+  *
+  * This function returns the size of all memory handed out by the arena
+  * instance.
+  *
+  * @return The used size in bytes.
+  *****************************************************************************/
+
+size_t CalArena::getUsedSize()
+{
+  return m_usedSize;
+}
+
+ /*****************************************************************************/
+/** Reserves memory.
+  *
+  * This function makes sure that the following allocations with a total size
+  * of up to the given size are served from a single block.
+  *
+  * @param size The size in bytes.
+  *****************************************************************************/
+
+void CalArena::reserve(size_t size)
+{
+  size = alignSize(size);
+
+  if((size_t)(m_pEnd - m_pCurrent) < size)
+  {
+    addBlock(size);
+  }
+}
+
+//****************************************************************************//
@@ -0,0 +1,72 @@
+//****************************************************************************//
+// arena.h                                                                    //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_ARENA_H
+#define CAL_ARENA_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The arena class.
+  *
+  * An arena hands out memory from a few large blocks. Single allocations are
+  * never freed; all blocks are released at once when the arena is destroyed.
+  *****************************************************************************/
+
+class CAL3D_API CalArena
+{
+// member variables
+protected:
+  struct Block
+  {
+    Block *pNext;
+    size_t size;
+  };
+
+  Block *m_pBlock;
+  char *m_pCurrent;
+  char *m_pEnd;
+  size_t m_blockSize;
+  size_t m_allocatedSize;
+  size_t m_usedSize;
+
+// constructors/destructor
+public:
+  CalArena();
+  virtual ~CalArena();
+
+// member functions
+public:
+  void *allocate(size_t size);
+  bool create(size_t blockSize = 16384);
+  void destroy();
+  size_t getAllocatedSize();
+  size_t getUsedSize();
+  void reserve(size_t size);
+
+protected:
+  bool addBlock(size_t size);
+
+private:
+  CalArena(const CalArena&) = delete; // the blocks can't be shared
+  CalArena& operator=(const CalArena&) = delete;
+};
+
+#endif
+
+//****************************************************************************//
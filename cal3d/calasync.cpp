@@ -0,0 +1,606 @@
+//****************************************************************************//
+// async.cpp                                                                  //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calasync.h"
+#include "calloader.h"
+#include "calcoremodel.h"
+#include "calcoreanim.h"
+
+ /*****************************************************************************/
+/** Constructs the asynchronous loader instance.
+  *
+  * This function is the default constructor of the asynchronous loader
+  * instance.
+  *****************************************************************************/
+
+CalAsyncLoader::CalAsyncLoader()
+{
+  m_nextRequestId = 0;
+  m_bShutdown = false;
+}
+
+ /*****************************************************************************/
+/** Destructs the asynchronous loader instance.
+  *
+  * This function is the destructor of the asynchronous loader instance.
+  *****************************************************************************/
+
+CalAsyncLoader::~CalAsyncLoader()
+{
+  assert(m_vectorThread.empty());
+}
+
+ /*****************************************************************************/
+/** Queues a load request.
+  *
+  * This function assigns a request ID and inserts a request into the queue,
+  * behind all requests of the same or a higher priority, and wakes up a
+  * worker.
+  *
+  * @param request The request to queue.
+  *
+  * @return One of the following values:
+  *         \li the ID of the request
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalAsyncLoader::addRequest(Request& request)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if(m_vectorThread.empty())
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalAsyncLoader::addRequest");
+    return -1;
+  }
+
+  request.id = m_nextRequestId++;
+  request.bCancelled = false;
+
+  std::list<Request>::iterator iteratorRequest;
+  for(iteratorRequest = m_listRequest.begin(); iteratorRequest != m_listRequest.end(); ++iteratorRequest)
+  {
+    if(iteratorRequest->priority < request.priority) break;
+  }
+  m_listRequest.insert(iteratorRequest, request);
+
+  m_conditionRequest.notify_one();
+
+  return request.id;
+}
+
+ /*****************************************************************************/
+/** Cancels a load request.
+  *
+  * This function cancels a request that was not collected yet. A queued
+  * request is removed from the queue. A request that is being loaded cannot
+  * be interrupted, but its result is destroyed when the worker finishes it.
+  * A completed request is removed from the completion queue and its core
+  * object is destroyed.
+  *
+  * @param requestId The ID of the request.
+  *
+  * @return One of the following values:
+  *         \li \b true if the request was cancelled
+  *         \li \b false if there is no such request
+  *****************************************************************************/
+
+bool CalAsyncLoader::cancel(int requestId)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  std::list<Request>::iterator iteratorRequest;
+  for(iteratorRequest = m_listRequest.begin(); iteratorRequest != m_listRequest.end(); ++iteratorRequest)
+  {
+    if(iteratorRequest->id == requestId)
+    {
+      m_listRequest.erase(iteratorRequest);
+      m_conditionResult.notify_all();
+      return true;
+    }
+  }
+
+  for(iteratorRequest = m_listLoading.begin(); iteratorRequest != m_listLoading.end(); ++iteratorRequest)
+  {
+    if(iteratorRequest->id == requestId)
+    {
+      iteratorRequest->bCancelled = true;
+      return true;
+    }
+  }
+
+  std::list<Result>::iterator iteratorResult;
+  for(iteratorResult = m_listResult.begin(); iteratorResult != m_listResult.end(); ++iteratorResult)
+  {
+    if(iteratorResult->requestId == requestId)
+    {
+      destroyResult(*iteratorResult);
+      m_listResult.erase(iteratorResult);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+ /*****************************************************************************/
+/** Creates the asynchronous loader instance.
+  *
+  * This function starts the worker threads of the asynchronous loader
+  * instance.
+  *
+  * @param threadCount The number of worker threads, or 0 to use one less than
+  *                    the number of hardware threads (but at least one).
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalAsyncLoader::create(int threadCount)
+{
+  if(!m_vectorThread.empty())
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalAsyncLoader::create");
+    return false;
+  }
+
+  if(threadCount <= 0)
+  {
+    threadCount = (int)std::thread::hardware_concurrency() - 1;
+    if(threadCount < 1) threadCount = 1;
+  }
+
+  m_bShutdown = false;
+
+  m_vectorThread.reserve(threadCount);
+
+  int threadId;
+  for(threadId = 0; threadId < threadCount; threadId++)
+  {
+    m_vectorThread.push_back(std::thread(&CalAsyncLoader::run, this));
+  }
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the asynchronous loader instance.
+  *
+  * This function drops all queued requests, waits for the workers to finish
+  * the requests they are loading and stops them. The core objects of all
+  * requests that were not collected are destroyed.
+  *****************************************************************************/
+
+void CalAsyncLoader::destroy()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_bShutdown = true;
+    m_listRequest.clear();
+  }
+  m_conditionRequest.notify_all();
+
+  std::vector<std::thread>::iterator iteratorThread;
+  for(iteratorThread = m_vectorThread.begin(); iteratorThread != m_vectorThread.end(); ++iteratorThread)
+  {
+    iteratorThread->join();
+  }
+  m_vectorThread.clear();
+
+  std::list<Result>::iterator iteratorResult;
+  for(iteratorResult = m_listResult.begin(); iteratorResult != m_listResult.end(); ++iteratorResult)
+  {
+    destroyResult(*iteratorResult);
+  }
+  m_listResult.clear();
+}
+
+ /*****************************************************************************/
+/** Destroys the core object of a result.
+  *
+  * This function destroys and frees the core object of a result.
+  *
+  * @param result The result.
+  *****************************************************************************/
+
+void CalAsyncLoader::destroyResult(Result& result)
+{
+  if(result.pCoreModel != 0)
+  {
+    result.pCoreModel->destroy();
+    CalCoreModel::Free(result.pCoreModel);
+    result.pCoreModel = 0;
+  }
+
+  if(result.pCoreAnimation != 0)
+  {
+    result.pCoreAnimation->destroy();
+    CalCoreAnimation::Free(result.pCoreAnimation);
+    result.pCoreAnimation = 0;
+  }
+}
+
+ /*****************************************************************************/
+/** Returns the number of pending requests.
+  *
+  * This function returns the number of requests that are queued, being
+  * loaded or waiting to be collected.
+  *
+  * @return The number of pending requests.
+  *****************************************************************************/
+
+int CalAsyncLoader::getPendingCount()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  return m_listRequest.size() + m_listLoading.size() + m_listResult.size();
+}
+
+ /*****************************************************************************/
+/** Loads a request.
+  *
+  * This function runs on a worker thread and loads the core object of a
+  * request with a CalLoader. If the load fails, the error of the worker
+  * thread is stored in the result.
+  *
+  * @param request The request to load.
+  * @param result The result that will be filled.
+  *****************************************************************************/
+
+void CalAsyncLoader::load(const Request& request, Result& result)
+{
+  result.requestId = request.id;
+  result.type = request.type;
+  result.bLoaded = false;
+  result.pCoreModel = 0;
+  result.pCoreAnimation = 0;
+  result.pUserData = request.pUserData;
+  result.errorCode = CalError::OK;
+
+  CalLoader loader;
+
+  if(request.type == TYPE_CORE_ANIMATION)
+  {
+    CalCoreAnimation *pCoreAnimation;
+    pCoreAnimation = CalCoreAnimation::Alloc();
+
+    if(pCoreAnimation->create(request.strFilename.c_str()))
+    {
+      if(request.pBuffer != 0)
+      {
+        result.bLoaded = loader.loadCoreAnimation(pCoreAnimation, (void *)request.pBuffer, request.len, request.strFilename);
+      }
+      else
+      {
+        result.bLoaded = loader.loadCoreAnimation(pCoreAnimation, request.strFilename);
+      }
+    }
+
+    if(result.bLoaded) result.pCoreAnimation = pCoreAnimation;
+    else
+    {
+      pCoreAnimation->destroy();
+      CalCoreAnimation::Free(pCoreAnimation);
+    }
+  }
+  else
+  {
+    CalCoreModel *pCoreModel;
+    pCoreModel = CalCoreModel::Alloc();
+
+    if(pCoreModel->create(request.strFilename.c_str()))
+    {
+      if(request.type == TYPE_BINARY_CORE_MODEL)
+      {
+        result.bLoaded = loader.loadBinaryCoreModel(pCoreModel, request.strFilename);
+      }
+      else if(request.pBuffer != 0)
+      {
+        result.bLoaded = loader.loadCoreModel(pCoreModel, (void *)request.pBuffer, request.len, request.strFilename);
+      }
+      else if(!request.strFilename2.empty())
+      {
+        result.bLoaded = loader.loadCoreModel(pCoreModel, request.strFilename, request.strFilename2);
+      }
+      else
+      {
+        result.bLoaded = loader.loadCoreModel(pCoreModel, request.strFilename);
+      }
+    }
+
+    if(result.bLoaded) result.pCoreModel = pCoreModel;
+    else
+    {
+      pCoreModel->destroy();
+      CalCoreModel::Free(pCoreModel);
+    }
+  }
+
+  if(!result.bLoaded)
+  {
+    result.errorCode = CalError::getLastErrorCode();
+    result.strErrorText = CalError::getLastErrorText();
+  }
+}
+
+ /*****************************************************************************/
+/** Requests a binary core model.
+  *
+  * This function queues the load of a binary core model file. See
+  * CalLoader::loadBinaryCoreModel().
+  *
+  * @param strFilename The name of the file.
+  * @param priority The priority of the request.
+  * @param pUserData A pointer that is passed through to the result.
+  *
+  * @return One of the following values:
+  *         \li the ID of the request
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalAsyncLoader::loadBinaryCoreModel(const std::string& strFilename, int priority, void *pUserData)
+{
+  Request request;
+  request.type = TYPE_BINARY_CORE_MODEL;
+  request.priority = priority;
+  request.strFilename = strFilename;
+  request.pBuffer = 0;
+  request.len = 0;
+  request.pUserData = pUserData;
+
+  return addRequest(request);
+}
+
+ /*****************************************************************************/
+/** Requests a core animation.
+  *
+  * This function queues the load of a core animation file.
+  *
+  * @param strFilename The name of the file.
+  * @param priority The priority of the request.
+  * @param pUserData A pointer that is passed through to the result.
+  *
+  * @return One of the following values:
+  *         \li the ID of the request
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalAsyncLoader::loadCoreAnimation(const std::string& strFilename, int priority, void *pUserData)
+{
+  Request request;
+  request.type = TYPE_CORE_ANIMATION;
+  request.priority = priority;
+  request.strFilename = strFilename;
+  request.pBuffer = 0;
+  request.len = 0;
+  request.pUserData = pUserData;
+
+  return addRequest(request);
+}
+
+ /*****************************************************************************/
+/** Requests a core animation.
+  *
+  * This function queues the load of a core animation from a memory buffer.
+  * The buffer is not copied and must stay valid until the request is
+  * collected or cancelled.
+  *
+  * @param pBuffer A pointer to the buffer.
+  * @param len The size of the buffer in bytes.
+  * @param strName The name of the core animation.
+  * @param priority The priority of the request.
+  * @param pUserData A pointer that is passed through to the result.
+  *
+  * @return One of the following values:
+  *         \li the ID of the request
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalAsyncLoader::loadCoreAnimation(const void *pBuffer, int len, const std::string& strName, int priority, void *pUserData)
+{
+  Request request;
+  request.type = TYPE_CORE_ANIMATION;
+  request.priority = priority;
+  request.strFilename = strName;
+  request.pBuffer = pBuffer;
+  request.len = len;
+  request.pUserData = pUserData;
+
+  return addRequest(request);
+}
+
+ /*****************************************************************************/
+/** Requests a core model.
+  *
+  * This function queues the load of a core model file.
+  *
+  * @param strFilename The name of the file.
+  * @param priority The priority of the request.
+  * @param pUserData A pointer that is passed through to the result.
+  *
+  * @return One of the following values:
+  *         \li the ID of the request
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalAsyncLoader::loadCoreModel(const std::string& strFilename, int priority, void *pUserData)
+{
+  Request request;
+  request.type = TYPE_CORE_MODEL;
+  request.priority = priority;
+  request.strFilename = strFilename;
+  request.pBuffer = 0;
+  request.len = 0;
+  request.pUserData = pUserData;
+
+  return addRequest(request);
+}
+
+ /*****************************************************************************/
+/** Requests a core model.
+  *
+  * This function queues the load of a core model that is split into two
+  * files.
+  *
+  * @param strFilename1 The name of the first file.
+  * @param strFilename2 The name of the second file.
+  * @param priority The priority of the request.
+  * @param pUserData A pointer that is passed through to the result.
+  *
+  * @return One of the following values:
+  *         \li the ID of the request
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalAsyncLoader::loadCoreModel(const std::string& strFilename1, const std::string& strFilename2, int priority, void *pUserData)
+{
+  Request request;
+  request.type = TYPE_CORE_MODEL;
+  request.priority = priority;
+  request.strFilename = strFilename1;
+  request.strFilename2 = strFilename2;
+  request.pBuffer = 0;
+  request.len = 0;
+  request.pUserData = pUserData;
+
+  return addRequest(request);
+}
+
+ /*****************************************************************************/
+/** Requests a core model.
+  *
+  * This function queues the load of a core model from a memory buffer. The
+  * buffer is not copied and must stay valid until the request is collected or
+  * cancelled.
+  *
+  * @param pBuffer A pointer to the buffer.
+  * @param len The size of the buffer in bytes.
+  * @param strName The name of the core model.
+  * @param priority The priority of the request.
+  * @param pUserData A pointer that is passed through to the result.
+  *
+  * @return One of the following values:
+  *         \li the ID of the request
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalAsyncLoader::loadCoreModel(const void *pBuffer, int len, const std::string& strName, int priority, void *pUserData)
+{
+  Request request;
+  request.type = TYPE_CORE_MODEL;
+  request.priority = priority;
+  request.strFilename = strName;
+  request.pBuffer = pBuffer;
+  request.len = len;
+  request.pUserData = pUserData;
+
+  return addRequest(request);
+}
+
+ /*****************************************************************************/
+/** Collects a completed request.
+  *
+  * This function takes the next completed request from the completion queue,
+  * without blocking. It is meant to be called on the main thread, for example
+  * once per frame. The core object of a successful request now belongs to
+  * the caller.
+  *
+  * @param result A reference to the result that will be filled.
+  *
+  * @return One of the following values:
+  *         \li \b true if a request was collected
+  *         \li \b false if no request is completed
+  *****************************************************************************/
+
+bool CalAsyncLoader::poll(Result& result)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if(m_listResult.empty()) return false;
+
+  result = m_listResult.front();
+  m_listResult.pop_front();
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Runs a worker thread.
+  *
+  * This function is the body of a worker thread. It takes the request with the
+  * highest priority from the queue, loads it without holding the lock and
+  * puts the result into the completion queue, until the loader is destroyed.
+  * Every worker decodes its models on its own, without the thread pool of
+  * CalLoader.
+  *****************************************************************************/
+
+void CalAsyncLoader::run()
+{
+  CalLoader::setWorkerThread(true);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while(true)
+  {
+    while(!m_bShutdown && m_listRequest.empty())
+    {
+      m_conditionRequest.wait(lock);
+    }
+
+    if(m_bShutdown) break;
+
+    // move the request to the loading list, where it can still be cancelled
+    std::list<Request>::iterator iteratorRequest;
+    iteratorRequest = m_listRequest.begin();
+    m_listLoading.splice(m_listLoading.end(), m_listRequest, iteratorRequest);
+
+    lock.unlock();
+
+    Result result;
+    load(*iteratorRequest, result);
+
+    lock.lock();
+
+    if(iteratorRequest->bCancelled) destroyResult(result);
+    else m_listResult.push_back(result);
+
+    m_listLoading.erase(iteratorRequest);
+
+    m_conditionResult.notify_all();
+  }
+}
+
+ /*****************************************************************************/
+/** Waits for all requests.
+  *
+  * This function blocks until all queued requests are loaded. The results
+  * still have to be collected with poll().
+  *****************************************************************************/
+
+void CalAsyncLoader::wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while(!m_listRequest.empty() || !m_listLoading.empty())
+  {
+    m_conditionResult.wait(lock);
+  }
+}
+
+//****************************************************************************//
@@ -0,0 +1,129 @@
+//****************************************************************************//
+// async.h                                                                    //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_ASYNC_H
+#define CAL_ASYNC_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+#include "calerror.h"
+
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalCoreModel;
+class CalCoreAnimation;
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The asynchronous loader class.
+  *
+  * An asynchronous loader decodes core models and core animations on a pool
+  * of worker threads. Load requests are queued with a priority and return a
+  * request ID at once; the loaded core objects are collected on the calling
+  * thread with poll(), for example once per frame. Requests with a higher
+  * priority are started first, requests of the same priority in the order
+  * they were made.
+  *****************************************************************************/
+
+class CAL3D_API CalAsyncLoader
+{
+// misc
+public:
+  /// The type of a load request.
+  enum Type
+  {
+    TYPE_CORE_MODEL = 0,
+    TYPE_CORE_ANIMATION,
+    TYPE_BINARY_CORE_MODEL
+  };
+
+  /// A completed load request. The core object belongs to the caller, who
+  /// destroys and frees it.
+  struct Result
+  {
+    int requestId;
+    Type type;
+    bool bLoaded;
+    CalCoreModel *pCoreModel;
+    CalCoreAnimation *pCoreAnimation;
+    void *pUserData;
+    CalError::Code errorCode;
+    std::string strErrorText;
+  };
+
+protected:
+  struct Request
+  {
+    int id;
+    Type type;
+    int priority;
+    std::string strFilename;
+    std::string strFilename2;
+    const void *pBuffer;
+    int len;
+    void *pUserData;
+    bool bCancelled;
+  };
+
+// member variables
+protected:
+  std::vector<std::thread> m_vectorThread;
+  std::mutex m_mutex;
+  std::condition_variable m_conditionRequest;
+  std::condition_variable m_conditionResult;
+  std::list<Request> m_listRequest;
+  std::list<Request> m_listLoading;
+  std::list<Result> m_listResult;
+  int m_nextRequestId;
+  bool m_bShutdown;
+
+// constructors/destructor
+public:
+  CalAsyncLoader();
+  virtual ~CalAsyncLoader();
+
+// member functions
+public:
+  bool cancel(int requestId);
+  bool create(int threadCount = 0);
+  void destroy();
+  int getPendingCount();
+  int loadBinaryCoreModel(const std::string& strFilename, int priority = 0, void *pUserData = 0);
+  int loadCoreAnimation(const std::string& strFilename, int priority = 0, void *pUserData = 0);
+  int loadCoreAnimation(const void *pBuffer, int len, const std::string& strName, int priority = 0, void *pUserData = 0);
+  int loadCoreModel(const std::string& strFilename, int priority = 0, void *pUserData = 0);
+  int loadCoreModel(const std::string& strFilename1, const std::string& strFilename2, int priority = 0, void *pUserData = 0);
+  int loadCoreModel(const void *pBuffer, int len, const std::string& strName, int priority = 0, void *pUserData = 0);
+  bool poll(Result& result);
+  void wait();
+
+protected:
+  int addRequest(Request& request);
+  static void destroyResult(Result& result);
+  static void load(const Request& request, Result& result);
+  void run();
+};
+
+#endif
+
+//****************************************************************************//
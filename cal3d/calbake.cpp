@@ -0,0 +1,378 @@
+//****************************************************************************//
+// bake.cpp                                                                   //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calbake.h"
+#include "calerror.h"
+#include "calcoremodel.h"
+#include "calcoreanim.h"
+#include "calmodel.h"
+
+// number of floats in a palette entry
+static const int PALETTE_ENTRY_SIZE = 12;
+
+ /*****************************************************************************/
+/** Constructs the baked animation instance.
+  *
+  * This function is the default constructor of the baked animation instance.
+  *****************************************************************************/
+
+CalBakedAnimation::CalBakedAnimation()
+{
+  m_pCoreModel = 0;
+  m_pCoreAnimation = 0;
+  m_boneCount = 0;
+  m_frameCount = 0;
+  m_duration = 0.0f;
+}
+
+ /*****************************************************************************/
+/** Destructs the baked animation instance.
+  *
+  * This function is the destructor of the baked animation instance.
+  *****************************************************************************/
+
+CalBakedAnimation::~CalBakedAnimation()
+{
+  assert(m_vectorPalette.empty());
+}
+
+CalBakedAnimation *CalBakedAnimation::Alloc(void) { return new CalBakedAnimation; }
+void CalBakedAnimation::Free(CalBakedAnimation *x) { delete x; }
+
+ /*****************************************************************************/
+/** Returns the frame count of a bake.
+  *
+  * This function returns the number of frames needed to bake a core animation
+  * at a given frame rate. The frames are spread evenly over the duration, and
+  * the last frame blends back to the first one.
+  *
+  * @param pCoreAnimation A pointer to the core animation.
+  * @param frameRate The frame rate in frames per second.
+  *
+  * @return The number of frames.
+  *****************************************************************************/
+
+int CalBakedAnimation::computeFrameCount(CalCoreAnimation *pCoreAnimation, float frameRate)
+{
+  int frameCount;
+  frameCount = (int)(pCoreAnimation->getDuration() * frameRate + 0.5f);
+  if(frameCount < 1) frameCount = 1;
+
+  return frameCount;
+}
+
+ /*****************************************************************************/
+/** Creates the baked animation instance.
+  *
+  * This function bakes a core animation against a core model. Every frame is
+  * evaluated through a temporary model instance (clearState, blendState,
+  * lockState and calculateState), and its bone transforms are stored as one
+  * skinning palette.
+  *
+  * @param pCoreModel A pointer to the core model.
+  * @param pCoreAnimation A pointer to the core animation.
+  * @param frameRate The frame rate in frames per second.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalBakedAnimation::create(CalCoreModel *pCoreModel, CalCoreAnimation *pCoreAnimation, float frameRate)
+{
+  if((pCoreModel == 0) || (pCoreAnimation == 0))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalBakedAnimation::create");
+    return false;
+  }
+
+  if((frameRate <= 0.0f) || (pCoreAnimation->getDuration() <= 0.0f))
+  {
+    CalError::setLastError(CalError::INVALID_ANIMATION_DURATION, __FILE__, __LINE__, "CalBakedAnimation::create");
+    return false;
+  }
+
+  m_pCoreModel = pCoreModel;
+  m_pCoreAnimation = pCoreAnimation;
+  m_boneCount = pCoreModel->getCoreBoneCount();
+  m_frameCount = computeFrameCount(pCoreAnimation, frameRate);
+  m_duration = pCoreAnimation->getDuration();
+
+  m_vectorPalette.reserve(m_frameCount * m_boneCount * PALETTE_ENTRY_SIZE);
+  m_vectorPalette.resize(m_frameCount * m_boneCount * PALETTE_ENTRY_SIZE);
+
+  // evaluate the animation through a temporary model instance
+  CalModel model;
+  if(!model.create(pCoreModel))
+  {
+    model.destroy();
+    m_vectorPalette.clear();
+    return false;
+  }
+
+  int frameId;
+  for(frameId = 0; frameId < m_frameCount; frameId++)
+  {
+    float time;
+    time = m_duration * frameId / m_frameCount;
+
+    model.clearState();
+    model.blendState(pCoreAnimation, 1.0f, time);
+    model.lockState();
+    model.calculateState();
+
+    // store the bone transforms as 3x4 rows
+    float *pPalette;
+    pPalette = &m_vectorPalette[frameId * m_boneCount * PALETTE_ENTRY_SIZE];
+
+    int boneId;
+    for(boneId = 0; boneId < m_boneCount; boneId++)
+    {
+      const CalMatrix& r = model.m_vectorTransformMatrix[boneId];
+      const CalVector& t = model.m_vectorTransformVector[boneId];
+
+      pPalette[0] = r.dxdx; pPalette[1] = r.dxdy; pPalette[2]  = r.dxdz; pPalette[3]  = t.x;
+      pPalette[4] = r.dydx; pPalette[5] = r.dydy; pPalette[6]  = r.dydz; pPalette[7]  = t.y;
+      pPalette[8] = r.dzdx; pPalette[9] = r.dzdy; pPalette[10] = r.dzdz; pPalette[11] = t.z;
+      pPalette += PALETTE_ENTRY_SIZE;
+    }
+  }
+
+  model.destroy();
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the baked animation instance.
+  *
+  * This function destroys all data stored in the baked animation instance and
+  * frees all allocated memory.
+  *****************************************************************************/
+
+void CalBakedAnimation::destroy()
+{
+  m_vectorPalette.clear();
+
+  m_pCoreModel = 0;
+  m_pCoreAnimation = 0;
+  m_boneCount = 0;
+  m_frameCount = 0;
+  m_duration = 0.0f;
+}
+
+ /*****************************************************************************/
+/** Returns the frames around a specified time.
+  *
+  * This function returns the two frames that enclose the specified time, and
+  * the blending factor between them. The time wraps around the duration.
+  *
+  * @param time The time in seconds.
+  * @param frameId0 A reference to the ID that will be filled with the frame
+  *                 before the time.
+  * @param frameId1 A reference to the ID that will be filled with the frame
+  *                 after the time.
+  * @param factor A reference to the factor that will be filled with the
+  *               blending factor between the two frames.
+  *****************************************************************************/
+
+void CalBakedAnimation::findFrames(float time, int& frameId0, int& frameId1, float& factor)
+{
+  float position;
+  position = time / m_duration;
+  position = (position - (float)floor(position)) * m_frameCount;
+
+  frameId0 = (int)position;
+  if(frameId0 >= m_frameCount) frameId0 = m_frameCount - 1;
+  frameId1 = (frameId0 + 1 == m_frameCount) ? 0 : frameId0 + 1;
+  factor = position - frameId0;
+}
+
+ /*****************************************************************************/
+/** Returns the number of bones.
+  *
+  * This function returns the number of palette entries per frame.
+  *
+  * @return The number of bones.
+  *****************************************************************************/
+
+int CalBakedAnimation::getBoneCount()
+{
+  return m_boneCount;
+}
+
+ /*****************************************************************************/
+/** Provides access to the core animation.
+  *
+  * This function returns the core animation that was baked.
+  *
+  * @return A pointer to the core animation.
+  *****************************************************************************/
+
+CalCoreAnimation *CalBakedAnimation::getCoreAnimation()
+{
+  return m_pCoreAnimation;
+}
+
+ /*****************************************************************************/
+/** Provides access to the core model.
+  *
+  * This function returns the core model the animation was baked against.
+  *
+  * @return A pointer to the core model.
+  *****************************************************************************/
+
+CalCoreModel *CalBakedAnimation::getCoreModel()
+{
+  return m_pCoreModel;
+}
+
+ /*****************************************************************************/
+/** Returns the duration.
+  *
+  * This function returns the duration of the baked animation.
+  *
+  * @return The duration in seconds.
+  *****************************************************************************/
+
+float CalBakedAnimation::getDuration()
+{
+  return m_duration;
+}
+
+ /*****************************************************************************/
+/** Provides access to a frame.
+  *
+  * This function returns the skinning palette of a frame, with 12 floats per
+  * bone. It can be uploaded as it is for skinning on the GPU.
+  *
+  * @param frameId The ID of the frame.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the palette
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+const float *CalBakedAnimation::getFrame(int frameId)
+{
+  if((frameId < 0) || (frameId >= m_frameCount))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalBakedAnimation::getFrame");
+    return 0;
+  }
+
+  return &m_vectorPalette[frameId * m_boneCount * PALETTE_ENTRY_SIZE];
+}
+
+ /*****************************************************************************/
+/** Returns the number of frames.
+  *
+  * This function returns the number of frames of the baked animation.
+  *
+  * @return The number of frames.
+  *****************************************************************************/
+
+int CalBakedAnimation::getFrameCount()
+{
+  return m_frameCount;
+}
+
+ /*****************************************************************************/
+/** Returns the memory size.
+  *
+  * This function returns the memory used by the palettes of the baked
+  * animation.
+  *
+  * @return The memory size in bytes.
+  *****************************************************************************/
+
+int CalBakedAnimation::getMemorySize()
+{
+  return m_vectorPalette.size() * sizeof(float);
+}
+
+ /*****************************************************************************/
+/** Returns the skinning palette at a specified time.
+  *
+  * This function fills a palette with the bone transforms at the specified
+  * time, either from the nearest frame before it or blended linearly between
+  * the two enclosing frames. The linear blend does not keep the rotations
+  * orthonormal, which is invisible at common frame rates.
+  *
+  * @param time The time in seconds.
+  * @param pPalette A pointer to the buffer that will be filled with 12 floats
+  *                 per bone.
+  * @param bInterpolate \b true to blend between frames, \b false to pick the
+  *                     frame before the time.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalBakedAnimation::getPalette(float time, float *pPalette, bool bInterpolate)
+{
+  if(m_vectorPalette.empty())
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalBakedAnimation::getPalette");
+    return false;
+  }
+
+  int frameId0, frameId1;
+  float factor;
+  findFrames(time, frameId0, frameId1, factor);
+
+  const int paletteSize = m_boneCount * PALETTE_ENTRY_SIZE;
+  const float *pFrame0 = &m_vectorPalette[frameId0 * paletteSize];
+
+  if(!bInterpolate)
+  {
+    memcpy(pPalette, pFrame0, paletteSize * sizeof(float));
+    return true;
+  }
+
+  const float *pFrame1 = &m_vectorPalette[frameId1 * paletteSize];
+
+  int i;
+  for(i = 0; i < paletteSize; i++)
+  {
+    pPalette[i] = pFrame0[i] + factor * (pFrame1[i] - pFrame0[i]);
+  }
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Returns the memory size of a bake.
+  *
+  * This function returns the memory a bake of a core animation against a core
+  * model would use, without doing it.
+  *
+  * @param pCoreModel A pointer to the core model.
+  * @param pCoreAnimation A pointer to the core animation.
+  * @param frameRate The frame rate in frames per second.
+  *
+  * @return The memory size in bytes.
+  *****************************************************************************/
+
+int CalBakedAnimation::estimateMemorySize(CalCoreModel *pCoreModel, CalCoreAnimation *pCoreAnimation, float frameRate)
+{
+  return computeFrameCount(pCoreAnimation, frameRate) * pCoreModel->getCoreBoneCount() * PALETTE_ENTRY_SIZE * sizeof(float);
+}
+
+//****************************************************************************//
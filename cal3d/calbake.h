@@ -0,0 +1,80 @@
+//****************************************************************************//
+// bake.h                                                                     //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_BAKE_H
+#define CAL_BAKE_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalCoreModel;
+class CalCoreAnimation;
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The baked animation class.
+  *
+  * A baked animation holds the skinning palette of a core animation played on
+  * a core model, sampled at a fixed frame rate. Every palette entry is a 3x4
+  * row-major bone transform: the rotation rows, each followed by one component
+  * of the translation. Playing a baked animation skips track sampling, bone
+  * blending and the hierarchy update.
+  *****************************************************************************/
+
+class CAL3D_API CalBakedAnimation
+{
+// member variables
+protected:
+  CalCoreModel *m_pCoreModel;
+  CalCoreAnimation *m_pCoreAnimation;
+  int m_boneCount;
+  int m_frameCount;
+  float m_duration;
+  std::vector<float> m_vectorPalette;
+
+// constructors/destructor
+public:
+  CalBakedAnimation();
+  virtual ~CalBakedAnimation();
+  static CalBakedAnimation *Alloc(void);
+  static void Free(CalBakedAnimation *x);
+
+// member functions
+public:
+  bool create(CalCoreModel *pCoreModel, CalCoreAnimation *pCoreAnimation, float frameRate);
+  void destroy();
+  void findFrames(float time, int& frameId0, int& frameId1, float& factor);
+  int getBoneCount();
+  CalCoreAnimation *getCoreAnimation();
+  CalCoreModel *getCoreModel();
+  float getDuration();
+  const float *getFrame(int frameId);
+  int getFrameCount();
+  int getMemorySize();
+  bool getPalette(float time, float *pPalette, bool bInterpolate = true);
+  static int estimateMemorySize(CalCoreModel *pCoreModel, CalCoreAnimation *pCoreAnimation, float frameRate);
+
+protected:
+  static int computeFrameCount(CalCoreAnimation *pCoreAnimation, float frameRate);
+};
+
+#endif
+
+//****************************************************************************//
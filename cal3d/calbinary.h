@@ -0,0 +1,120 @@
+//****************************************************************************//
+// binary.h                                                                   //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_BINARY_H
+#define CAL_BINARY_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Binary model file layout                                                   //
+//****************************************************************************//
+
+// A binary model file (Cal::BINARY_MODEL_FILE_MAGIC) is a memory image of a
+// core model. It starts with a CalBinaryHeader, and every other section is
+// found through a byte offset from the start of the file. All sections are
+// aligned to BINARY_ALIGNMENT bytes and stored in the byte order of the
+// machine that wrote them; the loader rejects files whose byte order marker
+// or record sizes differ from its own. The per-vertex, per-face, ... sections
+// have exactly the layout of the CalCoreSubmesh arrays, so each of them is
+// loaded with a single copy.
+
+namespace Cal
+{
+  const int BINARY_ALIGNMENT = 16;
+  const int BINARY_BYTE_ORDER = 0x01020304;
+};
+
+ /*****************************************************************************/
+/** The binary file header.
+  *****************************************************************************/
+
+struct CalBinaryHeader
+{
+  char magic[4];
+  int version;
+  int byteOrder;
+  int fileSize;
+  int boneSize;             // sizeof(CalBinaryBone)
+  int submeshSize;          // sizeof(CalBinarySubmesh)
+  int vertexSize;           // size of a vertex record
+  int boneCount;
+  int boneOffset;           // boneCount CalBinaryBone
+  int childCount;
+  int childOffset;          // childCount int, the child ids of all bones
+  int submeshCount;
+  int submeshOffset;        // submeshCount CalBinarySubmesh
+  int stringSize;
+  int stringOffset;         // zero-terminated bone names
+  int reserved;
+};
+
+ /*****************************************************************************/
+/** The binary bone record.
+  *****************************************************************************/
+
+struct CalBinaryBone
+{
+  int nameOffset;           // relative to the string section
+  int parentId;
+  int childCount;
+  int firstChild;           // index into the child section
+  float length;
+  float translation[3];
+  float rotation[4];
+  float translationBoneSpace[3];
+  float rotationBoneSpace[4];
+  int reserved;
+};
+
+ /*****************************************************************************/
+/** The binary submesh record.
+  *
+  * A vertex record is the position, followed by the packed normal and the
+  * influence count, as in CalCoreSubmesh::Vertex. The influences of all
+  * vertices follow each other in vertex order.
+  *****************************************************************************/
+
+struct CalBinarySubmesh
+{
+  int coreMaterialThreadId;
+  int lodCount;
+  int vertexCount;
+  int faceCount;
+  int springCount;
+  int influenceCount;
+  int textureCoordinateCount;
+  int channelOffset;          // textureCoordinateCount CalBinaryChannel
+  int vertexOffset;           // vertexCount vertex records
+  int lodControlOffset;       // vertexCount CalCoreSubmesh::LodControl
+  int influenceOffset;        // influenceCount CalCoreSubmesh::Influence
+  int physicalPropertyOffset; // vertexCount CalCoreSubmesh::PhysicalProperty, 0 without springs
+  int springOffset;           // springCount CalCoreSubmesh::Spring
+  int faceOffset;             // faceCount CalCoreSubmesh::Face
+  int reserved[2];
+};
+
+ /*****************************************************************************/
+/** The binary texture coordinate channel record.
+  *****************************************************************************/
+
+struct CalBinaryChannel
+{
+  int textureCoordinateOffset; // vertexCount CalCoreSubmesh::TextureCoordinate
+  int tangentSpaceOffset;      // vertexCount CalCoreSubmesh::TangentSpace, 0 if disabled
+};
+
+#endif
+
+//****************************************************************************//
@@ -84,7 +84,7 @@ void CalBone::blendState(float weight, const CalVector& translation, const CalQu
     factor = weight / (m_accumulatedWeightAbsolute + weight);
 
     m_translationAbsolute.blend(factor, translation);
-    m_rotationAbsolute.blend(factor, rotation);
+    m_rotationAbsolute.blend(factor, rotation, m_pModel->getInterpolationMode());
 
     m_accumulatedWeightAbsolute += weight;
   }
@@ -116,7 +116,7 @@ void CalBone::blendSavedState(float weight)
     factor = weight / (m_accumulatedWeightAbsolute + weight);
 
     m_translationAbsolute.blend(factor, m_translationSaved);
-    m_rotationAbsolute.blend(factor, m_rotationSaved);
+    m_rotationAbsolute.blend(factor, m_rotationSaved, m_pModel->getInterpolationMode());
 
     m_accumulatedWeightAbsolute += weight;
   }
@@ -374,7 +374,7 @@ void CalBone::lockState()
       factor = m_accumulatedWeightAbsolute / (m_accumulatedWeight + m_accumulatedWeightAbsolute);
 
       m_translation.blend(factor, m_translationAbsolute);
-      m_rotation.blend(factor, m_rotationAbsolute);
+      m_rotation.blend(factor, m_rotationAbsolute, m_pModel->getInterpolationMode());
 
       m_accumulatedWeight += m_accumulatedWeightAbsolute;
     }
@@ -0,0 +1,555 @@
+//****************************************************************************//
+// cache.cpp                                                                  //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calcache.h"
+#include "calerror.h"
+#include "calloader.h"
+#include "calcoremodel.h"
+#include "calcoreanim.h"
+
+ /*****************************************************************************/
+/** Constructs the resource cache instance.
+  *
+  * This function is the default constructor of the resource cache instance.
+  *****************************************************************************/
+
+CalResourceCache::CalResourceCache()
+{
+  m_budget = 0;
+  m_residentSize = 0;
+  m_residentCount = 0;
+  m_hitCount = 0;
+  m_missCount = 0;
+  m_evictionCount = 0;
+}
+
+ /*****************************************************************************/
+/** Destructs the resource cache instance.
+  *
+  * This function is the destructor of the resource cache instance.
+  *****************************************************************************/
+
+CalResourceCache::~CalResourceCache()
+{
+  assert(m_vectorResource.empty());
+}
+
+ /*****************************************************************************/
+/** Acquires a resource.
+  *
+  * This function makes a resource resident, loading it on a miss, and pins
+  * it. A pinned resource is taken out of the least recently used list.
+  *
+  * @param resourceId The ID of the resource.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalResourceCache::acquire(int resourceId)
+{
+  if((resourceId < 0) || (resourceId >= (int)m_vectorResource.size()))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalResourceCache::acquire");
+    return false;
+  }
+
+  Resource& resource = m_vectorResource[resourceId];
+
+  if((resource.pCoreModel != 0) || (resource.pCoreAnimation != 0))
+  {
+    m_hitCount++;
+
+    if(resource.iteratorLru != m_listLru.end())
+    {
+      m_listLru.erase(resource.iteratorLru);
+      resource.iteratorLru = m_listLru.end();
+    }
+
+    resource.pinCount++;
+    return true;
+  }
+
+  m_missCount++;
+
+  CalLoader loader;
+  if(resource.bAnimation)
+  {
+    CalCoreAnimation *pCoreAnimation;
+    pCoreAnimation = CalCoreAnimation::Alloc();
+    if(!pCoreAnimation->create(resource.strName.c_str()) || !loader.loadCoreAnimation(pCoreAnimation, resource.strFilename))
+    {
+      pCoreAnimation->destroy();
+      CalCoreAnimation::Free(pCoreAnimation);
+      return false;
+    }
+
+    resource.pCoreAnimation = pCoreAnimation;
+    resource.size = pCoreAnimation->getMemorySize();
+  }
+  else
+  {
+    CalCoreModel *pCoreModel;
+    pCoreModel = CalCoreModel::Alloc();
+    if(!pCoreModel->create(resource.strName.c_str()) || !loader.loadCoreModel(pCoreModel, resource.strFilename))
+    {
+      pCoreModel->destroy();
+      CalCoreModel::Free(pCoreModel);
+      return false;
+    }
+
+    resource.pCoreModel = pCoreModel;
+    resource.size = pCoreModel->getMemorySize();
+  }
+
+  resource.pinCount = 1;
+  m_residentSize += resource.size;
+  m_residentCount++;
+
+  // make room for the new resource
+  trim();
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Acquires a core animation.
+  *
+  * This function returns the core animation of a resource, loading it if it
+  * is not resident, and pins it until release() is called.
+  *
+  * @param resourceId The ID of the resource.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core animation
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreAnimation *CalResourceCache::acquireCoreAnimation(int resourceId)
+{
+  if((resourceId >= 0) && (resourceId < (int)m_vectorResource.size()) && !m_vectorResource[resourceId].bAnimation)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalResourceCache::acquireCoreAnimation");
+    return 0;
+  }
+
+  if(!acquire(resourceId)) return 0;
+
+  return m_vectorResource[resourceId].pCoreAnimation;
+}
+
+ /*****************************************************************************/
+/** Acquires a core model.
+  *
+  * This function returns the core model of a resource, loading it if it is
+  * not resident, and pins it until release() is called. A core model must be
+  * acquired for as long as a model created from it exists.
+  *
+  * @param resourceId The ID of the resource.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core model
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreModel *CalResourceCache::acquireCoreModel(int resourceId)
+{
+  if((resourceId >= 0) && (resourceId < (int)m_vectorResource.size()) && m_vectorResource[resourceId].bAnimation)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalResourceCache::acquireCoreModel");
+    return 0;
+  }
+
+  if(!acquire(resourceId)) return 0;
+
+  return m_vectorResource[resourceId].pCoreModel;
+}
+
+ /*****************************************************************************/
+/** Creates the resource cache instance.
+  *
+  * This function creates the resource cache instance.
+  *
+  * @param budget The memory budget in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalResourceCache::create(size_t budget)
+{
+  m_budget = budget;
+  resetCounters();
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the resource cache instance.
+  *
+  * This function destroys all resident resources, pinned or not, and removes
+  * all registered resources.
+  *****************************************************************************/
+
+void CalResourceCache::destroy()
+{
+  int resourceId;
+  for(resourceId = 0; resourceId < (int)m_vectorResource.size(); resourceId++)
+  {
+    evict(resourceId);
+  }
+
+  m_vectorResource.clear();
+  m_mapResourceId.clear();
+  m_listLru.clear();
+
+  m_budget = 0;
+  m_residentSize = 0;
+  m_residentCount = 0;
+}
+
+ /*****************************************************************************/
+/** Evicts a resource.
+  *
+  * This function destroys the core object of a resource and removes it from
+  * the least recently used list. It stays registered.
+  *
+  * @param resourceId The ID of the resource.
+  *****************************************************************************/
+
+void CalResourceCache::evict(int resourceId)
+{
+  Resource& resource = m_vectorResource[resourceId];
+
+  if((resource.pCoreModel == 0) && (resource.pCoreAnimation == 0)) return;
+
+  if(resource.pCoreModel != 0)
+  {
+    resource.pCoreModel->destroy();
+    CalCoreModel::Free(resource.pCoreModel);
+    resource.pCoreModel = 0;
+  }
+
+  if(resource.pCoreAnimation != 0)
+  {
+    resource.pCoreAnimation->destroy();
+    CalCoreAnimation::Free(resource.pCoreAnimation);
+    resource.pCoreAnimation = 0;
+  }
+
+  if(resource.iteratorLru != m_listLru.end())
+  {
+    m_listLru.erase(resource.iteratorLru);
+    resource.iteratorLru = m_listLru.end();
+  }
+
+  m_residentSize -= resource.size;
+  m_residentCount--;
+
+  resource.size = 0;
+  resource.pinCount = 0;
+}
+
+ /*****************************************************************************/
+/** Returns the memory budget.
+  *
+  * This function returns the memory budget of the resource cache instance.
+  *
+  * @return The memory budget in bytes.
+  *****************************************************************************/
+
+size_t CalResourceCache::getBudget()
+{
+  return m_budget;
+}
+
+ /*****************************************************************************/
+/** Returns the number of evictions.
+  *
+  * This function returns the number of resources evicted to stay in the
+  * budget since the counters were reset.
+  *
+  * @return The number of evictions.
+  *****************************************************************************/
+
+int CalResourceCache::getEvictionCount()
+{
+  return m_evictionCount;
+}
+
+ /*****************************************************************************/
+/** Returns the number of hits.
+  *
+  * This function returns the number of acquires that found their resource
+  * resident since the counters were reset.
+  *
+  * @return The number of hits.
+  *****************************************************************************/
+
+int CalResourceCache::getHitCount()
+{
+  return m_hitCount;
+}
+
+ /*****************************************************************************/
+/** Returns the hit rate.
+  *
+  * This function returns the share of acquires that found their resource
+  * resident since the counters were reset.
+  *
+  * @return The hit rate between 0.0 and 1.0.
+  *****************************************************************************/
+
+float CalResourceCache::getHitRate()
+{
+  if(m_hitCount + m_missCount == 0) return 0.0f;
+
+  return (float)m_hitCount / (float)(m_hitCount + m_missCount);
+}
+
+ /*****************************************************************************/
+/** Returns the number of misses.
+  *
+  * This function returns the number of acquires that had to load their
+  * resource since the counters were reset.
+  *
+  * @return The number of misses.
+  *****************************************************************************/
+
+int CalResourceCache::getMissCount()
+{
+  return m_missCount;
+}
+
+ /*****************************************************************************/
+/** Returns the number of resident resources.
+  *
+  * This function returns the number of resources that are loaded.
+  *
+  * @return The number of resident resources.
+  *****************************************************************************/
+
+int CalResourceCache::getResidentCount()
+{
+  return m_residentCount;
+}
+
+ /*****************************************************************************/
+/** Returns the resident size.
+  *
+  * This function returns the memory used by all loaded resources.
+  *
+  * @return The resident size in bytes.
+  *****************************************************************************/
+
+size_t CalResourceCache::getResidentSize()
+{
+  return m_residentSize;
+}
+
+ /*****************************************************************************/
+/** Returns the ID of a resource.
+  *
+  * This function returns the ID of a registered resource.
+  *
+  * @param strName The name of the resource.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the resource
+  *         \li \b -1 if there is no such resource
+  *****************************************************************************/
+
+int CalResourceCache::getResourceId(const std::string& strName)
+{
+  std::map<std::string, int>::iterator iteratorResourceId;
+  iteratorResourceId = m_mapResourceId.find(strName);
+  if(iteratorResourceId == m_mapResourceId.end()) return -1;
+
+  return iteratorResourceId->second;
+}
+
+ /*****************************************************************************/
+/** Returns the residency of a resource.
+  *
+  * This function returns whether a resource is loaded.
+  *
+  * @param resourceId The ID of the resource.
+  *
+  * @return One of the following values:
+  *         \li \b true if the resource is resident
+  *         \li \b false if not
+  *****************************************************************************/
+
+bool CalResourceCache::isResident(int resourceId)
+{
+  if((resourceId < 0) || (resourceId >= (int)m_vectorResource.size())) return false;
+
+  return (m_vectorResource[resourceId].pCoreModel != 0) || (m_vectorResource[resourceId].pCoreAnimation != 0);
+}
+
+ /*****************************************************************************/
+/** Registers a core animation.
+  *
+  * This function registers a core animation file under a name. It is loaded
+  * when it is acquired for the first time.
+  *
+  * @param strName The name of the resource.
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the resource
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalResourceCache::registerCoreAnimation(const std::string& strName, const std::string& strFilename)
+{
+  return registerResource(strName, strFilename, true);
+}
+
+ /*****************************************************************************/
+/** Registers a core model.
+  *
+  * This function registers a core model file under a name. It is loaded when
+  * it is acquired for the first time.
+  *
+  * @param strName The name of the resource.
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the resource
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalResourceCache::registerCoreModel(const std::string& strName, const std::string& strFilename)
+{
+  return registerResource(strName, strFilename, false);
+}
+
+ /*****************************************************************************/
+/** Registers a resource.
+  *
+  * This function adds a resource that is not resident yet.
+  *
+  * @param strName The name of the resource.
+  * @param strFilename The name of the file.
+  * @param bAnimation \b true for a core animation, \b false for a core model.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the resource
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalResourceCache::registerResource(const std::string& strName, const std::string& strFilename, bool bAnimation)
+{
+  if(m_mapResourceId.find(strName) != m_mapResourceId.end())
+  {
+    CalError::setLastError(CalError::INVALID_ATTRIBUTE_VALUE, __FILE__, __LINE__, strName);
+    return -1;
+  }
+
+  Resource resource;
+  resource.strName = strName;
+  resource.strFilename = strFilename;
+  resource.bAnimation = bAnimation;
+  resource.pCoreModel = 0;
+  resource.pCoreAnimation = 0;
+  resource.size = 0;
+  resource.pinCount = 0;
+  resource.iteratorLru = m_listLru.end();
+
+  int resourceId;
+  resourceId = m_vectorResource.size();
+  m_vectorResource.push_back(resource);
+  m_mapResourceId[strName] = resourceId;
+
+  return resourceId;
+}
+
+ /*****************************************************************************/
+/** Releases a resource.
+  *
+  * This function unpins a resource that was acquired. When it is no longer
+  * pinned, it becomes the most recently used resource, and the cache evicts
+  * resources until it is back in its budget.
+  *
+  * @param resourceId The ID of the resource.
+  *****************************************************************************/
+
+void CalResourceCache::release(int resourceId)
+{
+  if((resourceId < 0) || (resourceId >= (int)m_vectorResource.size())) return;
+
+  Resource& resource = m_vectorResource[resourceId];
+  if(resource.pinCount <= 0) return;
+
+  resource.pinCount--;
+  if(resource.pinCount > 0) return;
+
+  resource.iteratorLru = m_listLru.insert(m_listLru.end(), resourceId);
+
+  trim();
+}
+
+ /*****************************************************************************/
+/** Resets the counters.
+  *
+  * This function resets the hit, miss and eviction counters.
+  *****************************************************************************/
+
+void CalResourceCache::resetCounters()
+{
+  m_hitCount = 0;
+  m_missCount = 0;
+  m_evictionCount = 0;
+}
+
+ /*****************************************************************************/
+/** Sets the memory budget.
+  *
+  * This function sets the memory budget, and evicts resources until the
+  * cache is back in it.
+  *
+  * @param budget The memory budget in bytes.
+  *****************************************************************************/
+
+void CalResourceCache::setBudget(size_t budget)
+{
+  m_budget = budget;
+
+  trim();
+}
+
+ /*****************************************************************************/
+/** Evicts resources down to the budget.
+  *
+  * This function evicts the least recently used resources that are not
+  * pinned, until the resident size is within the budget.
+  *****************************************************************************/
+
+void CalResourceCache::trim()
+{
+  while((m_residentSize > m_budget) && !m_listLru.empty())
+  {
+    evict(m_listLru.front());
+    m_evictionCount++;
+  }
+}
+
+//****************************************************************************//
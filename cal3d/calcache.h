@@ -0,0 +1,107 @@
+//****************************************************************************//
+// cache.h                                                                    //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_CACHE_H
+#define CAL_CACHE_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalCoreModel;
+class CalCoreAnimation;
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The resource cache class.
+  *
+  * A resource cache keeps core models and core animations resident under a
+  * memory budget. Resources are registered by name and file, and loaded
+  * through CalLoader when they are acquired. An acquired resource is pinned
+  * until it is released, so a core model or core animation stays valid while
+  * a model uses it. Released resources stay resident in least recently used
+  * order, and are evicted from the front of that list whenever the resident
+  * size is above the budget. Pinned resources are never evicted, so they can
+  * exceed the budget.
+  *****************************************************************************/
+
+class CAL3D_API CalResourceCache
+{
+// misc
+protected:
+  struct Resource
+  {
+    std::string strName;
+    std::string strFilename;
+    bool bAnimation;
+    CalCoreModel *pCoreModel;
+    CalCoreAnimation *pCoreAnimation;
+    int size;
+    int pinCount;
+    std::list<int>::iterator iteratorLru;
+  };
+
+// member variables
+protected:
+  std::vector<Resource> m_vectorResource;
+  std::map<std::string, int> m_mapResourceId;
+  std::list<int> m_listLru;
+  size_t m_budget;
+  size_t m_residentSize;
+  int m_residentCount;
+  int m_hitCount;
+  int m_missCount;
+  int m_evictionCount;
+
+// constructors/destructor
+public:
+  CalResourceCache();
+  virtual ~CalResourceCache();
+
+// member functions
+public:
+  CalCoreAnimation *acquireCoreAnimation(int resourceId);
+  CalCoreModel *acquireCoreModel(int resourceId);
+  bool create(size_t budget);
+  void destroy();
+  size_t getBudget();
+  int getEvictionCount();
+  int getHitCount();
+  float getHitRate();
+  int getMissCount();
+  int getResidentCount();
+  size_t getResidentSize();
+  int getResourceId(const std::string& strName);
+  bool isResident(int resourceId);
+  int registerCoreAnimation(const std::string& strName, const std::string& strFilename);
+  int registerCoreModel(const std::string& strName, const std::string& strFilename);
+  void release(int resourceId);
+  void resetCounters();
+  void setBudget(size_t budget);
+
+protected:
+  bool acquire(int resourceId);
+  void evict(int resourceId);
+  int registerResource(const std::string& strName, const std::string& strFilename, bool bAnimation);
+  void trim();
+};
+
+#endif
+
+//****************************************************************************//
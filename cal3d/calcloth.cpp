@@ -0,0 +1,639 @@
+//****************************************************************************//
+// cloth.cpp                                                                  //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calcloth.h"
+#include "calerror.h"
+#include "calcorecloth.h"
+
+ /*****************************************************************************/
+/** Constructs the cloth instance.
+  *
+  * This function is the default constructor of the cloth instance.
+  *****************************************************************************/
+
+CalCloth::CalCloth()
+{
+  m_pCoreCloth = 0;
+  m_iterationCount = Cal::SPRING_ITERATION_COUNT;
+  m_timeStep = Cal::SPRING_TIME_STEP;
+  m_maxSubstepCount = Cal::SPRING_SUBSTEP_COUNT;
+  m_accumulatedTime = 0.0f;
+  m_sleepThreshold = Cal::SPRING_SLEEP_THRESHOLD;
+  m_stillStepCount = 0;
+  m_bSleeping = false;
+}
+
+ /*****************************************************************************/
+/** Destructs the cloth instance.
+  *
+  * This function is the destructor of the cloth instance.
+  *****************************************************************************/
+
+CalCloth::~CalCloth()
+{
+}
+
+ /*****************************************************************************/
+/** Creates the cloth instance.
+  *
+  * This function creates the cloth instance based on a core cloth, with all
+  * slots at rest at the given vertex positions.
+  *
+  * @param pCoreCloth A pointer to the core cloth.
+  * @param pVertex A pointer to the positions of the vertices of the submesh.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCloth::create(CalCoreCloth *pCoreCloth, const CalVector *pVertex)
+{
+  if((pCoreCloth == 0) || ((pVertex == 0) && (pCoreCloth->getSlotCount() > 0)))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalCloth::create");
+    return false;
+  }
+
+  m_pCoreCloth = pCoreCloth;
+
+  int slotCount;
+  slotCount = m_pCoreCloth->getSlotCount();
+
+  m_vectorPositionX.resize(slotCount);
+  m_vectorPositionY.resize(slotCount);
+  m_vectorPositionZ.resize(slotCount);
+
+  const int *pVertexId = m_pCoreCloth->getVertexIds();
+
+  int slotId;
+  for(slotId = 0; slotId < slotCount; slotId++)
+  {
+    const CalVector& vertex = pVertex[pVertexId[slotId]];
+    m_vectorPositionX[slotId] = vertex.x;
+    m_vectorPositionY[slotId] = vertex.y;
+    m_vectorPositionZ[slotId] = vertex.z;
+  }
+
+  int freeSlotCount;
+  freeSlotCount = m_pCoreCloth->getFreeSlotCount();
+
+  m_vectorOldPositionX.assign(m_vectorPositionX.begin(), m_vectorPositionX.begin() + freeSlotCount);
+  m_vectorOldPositionY.assign(m_vectorPositionY.begin(), m_vectorPositionY.begin() + freeSlotCount);
+  m_vectorOldPositionZ.assign(m_vectorPositionZ.begin(), m_vectorPositionZ.begin() + freeSlotCount);
+
+  // the corrections are buffered for the largest color
+  int colorCount;
+  colorCount = m_pCoreCloth->getColorCount();
+
+  const int *pColorOffset = m_pCoreCloth->getColorOffsets();
+
+  int maxColorSpringCount;
+  maxColorSpringCount = 0;
+
+  int color;
+  for(color = 0; color < colorCount; color++)
+  {
+    int colorSpringCount = pColorOffset[color + 1] - pColorOffset[color];
+    if(colorSpringCount > maxColorSpringCount) maxColorSpringCount = colorSpringCount;
+  }
+
+  m_vectorCorrectionX.resize(maxColorSpringCount);
+  m_vectorCorrectionY.resize(maxColorSpringCount);
+  m_vectorCorrectionZ.resize(maxColorSpringCount);
+
+  m_accumulatedTime = 0.0f;
+  m_stillStepCount = 0;
+  m_bSleeping = false;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the cloth instance.
+  *
+  * This function destroys all data stored in the cloth instance and frees
+  * all allocated memory.
+  *****************************************************************************/
+
+void CalCloth::destroy()
+{
+  m_pCoreCloth = 0;
+  m_vectorPositionX.clear();
+  m_vectorPositionY.clear();
+  m_vectorPositionZ.clear();
+  m_vectorOldPositionX.clear();
+  m_vectorOldPositionY.clear();
+  m_vectorOldPositionZ.clear();
+  m_vectorCorrectionX.clear();
+  m_vectorCorrectionY.clear();
+  m_vectorCorrectionZ.clear();
+}
+
+ /*****************************************************************************/
+/** Provides access to the core cloth.
+  *
+  * This function returns the core cloth on which this cloth instance is
+  * based on.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core cloth
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreCloth *CalCloth::getCoreCloth()
+{
+  return m_pCoreCloth;
+}
+
+ /*****************************************************************************/
+/** Returns the number of iterations.
+  *
+  * This function returns how many times the springs are relaxed per update.
+  *
+  * @return The number of iterations.
+  *****************************************************************************/
+
+int CalCloth::getIterationCount()
+{
+  return m_iterationCount;
+}
+
+ /*****************************************************************************/
+/** Returns the maximal number of steps per update.
+  *
+  * This function returns how many fixed time steps an update takes at most.
+  *
+  * @return The maximal number of steps.
+  *****************************************************************************/
+
+int CalCloth::getMaxSubstepCount()
+{
+  return m_maxSubstepCount;
+}
+
+ /*****************************************************************************/
+/** Returns the motion of the last step.
+  *
+  * This function returns how far the free slots moved in the last step, as
+  * the largest distance along any axis.
+  *
+  * @return The motion of the last step.
+  *****************************************************************************/
+
+float CalCloth::getMotion()
+{
+  int freeSlotCount;
+  freeSlotCount = m_pCoreCloth->getFreeSlotCount();
+
+  float motion;
+  motion = 0.0f;
+
+  int slotId;
+  for(slotId = 0; slotId < freeSlotCount; slotId++)
+  {
+    float dx = (float)fabs(m_vectorPositionX[slotId] - m_vectorOldPositionX[slotId]);
+    float dy = (float)fabs(m_vectorPositionY[slotId] - m_vectorOldPositionY[slotId]);
+    float dz = (float)fabs(m_vectorPositionZ[slotId] - m_vectorOldPositionZ[slotId]);
+
+    if(dx > motion) motion = dx;
+    if(dy > motion) motion = dy;
+    if(dz > motion) motion = dz;
+  }
+
+  return motion;
+}
+
+ /*****************************************************************************/
+/** Returns the previous position of a slot.
+  *
+  * This function returns the position of a slot before the last update. A
+  * pinned slot has no previous position, so its current one is returned.
+  *
+  * @param slotId The ID of the slot.
+  * @param position The position.
+  *****************************************************************************/
+
+void CalCloth::getOldPosition(int slotId, CalVector& position)
+{
+  if(slotId >= m_pCoreCloth->getFreeSlotCount())
+  {
+    getPosition(slotId, position);
+    return;
+  }
+
+  position.set(m_vectorOldPositionX[slotId], m_vectorOldPositionY[slotId], m_vectorOldPositionZ[slotId]);
+}
+
+ /*****************************************************************************/
+/** Returns the position of a slot.
+  *
+  * This function returns the position of a slot after the last update.
+  *
+  * @param slotId The ID of the slot.
+  * @param position The position.
+  *****************************************************************************/
+
+void CalCloth::getPosition(int slotId, CalVector& position)
+{
+  position.set(m_vectorPositionX[slotId], m_vectorPositionY[slotId], m_vectorPositionZ[slotId]);
+}
+
+ /*****************************************************************************/
+/** Returns the sleep threshold.
+  *
+  * This function returns the motion per step below which the cloth counts
+  * as still.
+  *
+  * @return The sleep threshold.
+  *****************************************************************************/
+
+float CalCloth::getSleepThreshold()
+{
+  return m_sleepThreshold;
+}
+
+ /*****************************************************************************/
+/** Returns the time step.
+  *
+  * This function returns the fixed time step the cloth advances in.
+  *
+  * @return The time step in seconds.
+  *****************************************************************************/
+
+float CalCloth::getTimeStep()
+{
+  return m_timeStep;
+}
+
+ /*****************************************************************************/
+/** Integrates the free slots.
+  *
+  * This function does the Verlet step of all free slots, under gravity and a
+  * light wind scaled by the inverse weight of the slot.
+  *
+  * @param deltaTime The elapsed time in seconds since the last update.
+  *****************************************************************************/
+
+void CalCloth::integrate(float deltaTime)
+{
+  int freeSlotCount;
+  freeSlotCount = m_pCoreCloth->getFreeSlotCount();
+  if(freeSlotCount == 0) return;
+
+  const float *pInverseWeight = m_pCoreCloth->getInverseWeights();
+  float *pX = &m_vectorPositionX[0];
+  float *pY = &m_vectorPositionY[0];
+  float *pZ = &m_vectorPositionZ[0];
+  float *pOldX = &m_vectorOldPositionX[0];
+  float *pOldY = &m_vectorOldPositionY[0];
+  float *pOldZ = &m_vectorOldPositionZ[0];
+
+  // the force on a vertex is (0.0, 0.5, weight * -98.1)
+  float windStep;
+  windStep = 0.5f * deltaTime * deltaTime;
+
+  float gravityStep;
+  gravityStep = -98.1f * deltaTime * deltaTime;
+
+  // one pass per axis, so every loop streams through two or three arrays
+  int slotId;
+  for(slotId = 0; slotId < freeSlotCount; slotId++)
+  {
+    float x = pX[slotId];
+    pX[slotId] = x + (x - pOldX[slotId]) * 0.99f;
+    pOldX[slotId] = x;
+  }
+
+  for(slotId = 0; slotId < freeSlotCount; slotId++)
+  {
+    float y = pY[slotId];
+    pY[slotId] = y + (y - pOldY[slotId]) * 0.99f + windStep * pInverseWeight[slotId];
+    pOldY[slotId] = y;
+  }
+
+  for(slotId = 0; slotId < freeSlotCount; slotId++)
+  {
+    float z = pZ[slotId];
+    pZ[slotId] = z + (z - pOldZ[slotId]) * 0.99f + gravityStep;
+    pOldZ[slotId] = z;
+  }
+}
+
+ /*****************************************************************************/
+/** Returns the sleep state.
+  *
+  * This function returns whether the cloth is asleep, that is not simulated
+  * until one of its pinned slots moves.
+  *
+  * @return One of the following values:
+  *         \li \b true if the cloth is asleep
+  *         \li \b false if it is not
+  *****************************************************************************/
+
+bool CalCloth::isSleeping()
+{
+  return m_bSleeping;
+}
+
+ /*****************************************************************************/
+/** Checks if the pinned slots moved.
+  *
+  * This function checks if any vertex of a pinned slot moved away from the
+  * slot by more than the sleep threshold along any axis.
+  *
+  * @param pVertex A pointer to the positions of the vertices of the submesh.
+  *
+  * @return One of the following values:
+  *         \li \b true if a pinned slot moved
+  *         \li \b false if none did
+  *****************************************************************************/
+
+bool CalCloth::pinnedSlotsMoved(const CalVector *pVertex)
+{
+  int slotCount;
+  slotCount = m_pCoreCloth->getSlotCount();
+
+  const int *pVertexId = m_pCoreCloth->getVertexIds();
+
+  int slotId;
+  for(slotId = m_pCoreCloth->getFreeSlotCount(); slotId < slotCount; slotId++)
+  {
+    const CalVector& vertex = pVertex[pVertexId[slotId]];
+    if(fabs(vertex.x - m_vectorPositionX[slotId]) > m_sleepThreshold) return true;
+    if(fabs(vertex.y - m_vectorPositionY[slotId]) > m_sleepThreshold) return true;
+    if(fabs(vertex.z - m_vectorPositionZ[slotId]) > m_sleepThreshold) return true;
+  }
+
+  return false;
+}
+
+ /*****************************************************************************/
+/** Relaxes the springs.
+  *
+  * This function moves the ends of every spring towards its idle length, as
+  * many times as the iteration count. The correction factors of the core
+  * cloth decide how much of the correction each end takes. The springs of a
+  * color share no free slot, so each color is done in two passes: one that
+  * computes the corrections of all its springs and one that applies them.
+  *****************************************************************************/
+
+void CalCloth::relax()
+{
+  int colorCount;
+  colorCount = m_pCoreCloth->getColorCount();
+  if(colorCount == 0) return;
+
+  const int *pColorOffset = m_pCoreCloth->getColorOffsets();
+  const int *pSlotA = m_pCoreCloth->getSpringSlotsA();
+  const int *pSlotB = m_pCoreCloth->getSpringSlotsB();
+  const float *pIdleLength = m_pCoreCloth->getSpringIdleLengths();
+  const float *pFactorA = m_pCoreCloth->getSpringFactorsA();
+  const float *pFactorB = m_pCoreCloth->getSpringFactorsB();
+  float *pX = &m_vectorPositionX[0];
+  float *pY = &m_vectorPositionY[0];
+  float *pZ = &m_vectorPositionZ[0];
+  float *pCorrectionX = &m_vectorCorrectionX[0];
+  float *pCorrectionY = &m_vectorCorrectionY[0];
+  float *pCorrectionZ = &m_vectorCorrectionZ[0];
+
+  int iterationId;
+  for(iterationId = 0; iterationId < m_iterationCount; iterationId++)
+  {
+    int color;
+    for(color = 0; color < colorCount; color++)
+    {
+      int firstSpringId = pColorOffset[color];
+      int colorSpringCount = pColorOffset[color + 1] - firstSpringId;
+
+      // compute the corrections, the positions are only read here
+      int springId;
+      for(springId = 0; springId < colorSpringCount; springId++)
+      {
+        int slotA = pSlotA[firstSpringId + springId];
+        int slotB = pSlotB[firstSpringId + springId];
+
+        float dx = pX[slotB] - pX[slotA];
+        float dy = pY[slotB] - pY[slotA];
+        float dz = pZ[slotB] - pZ[slotA];
+
+        float length = (float)sqrt(dx * dx + dy * dy + dz * dz);
+
+        float factor = 0.0f;
+        if(length > 0.0f) factor = (length - pIdleLength[firstSpringId + springId]) / length;
+
+        pCorrectionX[springId] = dx * factor;
+        pCorrectionY[springId] = dy * factor;
+        pCorrectionZ[springId] = dz * factor;
+      }
+
+      // apply the corrections, no two springs of a color write the same slot
+      for(springId = 0; springId < colorSpringCount; springId++)
+      {
+        int slotA = pSlotA[firstSpringId + springId];
+        int slotB = pSlotB[firstSpringId + springId];
+        float factorA = pFactorA[firstSpringId + springId];
+        float factorB = pFactorB[firstSpringId + springId];
+
+        pX[slotA] += pCorrectionX[springId] * factorA;
+        pY[slotA] += pCorrectionY[springId] * factorA;
+        pZ[slotA] += pCorrectionZ[springId] * factorA;
+
+        pX[slotB] -= pCorrectionX[springId] * factorB;
+        pY[slotB] -= pCorrectionY[springId] * factorB;
+        pZ[slotB] -= pCorrectionZ[springId] * factorB;
+      }
+    }
+  }
+}
+
+ /*****************************************************************************/
+/** Sets the number of iterations.
+  *
+  * This function sets how many times the springs are relaxed per update.
+  * More iterations make the cloth stiffer at a higher cost.
+  *
+  * @param iterationCount The number of iterations.
+  *****************************************************************************/
+
+void CalCloth::setIterationCount(int iterationCount)
+{
+  if(iterationCount < 0) iterationCount = 0;
+
+  m_iterationCount = iterationCount;
+}
+
+ /*****************************************************************************/
+/** Sets the sleep threshold.
+  *
+  * This function sets the motion per step, in model units along any axis,
+  * below which the cloth counts as still. A threshold of 0 keeps the cloth
+  * from ever falling asleep.
+  *
+  * @param sleepThreshold The sleep threshold.
+  *****************************************************************************/
+
+void CalCloth::setSleepThreshold(float sleepThreshold)
+{
+  if(sleepThreshold < 0.0f) sleepThreshold = 0.0f;
+
+  m_sleepThreshold = sleepThreshold;
+
+  if(m_sleepThreshold == 0.0f) wakeUp();
+}
+
+ /*****************************************************************************/
+/** Sets the time step.
+  *
+  * This function sets the fixed time step the cloth advances in, and how
+  * many steps an update takes at most. Elapsed time beyond that is dropped,
+  * so a long frame slows the cloth down instead of making it unstable.
+  *
+  * @param timeStep The time step in seconds.
+  * @param maxSubstepCount The maximal number of steps per update.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCloth::setTimeStep(float timeStep, int maxSubstepCount)
+{
+  if((timeStep <= 0.0f) || (maxSubstepCount < 1))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalCloth::setTimeStep");
+    return false;
+  }
+
+  m_timeStep = timeStep;
+  m_maxSubstepCount = maxSubstepCount;
+  m_accumulatedTime = 0.0f;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Updates the cloth instance.
+  *
+  * This function adds the elapsed time to the cloth and spends it in fixed
+  * steps. Every step moves the pinned slots a part of the way towards the
+  * skinned vertices, integrates and relaxes the cloth. The positions of the
+  * free slots are then written back to the vertices. An asleep cloth is only
+  * woken up, and simulated, if one of its pinned slots moved.
+  *
+  * @param pVertex A pointer to the positions of the vertices of the submesh.
+  * @param deltaTime The elapsed time in seconds since the last update.
+  *****************************************************************************/
+
+void CalCloth::update(CalVector *pVertex, float deltaTime)
+{
+  int slotCount;
+  slotCount = m_pCoreCloth->getSlotCount();
+  if(slotCount == 0) return;
+
+  int freeSlotCount;
+  freeSlotCount = m_pCoreCloth->getFreeSlotCount();
+
+  const int *pVertexId = m_pCoreCloth->getVertexIds();
+
+  if(m_bSleeping && pinnedSlotsMoved(pVertex)) wakeUp();
+
+  int substepCount;
+  substepCount = 0;
+
+  if(!m_bSleeping)
+  {
+    // spend the elapsed time in whole steps and drop what exceeds the cap
+    m_accumulatedTime += deltaTime;
+
+    substepCount = (int)(m_accumulatedTime / m_timeStep);
+    if(substepCount > m_maxSubstepCount)
+    {
+      substepCount = m_maxSubstepCount;
+      m_accumulatedTime = substepCount * m_timeStep;
+    }
+
+    m_accumulatedTime -= substepCount * m_timeStep;
+  }
+
+  int substepId;
+  for(substepId = 0; substepId < substepCount; substepId++)
+  {
+    // the pinned slots follow the skinned vertices in even parts
+    float part = 1.0f / (substepCount - substepId);
+
+    int slotId;
+    for(slotId = freeSlotCount; slotId < slotCount; slotId++)
+    {
+      const CalVector& vertex = pVertex[pVertexId[slotId]];
+      m_vectorPositionX[slotId] += (vertex.x - m_vectorPositionX[slotId]) * part;
+      m_vectorPositionY[slotId] += (vertex.y - m_vectorPositionY[slotId]) * part;
+      m_vectorPositionZ[slotId] += (vertex.z - m_vectorPositionZ[slotId]) * part;
+    }
+
+    integrate(m_timeStep);
+    relax();
+
+    // fall asleep after enough still steps
+    if(m_sleepThreshold > 0.0f)
+    {
+      if(getMotion() < m_sleepThreshold)
+      {
+        m_stillStepCount++;
+      }
+      else
+      {
+        m_stillStepCount = 0;
+      }
+
+      if(m_stillStepCount >= Cal::SPRING_SLEEP_STEP_COUNT)
+      {
+        m_bSleeping = true;
+        m_accumulatedTime = 0.0f;
+
+        // an asleep cloth has no velocity left
+        m_vectorOldPositionX.assign(m_vectorPositionX.begin(), m_vectorPositionX.begin() + freeSlotCount);
+        m_vectorOldPositionY.assign(m_vectorPositionY.begin(), m_vectorPositionY.begin() + freeSlotCount);
+        m_vectorOldPositionZ.assign(m_vectorPositionZ.begin(), m_vectorPositionZ.begin() + freeSlotCount);
+        break;
+      }
+    }
+  }
+
+  int slotId;
+  for(slotId = 0; slotId < freeSlotCount; slotId++)
+  {
+    pVertex[pVertexId[slotId]].set(m_vectorPositionX[slotId], m_vectorPositionY[slotId], m_vectorPositionZ[slotId]);
+  }
+}
+
+ /*****************************************************************************/
+/** Wakes the cloth instance up.
+  *
+  * This function makes an asleep cloth simulate again from the next update
+  * on.
+  *****************************************************************************/
+
+void CalCloth::wakeUp()
+{
+  m_bSleeping = false;
+  m_stillStepCount = 0;
+  m_accumulatedTime = 0.0f;
+}
+
+//****************************************************************************//
@@ -0,0 +1,107 @@
+//****************************************************************************//
+// cloth.h                                                                    //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_CLOTH_H
+#define CAL_CLOTH_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+#include "calvector.h"
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalCoreCloth;
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The cloth class.
+  *
+  * A cloth is the Verlet solver of the spring system of a submesh instance.
+  * It keeps the positions of the slots of its core cloth (see CalCoreCloth)
+  * as separate x, y and z arrays. Every update copies the skinned positions
+  * of the pinned slots in, integrates the free slots in one pass without
+  * tests, relaxes the springs a configurable number of times, and writes the
+  * free slots back to the vertices of the submesh.
+  *
+  * The springs are relaxed one color at a time. The corrections of a color
+  * are all computed before any is applied, which gives the same result as
+  * relaxing its springs one by one, but keeps the costly part of the loop
+  * free of stores that could alias its loads.
+  *
+  * The cloth advances in fixed time steps. The elapsed time is accumulated
+  * and spent in whole steps, at most a given number per update, with the
+  * pinned slots moving in even parts towards their new positions. A cloth
+  * whose free slots stay below the sleep threshold for a number of steps
+  * falls asleep and is not simulated until one of its pinned slots moves.
+  *****************************************************************************/
+
+class CAL3D_API CalCloth
+{
+// member variables
+protected:
+  CalCoreCloth *m_pCoreCloth;
+  std::vector<float> m_vectorPositionX;
+  std::vector<float> m_vectorPositionY;
+  std::vector<float> m_vectorPositionZ;
+  std::vector<float> m_vectorOldPositionX;
+  std::vector<float> m_vectorOldPositionY;
+  std::vector<float> m_vectorOldPositionZ;
+  std::vector<float> m_vectorCorrectionX;
+  std::vector<float> m_vectorCorrectionY;
+  std::vector<float> m_vectorCorrectionZ;
+  int m_iterationCount;
+  float m_timeStep;
+  int m_maxSubstepCount;
+  float m_accumulatedTime;
+  float m_sleepThreshold;
+  int m_stillStepCount;
+  bool m_bSleeping;
+
+// constructors/destructor
+public:
+  CalCloth();
+  virtual ~CalCloth();
+
+// member functions
+public:
+  bool create(CalCoreCloth *pCoreCloth, const CalVector *pVertex);
+  void destroy();
+  CalCoreCloth *getCoreCloth();
+  int getIterationCount();
+  int getMaxSubstepCount();
+  void getOldPosition(int slotId, CalVector& position);
+  void getPosition(int slotId, CalVector& position);
+  float getSleepThreshold();
+  float getTimeStep();
+  bool isSleeping();
+  void setIterationCount(int iterationCount);
+  void setSleepThreshold(float sleepThreshold);
+  bool setTimeStep(float timeStep, int maxSubstepCount);
+  void update(CalVector *pVertex, float deltaTime);
+  void wakeUp();
+
+protected:
+  float getMotion();
+  void integrate(float deltaTime);
+  bool pinnedSlotsMoved(const CalVector *pVertex);
+  void relax();
+};
+
+#endif
+
+//****************************************************************************//
@@ -18,6 +18,9 @@
 
 #include "calcoreanim.h"
 #include "calcoretrack.h"
+#include "calcorekey.h"
+#include "calpose.h"
+#include "calquat.h"
 
  /*****************************************************************************/
 /** Constructs the core animation instance.
@@ -27,11 +30,12 @@
 
 CalCoreAnimation::CalCoreAnimation()
 {
+  m_interpolationMode = INTERPOLATE_DEFAULT;
 }
 
 CalCoreAnimation::~CalCoreAnimation()
 {
-  assert(m_listCoreTrack.empty());
+  assert(m_vectorCoreTrack.empty());
 }
 
 CalCoreAnimation *CalCoreAnimation::Alloc(void) { return new CalCoreAnimation; }
@@ -40,7 +44,9 @@ void CalCoreAnimation::Free(CalCoreAnimation *x) { delete x; }
  /*****************************************************************************/
 /** Adds a core track.
   *
-  * This function adds a core track to the core animation instance.
+  * This function adds a core track to the core animation instance. The core
+  * track has to be allocated with CalCoreTrack::Alloc(), preferably in the
+  * arena of the core animation instance.
   *
   * @param pCoreTrack A pointer to the core track that should be added.
   *
@@ -51,7 +57,7 @@ void CalCoreAnimation::Free(CalCoreAnimation *x) { delete x; }
 
 bool CalCoreAnimation::addCoreTrack(CalCoreTrack *pCoreTrack)
 {
-  m_listCoreTrack.push_back(pCoreTrack);
+  m_vectorCoreTrack.push_back(pCoreTrack);
 
   return true;
 }
@@ -69,6 +75,8 @@ bool CalCoreAnimation::addCoreTrack(CalCoreTrack *pCoreTrack)
 bool CalCoreAnimation::create(const char *strName)
 {
   m_strName = strName;
+
+  if(!m_arena.create()) return false;
   
   return true;
 }
@@ -77,21 +85,36 @@ bool CalCoreAnimation::create(const char *strName)
 /** Destroys the core animation instance.
   *
   * This function destroys all data stored in the core animation instance and
-  * frees all allocated memory.
+  * frees all allocated memory. The tracks and keyframes in the arena are not
+  * freed one by one; the arena releases its blocks at once.
   *****************************************************************************/
 
 void CalCoreAnimation::destroy()
 {
   // destroy all core tracks
-  while(!m_listCoreTrack.empty())
+  std::vector<CalCoreTrack *>::iterator iteratorCoreTrack;
+  for(iteratorCoreTrack = m_vectorCoreTrack.begin(); iteratorCoreTrack != m_vectorCoreTrack.end(); ++iteratorCoreTrack)
   {
-    CalCoreTrack *pCoreTrack;
-    pCoreTrack = m_listCoreTrack.front();
-    m_listCoreTrack.pop_front();
-
-    pCoreTrack->destroy();
-    delete pCoreTrack;
+    (*iteratorCoreTrack)->destroy();
+    CalCoreTrack::Free(*iteratorCoreTrack);
   }
+  m_vectorCoreTrack.clear();
+
+  m_arena.destroy();
+}
+
+ /*****************************************************************************/
+/** Returns the arena.
+  *
+  * This function returns the arena that holds the core tracks and keyframes
+  * of the core animation instance.
+  *
+  * @return A pointer to the arena.
+  *****************************************************************************/
+
+CalArena *CalCoreAnimation::getArena()
+{
+  return &m_arena;
 }
 
  /*****************************************************************************/
@@ -108,17 +131,187 @@ float CalCoreAnimation::getDuration()
 }
 
  /*****************************************************************************/
-/** Returns the core track list.
+/** Returns the memory size.
+  *
+  * This function returns the memory used by the core animation instance,
+  * its arena and the core tracks that are not in the arena.
+  *
+  * @return The memory size in bytes.
+  *****************************************************************************/
+
+int CalCoreAnimation::getMemorySize()
+{
+  int size;
+  size = sizeof(CalCoreAnimation) + m_strName.capacity() + m_arena.getAllocatedSize();
+  size += m_vectorCoreTrack.capacity() * sizeof(CalCoreTrack *);
+
+  std::vector<CalCoreTrack *>::iterator iteratorCoreTrack;
+  for(iteratorCoreTrack = m_vectorCoreTrack.begin(); iteratorCoreTrack != m_vectorCoreTrack.end(); ++iteratorCoreTrack)
+  {
+    size += (*iteratorCoreTrack)->getMemorySize();
+  }
+
+  return size;
+}
+
+ /*****************************************************************************/
+/** Measures the error of an interpolation mode.
+  *
+  * This function blends every pair of neighbouring keyframes of all tracks
+  * with the given mode and with the exact slerp, at a few blend factors
+  * between the keys, and returns the largest angle between the two results.
+  * It tells whether a faster mode is accurate enough for this animation.
+  *
+  * @param mode One of INTERPOLATE_SLERP, INTERPOLATE_NLERP or
+  *             INTERPOLATE_FAST_SLERP.
+  *
+  * @return The largest angular error in radians.
+  *****************************************************************************/
+
+float CalCoreAnimation::getInterpolationError(int mode)
+{
+  float maxError;
+  maxError = 0.0f;
+
+  int trackId;
+  for(trackId = 0; trackId < (int)m_vectorCoreTrack.size(); trackId++)
+  {
+    CalCoreTrack *pCoreTrack = m_vectorCoreTrack[trackId];
+
+    int keyframeId;
+    for(keyframeId = 0; keyframeId + 1 < pCoreTrack->getCoreKeyframeCount(); keyframeId++)
+    {
+      const CalQuaternion& rotationBefore = pCoreTrack->getCoreKeyframe(keyframeId)->getRotation();
+      const CalQuaternion& rotationAfter = pCoreTrack->getCoreKeyframe(keyframeId + 1)->getRotation();
+
+      int sampleId;
+      for(sampleId = 1; sampleId < 8; sampleId++)
+      {
+        float blendFactor = sampleId / 8.0f;
+
+        CalQuaternion exact = rotationBefore;
+        exact.blend(blendFactor, rotationAfter);
+
+        CalQuaternion approximate = rotationBefore;
+        approximate.blend(blendFactor, rotationAfter, mode);
+
+        // q and -q are the same rotation
+        double sign = 1.0;
+        if(exact.x * approximate.x + exact.y * approximate.y + exact.z * approximate.z + exact.w * approximate.w < 0.0f) sign = -1.0;
+
+        // the chord is precise for small angles, where acos of the dot product is not
+        double dx = exact.x - sign * approximate.x;
+        double dy = exact.y - sign * approximate.y;
+        double dz = exact.z - sign * approximate.z;
+        double dw = exact.w - sign * approximate.w;
+
+        double chord = sqrt(dx * dx + dy * dy + dz * dz + dw * dw) * 0.5;
+        if(chord > 1.0) chord = 1.0;
+
+        float error = (float)(4.0 * asin(chord));
+        if(error > maxError) maxError = error;
+      }
+    }
+  }
+
+  return maxError;
+}
+
+ /*****************************************************************************/
+/** Returns the interpolation mode.
+  *
+  * This function returns the quaternion interpolation mode used to sample the
+  * tracks of the core animation instance.
   *
-  * This function returns the list that contains all core tracks of the core
+  * @return The interpolation mode, or INTERPOLATE_DEFAULT if the mode of the
+  *         model is used.
+  *****************************************************************************/
+
+int CalCoreAnimation::getInterpolationMode()
+{
+  return m_interpolationMode;
+}
+
+ /*****************************************************************************/
+/** Returns the core track vector.
+  *
+  * This function returns the vector that contains all core tracks of the core
   * animation instance.
   *
-  * @return A reference to the core track list.
+  * @return A reference to the core track vector.
+  *****************************************************************************/
+
+std::vector<CalCoreTrack *>& CalCoreAnimation::getVectorCoreTrack()
+{
+  return m_vectorCoreTrack;
+}
+
+ /*****************************************************************************/
+/** Reserves memory for the core tracks.
+  *
+  * This function reserves memory for a given number of core tracks.
+  *
+  * @param coreTrackCount The number of core tracks.
+  *****************************************************************************/
+
+void CalCoreAnimation::reserve(int coreTrackCount)
+{
+  m_vectorCoreTrack.reserve(coreTrackCount);
+}
+
+ /*****************************************************************************/
+/** Samples all core tracks into a pose.
+  *
+  * This function samples the state of every core track of the core animation
+  * instance at the specified time. The keyframes of all tracks are gathered
+  * first, then interpolated together by CalPose::interpolate().
+  *
+  * @param time The time in seconds at which the pose should be sampled.
+  * @param pose A reference to the pose that will be filled with one state per
+  *             core track, in the order of the core track vector.
+  * @param mode The quaternion interpolation mode, or INTERPOLATE_DEFAULT to
+  *             use the mode of the core animation instance.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
   *****************************************************************************/
 
-std::list<CalCoreTrack *>& CalCoreAnimation::getListCoreTrack()
+bool CalCoreAnimation::samplePose(float time, CalPose& pose, int mode)
 {
-  return m_listCoreTrack;
+  if(mode == INTERPOLATE_DEFAULT) mode = m_interpolationMode;
+
+  int trackCount;
+  trackCount = m_vectorCoreTrack.size();
+  pose.setTrackCount(trackCount);
+
+  // gather the keyframes of every core track
+  int trackId;
+  for(trackId = 0; trackId < trackCount; trackId++)
+  {
+    // a track without keyframes is skipped, the others are still sampled
+    if(m_vectorCoreTrack[trackId]->getCoreKeyframeCount() == 0)
+    {
+      pose.clearKeyframes(trackId);
+      continue;
+    }
+
+    CalCoreKeyframe *pCoreKeyframeBefore;
+    CalCoreKeyframe *pCoreKeyframeAfter;
+    float blendFactor;
+    if(!m_vectorCoreTrack[trackId]->getKeyframes(time, m_duration, pCoreKeyframeBefore, pCoreKeyframeAfter, blendFactor))
+    {
+      pose.setTrackCount(0);
+      return false;
+    }
+
+    pose.setKeyframes(trackId, pCoreKeyframeBefore, pCoreKeyframeAfter, blendFactor);
+  }
+
+  // interpolate all core tracks at once
+  pose.interpolate(mode);
+
+  return true;
 }
 
  /*****************************************************************************/
@@ -134,4 +327,22 @@ void CalCoreAnimation::setDuration(float duration)
   m_duration = duration;
 }
 
+ /*****************************************************************************/
+/** Sets the interpolation mode.
+  *
+  * This function sets the quaternion interpolation mode used to sample the
+  * tracks of the core animation instance. Cheap modes suit densely keyed
+  * animations, where neighbouring keys are only a few degrees apart (see
+  * getInterpolationError).
+  *
+  * @param mode One of INTERPOLATE_SLERP, INTERPOLATE_NLERP or
+  *             INTERPOLATE_FAST_SLERP, or INTERPOLATE_DEFAULT to use the mode
+  *             of the model the animation is blended into.
+  *****************************************************************************/
+
+void CalCoreAnimation::setInterpolationMode(int mode)
+{
+  m_interpolationMode = mode;
+}
+
 //****************************************************************************//
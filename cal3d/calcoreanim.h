@@ -16,12 +16,15 @@
 //****************************************************************************//
 
 #include "calglobal.h"
+#include "calquat.h"
+#include "calarena.h"
 
 //****************************************************************************//
 // Forward declarations                                                       //
 //****************************************************************************//
 
 class CalCoreTrack;
+class CalPose;
 
 //****************************************************************************//
 // Class declaration                                                          //
@@ -37,7 +40,9 @@ class CAL3D_API CalCoreAnimation: public CalCoreAnimationUserData
 protected:
   std::string m_strName;
   float m_duration;
-  std::list<CalCoreTrack *> m_listCoreTrack;
+  int m_interpolationMode;
+  std::vector<CalCoreTrack *> m_vectorCoreTrack;
+  CalArena m_arena;
 
 // constructors/destructor
 public:
@@ -51,9 +56,16 @@ public:
   bool addCoreTrack(CalCoreTrack *pCoreTrack);
   bool create(const char *strName);
   void destroy();
+  CalArena *getArena();
   float getDuration();
-  std::list<CalCoreTrack *>& getListCoreTrack();
+  float getInterpolationError(int mode);
+  int getInterpolationMode();
+  int getMemorySize();
+  std::vector<CalCoreTrack *>& getVectorCoreTrack();
+  void reserve(int coreTrackCount);
+  bool samplePose(float time, CalPose& pose, int mode = INTERPOLATE_DEFAULT);
   void setDuration(float duration);
+  void setInterpolationMode(int mode);
 };
 
 #endif
@@ -19,6 +19,7 @@
 #include "calerror.h"
 #include "calcorebone.h"
 #include "calcoremodel.h"
+#include "calnametable.h"
 
  /*****************************************************************************/
 /** Constructs the core bone instance.
@@ -28,6 +29,7 @@
 
 CalCoreBone::CalCoreBone()
 {
+  m_nameId = -1;
   m_pCoreModel = 0;
   m_parentId = -1;
 }
@@ -105,7 +107,8 @@ void CalCoreBone::calculateState()
  /*****************************************************************************/
 /** Creates the core bone instance.
   *
-  * This function creates the core bone instance.
+  * This function creates the core bone instance. The name is interned in
+  * the name table.
   *
   * @param strName A string that should be used as the name of the core bone
   *                instance.
@@ -117,7 +120,7 @@ void CalCoreBone::calculateState()
 
 bool CalCoreBone::create(const std::string& strName)
 {
-  m_strName = strName;
+  m_nameId = CalNameTable::intern(strName);
 
   return true;
 }
@@ -135,7 +138,7 @@ void CalCoreBone::destroy()
   m_listChildId.clear();
 
   m_parentId = -1;
-  m_strName.erase();
+  m_nameId = -1;
 }
 
  /*****************************************************************************/
@@ -162,7 +165,23 @@ std::list<int>& CalCoreBone::getListChildId()
 
 const std::string& CalCoreBone::getName()
 {
-  return m_strName;
+  return CalNameTable::getName(m_nameId);
+}
+
+ /*****************************************************************************/
+/** Returns the name ID.
+  *
+  * This function returns the ID of the name of the core bone instance in the
+  * name table.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the name
+  *         \li \b -1 if the core bone instance has no name
+  *****************************************************************************/
+
+int CalCoreBone::getNameId()
+{
+  return m_nameId;
 }
 
  /*****************************************************************************/
@@ -180,6 +199,20 @@ int CalCoreBone::getParentId()
   return m_parentId;
 }
 
+ /*****************************************************************************/
+/** Returns the memory size.
+  *
+  * This function returns the memory used by the core bone instance, with an
+  * estimate for the nodes of its child list.
+  *
+  * @return The memory size in bytes.
+  *****************************************************************************/
+
+int CalCoreBone::getMemorySize()
+{
+  return sizeof(CalCoreBone) + m_listChildId.size() * (sizeof(int) + 2 * sizeof(void *));
+}
+
  /*****************************************************************************/
 /** Returns the length.
   *
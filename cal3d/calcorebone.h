@@ -33,7 +33,7 @@ class CAL3D_API CalCoreBone: public CalCoreBoneUserData
 {
 // member variables
 protected:
-  std::string m_strName;
+  int m_nameId;
   CalCoreModel *m_pCoreModel;
   int m_parentId;
   std::list<int> m_listChildId;
@@ -58,8 +58,10 @@ public:
   void destroy();
   std::list<int>& getListChildId();
   const std::string& getName();
+  int getNameId();
   int getParentId();
   float getLength();
+  int getMemorySize();
   const CalQuaternion& getRotation();
   const CalQuaternion& getRotationAbsolute();
   const CalQuaternion& getRotationBoneSpace();
@@ -0,0 +1,550 @@
+//****************************************************************************//
+// corecloth.cpp                                                              //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calcorecloth.h"
+#include "calerror.h"
+#include "calcoresub.h"
+
+ /*****************************************************************************/
+/** Constructs the core cloth instance.
+  *
+  * This function is the default constructor of the core cloth instance.
+  *****************************************************************************/
+
+CalCoreCloth::CalCoreCloth()
+{
+  m_freeSlotCount = 0;
+}
+
+ /*****************************************************************************/
+/** Destructs the core cloth instance.
+  *
+  * This function is the destructor of the core cloth instance.
+  *****************************************************************************/
+
+CalCoreCloth::~CalCoreCloth()
+{
+}
+
+ /*****************************************************************************/
+/** Colors the springs.
+  *
+  * This function gives every spring the lowest color that no earlier spring
+  * sharing a free slot with it has, and sorts the springs by color, keeping
+  * their order within a color. Pinned slots are only read by the solver, so
+  * springs may share them within a color.
+  *****************************************************************************/
+
+void CalCoreCloth::colorSprings()
+{
+  int springCount;
+  springCount = m_vectorSpringSlotA.size();
+
+  // list the springs at every free slot
+  std::vector<int> vectorSlotSpringOffset(m_freeSlotCount + 1, 0);
+
+  int springId;
+  for(springId = 0; springId < springCount; springId++)
+  {
+    if(m_vectorSpringSlotA[springId] < m_freeSlotCount) vectorSlotSpringOffset[m_vectorSpringSlotA[springId] + 1]++;
+    if(m_vectorSpringSlotB[springId] < m_freeSlotCount) vectorSlotSpringOffset[m_vectorSpringSlotB[springId] + 1]++;
+  }
+
+  int slotId;
+  for(slotId = 0; slotId < m_freeSlotCount; slotId++)
+  {
+    vectorSlotSpringOffset[slotId + 1] += vectorSlotSpringOffset[slotId];
+  }
+
+  std::vector<int> vectorSlotSpring(vectorSlotSpringOffset[m_freeSlotCount]);
+  std::vector<int> vectorSlotSpringCount(m_freeSlotCount, 0);
+  for(springId = 0; springId < springCount; springId++)
+  {
+    int slotA = m_vectorSpringSlotA[springId];
+    if(slotA < m_freeSlotCount) vectorSlotSpring[vectorSlotSpringOffset[slotA] + vectorSlotSpringCount[slotA]++] = springId;
+
+    int slotB = m_vectorSpringSlotB[springId];
+    if(slotB < m_freeSlotCount) vectorSlotSpring[vectorSlotSpringOffset[slotB] + vectorSlotSpringCount[slotB]++] = springId;
+  }
+
+  // give every spring the lowest color its neighbours do not have yet
+  std::vector<int> vectorColor(springCount, -1);
+  std::vector<int> vectorColorMark;
+  std::vector<int> vectorColorSpringCount;
+
+  for(springId = 0; springId < springCount; springId++)
+  {
+    int endId;
+    for(endId = 0; endId < 2; endId++)
+    {
+      int slot = (endId == 0) ? m_vectorSpringSlotA[springId] : m_vectorSpringSlotB[springId];
+      if(slot >= m_freeSlotCount) continue;
+
+      int neighbourId;
+      for(neighbourId = vectorSlotSpringOffset[slot]; neighbourId < vectorSlotSpringOffset[slot + 1]; neighbourId++)
+      {
+        int color = vectorColor[vectorSlotSpring[neighbourId]];
+        if(color >= 0) vectorColorMark[color] = springId;
+      }
+    }
+
+    int color;
+    for(color = 0; color < (int)vectorColorMark.size(); color++)
+    {
+      if(vectorColorMark[color] != springId) break;
+    }
+
+    if(color == (int)vectorColorMark.size())
+    {
+      vectorColorMark.push_back(-1);
+      vectorColorSpringCount.push_back(0);
+    }
+
+    vectorColor[springId] = color;
+    vectorColorSpringCount[color]++;
+  }
+
+  // sort the springs by color
+  int colorCount;
+  colorCount = vectorColorSpringCount.size();
+
+  m_vectorColorOffset.assign(colorCount + 1, 0);
+
+  int color;
+  for(color = 0; color < colorCount; color++)
+  {
+    m_vectorColorOffset[color + 1] = m_vectorColorOffset[color] + vectorColorSpringCount[color];
+  }
+
+  std::vector<int> vectorNextSpringId(m_vectorColorOffset.begin(), m_vectorColorOffset.end() - 1);
+  std::vector<int> vectorSpringSlotA(springCount);
+  std::vector<int> vectorSpringSlotB(springCount);
+  std::vector<float> vectorSpringIdleLength(springCount);
+  std::vector<float> vectorSpringFactorA(springCount);
+  std::vector<float> vectorSpringFactorB(springCount);
+
+  for(springId = 0; springId < springCount; springId++)
+  {
+    int newSpringId = vectorNextSpringId[vectorColor[springId]]++;
+    vectorSpringSlotA[newSpringId] = m_vectorSpringSlotA[springId];
+    vectorSpringSlotB[newSpringId] = m_vectorSpringSlotB[springId];
+    vectorSpringIdleLength[newSpringId] = m_vectorSpringIdleLength[springId];
+    vectorSpringFactorA[newSpringId] = m_vectorSpringFactorA[springId];
+    vectorSpringFactorB[newSpringId] = m_vectorSpringFactorB[springId];
+  }
+
+  m_vectorSpringSlotA.swap(vectorSpringSlotA);
+  m_vectorSpringSlotB.swap(vectorSpringSlotB);
+  m_vectorSpringIdleLength.swap(vectorSpringIdleLength);
+  m_vectorSpringFactorA.swap(vectorSpringFactorA);
+  m_vectorSpringFactorB.swap(vectorSpringFactorB);
+}
+
+ /*****************************************************************************/
+/** Creates the core cloth instance.
+  *
+  * This function builds the slots and springs of the core cloth instance from
+  * the physical properties and springs of a core submesh.
+  *
+  * @param pCoreSubmesh A pointer to the core submesh.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreCloth::create(CalCoreSubmesh *pCoreSubmesh)
+{
+  destroy();
+
+  if(pCoreSubmesh == 0)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalCoreCloth::create");
+    return false;
+  }
+
+  std::vector<CalCoreSubmesh::PhysicalProperty>& vectorPhysicalProperty = pCoreSubmesh->getVectorPhysicalProperty();
+  std::vector<CalCoreSubmesh::Spring>& vectorSpring = pCoreSubmesh->getVectorSpring();
+
+  int vertexCount;
+  vertexCount = vectorPhysicalProperty.size();
+
+  // check the springs before anything is built
+  int springId;
+  for(springId = 0; springId < (int)vectorSpring.size(); springId++)
+  {
+    const CalCoreSubmesh::Spring& spring = vectorSpring[springId];
+    if((spring.vertexId[0] < 0) || (spring.vertexId[0] >= vertexCount) || (spring.vertexId[1] < 0) || (spring.vertexId[1] >= vertexCount))
+    {
+      CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalCoreCloth::create");
+      return false;
+    }
+  }
+
+  // the free vertices get the first slots
+  std::vector<int> vectorSlot(vertexCount, -1);
+
+  int vertexId;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    if(vectorPhysicalProperty[vertexId].weight > 0.0f)
+    {
+      vectorSlot[vertexId] = m_vectorVertexId.size();
+      m_vectorVertexId.push_back(vertexId);
+      m_vectorInverseWeight.push_back(1.0f / vectorPhysicalProperty[vertexId].weight);
+    }
+  }
+
+  m_freeSlotCount = m_vectorVertexId.size();
+
+  // the pinned vertices are left to skinning, in ranges
+  std::vector<CalCoreSubmesh::Vertex>& vectorVertex = pCoreSubmesh->getVectorVertex();
+
+  int influenceId;
+  influenceId = 0;
+
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    if(vectorSlot[vertexId] == -1)
+    {
+      if(m_vectorPinnedRange.empty() || (m_vectorPinnedRange.back().vertexId + m_vectorPinnedRange.back().vertexCount != vertexId))
+      {
+        PinnedRange pinnedRange;
+        pinnedRange.vertexId = vertexId;
+        pinnedRange.vertexCount = 0;
+        pinnedRange.influenceId = influenceId;
+        m_vectorPinnedRange.push_back(pinnedRange);
+      }
+
+      m_vectorPinnedRange.back().vertexCount++;
+    }
+
+    influenceId += vectorVertex[vertexId].influenceCount;
+  }
+
+  // the pinned vertices that anchor a spring get the remaining slots
+  for(springId = 0; springId < (int)vectorSpring.size(); springId++)
+  {
+    const CalCoreSubmesh::Spring& spring = vectorSpring[springId];
+
+    bool bFreeA;
+    bFreeA = (vectorPhysicalProperty[spring.vertexId[0]].weight > 0.0f);
+
+    bool bFreeB;
+    bFreeB = (vectorPhysicalProperty[spring.vertexId[1]].weight > 0.0f);
+
+    if(!bFreeA && !bFreeB) continue;
+
+    int endId;
+    for(endId = 0; endId < 2; endId++)
+    {
+      if(vectorSlot[spring.vertexId[endId]] == -1)
+      {
+        vectorSlot[spring.vertexId[endId]] = m_vectorVertexId.size();
+        m_vectorVertexId.push_back(spring.vertexId[endId]);
+      }
+    }
+
+    // a free end moves half the correction, or all of it against a pinned end
+    m_vectorSpringSlotA.push_back(vectorSlot[spring.vertexId[0]]);
+    m_vectorSpringSlotB.push_back(vectorSlot[spring.vertexId[1]]);
+    m_vectorSpringIdleLength.push_back(spring.idleLength);
+    m_vectorSpringFactorA.push_back(bFreeA ? (bFreeB ? 0.5f : 1.0f) : 0.0f);
+    m_vectorSpringFactorB.push_back(bFreeB ? (bFreeA ? 0.5f : 1.0f) : 0.0f);
+  }
+
+  colorSprings();
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the core cloth instance.
+  *
+  * This function destroys all data stored in the core cloth instance and
+  * frees all allocated memory.
+  *****************************************************************************/
+
+void CalCoreCloth::destroy()
+{
+  std::vector<int>().swap(m_vectorVertexId);
+  m_freeSlotCount = 0;
+  std::vector<float>().swap(m_vectorInverseWeight);
+  std::vector<int>().swap(m_vectorSpringSlotA);
+  std::vector<int>().swap(m_vectorSpringSlotB);
+  std::vector<float>().swap(m_vectorSpringIdleLength);
+  std::vector<float>().swap(m_vectorSpringFactorA);
+  std::vector<float>().swap(m_vectorSpringFactorB);
+  std::vector<int>().swap(m_vectorColorOffset);
+  std::vector<PinnedRange>().swap(m_vectorPinnedRange);
+}
+
+ /*****************************************************************************/
+/** Returns the number of colors.
+  *
+  * This function returns the number of colors of the springs.
+  *
+  * @return The number of colors.
+  *****************************************************************************/
+
+int CalCoreCloth::getColorCount()
+{
+  if(m_vectorColorOffset.empty()) return 0;
+
+  return m_vectorColorOffset.size() - 1;
+}
+
+ /*****************************************************************************/
+/** Provides access to the color offsets.
+  *
+  * This function returns the ID of the first spring of every color, followed
+  * by the number of springs. The springs of color n are the springs from
+  * offset n up to offset n + 1.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the color offsets
+  *         \li \b 0 if there are no springs
+  *****************************************************************************/
+
+int *CalCoreCloth::getColorOffsets()
+{
+  if(m_vectorColorOffset.empty()) return 0;
+
+  return &m_vectorColorOffset[0];
+}
+
+ /*****************************************************************************/
+/** Returns the number of free slots.
+  *
+  * This function returns the number of slots of free vertices. They are the
+  * first slots of the core cloth instance.
+  *
+  * @return The number of free slots.
+  *****************************************************************************/
+
+int CalCoreCloth::getFreeSlotCount()
+{
+  return m_freeSlotCount;
+}
+
+ /*****************************************************************************/
+/** Provides access to the inverse weights.
+  *
+  * This function returns the inverse weights of the free slots.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the inverse weights
+  *         \li \b 0 if there are no free slots
+  *****************************************************************************/
+
+float *CalCoreCloth::getInverseWeights()
+{
+  if(m_vectorInverseWeight.empty()) return 0;
+
+  return &m_vectorInverseWeight[0];
+}
+
+ /*****************************************************************************/
+/** Returns the memory size.
+  *
+  * This function returns the number of bytes allocated by the core cloth
+  * instance.
+  *
+  * @return The memory size.
+  *****************************************************************************/
+
+int CalCoreCloth::getMemorySize()
+{
+  int size;
+  size = m_vectorVertexId.capacity() * sizeof(int);
+  size += m_vectorInverseWeight.capacity() * sizeof(float);
+  size += m_vectorSpringSlotA.capacity() * sizeof(int);
+  size += m_vectorSpringSlotB.capacity() * sizeof(int);
+  size += m_vectorSpringIdleLength.capacity() * sizeof(float);
+  size += m_vectorSpringFactorA.capacity() * sizeof(float);
+  size += m_vectorSpringFactorB.capacity() * sizeof(float);
+  size += m_vectorColorOffset.capacity() * sizeof(int);
+  size += m_vectorPinnedRange.capacity() * sizeof(PinnedRange);
+
+  return size;
+}
+
+ /*****************************************************************************/
+/** Returns the number of pinned ranges.
+  *
+  * This function returns the number of ranges of pinned vertices.
+  *
+  * @return The number of pinned ranges.
+  *****************************************************************************/
+
+int CalCoreCloth::getPinnedRangeCount()
+{
+  return m_vectorPinnedRange.size();
+}
+
+ /*****************************************************************************/
+/** Provides access to the pinned ranges.
+  *
+  * This function returns the ranges of pinned vertices, in the order of
+  * their vertex IDs.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the pinned ranges
+  *         \li \b 0 if there are no pinned vertices
+  *****************************************************************************/
+
+CalCoreCloth::PinnedRange *CalCoreCloth::getPinnedRanges()
+{
+  if(m_vectorPinnedRange.empty()) return 0;
+
+  return &m_vectorPinnedRange[0];
+}
+
+ /*****************************************************************************/
+/** Returns the number of slots.
+  *
+  * This function returns the number of slots, free and pinned, of the core
+  * cloth instance.
+  *
+  * @return The number of slots.
+  *****************************************************************************/
+
+int CalCoreCloth::getSlotCount()
+{
+  return m_vectorVertexId.size();
+}
+
+ /*****************************************************************************/
+/** Returns the number of springs.
+  *
+  * This function returns the number of springs the solver relaxes.
+  *
+  * @return The number of springs.
+  *****************************************************************************/
+
+int CalCoreCloth::getSpringCount()
+{
+  return m_vectorSpringSlotA.size();
+}
+
+ /*****************************************************************************/
+/** Provides access to the correction factors of the first spring ends.
+  *
+  * This function returns the part of the length correction of every spring
+  * that moves its first end: 0.0 for a pinned end, 0.5 if both ends are free
+  * and 1.0 if the other end is pinned.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the factors
+  *         \li \b 0 if there are no springs
+  *****************************************************************************/
+
+float *CalCoreCloth::getSpringFactorsA()
+{
+  if(m_vectorSpringFactorA.empty()) return 0;
+
+  return &m_vectorSpringFactorA[0];
+}
+
+ /*****************************************************************************/
+/** Provides access to the correction factors of the second spring ends.
+  *
+  * This function returns the part of the length correction of every spring
+  * that moves its second end. See getSpringFactorsA().
+  *
+  * @return One of the following values:
+  *         \li a pointer to the factors
+  *         \li \b 0 if there are no springs
+  *****************************************************************************/
+
+float *CalCoreCloth::getSpringFactorsB()
+{
+  if(m_vectorSpringFactorB.empty()) return 0;
+
+  return &m_vectorSpringFactorB[0];
+}
+
+ /*****************************************************************************/
+/** Provides access to the idle lengths.
+  *
+  * This function returns the idle lengths of the springs.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the idle lengths
+  *         \li \b 0 if there are no springs
+  *****************************************************************************/
+
+float *CalCoreCloth::getSpringIdleLengths()
+{
+  if(m_vectorSpringIdleLength.empty()) return 0;
+
+  return &m_vectorSpringIdleLength[0];
+}
+
+ /*****************************************************************************/
+/** Provides access to the slots of the first spring ends.
+  *
+  * This function returns the slots of the first ends of the springs.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the slots
+  *         \li \b 0 if there are no springs
+  *****************************************************************************/
+
+int *CalCoreCloth::getSpringSlotsA()
+{
+  if(m_vectorSpringSlotA.empty()) return 0;
+
+  return &m_vectorSpringSlotA[0];
+}
+
+ /*****************************************************************************/
+/** Provides access to the slots of the second spring ends.
+  *
+  * This function returns the slots of the second ends of the springs.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the slots
+  *         \li \b 0 if there are no springs
+  *****************************************************************************/
+
+int *CalCoreCloth::getSpringSlotsB()
+{
+  if(m_vectorSpringSlotB.empty()) return 0;
+
+  return &m_vectorSpringSlotB[0];
+}
+
+ /*****************************************************************************/
+/** Provides access to the vertex IDs.
+  *
+  * This function returns the ID of the core submesh vertex of every slot.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the vertex IDs
+  *         \li \b 0 if there are no slots
+  *****************************************************************************/
+
+int *CalCoreCloth::getVertexIds()
+{
+  if(m_vectorVertexId.empty()) return 0;
+
+  return &m_vectorVertexId[0];
+}
+
+//****************************************************************************//
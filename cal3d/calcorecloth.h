@@ -0,0 +1,108 @@
+//****************************************************************************//
+// corecloth.h                                                                //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_CORECLOTH_H
+#define CAL_CORECLOTH_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalCoreSubmesh;
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The core cloth class.
+  *
+  * A core cloth holds the spring system of a core submesh in the form the
+  * cloth solver (see CalCloth) runs on. Every vertex the solver touches gets
+  * a slot: the free vertices, those with a weight > 0, come first, followed
+  * by the pinned vertices that anchor a spring. The springs are stored as
+  * separate arrays of slots, idle lengths and correction factors, where the
+  * factors replace the per-spring tests on the weights of both ends. Springs
+  * between two pinned vertices have no effect and are left out.
+  *
+  * The springs are graph colored and sorted by color, so no two springs of
+  * one color share a free slot. The springs of a color can be solved in any
+  * order, or all at once, with the same result as solving them one by one
+  * in the sorted order.
+  *
+  * The pinned vertices of the submesh, those skinning has to transform, are
+  * kept as ranges of vertex IDs with the ID of their first influence. A
+  * submesh whose vertices are partitioned (see
+  * CalCoreSubmesh::partitionVertices) has a single pinned range.
+  *****************************************************************************/
+
+class CAL3D_API CalCoreCloth
+{
+// misc
+public:
+  /// A range of pinned vertices.
+  struct PinnedRange
+  {
+    int vertexId;
+    int vertexCount;
+    int influenceId;
+  };
+
+// member variables
+protected:
+  std::vector<int> m_vectorVertexId;
+  int m_freeSlotCount;
+  std::vector<float> m_vectorInverseWeight;
+  std::vector<int> m_vectorSpringSlotA;
+  std::vector<int> m_vectorSpringSlotB;
+  std::vector<float> m_vectorSpringIdleLength;
+  std::vector<float> m_vectorSpringFactorA;
+  std::vector<float> m_vectorSpringFactorB;
+  std::vector<int> m_vectorColorOffset;
+  std::vector<PinnedRange> m_vectorPinnedRange;
+
+// constructors/destructor
+public:
+  CalCoreCloth();
+  virtual ~CalCoreCloth();
+
+// member functions
+public:
+  bool create(CalCoreSubmesh *pCoreSubmesh);
+  void destroy();
+  int getColorCount();
+  int *getColorOffsets();
+  int getFreeSlotCount();
+  float *getInverseWeights();
+  int getMemorySize();
+  int getPinnedRangeCount();
+  PinnedRange *getPinnedRanges();
+  int getSlotCount();
+  int getSpringCount();
+  float *getSpringFactorsA();
+  float *getSpringFactorsB();
+  float *getSpringIdleLengths();
+  int *getSpringSlotsA();
+  int *getSpringSlotsB();
+  int *getVertexIds();
+
+protected:
+  void colorSprings();
+};
+
+#endif
+
+//****************************************************************************//
@@ -25,6 +25,9 @@
 
  /*****************************************************************************/
 /** The core keyframe class.
+  *
+  * Core keyframes are stored by value in the keyframe array of a core track,
+  * so the class has no virtual functions.
   *****************************************************************************/
 
 class CAL3D_API CalCoreKeyframe: public CalCoreKeyframeUserData
@@ -38,7 +41,7 @@ protected:
 // constructors/destructor
 public:
   CalCoreKeyframe();
-  virtual ~CalCoreKeyframe();
+  ~CalCoreKeyframe();
 	
 // member functions
 public:
@@ -21,6 +21,8 @@
 #include "calcoresub.h"
 #include "calerror.h"
 #include "calloader.h"
+#include "calmapfile.h"
+#include "calnametable.h"
 #include "calsaver.h"
 
  /*****************************************************************************/
@@ -90,6 +92,45 @@ void CalCoreModel::destroy(void)
     delete (*iteratorCoreSubmesh);
   }
   m_vectorCoreSubmesh.clear();
+
+  // release the files that deferred submesh data was left in
+  std::vector<CalMappedFile *>::iterator iteratorMappedFile;
+  for(iteratorMappedFile = m_vectorMappedFile.begin(); iteratorMappedFile != m_vectorMappedFile.end(); ++iteratorMappedFile)
+  {
+    delete (*iteratorMappedFile);
+  }
+  m_vectorMappedFile.clear();
+}
+
+ /*****************************************************************************/
+/** Returns the memory size.
+  *
+  * This function returns the memory used by the core model instance, its
+  * core bones and its core submeshes.
+  *
+  * @return The memory size in bytes.
+  *****************************************************************************/
+
+int CalCoreModel::getMemorySize()
+{
+  int size;
+  size = sizeof(CalCoreModel) + m_strName.capacity();
+  size += m_vectorCoreBone.capacity() * sizeof(CalCoreBone *);
+  size += m_vectorCoreSubmesh.capacity() * sizeof(CalCoreSubmesh *);
+
+  int boneId;
+  for(boneId = 0; boneId < (int)m_vectorCoreBone.size(); boneId++)
+  {
+    size += m_vectorCoreBone[boneId]->getMemorySize();
+  }
+
+  int submeshId;
+  for(submeshId = 0; submeshId < (int)m_vectorCoreSubmesh.size(); submeshId++)
+  {
+    size += m_vectorCoreSubmesh[submeshId]->getMemorySize();
+  }
+
+  return size;
 }
 
  /*****************************************************************************/
@@ -142,10 +183,14 @@ CalCoreBone *CalCoreModel::getCoreBone(int coreBoneId)
 
 int CalCoreModel::getCoreBoneId(const std::string& strName)
 {
+  // a name that was never interned cannot belong to a core bone
+  int nameId = CalNameTable::getNameId(strName);
+  if(nameId < 0) return -1;
+
   int boneId;
   for(boneId = 0; boneId < (int)m_vectorCoreBone.size(); boneId++)
   {
-    if(m_vectorCoreBone[boneId]->getName() == strName) return boneId;
+    if(m_vectorCoreBone[boneId]->getNameId() == nameId) return boneId;
   }
 
   return -1;
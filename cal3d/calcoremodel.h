@@ -19,6 +19,7 @@
 
 class CalCoreSubmesh;
 class CalCoreBone;
+class CalMappedFile;
 
  /*****************************************************************************/
 /** The core model class.
@@ -26,6 +27,7 @@ class CalCoreBone;
 
 class CAL3D_API CalCoreModel: public CalCoreModelUserData
 {
+  friend class CalIncrementalLoader;
   friend class CalLoader;
   friend class CalSaver;
   
@@ -34,6 +36,7 @@ protected:
   std::string                   m_strName;
   std::vector<CalCoreBone *>    m_vectorCoreBone;
   std::vector<CalCoreSubmesh *> m_vectorCoreSubmesh;
+  std::vector<CalMappedFile *>  m_vectorMappedFile;
   
 // constructors/destructor
 public:
@@ -46,6 +49,7 @@ public:
 public:
   bool create(const char *strName);
   void destroy(void);
+  int getMemorySize();
 
 // Constructing and scanning the skeleton.
 public:
@@ -17,6 +17,8 @@
 //****************************************************************************//
 
 #include "calcoresub.h"
+#include "calerror.h"
+#include "calvcache.h"
 
  /*****************************************************************************/
 /** Constructs the core submesh instance.
@@ -28,6 +30,14 @@ CalCoreSubmesh::CalCoreSubmesh()
 {
   m_coreMaterialThreadId = 0;
   m_lodCount = 0;
+  m_bSortLodFaces = false;
+  m_bShortFaces = false;
+  m_bLodLevels = false;
+  m_pDeferredPhysicalProperty = 0;
+  m_pDeferredSpring = 0;
+  m_deferredSpringCount = 0;
+  m_bDeferredData = false;
+  m_bCoreCloth = false;
 }
 
  /*****************************************************************************/
@@ -45,6 +55,199 @@ CalCoreSubmesh::~CalCoreSubmesh()
   assert(m_vectorSpring.empty());
 }
 
+ /*****************************************************************************/
+/** Builds the precomputed LOD levels.
+  *
+  * This function quantizes the progressive LOD range of the core submesh
+  * instance into a number of discrete levels and builds the face array of
+  * every level once, with each vertex ID collapsed until it is part of that
+  * level. The collapse chains are flattened vertex by vertex, so every chain
+  * is followed only once per level. All submesh instances share these
+  * arrays, so changing the LOD level of an instance does not rebuild or copy
+  * any faces. Levels that collapse nothing use the face array of the core
+  * submesh directly.
+  *
+  * The levels are built on first use as well, under a lock, so submesh
+  * instances on different threads may trigger that build. They must be
+  * rebuilt if the faces or the LOD control information are modified through
+  * the vector accessors. After optimizeVertexCache() every level, the full
+  * level included, gets its own face array, sorted for the vertex cache.
+  * With short faces enabled, the face arrays of all levels are stored with
+  * 16-bit vertex IDs instead.
+  *
+  * The old face arrays are freed, so this function must not be called while
+  * submesh instances of the core submesh exist; they point into these arrays.
+  *
+  * @param lodLevelCount The number of LOD levels, including the full level.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreSubmesh::buildLodLevels(int lodLevelCount)
+{
+  if(lodLevelCount < 1)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
+    return false;
+  }
+
+  clearLodLevels();
+
+  const int vertexCount = m_vectorVertex.size();
+  const int faceCount = m_vectorFace.size();
+
+  int lodCount;
+  lodCount = getCollapsibleVertexCount();
+  if(lodCount == 0) lodLevelCount = 1;
+
+  // vertices may have been added since short faces were enabled
+  if(vertexCount > Cal::SHORT_FACE_VERTEX_COUNT) m_bShortFaces = false;
+
+  m_vectorLodLevel.resize(lodLevelCount);
+
+  std::vector<int> vectorCollapseTarget(vertexCount);
+
+  int lodLevelId;
+  for(lodLevelId = 0; lodLevelId < lodLevelCount; lodLevelId++)
+  {
+    LodLevel& lodLevel = m_vectorLodLevel[lodLevelId];
+
+    // calculate the collapsed vertex count the same way CalSubmesh always did
+    float level;
+    level = (lodLevelCount > 1) ? (float)lodLevelId / (float)(lodLevelCount - 1) : 1.0f;
+
+    int collapseCount;
+    collapseCount = (int)((1.0f - level) * lodCount);
+
+    lodLevel.vertexCount = vertexCount - collapseCount;
+    lodLevel.faceCount = faceCount;
+
+    int vertexId;
+    for(vertexId = vertexCount - 1; vertexId >= lodLevel.vertexCount; vertexId--)
+    {
+      lodLevel.faceCount -= m_vectorLodControl[vertexId].faceCollapseCount;
+    }
+    if(lodLevel.faceCount < 0) lodLevel.faceCount = 0;
+
+    // use the core faces if nothing is collapsed, unless they are to be
+    // sorted or narrowed, and share equal levels
+    if((collapseCount == 0) && !(m_bSortLodFaces && (lodCount > 0)) && !m_bShortFaces)
+    {
+      lodLevel.faceOffset = -1;
+      continue;
+    }
+
+    if((lodLevelId > 0) && (m_vectorLodLevel[lodLevelId - 1].vertexCount == lodLevel.vertexCount))
+    {
+      lodLevel.faceOffset = m_vectorLodLevel[lodLevelId - 1].faceOffset;
+      continue;
+    }
+
+    // flatten the collapse chains of this level
+    for(vertexId = 0; vertexId < vertexCount; vertexId++)
+    {
+      int collapsedVertexId;
+      collapsedVertexId = vertexId;
+
+      int guard;
+      for(guard = 0; (collapsedVertexId >= lodLevel.vertexCount) && (guard < vertexCount); guard++)
+      {
+        // vertices below this one are flattened already
+        if(collapsedVertexId < vertexId)
+        {
+          collapsedVertexId = vectorCollapseTarget[collapsedVertexId];
+          break;
+        }
+
+        collapsedVertexId = m_vectorLodControl[collapsedVertexId].collapseId;
+        if((collapsedVertexId < 0) || (collapsedVertexId >= vertexCount)) break;
+      }
+
+      if((collapsedVertexId < 0) || (collapsedVertexId >= lodLevel.vertexCount))
+      {
+        clearLodLevels();
+        CalError::setLastError(CalError::INDEX_BUILD_FAILED, __FILE__, __LINE__, "invalid LOD collapse chain");
+        return false;
+      }
+
+      vectorCollapseTarget[vertexId] = collapsedVertexId;
+    }
+
+    // build the face array of this level
+    lodLevel.faceOffset = m_vectorLodFace.size();
+
+    int faceId;
+    for(faceId = 0; faceId < lodLevel.faceCount; faceId++)
+    {
+      Face face;
+      face.vertexId[0] = vectorCollapseTarget[m_vectorFace[faceId].vertexId[0]];
+      face.vertexId[1] = vectorCollapseTarget[m_vectorFace[faceId].vertexId[1]];
+      face.vertexId[2] = vectorCollapseTarget[m_vectorFace[faceId].vertexId[2]];
+      m_vectorLodFace.push_back(face);
+    }
+  }
+
+  if(m_bSortLodFaces && (lodCount > 0) && !sortLodLevels())
+  {
+    clearLodLevels();
+    return false;
+  }
+
+  // narrow the face arrays, the 32-bit ones are widened again on demand
+  if(m_bShortFaces)
+  {
+    m_vectorLodShortFace.resize(m_vectorLodFace.size());
+
+    int lodFaceId;
+    for(lodFaceId = 0; lodFaceId < (int)m_vectorLodFace.size(); lodFaceId++)
+    {
+      m_vectorLodShortFace[lodFaceId].vertexId[0] = (unsigned short)m_vectorLodFace[lodFaceId].vertexId[0];
+      m_vectorLodShortFace[lodFaceId].vertexId[1] = (unsigned short)m_vectorLodFace[lodFaceId].vertexId[1];
+      m_vectorLodShortFace[lodFaceId].vertexId[2] = (unsigned short)m_vectorLodFace[lodFaceId].vertexId[2];
+    }
+
+    std::vector<Face>().swap(m_vectorLodFace);
+  }
+
+  // publish the levels to getLodLevel
+  m_bLodLevels.store(true, std::memory_order_release);
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Clears the precomputed LOD levels.
+  *
+  * This function frees the precomputed LOD levels of the core submesh
+  * instance. They are built again on next use. Every function that changes
+  * the faces, the vertices or the LOD control information calls it, so none
+  * of them must be called while submesh instances of the core submesh exist:
+  * the instances and the renderers hold pointers into the freed arrays.
+  *****************************************************************************/
+
+void CalCoreSubmesh::clearLodLevels()
+{
+  m_bLodLevels = false;
+  std::vector<LodLevel>().swap(m_vectorLodLevel);
+  std::vector<Face>().swap(m_vectorLodFace);
+  std::vector<ShortFace>().swap(m_vectorLodShortFace);
+}
+
+ /*****************************************************************************/
+/** Clears the core cloth.
+  *
+  * This function frees the core cloth, so it is built again from the springs
+  * the next time it is needed.
+  *****************************************************************************/
+
+void CalCoreSubmesh::clearCoreCloth()
+{
+  m_coreCloth.destroy();
+  m_bCoreCloth = false;
+}
+
  /*****************************************************************************/
 /** Creates the core submesh instance.
   *
@@ -60,6 +263,87 @@ bool CalCoreSubmesh::create()
   return true;
 }
 
+ /*****************************************************************************/
+/** Defers the loading of the springs.
+  *
+  * This function leaves the springs and the physical properties in the
+  * loaded file until they are first used. Both arrays must have the layout
+  * of the core submesh, and must stay valid for the lifetime of the core
+  * submesh instance.
+  *
+  * @param pPhysicalProperty A pointer to the physical property of every
+  *                          vertex.
+  * @param pSpring A pointer to the springs.
+  * @param springCount The number of springs.
+  *****************************************************************************/
+
+void CalCoreSubmesh::deferSprings(const void *pPhysicalProperty, const void *pSpring, int springCount)
+{
+  std::vector<PhysicalProperty>().swap(m_vectorPhysicalProperty);
+  std::vector<Spring>().swap(m_vectorSpring);
+
+  m_pDeferredPhysicalProperty = (const char *)pPhysicalProperty;
+  m_pDeferredSpring = (const char *)pSpring;
+  m_deferredSpringCount = springCount;
+  m_bDeferredData = true;
+}
+
+ /*****************************************************************************/
+/** Defers the loading of a tangent space channel.
+  *
+  * This function enables the tangent spaces of a texture coordinate channel,
+  * but leaves them in the loaded file until they are first used. The array
+  * must have the layout of the core submesh, and must stay valid for the
+  * lifetime of the core submesh instance.
+  *
+  * @param textureCoordinateId The ID of the texture coordinate channel.
+  * @param pTangentSpace A pointer to the tangent space of every vertex.
+  *****************************************************************************/
+
+void CalCoreSubmesh::deferTangentSpaces(int textureCoordinateId, const void *pTangentSpace)
+{
+  if((textureCoordinateId < 0) || (textureCoordinateId >= (int)m_vectorvectorTextureCoordinate.size())) return;
+
+  m_vectorTangentsEnabled[textureCoordinateId] = true;
+  std::vector<TangentSpace>().swap(m_vectorvectorTangentSpace[textureCoordinateId]);
+
+  m_vectorDeferredTangentSpace.resize(m_vectorvectorTextureCoordinate.size(), 0);
+  m_vectorDeferredTangentSpace[textureCoordinateId] = (const char *)pTangentSpace;
+  m_bDeferredData = true;
+}
+
+ /*****************************************************************************/
+/** Defers the loading of a texture coordinate channel.
+  *
+  * This function leaves the texture coordinates of a channel in the loaded
+  * file until they are first used. The channel is added if it does not exist
+  * yet. The array must have the layout of the core submesh, and must stay
+  * valid for the lifetime of the core submesh instance.
+  *
+  * @param textureCoordinateId The ID of the texture coordinate channel.
+  * @param pTextureCoordinate A pointer to the texture coordinate of every
+  *                           vertex.
+  *****************************************************************************/
+
+void CalCoreSubmesh::deferTextureCoordinates(int textureCoordinateId, const void *pTextureCoordinate)
+{
+  if(textureCoordinateId < 0) return;
+
+  // add the channel, with its tangent spaces disabled
+  if(textureCoordinateId >= (int)m_vectorvectorTextureCoordinate.size())
+  {
+    m_vectorTangentsEnabled.resize(textureCoordinateId + 1, false);
+    m_vectorvectorTangentSpace.resize(textureCoordinateId + 1);
+    m_vectorvectorTextureCoordinate.resize(textureCoordinateId + 1);
+  }
+
+  std::vector<TextureCoordinate>().swap(m_vectorvectorTextureCoordinate[textureCoordinateId]);
+
+  m_vectorDeferredTextureCoordinate.resize(m_vectorvectorTextureCoordinate.size(), 0);
+  m_vectorDeferredTextureCoordinate[textureCoordinateId] = (const char *)pTextureCoordinate;
+  m_bDeferredData = true;
+}
+
  /*****************************************************************************/
 /** Destroys the core submesh instance.
   *
@@ -75,6 +359,44 @@ void CalCoreSubmesh::destroy()
   m_vectorPhysicalProperty.clear();
   m_vectorvectorTextureCoordinate.clear();
   m_vectorSpring.clear();
+  clearLodLevels();
+  m_bSortLodFaces = false;
+  m_bShortFaces = false;
+
+  m_vectorDeferredTangentSpace.clear();
+  m_vectorDeferredTextureCoordinate.clear();
+  m_pDeferredPhysicalProperty = 0;
+  m_pDeferredSpring = 0;
+  m_deferredSpringCount = 0;
+  m_bDeferredData = false;
+  clearCoreCloth();
+}
+
+ /*****************************************************************************/
+/** Provides access to the core cloth.
+  *
+  * This function returns the spring system of the core submesh instance in
+  * the form the cloth solver runs on. It is built from the springs the first
+  * time it is needed, and again after the springs, physical properties or
+  * vertices change.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core cloth
+  *         \li \b 0 if the core submesh has no springs or an error happend
+  *****************************************************************************/
+
+CalCoreCloth *CalCoreSubmesh::getCoreCloth()
+{
+  if(getSpringCount() <= 0) return 0;
+
+  if(!m_bCoreCloth)
+  {
+    loadDeferredSprings();
+    if(!m_coreCloth.create(this)) return 0;
+    m_bCoreCloth = true;
+  }
+
+  return &m_coreCloth;
 }
 
  /*****************************************************************************/
@@ -91,6 +413,27 @@ int CalCoreSubmesh::getCoreMaterialThreadId()
   return m_coreMaterialThreadId;
 }
 
+ /*****************************************************************************/
+/** Returns the number of collapsible vertices.
+  *
+  * This function returns the number of LOD steps, limited to the vertices
+  * that have LOD control information. These are the last vertices of the
+  * core submesh instance.
+  *
+  * @return The number of collapsible vertices.
+  *****************************************************************************/
+
+int CalCoreSubmesh::getCollapsibleVertexCount()
+{
+  int lodCount;
+  lodCount = m_lodCount;
+  if(lodCount > (int)m_vectorLodControl.size()) lodCount = m_vectorLodControl.size();
+  if(lodCount > (int)m_vectorVertex.size()) lodCount = m_vectorVertex.size();
+  if(lodCount < 0) lodCount = 0;
+
+  return lodCount;
+}
+
  /*****************************************************************************/
 /** Returns the number of faces.
   *
@@ -104,6 +447,41 @@ int CalCoreSubmesh::getFaceCount()
   return m_vectorFace.size();
 }
 
+ /*****************************************************************************/
+/** Returns the memory size.
+  *
+  * This function returns the memory used by the core submesh instance and
+  * all of its arrays.
+  *
+  * @return The memory size in bytes.
+  *****************************************************************************/
+
+int CalCoreSubmesh::getMemorySize()
+{
+  int size;
+  size = sizeof(CalCoreSubmesh);
+  size += m_vectorVertex.capacity() * sizeof(Vertex);
+  size += m_vectorTangentsEnabled.capacity() / 8;
+  size += m_vectorPhysicalProperty.capacity() * sizeof(PhysicalProperty);
+  size += m_vectorFace.capacity() * sizeof(Face);
+  size += m_vectorSpring.capacity() * sizeof(Spring);
+  size += m_vectorInfluence.capacity() * sizeof(Influence);
+  size += m_vectorLodControl.capacity() * sizeof(LodControl);
+  size += m_vectorLodLevel.capacity() * sizeof(LodLevel);
+  size += m_vectorLodFace.capacity() * sizeof(Face);
+  size += m_vectorLodShortFace.capacity() * sizeof(ShortFace);
+  size += m_coreCloth.getMemorySize();
+
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorvectorTextureCoordinate.size(); textureCoordinateId++)
+  {
+    size += m_vectorvectorTextureCoordinate[textureCoordinateId].capacity() * sizeof(TextureCoordinate);
+    size += m_vectorvectorTangentSpace[textureCoordinateId].capacity() * sizeof(TangentSpace);
+  }
+
+  return size;
+}
+
  /*****************************************************************************/
 /** Returns the number of LOD steps.
   *
@@ -117,6 +495,167 @@ int CalCoreSubmesh::getLodCount()
   return m_lodCount;
 }
 
+ /*****************************************************************************/
+/** Returns the number of faces of a LOD level.
+  *
+  * This function returns the number of faces of a precomputed LOD level.
+  *
+  * @param lodLevelId The ID of the LOD level.
+  *
+  * @return The number of faces.
+  *****************************************************************************/
+
+int CalCoreSubmesh::getLodFaceCount(int lodLevelId)
+{
+  return getLodLevel(lodLevelId).faceCount;
+}
+
+ /*****************************************************************************/
+/** Provides access to the faces of a LOD level.
+  *
+  * This function returns the faces of a precomputed LOD level. The first
+  * getLodFaceCount() faces are part of the level. With short faces enabled,
+  * the 32-bit faces of all levels are rebuilt from the 16-bit ones on first
+  * use, under the lock of the LOD levels.
+  *
+  * @param lodLevelId The ID of the LOD level.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the faces
+  *         \li \b 0 if the level has no faces
+  *****************************************************************************/
+
+CalCoreSubmesh::Face *CalCoreSubmesh::getLodFaces(int lodLevelId)
+{
+  const LodLevel& lodLevel = getLodLevel(lodLevelId);
+  if(lodLevel.faceCount <= 0) return 0;
+
+  if(lodLevel.faceOffset < 0) return &m_vectorFace[0];
+
+  if(!m_bShortFaces) return &m_vectorLodFace[lodLevel.faceOffset];
+
+  std::lock_guard<std::mutex> lock(m_mutexLodLevels);
+  if(m_vectorLodFace.size() < m_vectorLodShortFace.size())
+  {
+    m_vectorLodFace.resize(m_vectorLodShortFace.size());
+
+    int lodFaceId;
+    for(lodFaceId = 0; lodFaceId < (int)m_vectorLodShortFace.size(); lodFaceId++)
+    {
+      m_vectorLodFace[lodFaceId].vertexId[0] = m_vectorLodShortFace[lodFaceId].vertexId[0];
+      m_vectorLodFace[lodFaceId].vertexId[1] = m_vectorLodShortFace[lodFaceId].vertexId[1];
+      m_vectorLodFace[lodFaceId].vertexId[2] = m_vectorLodShortFace[lodFaceId].vertexId[2];
+    }
+  }
+
+  return &m_vectorLodFace[lodLevel.faceOffset];
+}
+
+ /*****************************************************************************/
+/** Provides access to the 16-bit faces of a LOD level.
+  *
+  * This function returns the faces of a precomputed LOD level with 16-bit
+  * vertex IDs. The first getLodFaceCount() faces are part of the level.
+  *
+  * @param lodLevelId The ID of the LOD level.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the faces
+  *         \li \b 0 if the level has no faces or short faces are disabled
+  *****************************************************************************/
+
+CalCoreSubmesh::ShortFace *CalCoreSubmesh::getLodShortFaces(int lodLevelId)
+{
+  const LodLevel& lodLevel = getLodLevel(lodLevelId);
+  if(!m_bShortFaces || (lodLevel.faceCount <= 0)) return 0;
+
+  return &m_vectorLodShortFace[lodLevel.faceOffset];
+}
+
+ /*****************************************************************************/
+/** Returns a LOD level.
+  *
+  * This function returns a precomputed LOD level, and builds the levels first
+  * if necessary. Only the first caller builds them; others wait for the lock
+  * and then use the published levels. Invalid IDs are clamped to the valid
+  * range.
+  *
+  * @param lodLevelId The ID of the LOD level.
+  *
+  * @return A reference to the LOD level.
+  *****************************************************************************/
+
+const CalCoreSubmesh::LodLevel& CalCoreSubmesh::getLodLevel(int lodLevelId)
+{
+  if(!m_bLodLevels.load(std::memory_order_acquire))
+  {
+    std::lock_guard<std::mutex> lock(m_mutexLodLevels);
+    if(!m_bLodLevels.load(std::memory_order_relaxed) && !buildLodLevels(Cal::LOD_LEVEL_COUNT) && !buildLodLevels(1))
+    {
+      // fall back to the full level if the LOD control information is
+      // invalid, and to the unsorted faces if they cannot be sorted
+      m_bSortLodFaces = false;
+      buildLodLevels(1);
+    }
+  }
+
+  if(lodLevelId < 0) lodLevelId = 0;
+  if(lodLevelId >= (int)m_vectorLodLevel.size()) lodLevelId = m_vectorLodLevel.size() - 1;
+
+  return m_vectorLodLevel[lodLevelId];
+}
+
+ /*****************************************************************************/
+/** Returns the number of LOD levels.
+  *
+  * This function returns the number of precomputed LOD levels of the core
+  * submesh instance.
+  *
+  * @return The number of LOD levels.
+  *****************************************************************************/
+
+int CalCoreSubmesh::getLodLevelCount()
+{
+  getLodLevel(0);
+
+  return m_vectorLodLevel.size();
+}
+
+ /*****************************************************************************/
+/** Returns the LOD level closest to a continuous LOD value.
+  *
+  * This function quantizes a LOD value to the closest precomputed LOD level.
+  *
+  * @param lodLevel The LOD value in the range [0.0, 1.0].
+  *
+  * @return The ID of the LOD level.
+  *****************************************************************************/
+
+int CalCoreSubmesh::getLodLevelId(float lodLevel)
+{
+  // clamp the lod level to [0.0, 1.0]
+  if(lodLevel < 0.0f) lodLevel = 0.0f;
+  if(lodLevel > 1.0f) lodLevel = 1.0f;
+
+  return (int)(lodLevel * (getLodLevelCount() - 1) + 0.5f);
+}
+
+ /*****************************************************************************/
+/** Returns the number of vertices of a LOD level.
+  *
+  * This function returns the number of vertices of a precomputed LOD level.
+  * The vertices of a level are the first vertices of the core submesh.
+  *
+  * @param lodLevelId The ID of the LOD level.
+  *
+  * @return The number of vertices.
+  *****************************************************************************/
+
+int CalCoreSubmesh::getLodVertexCount(int lodLevelId)
+{
+  return getLodLevel(lodLevelId).vertexCount;
+}
+
  /*****************************************************************************/
 /** Returns the number of springs.
   *
@@ -127,6 +666,12 @@ int CalCoreSubmesh::getLodCount()
 
 int CalCoreSubmesh::getSpringCount()
 {
+  if(m_bDeferredData.load(std::memory_order_acquire))
+  {
+    std::lock_guard<std::mutex> lock(m_mutexDeferredData);
+    if(m_deferredSpringCount > 0) return m_deferredSpringCount;
+  }
+
   return m_vectorSpring.size();
 }
 
@@ -154,6 +699,8 @@ bool CalCoreSubmesh::tangentsEnabled(int mapId)
 bool CalCoreSubmesh::enableTangents(int mapId, bool enabled)
 {
   if((mapId < 0) || (mapId >= (int)m_vectorTangentsEnabled.size())) return false;
+
+  loadDeferredTangentSpaces(mapId);
   
   m_vectorTangentsEnabled[mapId] = enabled;
   
@@ -169,6 +716,51 @@ bool CalCoreSubmesh::enableTangents(int mapId, bool enabled)
   return true;
 }
 
+ /*****************************************************************************/
+/** Enables or disables 16-bit faces.
+  *
+  * This function enables or disables the storage of the LOD face arrays with
+  * 16-bit vertex IDs, which halves their size. It fails for core submeshes
+  * with more vertices than 16-bit IDs can address.
+  *
+  * @param enabled Whether the LOD faces should use 16-bit vertex IDs.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreSubmesh::enableShortFaces(bool enabled)
+{
+  if(enabled && ((int)m_vectorVertex.size() > Cal::SHORT_FACE_VERTEX_COUNT))
+  {
+    CalError::setLastError(CalError::INDEX_BUILD_FAILED, __FILE__, __LINE__, "too many vertices for 16-bit faces");
+    return false;
+  }
+
+  if(enabled != m_bShortFaces)
+  {
+    m_bShortFaces = enabled;
+    clearLodLevels();
+  }
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Returns whether 16-bit faces are enabled.
+  *
+  * This function returns whether the LOD face arrays of the core submesh
+  * instance are stored with 16-bit vertex IDs.
+  *
+  * @return True if 16-bit faces are enabled.
+  *****************************************************************************/
+
+bool CalCoreSubmesh::shortFacesEnabled()
+{
+  return m_bShortFaces;
+}
+
  /*****************************************************************************/
 /** Returns the face vector.
   *
@@ -194,6 +786,7 @@ std::vector<CalCoreSubmesh::Face>& CalCoreSubmesh::getVectorFace()
 
 std::vector<CalCoreSubmesh::PhysicalProperty>& CalCoreSubmesh::getVectorPhysicalProperty()
 {
+  loadDeferredSprings();
   return m_vectorPhysicalProperty;
 }
 
@@ -208,6 +801,7 @@ std::vector<CalCoreSubmesh::PhysicalProperty>& CalCoreSubmesh::getVectorPhysical
 
 std::vector<CalCoreSubmesh::Spring>& CalCoreSubmesh::getVectorSpring()
 {
+  loadDeferredSprings();
   return m_vectorSpring;
 }
 
@@ -222,6 +816,7 @@ std::vector<CalCoreSubmesh::Spring>& CalCoreSubmesh::getVectorSpring()
 
 std::vector<CalCoreSubmesh::TextureCoordinate> & CalCoreSubmesh::getVectorTextureCoordinate(int textureCoordinateId)
 {
+  loadDeferredTextureCoordinates(textureCoordinateId);
   return m_vectorvectorTextureCoordinate[textureCoordinateId];
 }
 
@@ -236,6 +831,7 @@ std::vector<CalCoreSubmesh::TextureCoordinate> & CalCoreSubmesh::getVectorTextur
 
 std::vector<CalCoreSubmesh::TangentSpace>& CalCoreSubmesh::getVectorTangentSpace(int textureCoordinateId)
 {
+  loadDeferredTangentSpaces(textureCoordinateId);
   return m_vectorvectorTangentSpace[textureCoordinateId];
 }
 
@@ -251,6 +847,12 @@ std::vector<CalCoreSubmesh::TangentSpace>& CalCoreSubmesh::getVectorTangentSpace
 
 std::vector<std::vector<CalCoreSubmesh::TextureCoordinate> > & CalCoreSubmesh::getVectorVectorTextureCoordinate()
 {
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorDeferredTextureCoordinate.size(); textureCoordinateId++)
+  {
+    loadDeferredTextureCoordinates(textureCoordinateId);
+  }
+
   return m_vectorvectorTextureCoordinate;
 }
 
@@ -266,6 +868,12 @@ std::vector<std::vector<CalCoreSubmesh::TextureCoordinate> > & CalCoreSubmesh::g
 
 std::vector<std::vector<CalCoreSubmesh::TangentSpace> >& CalCoreSubmesh::getVectorVectorTangentSpace()
 {
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorDeferredTangentSpace.size(); textureCoordinateId++)
+  {
+    loadDeferredTangentSpaces(textureCoordinateId);
+  }
+
   return m_vectorvectorTangentSpace;
 }
 
@@ -342,6 +950,448 @@ int CalCoreSubmesh::getTextureCoordinateCount()
   return m_vectorvectorTextureCoordinate.size();
 }
 
+ /*****************************************************************************/
+/** Checks if some data is not loaded yet.
+  *
+  * This function checks if a texture coordinate channel, a tangent space
+  * channel or the springs are still left in the loaded file.
+  *
+  * @return One of the following values:
+  *         \li \b true if some data is deferred
+  *         \li \b false if not
+  *****************************************************************************/
+
+bool CalCoreSubmesh::hasDeferredData()
+{
+  return m_bDeferredData.load(std::memory_order_acquire);
+}
+
+ /*****************************************************************************/
+/** Checks if some data is not loaded yet.
+  *
+  * This function scans the deferred arrays for data that is still left in the
+  * loaded file. The caller holds the lock of the deferred data.
+  *
+  * @return One of the following values:
+  *         \li \b true if some data is deferred
+  *         \li \b false if not
+  *****************************************************************************/
+
+bool CalCoreSubmesh::findDeferredData()
+{
+  if(m_deferredSpringCount > 0) return true;
+
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorDeferredTextureCoordinate.size(); textureCoordinateId++)
+  {
+    if(m_vectorDeferredTextureCoordinate[textureCoordinateId] != 0) return true;
+  }
+
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorDeferredTangentSpace.size(); textureCoordinateId++)
+  {
+    if(m_vectorDeferredTangentSpace[textureCoordinateId] != 0) return true;
+  }
+
+  return false;
+}
+
+ /*****************************************************************************/
+/** Loads all deferred data.
+  *
+  * This function loads all texture coordinate channels, tangent space
+  * channels and springs that are still left in the loaded file. Deferred data
+  * is otherwise loaded on first use. That load is done under a lock, so
+  * threads sharing the core submesh may trigger it, but calling this function
+  * first keeps the lock and the copy out of the frame.
+  *****************************************************************************/
+
+void CalCoreSubmesh::loadDeferredData()
+{
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorDeferredTextureCoordinate.size(); textureCoordinateId++)
+  {
+    loadDeferredTextureCoordinates(textureCoordinateId);
+  }
+
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorDeferredTangentSpace.size(); textureCoordinateId++)
+  {
+    loadDeferredTangentSpaces(textureCoordinateId);
+  }
+
+  loadDeferredSprings();
+}
+
+ /*****************************************************************************/
+/** Loads the deferred springs.
+  *
+  * This function copies the springs and the physical properties out of the
+  * loaded file, if they were deferred.
+  *****************************************************************************/
+
+void CalCoreSubmesh::loadDeferredSprings()
+{
+  if(!m_bDeferredData.load(std::memory_order_acquire)) return;
+
+  std::lock_guard<std::mutex> lock(m_mutexDeferredData);
+  if(m_deferredSpringCount <= 0) return;
+
+  m_vectorPhysicalProperty.resize(m_vectorVertex.size());
+  if(!m_vectorPhysicalProperty.empty()) memcpy(&m_vectorPhysicalProperty[0], m_pDeferredPhysicalProperty, m_vectorPhysicalProperty.size() * sizeof(PhysicalProperty));
+
+  m_vectorSpring.resize(m_deferredSpringCount);
+  memcpy(&m_vectorSpring[0], m_pDeferredSpring, m_deferredSpringCount * sizeof(Spring));
+
+  m_pDeferredPhysicalProperty = 0;
+  m_pDeferredSpring = 0;
+  m_deferredSpringCount = 0;
+  m_bDeferredData.store(findDeferredData(), std::memory_order_release);
+}
+
+ /*****************************************************************************/
+/** Loads a deferred tangent space channel.
+  *
+  * This function copies the tangent spaces of a texture coordinate channel
+  * out of the loaded file, if they were deferred.
+  *
+  * @param textureCoordinateId The ID of the texture coordinate channel.
+  *****************************************************************************/
+
+void CalCoreSubmesh::loadDeferredTangentSpaces(int textureCoordinateId)
+{
+  if(!m_bDeferredData.load(std::memory_order_acquire)) return;
+
+  std::lock_guard<std::mutex> lock(m_mutexDeferredData);
+  if((textureCoordinateId < 0) || (textureCoordinateId >= (int)m_vectorDeferredTangentSpace.size())) return;
+  if(m_vectorDeferredTangentSpace[textureCoordinateId] == 0) return;
+
+  std::vector<TangentSpace>& vectorTangentSpace = m_vectorvectorTangentSpace[textureCoordinateId];
+  vectorTangentSpace.resize(m_vectorVertex.size());
+  if(!vectorTangentSpace.empty()) memcpy(&vectorTangentSpace[0], m_vectorDeferredTangentSpace[textureCoordinateId], vectorTangentSpace.size() * sizeof(TangentSpace));
+
+  m_vectorDeferredTangentSpace[textureCoordinateId] = 0;
+  m_bDeferredData.store(findDeferredData(), std::memory_order_release);
+}
+
+ /*****************************************************************************/
+/** Loads a deferred texture coordinate channel.
+  *
+  * This function copies the texture coordinates of a channel out of the
+  * loaded file, if they were deferred.
+  *
+  * @param textureCoordinateId The ID of the texture coordinate channel.
+  *****************************************************************************/
+
+void CalCoreSubmesh::loadDeferredTextureCoordinates(int textureCoordinateId)
+{
+  if(!m_bDeferredData.load(std::memory_order_acquire)) return;
+
+  std::lock_guard<std::mutex> lock(m_mutexDeferredData);
+  if((textureCoordinateId < 0) || (textureCoordinateId >= (int)m_vectorDeferredTextureCoordinate.size())) return;
+  if(m_vectorDeferredTextureCoordinate[textureCoordinateId] == 0) return;
+
+  std::vector<TextureCoordinate>& vectorTextureCoordinate = m_vectorvectorTextureCoordinate[textureCoordinateId];
+  vectorTextureCoordinate.resize(m_vectorVertex.size());
+  if(!vectorTextureCoordinate.empty()) memcpy(&vectorTextureCoordinate[0], m_vectorDeferredTextureCoordinate[textureCoordinateId], vectorTextureCoordinate.size() * sizeof(TextureCoordinate));
+
+  m_vectorDeferredTextureCoordinate[textureCoordinateId] = 0;
+  m_bDeferredData.store(findDeferredData(), std::memory_order_release);
+}
+
+ /*****************************************************************************/
+/** Optimizes the face and vertex order for the vertex cache.
+  *
+  * This function sorts the faces of the core submesh instance for the
+  * post-transform vertex cache, and then numbers the vertices in the order
+  * they are first used, so that skinning walks the vertices in drawing order.
+  * The vertices of a spring system are then partitioned (see
+  * partitionVertices).
+  *
+  * The progressive LOD order is kept: the faces removed by a collapse stay in
+  * place at the end of the face array, and the collapsible vertices at the
+  * end of the vertex array. Instead, every LOD level, the full level
+  * included, gets its own sorted face array when the levels are built.
+  *
+  * @param bReorderVertices Whether the vertices should be renumbered too.
+  *                         This loads any deferred channels.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreSubmesh::optimizeVertexCache(bool bReorderVertices)
+{
+  const int vertexCount = m_vectorVertex.size();
+  const int faceCount = m_vectorFace.size();
+  const int fixedVertexCount = vertexCount - getCollapsibleVertexCount();
+
+  // only the faces that no collapse removes can be sorted in place
+  int sortedFaceCount;
+  sortedFaceCount = faceCount;
+
+  int vertexId;
+  for(vertexId = fixedVertexCount; vertexId < vertexCount; vertexId++)
+  {
+    sortedFaceCount -= m_vectorLodControl[vertexId].faceCollapseCount;
+  }
+  if(sortedFaceCount < 0) sortedFaceCount = 0;
+
+  if((sortedFaceCount > 0) && !CalVertexCache::sortFaces(&m_vectorFace[0], sortedFaceCount)) return false;
+
+  m_bSortLodFaces = true;
+  clearLodLevels();
+
+  if(!bReorderVertices) return true;
+
+  // number the fixed vertices in the order the full level uses them first
+  if(!buildLodLevels(1)) return false;
+
+  const Face *pFace = getLodFaces(0);
+  const int lodFaceCount = getLodFaceCount(0);
+
+  std::vector<int> vectorNewVertexId(vertexCount, -1);
+  int nextVertexId = 0;
+
+  int faceId;
+  for(faceId = 0; faceId < lodFaceCount; faceId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      vertexId = pFace[faceId].vertexId[cornerId];
+      if((vertexId >= 0) && (vertexId < fixedVertexCount) && (vectorNewVertexId[vertexId] == -1))
+      {
+        vectorNewVertexId[vertexId] = nextVertexId++;
+      }
+    }
+  }
+
+  // unused fixed vertices follow, the collapsible vertices stay where they are
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    if(vertexId >= fixedVertexCount) vectorNewVertexId[vertexId] = vertexId;
+    else if(vectorNewVertexId[vertexId] == -1) vectorNewVertexId[vertexId] = nextVertexId++;
+  }
+
+  if(!reorderVertices(vectorNewVertexId)) return false;
+
+  return partitionVertices();
+}
+
+ /*****************************************************************************/
+/** Partitions the vertices of the spring system.
+  *
+  * This function moves the pinned vertices, those skinning transforms, ahead
+  * of the vertices the cloth simulates, so that each kind forms a single
+  * range. The vertices keep their order within a range, and the collapsible
+  * vertices stay at the end, as the progressive LOD order needs them there.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreSubmesh::partitionVertices()
+{
+  if(getSpringCount() <= 0) return true;
+
+  loadDeferredSprings();
+
+  const int vertexCount = m_vectorVertex.size();
+  const int fixedVertexCount = vertexCount - getCollapsibleVertexCount();
+
+  if((int)m_vectorPhysicalProperty.size() != vertexCount)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
+    return false;
+  }
+
+  // the pinned vertices first, then the simulated ones
+  std::vector<int> vectorNewVertexId(vertexCount);
+  int nextVertexId = 0;
+
+  int vertexId;
+  for(vertexId = 0; vertexId < fixedVertexCount; vertexId++)
+  {
+    if(m_vectorPhysicalProperty[vertexId].weight <= 0.0f) vectorNewVertexId[vertexId] = nextVertexId++;
+  }
+
+  for(vertexId = 0; vertexId < fixedVertexCount; vertexId++)
+  {
+    if(m_vectorPhysicalProperty[vertexId].weight > 0.0f) vectorNewVertexId[vertexId] = nextVertexId++;
+  }
+
+  // nothing to do if the vertices are partitioned already
+  bool bPartitioned;
+  bPartitioned = true;
+
+  for(vertexId = 0; vertexId < fixedVertexCount; vertexId++)
+  {
+    if(vectorNewVertexId[vertexId] != vertexId) bPartitioned = false;
+  }
+
+  if(bPartitioned) return true;
+
+  for(vertexId = fixedVertexCount; vertexId < vertexCount; vertexId++)
+  {
+    vectorNewVertexId[vertexId] = vertexId;
+  }
+
+  return reorderVertices(vectorNewVertexId);
+}
+
+ /*****************************************************************************/
+/** Reorders the vertices.
+  *
+  * This function moves every vertex of the core submesh instance to a new
+  * position, together with its texture coordinates, tangent spaces,
+  * influences, physical property and LOD control information. The faces,
+  * springs and collapse IDs are renumbered accordingly.
+  *
+  * @param vectorNewVertexId The new ID of every vertex. It must be a
+  *                          permutation of the vertex IDs.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreSubmesh::reorderVertices(const std::vector<int>& vectorNewVertexId)
+{
+  loadDeferredData();
+
+  const int vertexCount = m_vectorVertex.size();
+
+  // check that the new ids are a permutation
+  if((int)vectorNewVertexId.size() != vertexCount)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
+    return false;
+  }
+
+  std::vector<int> vectorOldVertexId(vertexCount, -1);
+
+  int vertexId;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    int newVertexId;
+    newVertexId = vectorNewVertexId[vertexId];
+    if((newVertexId < 0) || (newVertexId >= vertexCount) || (vectorOldVertexId[newVertexId] != -1))
+    {
+      CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
+      return false;
+    }
+
+    vectorOldVertexId[newVertexId] = vertexId;
+  }
+
+  // find the first influence of every vertex
+  std::vector<int> vectorFirstInfluence(vertexCount + 1, 0);
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    vectorFirstInfluence[vertexId + 1] = vectorFirstInfluence[vertexId] + m_vectorVertex[vertexId].influenceCount;
+  }
+
+  // move the per-vertex data
+  std::vector<Vertex> vectorVertex(vertexCount);
+  std::vector<LodControl> vectorLodControl(m_vectorLodControl.size());
+  std::vector<Influence> vectorInfluence;
+  vectorInfluence.reserve(m_vectorInfluence.size());
+
+  int newVertexId;
+  for(newVertexId = 0; newVertexId < vertexCount; newVertexId++)
+  {
+    int oldVertexId;
+    oldVertexId = vectorOldVertexId[newVertexId];
+
+    vectorVertex[newVertexId] = m_vectorVertex[oldVertexId];
+
+    if(oldVertexId < (int)m_vectorLodControl.size())
+    {
+      vectorLodControl[newVertexId] = m_vectorLodControl[oldVertexId];
+
+      int collapseId;
+      collapseId = vectorLodControl[newVertexId].collapseId;
+      if((collapseId >= 0) && (collapseId < vertexCount)) vectorLodControl[newVertexId].collapseId = vectorNewVertexId[collapseId];
+    }
+
+    int influenceId;
+    for(influenceId = vectorFirstInfluence[oldVertexId]; influenceId < vectorFirstInfluence[oldVertexId + 1]; influenceId++)
+    {
+      if(influenceId < (int)m_vectorInfluence.size()) vectorInfluence.push_back(m_vectorInfluence[influenceId]);
+    }
+  }
+
+  m_vectorVertex.swap(vectorVertex);
+  m_vectorLodControl.swap(vectorLodControl);
+  m_vectorInfluence.swap(vectorInfluence);
+
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorvectorTextureCoordinate.size(); textureCoordinateId++)
+  {
+    std::vector<TextureCoordinate>& vectorTextureCoordinate = m_vectorvectorTextureCoordinate[textureCoordinateId];
+    if((int)vectorTextureCoordinate.size() != vertexCount) continue;
+
+    std::vector<TextureCoordinate> vectorNewTextureCoordinate(vertexCount);
+    for(newVertexId = 0; newVertexId < vertexCount; newVertexId++)
+    {
+      vectorNewTextureCoordinate[newVertexId] = vectorTextureCoordinate[vectorOldVertexId[newVertexId]];
+    }
+    vectorTextureCoordinate.swap(vectorNewTextureCoordinate);
+  }
+
+  for(textureCoordinateId = 0; textureCoordinateId < (int)m_vectorvectorTangentSpace.size(); textureCoordinateId++)
+  {
+    std::vector<TangentSpace>& vectorTangentSpace = m_vectorvectorTangentSpace[textureCoordinateId];
+    if((int)vectorTangentSpace.size() != vertexCount) continue;
+
+    std::vector<TangentSpace> vectorNewTangentSpace(vertexCount);
+    for(newVertexId = 0; newVertexId < vertexCount; newVertexId++)
+    {
+      vectorNewTangentSpace[newVertexId] = vectorTangentSpace[vectorOldVertexId[newVertexId]];
+    }
+    vectorTangentSpace.swap(vectorNewTangentSpace);
+  }
+
+  if((int)m_vectorPhysicalProperty.size() == vertexCount)
+  {
+    std::vector<PhysicalProperty> vectorPhysicalProperty(vertexCount);
+    for(newVertexId = 0; newVertexId < vertexCount; newVertexId++)
+    {
+      vectorPhysicalProperty[newVertexId] = m_vectorPhysicalProperty[vectorOldVertexId[newVertexId]];
+    }
+    m_vectorPhysicalProperty.swap(vectorPhysicalProperty);
+    clearCoreCloth();
+  }
+
+  // renumber the faces and springs
+  int faceId;
+  for(faceId = 0; faceId < (int)m_vectorFace.size(); faceId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      int& faceVertexId = m_vectorFace[faceId].vertexId[cornerId];
+      if((faceVertexId >= 0) && (faceVertexId < vertexCount)) faceVertexId = vectorNewVertexId[faceVertexId];
+    }
+  }
+
+  int springId;
+  for(springId = 0; springId < (int)m_vectorSpring.size(); springId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 2; cornerId++)
+    {
+      int& springVertexId = m_vectorSpring[springId].vertexId[cornerId];
+      if((springVertexId >= 0) && (springVertexId < vertexCount)) springVertexId = vectorNewVertexId[springVertexId];
+    }
+  }
+
+  clearLodLevels();
+
+  return true;
+}
+
  /*****************************************************************************/
 /** Reserves memory for the vertices, faces and texture coordinates.
   *
@@ -365,6 +1415,9 @@ int CalCoreSubmesh::getTextureCoordinateCount()
 
 bool CalCoreSubmesh::reserve(int vertexCount, int textureCoordinateCount, int faceCount, int springCount)
 {
+  loadDeferredData();
+  clearLodLevels();
+
   int oldTextureCoordinateCount = m_vectorvectorTextureCoordinate.size();
 
   // reserve the space needed in all the vectors
@@ -452,6 +1505,10 @@ bool CalCoreSubmesh::reserve(int vertexCount, int textureCoordinateCount, int fa
 
 bool CalCoreSubmesh::resize(int vertexCount, int textureCoordinateCount, int faceCount, int springCount)
 {
+  loadDeferredData();
+  clearLodLevels();
+  clearCoreCloth();
+
   int oldTextureCoordinateCount = m_vectorvectorTextureCoordinate.size();
 
   int vertexReserve = 16;
@@ -527,6 +1584,60 @@ bool CalCoreSubmesh::resize(int vertexCount, int textureCoordinateCount, int fac
   return true;
 }
 
+ /*****************************************************************************/
+/** Sorts the faces of the LOD levels for the vertex cache.
+  *
+  * This function sorts the face array of every precomputed LOD level, from
+  * the full level down. A level draws its faces in the order of the last
+  * sorted level as long as it keeps at least half of that level's faces,
+  * otherwise its order is computed anew. This keeps the cost close to sorting
+  * the full level twice, while the coarse levels still get an order of their
+  * own.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreSubmesh::sortLodLevels()
+{
+  // the face arrays are still in core face order, so a position is a face ID
+  std::vector<int> vectorFaceId;
+  int sortedFaceCount = 0;
+
+  std::vector<Face> vectorFace;
+
+  int lodLevelId;
+  for(lodLevelId = (int)m_vectorLodLevel.size() - 1; lodLevelId >= 0; lodLevelId--)
+  {
+    const LodLevel& lodLevel = m_vectorLodLevel[lodLevelId];
+    if((lodLevel.faceOffset < 0) || (lodLevel.faceCount <= 0)) continue;
+
+    // shared face arrays are sorted once
+    if((lodLevelId + 1 < (int)m_vectorLodLevel.size()) && (m_vectorLodLevel[lodLevelId + 1].faceOffset == lodLevel.faceOffset)) continue;
+
+    Face *pFace = &m_vectorLodFace[lodLevel.faceOffset];
+
+    if(vectorFaceId.empty() || (lodLevel.faceCount * 2 < sortedFaceCount))
+    {
+      if(!CalVertexCache::getFaceOrder(pFace, lodLevel.faceCount, vectorFaceId)) return false;
+      sortedFaceCount = lodLevel.faceCount;
+    }
+
+    vectorFace.assign(pFace, pFace + lodLevel.faceCount);
+
+    int orderId;
+    for(orderId = 0; orderId < (int)vectorFaceId.size(); orderId++)
+    {
+      int faceId;
+      faceId = vectorFaceId[orderId];
+      if(faceId < lodLevel.faceCount) *pFace++ = vectorFace[faceId];
+    }
+  }
+
+  return true;
+}
+
  /*****************************************************************************/
 /** Sets the ID of the core material thread.
   *
@@ -560,6 +1671,7 @@ bool CalCoreSubmesh::setFace(int faceId, const Face& face)
   if((faceId < 0) || (faceId >= (int)m_vectorFace.size())) return false;
 
   m_vectorFace[faceId] = face;
+  clearLodLevels();
 
   return true;
 }
@@ -575,6 +1687,7 @@ bool CalCoreSubmesh::setFace(int faceId, const Face& face)
 void CalCoreSubmesh::setLodCount(int lodCount)
 {
   m_lodCount = lodCount;
+  clearLodLevels();
 }
 
  /*****************************************************************************/
@@ -593,9 +1706,12 @@ void CalCoreSubmesh::setLodCount(int lodCount)
 
 bool CalCoreSubmesh::setPhysicalProperty(int vertexId, const PhysicalProperty& physicalProperty)
 {
+  loadDeferredSprings();
+
   if((vertexId < 0) || (vertexId >= (int)m_vectorPhysicalProperty.size())) return false;
 
   m_vectorPhysicalProperty[vertexId] = physicalProperty;
+  clearCoreCloth();
 
   return true;
 }
@@ -615,9 +1731,12 @@ bool CalCoreSubmesh::setPhysicalProperty(int vertexId, const PhysicalProperty& p
 
 bool CalCoreSubmesh::setSpring(int springId, const Spring& spring)
 {
+  loadDeferredSprings();
+
   if((springId < 0) || (springId >= (int)m_vectorSpring.size())) return false;
 
   m_vectorSpring[springId] = spring;
+  clearCoreCloth();
 
   return true;
 }
@@ -639,6 +1758,8 @@ bool CalCoreSubmesh::setSpring(int springId, const Spring& spring)
 
 bool CalCoreSubmesh::setTextureCoordinate(int vertexId, int textureCoordinateId, const TextureCoordinate& textureCoordinate)
 {
+  loadDeferredTextureCoordinates(textureCoordinateId);
+
   if((textureCoordinateId < 0) || (textureCoordinateId >= (int)m_vectorvectorTextureCoordinate.size())) return false;
   if((vertexId < 0) || (vertexId >= (int)m_vectorvectorTextureCoordinate[textureCoordinateId].size())) return false;
 
@@ -697,7 +1818,8 @@ bool CalCoreSubmesh::setInfluenceCount(int vertexId, int influenceCount)
   if((influenceCount < 0) || (influenceCount > 127)) return false;
 
   m_vectorVertex[vertexId].influenceCount = influenceCount;
-  
+  clearCoreCloth();
+
   return true;
 }
 
@@ -721,6 +1843,7 @@ bool CalCoreSubmesh::setLodControl(int vertexId, int faceCollapseCount, int coll
 
   m_vectorLodControl[vertexId].faceCollapseCount = faceCollapseCount;
   m_vectorLodControl[vertexId].collapseId = collapseId;
+  clearLodLevels();
   
   return true;
 }
@@ -745,6 +1868,8 @@ bool CalCoreSubmesh::setTangentSpace(int vertexId, int textureCoordinateId, cons
 {
   if((vertexId < 0) || (vertexId >= (int)m_vectorVertex.size())) return false;
   if((textureCoordinateId < 0) || (textureCoordinateId >= (int)m_vectorvectorTextureCoordinate.size())) return false;
+
+  loadDeferredTangentSpaces(textureCoordinateId);
   
   int tx = tangent.x * 127.5;
   int ty = tangent.y * 127.5;
@@ -789,5 +1914,8 @@ float *CalCoreSubmesh::getTextureCoordinates(int mapId)
   {
     return 0;
   }
+
+  loadDeferredTextureCoordinates(mapId);
+
   return &(m_vectorvectorTextureCoordinate[mapId][0].u);
 }
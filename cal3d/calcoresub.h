@@ -17,6 +17,10 @@
 
 #include "calglobal.h"
 #include "calvector.h"
+#include "calcorecloth.h"
+
+#include <atomic>
+#include <mutex>
 
 //****************************************************************************//
 // Class declaration                                                          //
@@ -72,12 +76,26 @@ public:
     int collapseId;
   };
 
+  /// A precomputed LOD level.
+  struct LodLevel
+  {
+    int vertexCount;
+    int faceCount;
+    int faceOffset;
+  };
+
   /// The core submesh Face.
   struct Face
   {
     int vertexId[3];
   };
 
+  /// A core submesh Face with 16-bit vertex IDs.
+  struct ShortFace
+  {
+    unsigned short vertexId[3];
+  };
+
   /// The core submesh Spring.
   struct Spring
   {
@@ -99,6 +117,22 @@ protected:
   std::vector<LodControl> m_vectorLodControl;
   int m_coreMaterialThreadId;
   int m_lodCount;
+  bool m_bSortLodFaces;
+  std::vector<LodLevel> m_vectorLodLevel;
+  std::vector<Face> m_vectorLodFace;
+  std::vector<ShortFace> m_vectorLodShortFace;
+  bool m_bShortFaces;
+  std::atomic<bool> m_bLodLevels;
+  std::mutex m_mutexLodLevels;
+  std::vector<const char *> m_vectorDeferredTangentSpace;
+  std::vector<const char *> m_vectorDeferredTextureCoordinate;
+  const char *m_pDeferredPhysicalProperty;
+  const char *m_pDeferredSpring;
+  int m_deferredSpringCount;
+  std::atomic<bool> m_bDeferredData;
+  std::mutex m_mutexDeferredData;
+  CalCoreCloth m_coreCloth;
+  bool m_bCoreCloth;
 
 // constructors/destructor
 public:
@@ -107,14 +141,30 @@ public:
 
 // member functions	
 public:
+  bool buildLodLevels(int lodLevelCount);
+  void clearLodLevels();
   bool create();
+  void deferSprings(const void *pPhysicalProperty, const void *pSpring, int springCount);
+  void deferTangentSpaces(int textureCoordinateId, const void *pTangentSpace);
+  void deferTextureCoordinates(int textureCoordinateId, const void *pTextureCoordinate);
   void destroy();
+  int getCollapsibleVertexCount();
+  CalCoreCloth *getCoreCloth();
   int getCoreMaterialThreadId();
   int getFaceCount();
   int getLodCount();
+  int getLodFaceCount(int lodLevelId);
+  Face *getLodFaces(int lodLevelId);
+  ShortFace *getLodShortFaces(int lodLevelId);
+  int getLodLevelCount();
+  int getLodLevelId(float lodLevel);
+  int getLodVertexCount(int lodLevelId);
+  int getMemorySize();
   int getSpringCount();
   int getVertexCount();
   int getTextureCoordinateCount();
+  bool hasDeferredData();
+  void loadDeferredData();
   float *getTextureCoordinates(int textureCoordinateId);
   std::vector<Face>& getVectorFace();
   std::vector<PhysicalProperty>& getVectorPhysicalProperty();
@@ -128,6 +178,11 @@ public:
   std::vector<LodControl>& getVectorLodControl();
   bool tangentsEnabled(int mapId);
   bool enableTangents(int mapId, bool enabled);
+  bool enableShortFaces(bool enabled);
+  bool shortFacesEnabled();
+  bool optimizeVertexCache(bool bReorderVertices = true);
+  bool partitionVertices();
+  bool reorderVertices(const std::vector<int>& vectorNewVertexId);
   bool reserve(int vertexCount, int textureCoordinateCount, int faceCount, int springCount);
   bool resize(int vertexCount, int textureCoordinateCount, int faceCount, int springCount);
   void setCoreMaterialThreadId(int coreMaterialThreadId);
@@ -141,6 +196,15 @@ public:
   bool setVertex(int vertexId, const CalVector &position, const CalVector &normal);
   bool setInfluenceCount(int vertexId, int influenceCount);
   CalCoreVertexUserData *getVertexUserData(int vertexId);
+
+protected:
+  void clearCoreCloth();
+  bool findDeferredData();
+  const LodLevel& getLodLevel(int lodLevelId);
+  void loadDeferredSprings();
+  void loadDeferredTangentSpaces(int textureCoordinateId);
+  void loadDeferredTextureCoordinates(int textureCoordinateId);
+  bool sortLodLevels();
 };
 
 #endif
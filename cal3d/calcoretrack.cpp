@@ -19,6 +19,10 @@
 #include "calcoretrack.h"
 #include "calerror.h"
 #include "calcorekey.h"
+#include "calarena.h"
+#include "calnametable.h"
+
+#include <new>
 
  /*****************************************************************************/
 /** Constructs the core track instance.
@@ -29,6 +33,11 @@
 CalCoreTrack::CalCoreTrack()
 {
   m_coreBoneHint = -1;
+  m_coreBoneNameId = -1;
+  m_pArena = 0;
+  m_pCoreKeyframe = 0;
+  m_coreKeyframeCount = 0;
+  m_coreKeyframeCapacity = 0;
 }
 
  /*****************************************************************************/
@@ -39,13 +48,57 @@ CalCoreTrack::CalCoreTrack()
 
 CalCoreTrack::~CalCoreTrack()
 {
-  assert(m_mapCoreKeyframe.empty());
+  assert(m_pCoreKeyframe == 0);
+}
+
+ /*****************************************************************************/
+/** Allocates a core track instance.
+  *
+  * This function allocates a core track instance, either on the heap or in an
+  * arena. A core track allocated in an arena keeps its keyframes in the same
+  * arena. It must be released with Free() after it was destroyed.
+  *
+  * @param pArena A pointer to the arena, or \b 0 to use the heap.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core track
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreTrack *CalCoreTrack::Alloc(CalArena *pArena)
+{
+  if(pArena == 0) return new CalCoreTrack;
+
+  void *pMemory;
+  pMemory = pArena->allocate(sizeof(CalCoreTrack));
+  if(pMemory == 0) return 0;
+
+  CalCoreTrack *x;
+  x = new(pMemory) CalCoreTrack;
+  x->m_pArena = pArena;
+
+  return x;
+}
+
+void CalCoreTrack::Free(CalCoreTrack *x)
+{
+  if(x->m_pArena == 0)
+  {
+    delete x;
+  }
+  else
+  {
+    // the memory is released together with the arena
+    x->~CalCoreTrack();
+  }
 }
 
  /*****************************************************************************/
 /** Adds a core keyframe.
   *
-  * This function adds a core keyframe to the core track instance.
+  * This function adds a core keyframe to the core track instance. The track
+  * copies the keyframe into its keyframe array and takes ownership of the
+  * given instance, which is destroyed and deleted.
   *
   * @param pCoreKeyframe A pointer to the core keyframe that should be added.
   *
@@ -56,7 +109,57 @@ CalCoreTrack::~CalCoreTrack()
 
 bool CalCoreTrack::addCoreKeyframe(CalCoreKeyframe *pCoreKeyframe)
 {
-  m_mapCoreKeyframe.insert(std::make_pair(pCoreKeyframe->getTime(), pCoreKeyframe));
+  bool bSuccess;
+  bSuccess = addCoreKeyframe(*pCoreKeyframe);
+
+  pCoreKeyframe->destroy();
+  delete pCoreKeyframe;
+
+  return bSuccess;
+}
+
+ /*****************************************************************************/
+/** Adds a core keyframe.
+  *
+  * This function copies a core keyframe into the core track instance. The
+  * keyframes are kept sorted by time; a keyframe at the time of an existing
+  * keyframe is ignored.
+  *
+  * @param coreKeyframe The core keyframe that should be added.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreTrack::addCoreKeyframe(const CalCoreKeyframe& coreKeyframe)
+{
+  float time;
+  time = const_cast<CalCoreKeyframe&>(coreKeyframe).getTime();
+
+  // find the insertion point, keyframes usually arrive in order
+  int coreKeyframeId;
+  coreKeyframeId = m_coreKeyframeCount;
+  while((coreKeyframeId > 0) && (m_pCoreKeyframe[coreKeyframeId - 1].getTime() >= time))
+  {
+    if(m_pCoreKeyframe[coreKeyframeId - 1].getTime() == time) return true;
+    coreKeyframeId--;
+  }
+
+  // make room for the new keyframe, in an arena the old array is abandoned
+  if(m_coreKeyframeCount == m_coreKeyframeCapacity)
+  {
+    if(!reserve((m_coreKeyframeCapacity == 0) ? 8 : m_coreKeyframeCapacity * 2)) return false;
+  }
+
+  int shiftId;
+  for(shiftId = m_coreKeyframeCount; shiftId > coreKeyframeId; shiftId--)
+  {
+    m_pCoreKeyframe[shiftId] = m_pCoreKeyframe[shiftId - 1];
+  }
+
+  m_pCoreKeyframe[coreKeyframeId] = coreKeyframe;
+  m_coreKeyframeCount++;
 
   return true;
 }
@@ -80,104 +183,208 @@ bool CalCoreTrack::create()
 /** Destroys the core track instance.
   *
   * This function destroys all data stored in the core track instance and frees
-  * all allocated memory.
+  * all allocated memory. Keyframes stored in an arena are left to the arena.
   *****************************************************************************/
 
 void CalCoreTrack::destroy()
 {
-  // destroy all core keyframes
-  std::map<float, CalCoreKeyframe *>::iterator iteratorCoreKeyframe;
+  if(m_pArena == 0)
+  {
+    delete [] m_pCoreKeyframe;
+  }
+
+  m_pCoreKeyframe = 0;
+  m_coreKeyframeCount = 0;
+  m_coreKeyframeCapacity = 0;
+
+  m_coreBoneHint = -1;
+  m_coreBoneNameId = -1;
+}
+
+ /*****************************************************************************/
+/** Reserves memory for the keyframes.
+  *
+  * This function reserves memory for a given number of keyframes. Loaders
+  * call it with the exact count, so that a track in an arena needs a single
+  * allocation for all of its keyframes. An arena cannot free single
+  * allocations, so when a track in an arena grows past its capacity the old
+  * array stays in the arena, unused, until the arena is destroyed.
+  *
+  * @param coreKeyframeCount The number of keyframes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreTrack::reserve(int coreKeyframeCount)
+{
+  if(coreKeyframeCount <= m_coreKeyframeCapacity) return true;
 
-  for(iteratorCoreKeyframe = m_mapCoreKeyframe.begin(); iteratorCoreKeyframe != m_mapCoreKeyframe.end(); ++iteratorCoreKeyframe)
+  CalCoreKeyframe *pCoreKeyframe;
+  if(m_pArena == 0)
   {
-    CalCoreKeyframe *pCoreKeyframe;
-    pCoreKeyframe = iteratorCoreKeyframe->second;
+    pCoreKeyframe = new CalCoreKeyframe[coreKeyframeCount];
+  }
+  else
+  {
+    void *pMemory;
+    pMemory = m_pArena->allocate(coreKeyframeCount * sizeof(CalCoreKeyframe));
+    pCoreKeyframe = (CalCoreKeyframe *)pMemory;
+
+    // construct every keyframe in place, the array form of placement new may
+    // store a cookie in front of the array that was not allocated
+    int coreKeyframeId;
+    for(coreKeyframeId = 0; (pMemory != 0) && (coreKeyframeId < coreKeyframeCount); coreKeyframeId++)
+    {
+      new(&pCoreKeyframe[coreKeyframeId]) CalCoreKeyframe;
+    }
+  }
 
-    pCoreKeyframe->destroy();
-    delete pCoreKeyframe;
+  if(pCoreKeyframe == 0)
+  {
+    CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__, "CalCoreTrack::reserve");
+    return false;
   }
 
-  m_mapCoreKeyframe.clear();
+  // move the existing keyframes, an old array in the arena is abandoned
+  int coreKeyframeId;
+  for(coreKeyframeId = 0; coreKeyframeId < m_coreKeyframeCount; coreKeyframeId++)
+  {
+    pCoreKeyframe[coreKeyframeId] = m_pCoreKeyframe[coreKeyframeId];
+  }
 
-  m_coreBoneHint = -1;
+  if(m_pArena == 0)
+  {
+    delete [] m_pCoreKeyframe;
+  }
+
+  m_pCoreKeyframe = pCoreKeyframe;
+  m_coreKeyframeCapacity = coreKeyframeCount;
+
+  return true;
 }
 
  /*****************************************************************************/
-/** Returns the core keyframe map.
+/** Returns the memory size.
   *
-  * This function returns the map that contains all core keyframes of the core
-  * track instance.
+  * This function returns the heap memory used by the core track instance
+  * and its keyframes. A core track in an arena is counted with the arena and
+  * returns 0.
   *
-  * @return A reference to the core keyframe map.
+  * @return The memory size in bytes.
   *****************************************************************************/
 
-std::map<float, CalCoreKeyframe *>& CalCoreTrack::getMapCoreKeyframe()
+int CalCoreTrack::getMemorySize()
 {
-  return m_mapCoreKeyframe;
+  if(m_pArena != 0) return 0;
+
+  return sizeof(CalCoreTrack) + m_coreKeyframeCapacity * sizeof(CalCoreKeyframe);
 }
 
  /*****************************************************************************/
-/** Returns a specified state.
+/** Returns the number of core keyframes.
   *
-  * This function returns the state (translation and rotation of the core bone)
-  * for the specified time and duration.
+  * This function returns the number of core keyframes in the core track
+  * instance.
   *
-  * @param time The time in seconds at which the state should be returned.
+  * @return The number of core keyframes.
+  *****************************************************************************/
+
+int CalCoreTrack::getCoreKeyframeCount()
+{
+  return m_coreKeyframeCount;
+}
+
+ /*****************************************************************************/
+/** Provides access to a core keyframe.
+  *
+  * This function returns the core keyframe with the given ID. The keyframes
+  * are sorted by time.
+  *
+  * @param coreKeyframeId The ID of the core keyframe that should be returned.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core keyframe
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreKeyframe *CalCoreTrack::getCoreKeyframe(int coreKeyframeId)
+{
+  if((coreKeyframeId < 0) || (coreKeyframeId >= m_coreKeyframeCount))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalCoreTrack::getCoreKeyframe");
+    return 0;
+  }
+
+  return &m_pCoreKeyframe[coreKeyframeId];
+}
+
+ /*****************************************************************************/
+/** Returns the keyframes around a specified time.
+  *
+  * This function returns the two core keyframes that enclose the specified
+  * time, and the blending factor between them.
+  *
+  * @param time The time in seconds at which the keyframes should be returned.
   * @param duration The duration of the animation containing this core track
   *                 instance in seconds.
-  * @param translation A reference to the translation reference that will be
-  *                    filled with the specified state.
-  * @param rotation A reference to the rotation reference that will be filled
-  *                 with the specified state.
+  * @param pCoreKeyframeBefore A reference to the keyframe pointer that will be
+  *                            filled with the keyframe before the time.
+  * @param pCoreKeyframeAfter A reference to the keyframe pointer that will be
+  *                           filled with the keyframe after the time.
+  * @param blendFactor A reference to the factor that will be filled with the
+  *                    blending factor between the two keyframes.
   *
   * @return One of the following values:
   *         \li \b true if successful
   *         \li \b false if an error happend
   *****************************************************************************/
 
-bool CalCoreTrack::getState(float time, float duration, CalVector& orientation, CalQuaternion& rotation)
+bool CalCoreTrack::getKeyframes(float time, float duration, CalCoreKeyframe *&pCoreKeyframeBefore, CalCoreKeyframe *&pCoreKeyframeAfter, float& blendFactor)
 {
-  std::map<float, CalCoreKeyframe *>::iterator iteratorCoreKeyframeBefore;
-  std::map<float, CalCoreKeyframe *>::iterator iteratorCoreKeyframeAfter;
+  if(m_coreKeyframeCount == 0)
+  {
+    CalError::setLastError(CalError::INVALID_KEYFRAME_COUNT, __FILE__, __LINE__, "CalCoreTrack::getKeyframes");
+    return false;
+  }
 
-  // get the one core keyframe before and the one after the requested time
-  bool bWrap;
-  iteratorCoreKeyframeAfter = m_mapCoreKeyframe.upper_bound(time);
+  // get the first core keyframe after the requested time
+  int low, high;
+  low = 0;
+  high = m_coreKeyframeCount;
+  while(low < high)
+  {
+    int middle;
+    middle = (low + high) / 2;
+    if(m_pCoreKeyframe[middle].getTime() <= time) low = middle + 1; else high = middle;
+  }
+
+  int coreKeyframeIdBefore;
+  int coreKeyframeIdAfter;
+  coreKeyframeIdAfter = low;
 
   // check if we have a wrap-around
-  if(iteratorCoreKeyframeAfter == m_mapCoreKeyframe.end())
+  bool bWrap;
+  if(coreKeyframeIdAfter == m_coreKeyframeCount)
   {
-    iteratorCoreKeyframeBefore = iteratorCoreKeyframeAfter;
-    --iteratorCoreKeyframeBefore;
+    coreKeyframeIdBefore = m_coreKeyframeCount - 1;
+    coreKeyframeIdAfter = 0;
 
-    iteratorCoreKeyframeAfter = m_mapCoreKeyframe.begin();
-    
     bWrap = true;
   }
   else
   {
-    if(iteratorCoreKeyframeAfter == m_mapCoreKeyframe.begin())
-    {
-      iteratorCoreKeyframeBefore = m_mapCoreKeyframe.end();
-    }
-    else
-    {
-      iteratorCoreKeyframeBefore = iteratorCoreKeyframeAfter;
-    }
-    
-    --iteratorCoreKeyframeBefore;
-    
+    coreKeyframeIdBefore = (coreKeyframeIdAfter == 0) ? m_coreKeyframeCount - 1 : coreKeyframeIdAfter - 1;
+
     bWrap = false;
   }
 
   // get the two keyframes
-  CalCoreKeyframe *pCoreKeyframeBefore;
-  pCoreKeyframeBefore = iteratorCoreKeyframeBefore->second;
-  CalCoreKeyframe *pCoreKeyframeAfter;
-  pCoreKeyframeAfter = iteratorCoreKeyframeAfter->second;
+  pCoreKeyframeBefore = &m_pCoreKeyframe[coreKeyframeIdBefore];
+  pCoreKeyframeAfter = &m_pCoreKeyframe[coreKeyframeIdAfter];
 
   // calculate the blending factor between the two keyframe states
-  float blendFactor;
   if(bWrap)
   {
     blendFactor = (time - pCoreKeyframeBefore->getTime()) / (duration - pCoreKeyframeBefore->getTime());
@@ -187,12 +394,46 @@ bool CalCoreTrack::getState(float time, float duration, CalVector& orientation,
     blendFactor = (time - pCoreKeyframeBefore->getTime()) / (pCoreKeyframeAfter->getTime() - pCoreKeyframeBefore->getTime());
   }
 
+  return true;
+}
+
+ /*****************************************************************************/
+/** Returns a specified state.
+  *
+  * This function returns the state (translation and rotation of the core bone)
+  * for the specified time and duration.
+  *
+  * @param time The time in seconds at which the state should be returned.
+  * @param duration The duration of the animation containing this core track
+  *                 instance in seconds.
+  * @param translation A reference to the translation reference that will be
+  *                    filled with the specified state.
+  * @param rotation A reference to the rotation reference that will be filled
+  *                 with the specified state.
+  * @param mode The quaternion interpolation mode.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalCoreTrack::getState(float time, float duration, CalVector& orientation, CalQuaternion& rotation, int mode)
+{
+  // get the two keyframes and the blending factor between them
+  CalCoreKeyframe *pCoreKeyframeBefore;
+  CalCoreKeyframe *pCoreKeyframeAfter;
+  float blendFactor;
+  if(!getKeyframes(time, duration, pCoreKeyframeBefore, pCoreKeyframeAfter, blendFactor))
+  {
+    return false;
+  }
+
   // blend between the two keyframes
   orientation = pCoreKeyframeBefore->getOrientation();
   orientation.blend(blendFactor, pCoreKeyframeAfter->getOrientation());
 
   rotation = pCoreKeyframeBefore->getRotation();
-  rotation.blend(blendFactor, pCoreKeyframeAfter->getRotation());
+  rotation.blend(blendFactor, pCoreKeyframeAfter->getRotation(), mode);
 
   return true;
 }
@@ -231,15 +472,32 @@ void CalCoreTrack::setCoreBoneHint(int coreBoneId)
   *
   *****************************************************************************/
 
-std::string& CalCoreTrack::getCoreBoneName(void)
+const std::string& CalCoreTrack::getCoreBoneName(void)
 {
-  return m_coreBoneName;
+  return CalNameTable::getName(m_coreBoneNameId);
+}
+
+ /*****************************************************************************/
+/** Gets the bone name ID of the core track.
+  *
+  * This function gets the ID of the bone name of the core track in the name
+  * table.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the name
+  *         \li \b -1 if no bone name is set
+  *****************************************************************************/
+
+int CalCoreTrack::getCoreBoneNameId()
+{
+  return m_coreBoneNameId;
 }
 
  /*****************************************************************************/
 /** Sets the bone name of the core track.
   *
-  * This function set the bone name of the core track.
+  * This function sets the bone name of the core track. The name is interned
+  * in the name table.
   *
   * @param name The name to store.
   *
@@ -247,7 +505,22 @@ std::string& CalCoreTrack::getCoreBoneName(void)
 
 void CalCoreTrack::setCoreBoneName(const std::string& name)
 {
-  m_coreBoneName = name;
+  m_coreBoneNameId = CalNameTable::intern(name);
+}
+
+ /*****************************************************************************/
+/** Sets the bone name ID of the core track.
+  *
+  * This function sets the bone name of the core track by its ID in the name
+  * table.
+  *
+  * @param nameId The ID of the name to store.
+  *
+  *****************************************************************************/
+
+void CalCoreTrack::setCoreBoneNameId(int nameId)
+{
+  m_coreBoneNameId = nameId;
 }
 
 //****************************************************************************//
@@ -23,6 +23,7 @@
 // Forward declarations                                                       //
 //****************************************************************************//
 
+class CalArena;
 class CalCoreBone;
 class CalCoreKeyframe;
 
@@ -39,25 +40,37 @@ class CAL3D_API CalCoreTrack: public CalCoreTrackUserData
 // member variables
 protected:
   int m_coreBoneHint;
-  std::string m_coreBoneName;
-  std::map<float, CalCoreKeyframe *> m_mapCoreKeyframe;
+  int m_coreBoneNameId;
+  CalArena *m_pArena;
+  CalCoreKeyframe *m_pCoreKeyframe;
+  int m_coreKeyframeCount;
+  int m_coreKeyframeCapacity;
 
 // constructors/destructor
 public:
   CalCoreTrack();
   virtual ~CalCoreTrack();
+  static CalCoreTrack *Alloc(CalArena *pArena = 0);
+  static void Free(CalCoreTrack *x);
 
 // member functions	
 public:
   bool addCoreKeyframe(CalCoreKeyframe *pCoreKeyframe);
+  bool addCoreKeyframe(const CalCoreKeyframe& coreKeyframe);
   bool create();
   void destroy();
+  bool reserve(int coreKeyframeCount);
   int getCoreBoneHint();
   void setCoreBoneHint(int coreBoneId);
-  std::string& getCoreBoneName(void);
+  const std::string& getCoreBoneName(void);
+  int getCoreBoneNameId();
   void setCoreBoneName(const std::string& name);
-  std::map<float, CalCoreKeyframe *>& getMapCoreKeyframe();
-  bool getState(float time, float duration, CalVector& orientation, CalQuaternion& rotation);
+  void setCoreBoneNameId(int nameId);
+  int getCoreKeyframeCount();
+  int getMemorySize();
+  CalCoreKeyframe *getCoreKeyframe(int coreKeyframeId);
+  bool getKeyframes(float time, float duration, CalCoreKeyframe *&pCoreKeyframeBefore, CalCoreKeyframe *&pCoreKeyframeAfter, float& blendFactor);
+  bool getState(float time, float duration, CalVector& orientation, CalQuaternion& rotation, int mode = INTERPOLATE_SLERP);
 };
 
 #endif
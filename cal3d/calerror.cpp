@@ -14,12 +14,14 @@
 
 #include "calerror.h"
 
+// the last error is kept per thread, so that loads running on worker threads
+// neither race on it nor overwrite the error of the main thread
 namespace
 {
-    CalError::Code m_lastErrorCode = CalError::OK;
-    std::string m_strLastErrorFile;
-    int m_lastErrorLine = -1;
-    std::string m_strLastErrorText;
+    thread_local CalError::Code m_lastErrorCode = CalError::OK;
+    thread_local std::string m_strLastErrorFile;
+    thread_local int m_lastErrorLine = -1;
+    thread_local std::string m_strLastErrorText;
 }
 
  /*****************************************************************************/
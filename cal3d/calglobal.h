@@ -46,6 +46,8 @@ namespace Cal
   const char ANIMATION_FILE_MAGIC[4] = { 'C', 'A', 'F', '\0' };
   const char MESH_FILE_MAGIC[4]      = { 'C', 'M', 'F', '\0' };
   const char MATERIAL_FILE_MAGIC[4]  = { 'C', 'R', 'F', '\0' };
+  const char BINARY_MODEL_FILE_MAGIC[4] = { 'C', 'B', 'F', '\0' };
+  const char PACK_FILE_MAGIC[4]      = { 'C', 'P', 'F', '\0' };
   
   // library version
   const int LIBRARY_VERSION = 710;
@@ -54,6 +56,33 @@ namespace Cal
   const int CURRENT_FILE_VERSION = LIBRARY_VERSION;
   const int EARLIEST_COMPATIBLE_FILE_VERSION = 700;
 
+  // binary model file layout version, bumped whenever the layout changes
+  const int BINARY_FILE_VERSION = 1;
+
+  // pack file layout version
+  const int PACK_FILE_VERSION = 1;
+
+  // number of precomputed LOD levels of a core submesh
+  const int LOD_LEVEL_COUNT = 16;
+
+  // number of vertices of the simulated post-transform vertex cache
+  const int VERTEX_CACHE_SIZE = 32;
+
+  // number of vertices that 16-bit faces can address
+  const int SHORT_FACE_VERTEX_COUNT = 65536;
+
+  // default number of times the springs of a cloth are relaxed per update
+  const int SPRING_ITERATION_COUNT = 2;
+
+  // default fixed time step of a cloth, and the most steps taken per update
+  const float SPRING_TIME_STEP = 1.0f / 60.0f;
+  const int SPRING_SUBSTEP_COUNT = 4;
+
+  // default motion per step below which a cloth counts as still, and the
+  // number of still steps after which it falls asleep
+  const float SPRING_SLEEP_THRESHOLD = 0.01f;
+  const int SPRING_SLEEP_STEP_COUNT = 30;
+
   // empty string
   const std::string strNull;
 };
@@ -0,0 +1,544 @@
+//****************************************************************************//
+// incloader.cpp                                                              //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calincloader.h"
+#include "calerror.h"
+#include "buffersource.h"
+#include "calcoremodel.h"
+#include "calcorebone.h"
+#include "calcoreanim.h"
+#include "calcoretrack.h"
+#include "calcoresub.h"
+
+#include <algorithm>
+#include <chrono>
+
+// The number of vertices or keyframes decoded between two checks of the
+// time budget.
+
+static const int INCREMENTAL_BATCH_SIZE = 256;
+
+ /*****************************************************************************/
+/** Constructs the incremental loader instance.
+  *
+  * This function is the default constructor of the incremental loader
+  * instance.
+  *****************************************************************************/
+
+CalIncrementalLoader::CalIncrementalLoader()
+{
+  m_pBuffer = 0;
+  m_size = 0;
+  m_position = 0;
+  m_pCoreAnimation = 0;
+  m_pCoreModel = 0;
+  m_pCoreSubmesh = 0;
+  m_pCoreTrack = 0;
+  m_status = STATUS_IDLE;
+  m_phase = PHASE_MODEL_HEADER;
+  m_count = 0;
+  m_id = 0;
+  m_itemCount = 0;
+  m_itemId = 0;
+}
+
+ /*****************************************************************************/
+/** Destructs the incremental loader instance.
+  *
+  * This function is the destructor of the incremental loader instance. A
+  * pending load is cancelled.
+  *****************************************************************************/
+
+CalIncrementalLoader::~CalIncrementalLoader()
+{
+  cancel();
+}
+
+ /*****************************************************************************/
+/** Starts loading from memory.
+  *
+  * This function resets the parse state to the start of a buffer.
+  *
+  * @param pBuffer A pointer to the data.
+  * @param len The size of the data in bytes.
+  * @param phase The phase to start in.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalIncrementalLoader::begin(const void *pBuffer, int len, int phase)
+{
+  m_status = STATUS_PENDING;
+
+  if((pBuffer == 0) || (len < 0))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
+    fail();
+    return false;
+  }
+
+  m_pBuffer = (const char *)pBuffer;
+  m_size = len;
+  m_position = 0;
+  m_phase = phase;
+  m_count = 0;
+  m_id = 0;
+  m_itemCount = 0;
+  m_itemId = 0;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Starts loading a core animation.
+  *
+  * This function maps a core animation file and prepares to decode it with
+  * step().
+  *
+  * @param anim The core animation to load into.
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalIncrementalLoader::beginCoreAnimation(CalCoreAnimation *anim, const std::string& strFilename)
+{
+  cancel();
+
+  // map the file, the error is set by the mapped file
+  if(!m_file.open(strFilename))
+  {
+    anim->destroy();
+    m_status = STATUS_FAILED;
+    return false;
+  }
+
+  m_pCoreAnimation = anim;
+  return begin(m_file.getData(), m_file.getSize(), PHASE_ANIMATION_HEADER);
+}
+
+ /*****************************************************************************/
+/** Starts loading a core animation from memory.
+  *
+  * This function prepares to decode a core animation from a buffer with
+  * step(). The buffer must stay valid until the load has finished.
+  *
+  * @param anim The core animation to load into.
+  * @param pBuffer A pointer to the data.
+  * @param len The size of the data in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalIncrementalLoader::beginCoreAnimation(CalCoreAnimation *anim, const void *pBuffer, int len)
+{
+  cancel();
+
+  m_pCoreAnimation = anim;
+  return begin(pBuffer, len, PHASE_ANIMATION_HEADER);
+}
+
+ /*****************************************************************************/
+/** Starts loading a core model.
+  *
+  * This function maps a core model file and prepares to decode it with
+  * step().
+  *
+  * @param model The core model to load into.
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalIncrementalLoader::beginCoreModel(CalCoreModel *model, const std::string& strFilename)
+{
+  cancel();
+
+  // map the file, the error is set by the mapped file
+  if(!m_file.open(strFilename))
+  {
+    model->destroy();
+    m_status = STATUS_FAILED;
+    return false;
+  }
+
+  m_pCoreModel = model;
+  return begin(m_file.getData(), m_file.getSize(), PHASE_MODEL_HEADER);
+}
+
+ /*****************************************************************************/
+/** Starts loading a core model from memory.
+  *
+  * This function prepares to decode a core model from a buffer with step().
+  * The buffer must stay valid until the load has finished.
+  *
+  * @param model The core model to load into.
+  * @param pBuffer A pointer to the data.
+  * @param len The size of the data in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalIncrementalLoader::beginCoreModel(CalCoreModel *model, const void *pBuffer, int len)
+{
+  cancel();
+
+  m_pCoreModel = model;
+  return begin(pBuffer, len, PHASE_MODEL_HEADER);
+}
+
+ /*****************************************************************************/
+/** Cancels the load.
+  *
+  * This function stops a pending load. The partly loaded core model or core
+  * animation is destroyed, as it would be after a failed load. A finished
+  * load is left alone.
+  *****************************************************************************/
+
+void CalIncrementalLoader::cancel()
+{
+  if(m_status == STATUS_PENDING)
+  {
+    // release the parts not yet added to the core model or core animation
+    if(m_pCoreTrack != 0)
+    {
+      m_pCoreTrack->destroy();
+      CalCoreTrack::Free(m_pCoreTrack);
+    }
+
+    if(m_pCoreSubmesh != 0)
+    {
+      m_pCoreSubmesh->destroy();
+      delete m_pCoreSubmesh;
+    }
+
+    if(m_pCoreAnimation != 0) m_pCoreAnimation->destroy();
+    if(m_pCoreModel != 0) m_pCoreModel->destroy();
+  }
+
+  finish();
+  m_status = STATUS_IDLE;
+}
+
+ /*****************************************************************************/
+/** Fails the load.
+  *
+  * This function cancels a pending load after an error. The error is set by
+  * the caller.
+  *****************************************************************************/
+
+void CalIncrementalLoader::fail()
+{
+  cancel();
+  m_status = STATUS_FAILED;
+}
+
+ /*****************************************************************************/
+/** Finishes the load.
+  *
+  * This function marks the load as done and releases the file.
+  *****************************************************************************/
+
+void CalIncrementalLoader::finish()
+{
+  m_file.close();
+  m_pBuffer = 0;
+  m_pCoreAnimation = 0;
+  m_pCoreModel = 0;
+  m_pCoreSubmesh = 0;
+  m_pCoreTrack = 0;
+  m_status = STATUS_DONE;
+}
+
+ /*****************************************************************************/
+/** Returns the progress of the load.
+  *
+  * This function returns the part of the data that has been decoded.
+  *
+  * @return The progress, from 0.0 to 1.0.
+  *****************************************************************************/
+
+float CalIncrementalLoader::getProgress()
+{
+  if(m_status == STATUS_DONE) return 1.0f;
+  if((m_status != STATUS_PENDING) || (m_size <= 0)) return 0.0f;
+
+  return (float)m_position / (float)m_size;
+}
+
+ /*****************************************************************************/
+/** Returns the status of the load.
+  *
+  * This function returns the status of the load.
+  *
+  * @return One of the following values:
+  *         \li \b STATUS_IDLE if no load was started
+  *         \li \b STATUS_PENDING if the load needs more steps
+  *         \li \b STATUS_DONE if the load has finished
+  *         \li \b STATUS_FAILED if an error happend
+  *****************************************************************************/
+
+int CalIncrementalLoader::getStatus()
+{
+  return m_status;
+}
+
+ /*****************************************************************************/
+/** Continues the load.
+  *
+  * This function decodes units of work until the time budget is used up or
+  * the load is finished. A unit is a header, a bone, a track header, or a
+  * batch of vertices or keyframes, and at least one unit is decoded on every
+  * call. The parse state is kept for the next call.
+  *
+  * @param maxMicroseconds The time budget in microseconds.
+  *
+  * @return One of the following values:
+  *         \li \b STATUS_IDLE if no load was started
+  *         \li \b STATUS_PENDING if the load needs more steps
+  *         \li \b STATUS_DONE if the load has finished
+  *         \li \b STATUS_FAILED if an error happend
+  *****************************************************************************/
+
+int CalIncrementalLoader::step(int maxMicroseconds)
+{
+  if(m_status != STATUS_PENDING) return m_status;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::chrono::microseconds budget(maxMicroseconds);
+
+  // resume reading where the last step stopped
+  CalBufferReader dataSrc(m_pBuffer + m_position, m_size - m_position);
+
+  while(m_status == STATUS_PENDING)
+  {
+    if(!stepUnit(dataSrc))
+    {
+      fail();
+      break;
+    }
+
+    if(m_status != STATUS_PENDING) break;
+    m_position = dataSrc.getPosition() - m_pBuffer;
+
+    if(std::chrono::steady_clock::now() - start >= budget) break;
+  }
+
+  return m_status;
+}
+
+ /*****************************************************************************/
+/** Decodes one unit of work.
+  *
+  * This function decodes the next unit of the current phase, and moves on to
+  * the next phase when the current one is complete.
+  *
+  * @param dataSrc The buffer reader positioned at the next unit.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalIncrementalLoader::stepUnit(CalBufferReader& dataSrc)
+{
+  switch(m_phase)
+  {
+    case PHASE_ANIMATION_HEADER:
+    {
+      // check if this is a valid file
+      char magic[4];
+      if(!dataSrc.readBytes(&magic[0], 4) || (memcmp(&magic[0], Cal::ANIMATION_FILE_MAGIC, 4) != 0))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        return false;
+      }
+
+      // check if the version is compatible with the library
+      int version;
+      if(!dataSrc.readInteger(version) || (version < Cal::EARLIEST_COMPATIBLE_FILE_VERSION) || (version > Cal::CURRENT_FILE_VERSION))
+      {
+        CalError::setLastError(CalError::INCOMPATIBLE_FILE_VERSION, __FILE__, __LINE__);
+        return false;
+      }
+
+      // get the duration of the core animation
+      float duration;
+      if(!dataSrc.readFloat(duration))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        return false;
+      }
+
+      // check for a valid duration
+      if(duration <= 0.0f)
+      {
+        CalError::setLastError(CalError::INVALID_ANIMATION_DURATION, __FILE__, __LINE__);
+        return false;
+      }
+
+      m_pCoreAnimation->setDuration(duration);
+
+      // read the number of tracks
+      if(!dataSrc.readInteger(m_count) || (m_count <= 0) || !dataSrc.hasRecords(m_count, 8))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        return false;
+      }
+
+      m_pCoreAnimation->reserve(m_count);
+      m_phase = PHASE_TRACK_HEADER;
+      return true;
+    }
+
+    case PHASE_TRACK_HEADER:
+    {
+      m_pCoreTrack = loadCoreTrackHeader(dataSrc, m_pCoreAnimation->getArena(), m_itemCount);
+      if(m_pCoreTrack == 0) return false;
+
+      m_itemId = 0;
+      m_phase = PHASE_KEYFRAMES;
+      return true;
+    }
+
+    case PHASE_KEYFRAMES:
+    {
+      int keyframeCount;
+      keyframeCount = std::min(INCREMENTAL_BATCH_SIZE, m_itemCount - m_itemId);
+      if(!loadCoreKeyframes(dataSrc, m_pCoreTrack, keyframeCount)) return false;
+
+      m_itemId += keyframeCount;
+      if(m_itemId < m_itemCount) return true;
+
+      // the track is complete
+      m_pCoreAnimation->addCoreTrack(m_pCoreTrack);
+      m_pCoreTrack = 0;
+
+      if(++m_id < m_count) m_phase = PHASE_TRACK_HEADER;
+      else finish();
+      return true;
+    }
+
+    case PHASE_MODEL_HEADER:
+    {
+      // check if this is a valid file
+      char magic[4];
+      if(!dataSrc.readBytes(&magic[0], 4) || (memcmp(&magic[0], Cal::MODEL_FILE_MAGIC, 4) != 0))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        return false;
+      }
+
+      // check if the version is compatible with the library
+      int version;
+      if(!dataSrc.readInteger(version) || (version < Cal::EARLIEST_COMPATIBLE_FILE_VERSION) || (version > Cal::CURRENT_FILE_VERSION))
+      {
+        CalError::setLastError(CalError::INCOMPATIBLE_FILE_VERSION, __FILE__, __LINE__);
+        return false;
+      }
+
+      // read the number of bones
+      if(!dataSrc.readInteger(m_count) || (m_count <= 0))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        return false;
+      }
+
+      m_phase = PHASE_BONES;
+      return true;
+    }
+
+    case PHASE_BONES:
+    {
+      CalCoreBone *pCoreBone;
+      pCoreBone = loadCoreBones(dataSrc);
+      if(pCoreBone == 0) return false;
+
+      pCoreBone->setCoreModel(m_pCoreModel);
+      m_pCoreModel->m_vectorCoreBone.push_back(pCoreBone);
+
+      if(++m_id == m_count) m_phase = PHASE_SUBMESH_COUNT;
+      return true;
+    }
+
+    case PHASE_SUBMESH_COUNT:
+    {
+      // get the number of submeshes
+      if(!dataSrc.readInteger(m_count))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        return false;
+      }
+
+      m_id = 0;
+      if(m_count > 0) m_phase = PHASE_SUBMESH_HEADER;
+      else finish();
+      return true;
+    }
+
+    case PHASE_SUBMESH_HEADER:
+    {
+      m_pCoreSubmesh = loadCoreSubmeshHeader(dataSrc);
+      if(m_pCoreSubmesh == 0) return false;
+
+      m_itemCount = m_pCoreSubmesh->getVertexCount();
+      m_itemId = 0;
+      m_phase = PHASE_VERTICES;
+      return true;
+    }
+
+    case PHASE_VERTICES:
+    {
+      int vertexCount;
+      vertexCount = std::min(INCREMENTAL_BATCH_SIZE, m_itemCount - m_itemId);
+      if(!loadCoreSubmeshVertices(dataSrc, m_pCoreSubmesh, m_itemId, vertexCount)) return false;
+
+      m_itemId += vertexCount;
+      if(m_itemId >= m_itemCount) m_phase = PHASE_FACES;
+      return true;
+    }
+
+    case PHASE_FACES:
+    {
+      if(!loadCoreSubmeshFaces(dataSrc, m_pCoreSubmesh)) return false;
+
+      // the submesh is complete
+      m_pCoreModel->m_vectorCoreSubmesh.push_back(m_pCoreSubmesh);
+      m_pCoreSubmesh = 0;
+
+      if(++m_id < m_count) m_phase = PHASE_SUBMESH_HEADER;
+      else finish();
+      return true;
+    }
+  }
+
+  CalError::setLastError(CalError::INTERNAL, __FILE__, __LINE__);
+  return false;
+}
+
+//****************************************************************************//
@@ -0,0 +1,105 @@
+//****************************************************************************//
+// incloader.h                                                                //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_INCLOADER_H
+#define CAL_INCLOADER_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+#include "calloader.h"
+#include "calmapfile.h"
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The incremental loader class.
+  *
+  * An incremental loader loads a core model or a core animation in small
+  * steps, so that loading can be spread over several frames of the calling
+  * thread. Each call of step() decodes bones, batches of vertices or batches
+  * of keyframes until its time budget is used up, and keeps the parse state
+  * for the next call. The result is the same as loading the file with
+  * CalLoader in one go.
+  *****************************************************************************/
+
+class CAL3D_API CalIncrementalLoader : public CalLoader
+{
+// misc
+public:
+  enum Status
+  {
+    STATUS_IDLE = 0,
+    STATUS_PENDING,
+    STATUS_DONE,
+    STATUS_FAILED
+  };
+
+protected:
+  enum Phase
+  {
+    PHASE_ANIMATION_HEADER = 0,
+    PHASE_TRACK_HEADER,
+    PHASE_KEYFRAMES,
+    PHASE_MODEL_HEADER,
+    PHASE_BONES,
+    PHASE_SUBMESH_COUNT,
+    PHASE_SUBMESH_HEADER,
+    PHASE_VERTICES,
+    PHASE_FACES
+  };
+
+// member variables
+protected:
+  CalMappedFile m_file;
+  const char *m_pBuffer;
+  int m_size;
+  int m_position;
+  CalCoreAnimation *m_pCoreAnimation;
+  CalCoreModel *m_pCoreModel;
+  CalCoreSubmesh *m_pCoreSubmesh;
+  CalCoreTrack *m_pCoreTrack;
+  int m_status;
+  int m_phase;
+  int m_count;
+  int m_id;
+  int m_itemCount;
+  int m_itemId;
+
+// constructors/destructor
+public:
+  CalIncrementalLoader();
+  virtual ~CalIncrementalLoader();
+
+// member functions
+public:
+  bool beginCoreAnimation(CalCoreAnimation *anim, const std::string& strFilename);
+  bool beginCoreAnimation(CalCoreAnimation *anim, const void *pBuffer, int len);
+  bool beginCoreModel(CalCoreModel *model, const std::string& strFilename);
+  bool beginCoreModel(CalCoreModel *model, const void *pBuffer, int len);
+  void cancel();
+  float getProgress();
+  int getStatus();
+  int step(int maxMicroseconds);
+
+protected:
+  bool begin(const void *pBuffer, int len, int phase);
+  void fail();
+  void finish();
+  bool stepUnit(CalBufferReader& dataSrc);
+};
+
+#endif
+
+//****************************************************************************//
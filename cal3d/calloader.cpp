@@ -31,8 +31,113 @@
 #include "calcoresub.h"
 #include "buffersource.h"
 #include "streamsource.h"
+#include "calbinary.h"
+#include "calmapfile.h"
+#include "calnametable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <thread>
 
 int CalLoader::loadingMode;
+int CalLoader::loadingThreadCount;
+
+// A model in a memory buffer is only decoded in parallel above this size.
+static const int PARALLEL_SUBMESH_MIN_SIZE = 256 * 1024;
+
+// Set on the workers of an asynchronous loader, which already keep the cores
+// busy with one load each, so they decode their models on their own.
+static thread_local bool workerThread = false;
+
+// Block reads. The buffer reader checks a whole block against the buffer
+// length once; any other data source reads it with a single readBytes call.
+
+static inline bool readWords(CalBufferReader& dataSrc, void *pBuffer, int count)
+{
+  return dataSrc.readWords(pBuffer, count);
+}
+
+static inline bool readWords(CalDataSource& dataSrc, void *pBuffer, int count)
+{
+  if((count < 0) || (count > INT_MAX / 4) || !dataSrc.readBytes(pBuffer, count * 4)) return false;
+  CalPlatform::swapWords(pBuffer, count);
+  return true;
+}
+
+// Checks that a number of records can still be read before memory is
+// reserved for them. Only the buffer reader knows its size, any other data
+// source can only reject a block larger than a single read.
+
+static inline bool hasRecords(CalBufferReader& dataSrc, int count, int size)
+{
+  return dataSrc.hasRecords(count, size);
+}
+
+static inline bool hasRecords(CalDataSource&, int count, int size)
+{
+  return (count >= 0) && (size > 0) && (count <= INT_MAX / size);
+}
+
+// Reads a bone name, the terminator is part of the length, and interns it
+// in the name table. The buffer reader interns it straight from the buffer.
+
+static inline int readNameId(CalBufferReader& dataSrc, int len)
+{
+  const char *pName = dataSrc.getPosition();
+  if(!dataSrc.skipBytes(len)) return -1;
+  return CalNameTable::intern(pName, strnlen(pName, len));
+}
+
+static inline int readNameId(CalDataSource& dataSrc, int len)
+{
+  std::vector<char> vectorName(len);
+  if(!dataSrc.readBytes(&vectorName[0], len)) return -1;
+  return CalNameTable::intern(&vectorName[0], strnlen(&vectorName[0], len));
+}
+
+// Moves the buffer reader over a submesh without decoding it. Only the
+// influence counts and the tangent space flags are read, since they decide
+// the size of the vertex records.
+
+static bool skipCoreSubmesh(CalBufferReader& dataSrc)
+{
+  int header[6];
+  if(!dataSrc.readWords(header, 6)) return false;
+
+  int vertexCount = header[1];
+  int faceCount = header[2];
+  int springCount = header[4];
+  int textureCoordinateCount = header[5];
+
+  if(!dataSrc.hasRecords(textureCoordinateCount, 1)
+  || !dataSrc.hasRecords(vertexCount, 27 + textureCoordinateCount * 8)) return false;
+
+  // the size of a vertex record before and after its influences
+  int vertexSize = 23;
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < textureCoordinateCount; textureCoordinateId++)
+  {
+    char ena;
+    dataSrc.readBytes(&ena, 1);
+    vertexSize += ena ? 12 : 8;
+  }
+  int physicalPropertySize = (springCount > 0) ? 4 : 0;
+
+  int vertexId;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    int influenceCount;
+    if(!dataSrc.skipBytes(vertexSize) || !dataSrc.readInteger(influenceCount)
+    || !dataSrc.hasRecords(influenceCount, sizeof(CalCoreSubmesh::Influence))
+    || !dataSrc.skipBytes(influenceCount * sizeof(CalCoreSubmesh::Influence) + physicalPropertySize)) return false;
+  }
+
+  return dataSrc.hasRecords(springCount, sizeof(CalCoreSubmesh::Spring))
+      && dataSrc.skipBytes(springCount * sizeof(CalCoreSubmesh::Spring))
+      && dataSrc.hasRecords(faceCount, sizeof(CalCoreSubmesh::Face))
+      && dataSrc.skipBytes(faceCount * sizeof(CalCoreSubmesh::Face));
+}
                                                                                                             
  /*****************************************************************************/
 /** Sets optional flags which affect how the model is loaded into memory.
@@ -44,6 +149,14 @@ int CalLoader::loadingMode;
   *             which has the effect of swapping Y/Z coordinates.
   *         \li LOADER_INVERT_V_COORD will substitute (1-v) for any v texture coordinate
   *             to eliminate the need for texture inversion after export.
+  *         \li LOADER_DEFER_CHANNELS will leave the tangent spaces, the texture
+  *             coordinates past the first channel and the springs of binary
+  *             models in the loaded file until they are first used. Only
+  *             loadBinaryCoreModel() defers; the other loaders ignore it.
+  *         \li LOADER_OPTIMIZE_VERTEX_CACHE will sort the faces and vertices of
+  *             every submesh for the vertex cache, and put the pinned vertices
+  *             of a spring system ahead of the simulated ones (see
+  *             CalCoreSubmesh::optimizeVertexCache()).
   *
   *****************************************************************************/
 void CalLoader::setLoadingMode(int flags)
@@ -51,6 +164,39 @@ void CalLoader::setLoadingMode(int flags)
   loadingMode = flags;
 }
 
+ /*****************************************************************************/
+/** Sets the number of threads used to decode a model.
+  *
+  * This function sets how many threads decode the submeshes of a core model
+  * loaded from memory (or from a file, which is mapped into memory) for all
+  * future loader calls.
+  *
+  * The workers of a CalAsyncLoader always decode on their own thread.
+  *
+  * @param count The number of threads, 1 to decode on the calling thread
+  *              only, or 0 to use all hardware threads (the default).
+  *****************************************************************************/
+
+void CalLoader::setLoadingThreadCount(int count)
+{
+  loadingThreadCount = count;
+}
+
+ /*****************************************************************************/
+/** Marks the calling thread as a worker of an asynchronous loader.
+  *
+  * This function makes all loads on the calling thread decode their
+  * submeshes on that thread only, so that the workers of an asynchronous
+  * loader do not each start a pool of their own.
+  *
+  * @param bWorkerThread \b true if the thread is a worker, \b false if not.
+  *****************************************************************************/
+
+void CalLoader::setWorkerThread(bool bWorkerThread)
+{
+  workerThread = bWorkerThread;
+}
+
  /*****************************************************************************/
 /** Constructs the loader instance.
   *
@@ -73,30 +219,24 @@ CalLoader::~CalLoader()
 
  /*****************************************************************************/
 /** Loads a core animation.
+  *
+  * This function loads a core animation from a file. The file is mapped into
+  * memory (or read with a single read where that is not possible) and decoded
+  * with the inline CalBufferReader, instead of going through an ifstream.
   *****************************************************************************/
 
 bool CalLoader::loadCoreAnimation(CalCoreAnimation *anim, const std::string& strFilename)
 {
-  // open the file
-  std::ifstream file;
-  file.open(strFilename.c_str(), std::ios::in | std::ios::binary);
-
-  //make sure it was opened properly
-  if(!file)
+  // map the file, the error is set by the mapped file
+  CalMappedFile file;
+  if(!file.open(strFilename))
   {
-    CalError::setLastError(CalError::FILE_NOT_FOUND, __FILE__, __LINE__, strFilename);
     anim->destroy(); return false;
   }
 
-  //make a new stream data source and use it to load the animation
-  CalStreamSource streamSrc( file );
-
-  bool coreanim = loadCoreAnimation(anim, streamSrc);
-
-  //close the file
-  file.close();
-
-  return coreanim;
+  // decode it straight from memory
+  CalBufferReader bufferSrc(file.getData(), file.getSize());
+  return loadCoreAnimationData(anim, bufferSrc);
 }
 
  /*****************************************************************************/
@@ -119,16 +259,35 @@ bool CalLoader::loadCoreAnimation(CalCoreAnimation *anim, std::istream& inputStr
    return loadCoreAnimation(anim, streamSrc);
 }
 
+ /*****************************************************************************/
+/** Loads a core animation instance.
+  *
+  * This function loads a core animation instance from a memory buffer. The
+  * buffer is decoded with the inline CalBufferReader, and every read is
+  * checked against the buffer length.
+  *
+  * @param inputBuffer The buffer to load the core animation instance from.
+  * @param len The size of the buffer in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
 bool CalLoader::loadCoreAnimation(CalCoreAnimation *anim, void* inputBuffer, int len, const std::string& strFilename)
 {
-  //Create a new buffer data source and pass it on
-  CalBufferSource bufferSrc(inputBuffer);
-
-  // std::istrstream file(data, len);
-  return loadCoreAnimation(anim, bufferSrc);
+  //Create a new buffer reader and pass it on
+  CalBufferReader bufferSrc(inputBuffer, len);
+  return loadCoreAnimationData(anim, bufferSrc);
 }
 
 bool CalLoader::loadCoreAnimation(CalCoreAnimation *anim, CalDataSource& dataSrc)
+{
+  return loadCoreAnimationData(anim, dataSrc);
+}
+
+template<class DataSource>
+bool CalLoader::loadCoreAnimationData(CalCoreAnimation *anim, DataSource& dataSrc)
 {
   // check if this is a valid file
   char magic[4];
@@ -166,19 +325,21 @@ bool CalLoader::loadCoreAnimation(CalCoreAnimation *anim, CalDataSource& dataSrc
   
   // read the number of tracks
   int trackCount;
-  if(!dataSrc.readInteger(trackCount) || (trackCount <= 0))
+  if(!dataSrc.readInteger(trackCount) || (trackCount <= 0) || !hasRecords(dataSrc, trackCount, 8))
   {
     CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
     anim->destroy(); return false;
   }
   
-  // load all core bones
+  anim->reserve(trackCount);
+
+  // load all core tracks into the arena of the core animation
   int trackId;
   for(trackId = 0; trackId < trackCount; ++trackId)
   {
     // load the core track
     CalCoreTrack *pCoreTrack;
-    pCoreTrack = loadCoreTrack(dataSrc);
+    pCoreTrack = loadCoreTrack(dataSrc, anim->getArena());
     if(pCoreTrack == 0) { anim->destroy(); return false; }
     anim->addCoreTrack(pCoreTrack);
   }
@@ -200,7 +361,8 @@ bool CalLoader::loadCoreAnimation(CalCoreAnimation *anim, CalDataSource& dataSrc
   *         \li \b 0 if an error happend
   *****************************************************************************/
 
-CalCoreBone *CalLoader::loadCoreBones(CalDataSource& dataSrc)
+template<class DataSource>
+CalCoreBone *CalLoader::loadCoreBones(DataSource& dataSrc)
 {
   if(!dataSrc.ok())
   {
@@ -210,49 +372,31 @@ CalCoreBone *CalLoader::loadCoreBones(CalDataSource& dataSrc)
 
   // get the name length of the bone
   int len;
-  if(!dataSrc.readInteger(len) || (len < 1))
+  if(!dataSrc.readInteger(len) || (len < 1) || !hasRecords(dataSrc, len, 1))
   {
     CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
     return 0;
   }
 
   // read the name of the bone
-  char *strBuffer;
-  strBuffer = new char[len];
-  dataSrc.readBytes(strBuffer, len);
-  std::string strName;
-  strName = strBuffer;
-  delete [] strBuffer;
-  
-  // read the length of the bone.
-  float length;
-  dataSrc.readFloat(length);
+  int nameId;
+  nameId = readNameId(dataSrc, len);
+  if(nameId < 0)
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    return 0;
+  }
   
-  // get the translation of the bone
-  float tx, ty, tz;
-  dataSrc.readFloat(tx);
-  dataSrc.readFloat(ty);
-  dataSrc.readFloat(tz);
-
-  // get the rotation of the bone
-  float rx, ry, rz, rw;
-  dataSrc.readFloat(rx);
-  dataSrc.readFloat(ry);
-  dataSrc.readFloat(rz);
-  dataSrc.readFloat(rw);
-
-  // get the bone space translation of the bone
-  float txBoneSpace, tyBoneSpace, tzBoneSpace;
-  dataSrc.readFloat(txBoneSpace);
-  dataSrc.readFloat(tyBoneSpace);
-  dataSrc.readFloat(tzBoneSpace);
-
-  // get the bone space rotation of the bone
-  float rxBoneSpace, ryBoneSpace, rzBoneSpace, rwBoneSpace;
-  dataSrc.readFloat(rxBoneSpace);
-  dataSrc.readFloat(ryBoneSpace);
-  dataSrc.readFloat(rzBoneSpace);
-  dataSrc.readFloat(rwBoneSpace);
+  // read the length, the translation, the rotation, the bone space
+  // translation and the bone space rotation of the bone at once
+  float data[15];
+  readWords(dataSrc, data, 15);
+
+  float length = data[0];
+  float tx = data[1], ty = data[2], tz = data[3];
+  float rx = data[4], ry = data[5], rz = data[6], rw = data[7];
+  float txBoneSpace = data[8], tyBoneSpace = data[9], tzBoneSpace = data[10];
+  float rxBoneSpace = data[11], ryBoneSpace = data[12], rzBoneSpace = data[13], rwBoneSpace = data[14];
 
   // get the parent bone id
   int parentId;
@@ -292,7 +436,7 @@ CalCoreBone *CalLoader::loadCoreBones(CalDataSource& dataSrc)
   }
 
   // create the core bone instance
-  if(!pCoreBone->create(strName))
+  if(!pCoreBone->create(CalNameTable::getName(nameId)))
   {
     delete pCoreBone;
     return 0;
@@ -339,106 +483,89 @@ CalCoreBone *CalLoader::loadCoreBones(CalDataSource& dataSrc)
  /*****************************************************************************/
 /** Loads a core keyframe instance.
   *
-  * This function loads a core keyframe instance from a file stream.
+  * This function loads a core keyframe instance from a data source.
   *
-  * @param file The file stream to load the core keyframe instance from.
-  * @param strFilename The name of the file stream.
+  * @param dataSrc The data source to load the core keyframe instance from.
+  * @param coreKeyframe A reference to the core keyframe that will be filled.
   *
   * @return One of the following values:
-  *         \li a pointer to the core keyframe
-  *         \li \b 0 if an error happend
+  *         \li \b true if successful
+  *         \li \b false if an error happend
   *****************************************************************************/
 
-CalCoreKeyframe *CalLoader::loadCoreKeyframe(CalDataSource& dataSrc)
+template<class DataSource>
+bool CalLoader::loadCoreKeyframe(DataSource& dataSrc, CalCoreKeyframe& coreKeyframe)
 {
   if(!dataSrc.ok())
   {
     CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
-    return 0;
+    return false;
   }
 
-  // get the time of the keyframe
-  float time;
-  dataSrc.readFloat(time);
-
-  // get the orientation of the bone
-  float tx, ty, tz;
-  dataSrc.readFloat(tx);
-  dataSrc.readFloat(ty);
-  dataSrc.readFloat(tz);
-
-  // get the rotation of the bone
-  float rx, ry, rz, rw;
-  dataSrc.readFloat(rx);
-  dataSrc.readFloat(ry);
-  dataSrc.readFloat(rz);
-  dataSrc.readFloat(rw);
-
-  // check if an error happend
-  if(!dataSrc.ok())
+  // get the time, the orientation and the rotation of the keyframe at once
+  float data[8];
+  if(!readWords(dataSrc, data, 8))
   {
     CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-    return 0;
-  }
-
-  // allocate a new core keyframe instance
-  CalCoreKeyframe *pCoreKeyframe;
-  pCoreKeyframe = new CalCoreKeyframe();
-  if(pCoreKeyframe == 0)
-  {
-    CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__, "CalLoader::loadCoreKeyframe");
-    return 0;
-  }
-
-  // create the core keyframe instance
-  if(!pCoreKeyframe->create())
-  {
-    delete pCoreKeyframe;
-    return 0;
+    return false;
   }
 
   // set all attributes of the keyframe
-  pCoreKeyframe->setTime(time);
-  pCoreKeyframe->setOrientation(CalVector(tx, ty, tz));
-  pCoreKeyframe->setRotation(CalQuaternion(rx, ry, rz, rw));
+  coreKeyframe.setTime(data[0]);
+  coreKeyframe.setOrientation(CalVector(data[1], data[2], data[3]));
+  coreKeyframe.setRotation(CalQuaternion(data[4], data[5], data[6], data[7]));
 
-  return pCoreKeyframe;
+  return true;
 }
 
  /*****************************************************************************/
 /** Loads a core model.
+  *
+  * This function loads a core model from a file. The file is mapped into
+  * memory and decoded like a memory buffer.
   *****************************************************************************/
 
 bool CalLoader::loadCoreModel(CalCoreModel *model, const std::string& strFilename)
 {
-  // open the file
-  std::ifstream file;
-  file.open(strFilename.c_str(), std::ios::in | std::ios::binary);
-  if(!file)
+  // map the file, the error is set by the mapped file
+  CalMappedFile file;
+  if(!file.open(strFilename))
   {
-    CalError::setLastError(CalError::FILE_NOT_FOUND, __FILE__, __LINE__, strFilename);
     model->destroy(); return false;
   }
-  
-  //make a new stream data source and use it to load the animation
-  CalStreamSource streamSrc( file );
 
-  bool coremodel = loadCoreModel(model, streamSrc);
+  // decode it straight from memory
+  CalBufferReader bufferSrc(file.getData(), file.getSize());
+  return loadCoreModelData(model, bufferSrc);
+}
 
-  //close the file
-  file.close();
+ /*****************************************************************************/
+/** Loads a core model.
+  *
+  * This function loads a core model from an input stream, which is read in
+  * large chunks through a CalStreamSource.
+  *****************************************************************************/
 
-  return coremodel;
+bool CalLoader::loadCoreModel(CalCoreModel *model, std::istream& src, const std::string& strFilename)
+{
+  CalStreamSource streamSrc(src);
+  return loadCoreModel(model, streamSrc);
 }
 
 bool CalLoader::loadCoreModel(CalCoreModel *model, void* inputBuffer, int len, const std::string& strFilename)
 {
-  //Create a new buffer data source and pass it on
-  CalBufferSource bufferSrc(inputBuffer);
-  return loadCoreModel(model, bufferSrc);
+  //Create a new buffer reader and pass it on
+  CalBufferReader bufferSrc(inputBuffer, len);
+  return loadCoreModelData(model, bufferSrc);
 }
 
 bool CalLoader::loadCoreModel(CalCoreModel *model, CalDataSource& dataSrc)
+{
+  return loadCoreModelData(model, dataSrc);
+}
+
+template<class DataSource>
+bool CalLoader::loadCoreModelData(CalCoreModel *model, DataSource& dataSrc)
 {
   // check if this is a valid file
   char magic[4];
@@ -492,60 +619,56 @@ bool CalLoader::loadCoreModel(CalCoreModel *model, CalDataSource& dataSrc)
   }
 
   // load all core submeshes
-  int submeshId;
-  for(submeshId = 0; submeshId < submeshCount; submeshId++)
-  {
-    // load the core submesh
-    CalCoreSubmesh *pCoreSubmesh;
-    pCoreSubmesh = loadCoreSubmesh(dataSrc);
-    if(pCoreSubmesh == 0) { model->destroy(); return false; }
-
-    // add the core submesh to the core mesh instance
-    model->m_vectorCoreSubmesh.push_back(pCoreSubmesh);
-  }
+  if(!loadCoreSubmeshes(model, dataSrc, submeshCount)) { model->destroy(); return false; }
 
   return true;
 }
 
 bool CalLoader::loadCoreModel(CalCoreModel *model, const std::string& strFilename1, const std::string& strFilename2)
 {
-  // open the first file
-  std::ifstream file1;
-  file1.open(strFilename1.c_str(), std::ios::in | std::ios::binary);
-  if(!file1)
+  // map the first file
+  CalMappedFile file1;
+  if(!file1.open(strFilename1))
   {
-    CalError::setLastError(CalError::FILE_NOT_FOUND, __FILE__, __LINE__, strFilename1);
     model->destroy(); return false;
   }
 
-  // open the second file
-  std::ifstream file2;
-  file2.open(strFilename2.c_str(), std::ios::in | std::ios::binary);
-  if(!file2)
+  // map the second file
+  CalMappedFile file2;
+  if(!file2.open(strFilename2))
   {
-    CalError::setLastError(CalError::FILE_NOT_FOUND, __FILE__, __LINE__, strFilename2);
     model->destroy(); return false;
   }
-  
-  CalStreamSource streamSrc1( file1 );
-  CalStreamSource streamSrc2( file2 );
 
-  bool result = loadCoreModel(model, streamSrc1, streamSrc2);
-  file1.close();
-  file2.close();
-  return result;
+  CalBufferReader bufferSrc1(file1.getData(), file1.getSize());
+  CalBufferReader bufferSrc2(file2.getData(), file2.getSize());
+  return loadCoreModelData(model, bufferSrc1, bufferSrc2);
+}
+
+bool CalLoader::loadCoreModel(CalCoreModel *model, std::istream& src1, const std::string& strFilename1,
+                              std::istream& src2, const std::string& strFilename2)
+{
+  CalStreamSource streamSrc1(src1);
+  CalStreamSource streamSrc2(src2);
+  return loadCoreModel(model, streamSrc1, streamSrc2);
 }
 
 bool CalLoader::loadCoreModel(CalCoreModel *model,
 			      void* inputBuffer1, int len1, const std::string& strFilename1,
 			      void* inputBuffer2, int len2, const std::string& strFilename2)
 {
-  CalBufferSource bufferSrc1(inputBuffer1);
-  CalBufferSource bufferSrc2(inputBuffer2);
-  return loadCoreModel(model, bufferSrc1, bufferSrc2);
+  CalBufferReader bufferSrc1(inputBuffer1, len1);
+  CalBufferReader bufferSrc2(inputBuffer2, len2);
+  return loadCoreModelData(model, bufferSrc1, bufferSrc2);
 }
 
 bool CalLoader::loadCoreModel(CalCoreModel *model, CalDataSource& dataSrc1, CalDataSource& dataSrc2)
+{
+  return loadCoreModelData(model, dataSrc1, dataSrc2);
+}
+
+template<class DataSource>
+bool CalLoader::loadCoreModelData(CalCoreModel *model, DataSource& dataSrc1, DataSource& dataSrc2)
 {
   // check if this is a valid file
   char magic[4];
@@ -617,13 +740,36 @@ bool CalLoader::loadCoreModel(CalCoreModel *model, CalDataSource& dataSrc1, CalD
   }
 
   // load all core submeshes
+  if(!loadCoreSubmeshes(model, dataSrc2, submeshCount)) { model->destroy(); return false; }
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Loads the core submeshes of a core model.
+  *
+  * This function loads the core submeshes one after the other and adds them
+  * to the core model.
+  *
+  * @param model The core model.
+  * @param dataSrc The data source to read from.
+  * @param submeshCount The number of submeshes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+template<class DataSource>
+bool CalLoader::loadCoreSubmeshes(CalCoreModel *model, DataSource& dataSrc, int submeshCount)
+{
   int submeshId;
   for(submeshId = 0; submeshId < submeshCount; submeshId++)
   {
     // load the core submesh
     CalCoreSubmesh *pCoreSubmesh;
-    pCoreSubmesh = loadCoreSubmesh(dataSrc2);
-    if(pCoreSubmesh == 0) { model->destroy(); return false; }
+    pCoreSubmesh = loadCoreSubmesh(dataSrc);
+    if(pCoreSubmesh == 0) return false;
 
     // add the core submesh to the core mesh instance
     model->m_vectorCoreSubmesh.push_back(pCoreSubmesh);
@@ -632,20 +778,159 @@ bool CalLoader::loadCoreModel(CalCoreModel *model, CalDataSource& dataSrc1, CalD
   return true;
 }
 
+ /*****************************************************************************/
+/** Loads the core submeshes of a core model from memory.
+  *
+  * This function loads the core submeshes in parallel. A first pass over the
+  * buffer finds where each submesh starts, reading only the counts that
+  * decide its size. The submeshes are then decoded by a pool of threads, each
+  * from its own buffer reader, and added to the core model in file order.
+  * Small models, and all models loaded by the workers of an asynchronous
+  * loader, are loaded on the calling thread.
+  *
+  * @param model The core model.
+  * @param dataSrc The buffer reader to read from.
+  * @param submeshCount The number of submeshes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalLoader::loadCoreSubmeshes(CalCoreModel *model, CalBufferReader& dataSrc, int submeshCount)
+{
+  int threadCount = loadingThreadCount;
+  if(threadCount <= 0) threadCount = (int)std::thread::hardware_concurrency();
+  if(threadCount > submeshCount) threadCount = submeshCount;
+  if(workerThread) threadCount = 1;
+
+  if((threadCount <= 1) || !dataSrc.hasBytes(PARALLEL_SUBMESH_MIN_SIZE))
+  {
+    return loadCoreSubmeshes<CalBufferReader>(model, dataSrc, submeshCount);
+  }
+
+  // find the start of every submesh
+  std::vector<const char *> vectorStart(submeshCount + 1);
+
+  CalBufferReader scanSrc(dataSrc);
+  int submeshId;
+  for(submeshId = 0; submeshId < submeshCount; submeshId++)
+  {
+    vectorStart[submeshId] = scanSrc.getPosition();
+    if(!skipCoreSubmesh(scanSrc))
+    {
+      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+      return false;
+    }
+  }
+  vectorStart[submeshCount] = scanSrc.getPosition();
+
+  // decode the submeshes on the pool, the calling thread included
+  std::vector<CalCoreSubmesh *> vectorCoreSubmesh(submeshCount, (CalCoreSubmesh *)0);
+  std::vector<CalError::Code> vectorErrorCode(submeshCount, CalError::OK);
+  std::atomic<int> nextSubmeshId(0);
+
+  auto decode = [&]()
+  {
+    int id;
+    while((id = nextSubmeshId++) < submeshCount)
+    {
+      CalBufferReader submeshSrc(vectorStart[id], vectorStart[id + 1] - vectorStart[id]);
+      vectorCoreSubmesh[id] = loadCoreSubmesh(submeshSrc);
+      if(vectorCoreSubmesh[id] == 0) vectorErrorCode[id] = CalError::getLastErrorCode();
+    }
+  };
+
+  std::vector<std::thread> vectorThread;
+  int threadId;
+  for(threadId = 1; threadId < threadCount; threadId++)
+  {
+    vectorThread.push_back(std::thread(decode));
+  }
+  decode();
+  for(threadId = 0; threadId < (int)vectorThread.size(); threadId++)
+  {
+    vectorThread[threadId].join();
+  }
+
+  // add the core submeshes in file order, or report the first error
+  CalError::Code errorCode = CalError::OK;
+  for(submeshId = 0; submeshId < submeshCount; submeshId++)
+  {
+    if((vectorCoreSubmesh[submeshId] == 0) && (errorCode == CalError::OK)) errorCode = vectorErrorCode[submeshId];
+  }
+
+  if(errorCode != CalError::OK)
+  {
+    for(submeshId = 0; submeshId < submeshCount; submeshId++)
+    {
+      if(vectorCoreSubmesh[submeshId] == 0) continue;
+      vectorCoreSubmesh[submeshId]->destroy();
+      delete vectorCoreSubmesh[submeshId];
+    }
+
+    CalError::setLastError(errorCode, __FILE__, __LINE__);
+    return false;
+  }
+
+  model->m_vectorCoreSubmesh.insert(model->m_vectorCoreSubmesh.end(), vectorCoreSubmesh.begin(), vectorCoreSubmesh.end());
+
+  return dataSrc.skipBytes(vectorStart[submeshCount] - vectorStart[0]);
+}
+
  /*****************************************************************************/
 /** Loads a core submesh instance.
   *
-  * This function loads a core submesh instance from a file stream.
+  * This function loads a core submesh instance from a data source. Fields
+  * that are stored next to each other are read as one block: the submesh
+  * header, the fixed part of each vertex, the influences of a vertex, and all
+  * springs and faces, which go straight into the arrays of the submesh.
   *
-  * @param file The file stream to load the core submesh instance from.
-  * @param strFilename The name of the file stream.
+  * @param dataSrc The data source to load the core submesh instance from.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core submesh
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+template<class DataSource>
+CalCoreSubmesh *CalLoader::loadCoreSubmesh(DataSource& dataSrc)
+{
+  // load the header, then all vertices, springs and faces
+  CalCoreSubmesh *pCoreSubmesh;
+  pCoreSubmesh = loadCoreSubmeshHeader(dataSrc);
+  if(pCoreSubmesh == 0) return 0;
+
+  if(!loadCoreSubmeshVertices(dataSrc, pCoreSubmesh, 0, pCoreSubmesh->getVertexCount())
+  || !loadCoreSubmeshFaces(dataSrc, pCoreSubmesh))
+  {
+    pCoreSubmesh->destroy();
+    delete pCoreSubmesh;
+    return 0;
+  }
+#ifdef DEBUG_LOADER
+  printf("loadCoreSubMesh: DONE!!!!!!\n\n\n\n\n");
+#endif
+
+  return pCoreSubmesh;
+}
+
+ /*****************************************************************************/
+/** Loads the header of a core submesh instance.
+  *
+  * This function loads the counts and the tangent space flags of a core
+  * submesh, and creates a core submesh instance with room for all of its
+  * vertices, faces and springs.
+  *
+  * @param dataSrc The data source to load the header from.
   *
   * @return One of the following values:
   *         \li a pointer to the core submesh
   *         \li \b 0 if an error happend
   *****************************************************************************/
 
-CalCoreSubmesh *CalLoader::loadCoreSubmesh(CalDataSource& dataSrc)
+template<class DataSource>
+CalCoreSubmesh *CalLoader::loadCoreSubmeshHeader(DataSource& dataSrc)
 {
   if(!dataSrc.ok())
   {
@@ -653,46 +938,32 @@ CalCoreSubmesh *CalLoader::loadCoreSubmesh(CalDataSource& dataSrc)
     return 0;
   }
 
-  // get the material thread id of the submesh
-  int coreMaterialThreadId;
-  dataSrc.readInteger(coreMaterialThreadId);
+  // get the material thread id of the submesh, and the number of vertices,
+  // faces, level-of-details, springs, and texture coordinates
+  int header[6];
+  readWords(dataSrc, header, 6);
+
+  int coreMaterialThreadId = header[0];
+  int vertexCount = header[1];
+  int faceCount = header[2];
+  int lodCount = header[3];
+  int springCount = header[4];
+  int textureCoordinateCount = header[5];
 #ifdef DEBUG_LOADER
   printf("loadCoreSubMesh: coreMaterialThreadId: %d\n", coreMaterialThreadId);
-#endif
-
-  // get the number of vertices, faces, level-of-details, springs, and texture coordinates
-  int vertexCount;
-  dataSrc.readInteger(vertexCount);
-#ifdef DEBUG_LOADER
   printf("loadCoreSubMesh: vertexCount: %d\n", vertexCount);
-#endif
-
-  int faceCount;
-  dataSrc.readInteger(faceCount);
-#ifdef DEBUG_LOADER
   printf("loadCoreSubMesh: faceCount: %d\n", faceCount);
-#endif
-
-  int lodCount;
-  dataSrc.readInteger(lodCount);
-#ifdef DEBUG_LOADER
   printf("loadCoreSubMesh: lodCount: %d\n", lodCount);
-#endif
-
-  int springCount;
-  dataSrc.readInteger(springCount);
-#ifdef DEBUG_LOADER
   printf("loadCoreSubMesh: springCount: %d\n", springCount);
-#endif
-
-  int textureCoordinateCount;
-  dataSrc.readInteger(textureCoordinateCount);
-#ifdef DEBUG_LOADER
   printf("loadCoreSubMesh: textureCoordinateCount: %d\n", textureCoordinateCount);
 #endif
 
-  // check if an error happend
-  if(!dataSrc.ok())
+  // check if an error happend, and that the counts fit into the data left
+  // before reserving memory for them (a vertex takes at least 27 bytes)
+  if(!dataSrc.ok() || !hasRecords(dataSrc, textureCoordinateCount, 1)
+  || !hasRecords(dataSrc, vertexCount, 27 + textureCoordinateCount * 8)
+  || !hasRecords(dataSrc, faceCount, sizeof(CalCoreSubmesh::Face))
+  || !hasRecords(dataSrc, springCount, sizeof(CalCoreSubmesh::Spring)))
   {
     CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
     return 0;
@@ -742,95 +1013,115 @@ CalCoreSubmesh *CalLoader::loadCoreSubmesh(CalDataSource& dataSrc)
 #endif
   }
 
+  return pCoreSubmesh;
+}
+
+ /*****************************************************************************/
+/** Loads a range of vertices of a core submesh instance.
+  *
+  * This function loads the vertices, texture coordinates, influences and
+  * physical properties of a range of vertices. The vertices must be loaded in
+  * file order, as the influences are appended to the core submesh.
+  *
+  * @param dataSrc The data source to load the vertices from.
+  * @param pCoreSubmesh The core submesh created by loadCoreSubmeshHeader().
+  * @param firstVertexId The id of the first vertex to load.
+  * @param vertexCount The number of vertices to load.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+template<class DataSource>
+bool CalLoader::loadCoreSubmeshVertices(DataSource& dataSrc, CalCoreSubmesh *pCoreSubmesh, int firstVertexId, int vertexCount)
+{
+  int textureCoordinateCount = pCoreSubmesh->getTextureCoordinateCount();
+  int springCount = pCoreSubmesh->getSpringCount();
+
   // Get the influence vector.
   std::vector<CalCoreSubmesh::Influence>& vectorInfluence = pCoreSubmesh->getVectorInfluence();
   
   // Get the vertex vector.
   std::vector<CalCoreSubmesh::Vertex>& vectorVertex = pCoreSubmesh->getVectorVertex();
+
+  // Get the LOD control vector.
+  std::vector<CalCoreSubmesh::LodControl>& vectorLodControl = pCoreSubmesh->getVectorLodControl();
   
-  // Get the tangent space vectors
+  // Get the texture coordinate and tangent space vectors
+  std::vector<std::vector<CalCoreSubmesh::TextureCoordinate> >& vectorvectorTextureCoordinate =
+    pCoreSubmesh->getVectorVectorTextureCoordinate();
   std::vector<std::vector<CalCoreSubmesh::TangentSpace> >& vectorvectorTangentSpace =
     pCoreSubmesh->getVectorVectorTangentSpace();
   
   // load all vertices and their influences
   int vertexId;
-  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  for(vertexId = firstVertexId; vertexId < firstVertexId + vertexCount; vertexId++)
   {
     // The vertex we're setting.
     CalCoreSubmesh::Vertex &vertex = vectorVertex[vertexId];
     
-    // load data of the vertex
-    dataSrc.readFloat(vertex.position.x);
-    dataSrc.readFloat(vertex.position.y);
-    dataSrc.readFloat(vertex.position.z);
-#ifdef DEBUG_LOADER
-  printf("loadCoreSubMesh: vertex.position: %f %f %f\n", vertex.position.x, vertex.position.y, vertex.position.z);
-#endif
-
-    char nxyz[3];
-    dataSrc.readBytes(nxyz, 3);
-    vertex.nx = nxyz[0];
-    vertex.ny = nxyz[1];
-    vertex.nz = nxyz[2];
-#ifdef DEBUG_LOADER
-  printf("loadCoreSubMesh: vertex. nx ny nz: %d %d %d\n", vertex.nx, vertex.ny, vertex.nz);
-#endif
+    // load the position, the normal and the LOD control information at once
+    char data[23];
+    if(!dataSrc.readBytes(data, 23))
+    {
+      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+      return false;
+    }
 
-    // Load the LOD control information.
-    int faceCollapseCount, collapseId;
-    dataSrc.readInteger(collapseId);
-    dataSrc.readInteger(faceCollapseCount);
+    float position[3];
+    memcpy(position, &data[0], 12);
+    CalPlatform::swapWords(position, 3);
+    vertex.position.x = position[0];
+    vertex.position.y = position[1];
+    vertex.position.z = position[2];
+    vertex.nx = data[12];
+    vertex.ny = data[13];
+    vertex.nz = data[14];
+
+    int lodControl[2];
+    memcpy(lodControl, &data[15], 8);
+    CalPlatform::swapWords(lodControl, 2);
+    vectorLodControl[vertexId].collapseId = lodControl[0];
+    vectorLodControl[vertexId].faceCollapseCount = lodControl[1];
 #ifdef DEBUG_LOADER
-  printf("loadCoreSubMesh: collapseId faceCollapseCount: %d %d\n", collapseId, faceCollapseCount);
+    printf("loadCoreSubMesh: vertex.position: %f %f %f\n", vertex.position.x, vertex.position.y, vertex.position.z);
+    printf("loadCoreSubMesh: vertex. nx ny nz: %d %d %d\n", vertex.nx, vertex.ny, vertex.nz);
+    printf("loadCoreSubMesh: collapseId faceCollapseCount: %d %d\n", lodControl[0], lodControl[1]);
 #endif
-
-    pCoreSubmesh->setLodControl(vertexId, faceCollapseCount, collapseId);
-    
-    // check if an error happend
-    if(!dataSrc.ok())
-    {
-      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-      pCoreSubmesh->destroy();
-      delete pCoreSubmesh;
-      return 0;
-    }
     
     // load all texture coordinates of the vertex
     int textureCoordinateId;
     for(textureCoordinateId = 0; textureCoordinateId < textureCoordinateCount; textureCoordinateId++)
     {
-      CalCoreSubmesh::TextureCoordinate textureCoordinate;
+      // load the texture coordinate and the tangent space at once
+      char data[12];
+      int length;
+      length = pCoreSubmesh->tangentsEnabled(textureCoordinateId) ? 12 : 8;
+      if(!dataSrc.readBytes(data, length))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        return false;
+      }
 
-      // load data of the influence
-      dataSrc.readFloat(textureCoordinate.u);
-      dataSrc.readFloat(textureCoordinate.v);
+      CalCoreSubmesh::TextureCoordinate& textureCoordinate = vectorvectorTextureCoordinate[textureCoordinateId][vertexId];
+      memcpy(&textureCoordinate, &data[0], 8);
+      CalPlatform::swapWords(&textureCoordinate, 2);
 #ifdef DEBUG_LOADER
       printf("loadCoreSubMesh: textureCoordinate(%d): %f %f\n", textureCoordinateId,textureCoordinate.u, textureCoordinate.v);
 #endif
-
-      pCoreSubmesh->setTextureCoordinate(vertexId, textureCoordinateId, textureCoordinate);
       
-      if (pCoreSubmesh->tangentsEnabled(textureCoordinateId))
+      if(length == 12)
       {
-	char tanspace[4];
-	dataSrc.readBytes(tanspace, 4);
-	vectorvectorTangentSpace[textureCoordinateId][vertexId].tx = tanspace[0];
-	vectorvectorTangentSpace[textureCoordinateId][vertexId].ty = tanspace[1];
-	vectorvectorTangentSpace[textureCoordinateId][vertexId].tz = tanspace[2];
-	vectorvectorTangentSpace[textureCoordinateId][vertexId].crossFactor = tanspace[3];
+        CalCoreSubmesh::TangentSpace& tangentSpace = vectorvectorTangentSpace[textureCoordinateId][vertexId];
+        tangentSpace.tx = data[8];
+        tangentSpace.ty = data[9];
+        tangentSpace.tz = data[10];
+        tangentSpace.crossFactor = data[11];
 #ifdef DEBUG_LOADER
-        printf("loadCoreSubMesh: vectorTangentSpace(%d, %d): %d %d %d %d\n", textureCoordinateId, vertexId, tanspace[0], tanspace[1], tanspace[2], tanspace[3]);
+        printf("loadCoreSubMesh: vectorTangentSpace(%d, %d): %d %d %d %d\n", textureCoordinateId, vertexId, data[8], data[9], data[10], data[11]);
 #endif
       }
-      
-      // check if an error happend
-      if(!dataSrc.ok())
-      {
-        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-        pCoreSubmesh->destroy();
-        delete pCoreSubmesh;
-        return 0;
-      }
     }
 
     // get the number of influences
@@ -842,33 +1133,19 @@ CalCoreSubmesh *CalLoader::loadCoreSubmesh(CalDataSource& dataSrc)
 #endif
     
     // check if an error happend
-    if(!dataSrc.ok())
+    if(!dataSrc.ok() || (influenceCount != vertex.influenceCount) || !hasRecords(dataSrc, influenceCount, sizeof(CalCoreSubmesh::Influence)))
     {
       CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-      pCoreSubmesh->destroy();
-      delete pCoreSubmesh;
-      return 0;
+      return false;
     }
     
+    // load all influences of the vertex, they have the layout of the file
     int firstInfluence = vectorInfluence.size();
     vectorInfluence.resize(firstInfluence + vertex.influenceCount);
-    
-    // load all influences of the vertex
-    int influenceId;
-    for(influenceId = 0; influenceId < vertex.influenceCount; influenceId++)
+    if((influenceCount > 0) && !readWords(dataSrc, &vectorInfluence[firstInfluence], influenceCount * 2))
     {
-      // load data of the influence
-      dataSrc.readInteger(vectorInfluence[firstInfluence + influenceId].boneId);
-      dataSrc.readFloat(vectorInfluence[firstInfluence + influenceId].weight);
-
-      // check if an error happend
-      if(!dataSrc.ok())
-      {
-        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-        pCoreSubmesh->destroy();
-        delete pCoreSubmesh;
-        return 0;
-      }
+      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+      return false;
     }
     
     // load the physical property of the vertex if there are springs in the core submesh
@@ -883,9 +1160,7 @@ CalCoreSubmesh *CalLoader::loadCoreSubmesh(CalDataSource& dataSrc)
       if(!dataSrc.ok())
       {
         CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-        pCoreSubmesh->destroy();
-        delete pCoreSubmesh;
-        return 0;
+        return false;
       }
 
       // set the physical property in the core submesh instance
@@ -893,63 +1168,50 @@ CalCoreSubmesh *CalLoader::loadCoreSubmesh(CalDataSource& dataSrc)
     }
   }
 
+  return true;
+}
+
+ /*****************************************************************************/
+/** Loads the springs and faces of a core submesh instance.
+  *
+  * This function loads all springs and faces of a core submesh, after all of
+  * its vertices have been loaded, which completes the submesh. With
+  * LOADER_OPTIMIZE_VERTEX_CACHE the submesh is then sorted for the vertex
+  * cache.
+  *
+  * @param dataSrc The data source to load the springs and faces from.
+  * @param pCoreSubmesh The core submesh.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+template<class DataSource>
+bool CalLoader::loadCoreSubmeshFaces(DataSource& dataSrc, CalCoreSubmesh *pCoreSubmesh)
+{
+  int faceCount = pCoreSubmesh->getFaceCount();
+  int springCount = pCoreSubmesh->getSpringCount();
+
   // Pack the influence vector.
+  std::vector<CalCoreSubmesh::Influence>& vectorInfluence = pCoreSubmesh->getVectorInfluence();
   vectorInfluence.reserve(vectorInfluence.size());
   
-  // load all springs
-  int springId;
-  for(springId = 0; springId < springCount; springId++)
+  // load all springs and faces, they have the layout of the file
+  if(((springCount > 0) && !readWords(dataSrc, &pCoreSubmesh->getVectorSpring()[0], springCount * 4))
+  || ((faceCount > 0) && !readWords(dataSrc, &pCoreSubmesh->getVectorFace()[0], faceCount * 3)))
   {
-    CalCoreSubmesh::Spring spring;
-
-    // load data of the spring
-    dataSrc.readInteger(spring.vertexId[0]);
-    dataSrc.readInteger(spring.vertexId[1]);
-    dataSrc.readFloat(spring.springCoefficient);
-    dataSrc.readFloat(spring.idleLength);
-
-    // check if an error happend
-    if(!dataSrc.ok())
-    {
-      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-      pCoreSubmesh->destroy();
-      delete pCoreSubmesh;
-      return 0;
-    }
-
-    // set spring in the core submesh instance
-    pCoreSubmesh->setSpring(springId, spring);
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    return false;
   }
 
-  // load all faces
-  int faceId;
-  for(faceId = 0; faceId < faceCount; faceId++)
+  // the error is set by the optimizer
+  if((loadingMode & LOADER_OPTIMIZE_VERTEX_CACHE) && !pCoreSubmesh->optimizeVertexCache())
   {
-    CalCoreSubmesh::Face face;
-
-    // load data of the face
-    dataSrc.readInteger(face.vertexId[0]);
-    dataSrc.readInteger(face.vertexId[1]);
-    dataSrc.readInteger(face.vertexId[2]);
-
-    // check if an error happend
-    if(!dataSrc.ok())
-    {
-      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
-      pCoreSubmesh->destroy();
-      delete pCoreSubmesh;
-      return 0;
-    }
-
-    // set face in the core submesh instance
-    pCoreSubmesh->setFace(faceId, face);
+    return false;
   }
-#ifdef DEBUG_LOADER
-  printf("loadCoreSubMesh: DONE!!!!!!\n\n\n\n\n");
-#endif
-    
 
-  return pCoreSubmesh;
+  return true;
 }
 
  /*****************************************************************************/
@@ -958,13 +1220,49 @@ CalCoreSubmesh *CalLoader::loadCoreSubmesh(CalDataSource& dataSrc)
   * This function loads a core track instance from a data source.
   *
   * @param dataSrc The data source to load the core track instance from.
+  * @param pArena The arena to allocate the core track and its keyframes in.
   *
   * @return One of the following values:
   *         \li a pointer to the core track
   *         \li \b 0 if an error happend
   *****************************************************************************/
 
-CalCoreTrack *CalLoader::loadCoreTrack(CalDataSource& dataSrc)
+template<class DataSource>
+CalCoreTrack *CalLoader::loadCoreTrack(DataSource& dataSrc, CalArena *pArena)
+{
+  // load the header, then all keyframes
+  int keyframeCount;
+  CalCoreTrack *pCoreTrack;
+  pCoreTrack = loadCoreTrackHeader(dataSrc, pArena, keyframeCount);
+  if(pCoreTrack == 0) return 0;
+
+  if(!loadCoreKeyframes(dataSrc, pCoreTrack, keyframeCount))
+  {
+    pCoreTrack->destroy();
+    CalCoreTrack::Free(pCoreTrack);
+    return 0;
+  }
+
+  return pCoreTrack;
+}
+
+ /*****************************************************************************/
+/** Loads the header of a core track instance.
+  *
+  * This function loads the bone name and the keyframe count of a core track,
+  * and creates a core track instance with room for all of its keyframes.
+  *
+  * @param dataSrc The data source to load the header from.
+  * @param pArena The arena to allocate the core track and its keyframes in.
+  * @param keyframeCount A reference to store the number of keyframes in.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core track
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+template<class DataSource>
+CalCoreTrack *CalLoader::loadCoreTrackHeader(DataSource& dataSrc, CalArena *pArena, int& keyframeCount)
 {
   if(!dataSrc.ok())
   {
@@ -972,31 +1270,26 @@ CalCoreTrack *CalLoader::loadCoreTrack(CalDataSource& dataSrc)
     return 0;
   }
 
-  // BUG BUG BUG - Code SHOULD use readString section below rather than the rest, but
-  // readString crashes and I dont have time to putz with it...
   // get the name length of the bone
   int len;
-  if(!dataSrc.readInteger(len) || (len < 1))
-  //std::string strName;
-  // if(!dataSrc.readString(strName))
+  if(!dataSrc.readInteger(len) || (len < 1) || !hasRecords(dataSrc, len, 1))
   {
     CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
     return 0;
   }
 
   // read the name of the bone
-  char *strBuffer;
-  strBuffer = new char[len];
-  dataSrc.readBytes(strBuffer, len);
-  std::string strName;
-  strName = strBuffer;
-  delete [] strBuffer;
-
-  // END BUG
+  int nameId;
+  nameId = readNameId(dataSrc, len);
+  if(nameId < 0)
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    return 0;
+  }
 
   // allocate a new core track instance
   CalCoreTrack *pCoreTrack;
-  pCoreTrack = new CalCoreTrack();
+  pCoreTrack = CalCoreTrack::Alloc(pArena);
   if(pCoreTrack == 0)
   {
     CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__);
@@ -1006,34 +1299,57 @@ CalCoreTrack *CalLoader::loadCoreTrack(CalDataSource& dataSrc)
   // create the core track instance
   if(!pCoreTrack->create())
   {
-    delete pCoreTrack;
+    CalCoreTrack::Free(pCoreTrack);
     return 0;
   }
 
   // link the core track to the appropriate core bone
-  pCoreTrack->setCoreBoneName(strName);
+  pCoreTrack->setCoreBoneNameId(nameId);
 
-  // read the number of keyframes
-  int keyframeCount;
-  if(!dataSrc.readInteger(keyframeCount) || (keyframeCount <= 0))
+  // read the number of keyframes, 32 bytes each
+  if(!dataSrc.readInteger(keyframeCount) || (keyframeCount <= 0) || !hasRecords(dataSrc, keyframeCount, 32))
   {
     CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    pCoreTrack->destroy();
+    CalCoreTrack::Free(pCoreTrack);
+    return 0;
+  }
+
+  // allocate all keyframes at once
+  if(!pCoreTrack->reserve(keyframeCount))
+  {
+    pCoreTrack->destroy();
+    CalCoreTrack::Free(pCoreTrack);
     return 0;
   }
 
+  return pCoreTrack;
+}
+
+ /*****************************************************************************/
+/** Loads keyframes of a core track instance.
+  *
+  * This function loads a number of keyframes and adds them to a core track.
+  *
+  * @param dataSrc The data source to load the keyframes from.
+  * @param pCoreTrack The core track created by loadCoreTrackHeader().
+  * @param keyframeCount The number of keyframes to load.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+template<class DataSource>
+bool CalLoader::loadCoreKeyframes(DataSource& dataSrc, CalCoreTrack *pCoreTrack, int keyframeCount)
+{
   // load all core keyframes
   int keyframeId;
   for(keyframeId = 0; keyframeId < keyframeCount; ++keyframeId)
   {
     // load the core keyframe
-    CalCoreKeyframe *pCoreKeyframe;
-    pCoreKeyframe = loadCoreKeyframe(dataSrc);
-    if(pCoreKeyframe == 0)
-    {
-      pCoreTrack->destroy();
-      delete pCoreTrack;
-      return 0;
-    }
+    CalCoreKeyframe coreKeyframe;
+    if(!loadCoreKeyframe(dataSrc, coreKeyframe)) return false;
 
 //    if (loadingMode & LOADER_ROTATE_X_AXIS)
 //    {
@@ -1056,10 +1372,397 @@ CalCoreTrack *CalLoader::loadCoreTrack(CalDataSource& dataSrc)
 //    }
 
     // add the core keyframe to the core track instance
-    pCoreTrack->addCoreKeyframe(pCoreKeyframe);
+    pCoreTrack->addCoreKeyframe(coreKeyframe);
   }
 
-  return pCoreTrack;
+  return true;
+}
+
+ /*****************************************************************************/
+/** Checks a section of a binary model file.
+  *
+  * This function checks that a section of a binary model file is aligned and
+  * lies completely inside the file.
+  *
+  * @param len The size of the file in bytes.
+  * @param offset The offset of the section.
+  * @param count The number of records in the section.
+  * @param size The size of one record.
+  *
+  * @return One of the following values:
+  *         \li \b true if the section is valid
+  *         \li \b false if not
+  *****************************************************************************/
+
+static bool checkBinarySection(int len, int offset, int count, int size)
+{
+  if((count < 0) || (offset < 0) || (offset % Cal::BINARY_ALIGNMENT != 0)) return false;
+  if(count == 0) return true;
+
+  return (offset <= len) && (count <= (len - offset) / size);
+}
+
+ /*****************************************************************************/
+/** Loads a binary core model.
+  *
+  * This function maps a binary model file into memory and loads the core
+  * model from it. See loadBinaryCoreModel(CalCoreModel *, const void *, int).
+  * With LOADER_DEFER_CHANNELS the file stays mapped until the core model is
+  * destroyed.
+  *
+  * @param model The core model to load into.
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalLoader::loadBinaryCoreModel(CalCoreModel *model, const std::string& strFilename)
+{
+  // with deferred channels the core model keeps the file mapped
+  if(loadingMode & LOADER_DEFER_CHANNELS)
+  {
+    CalMappedFile *pFile;
+    pFile = new CalMappedFile();
+    if(!pFile->open(strFilename))
+    {
+      delete pFile;
+      model->destroy(); return false;
+    }
+
+    model->m_vectorMappedFile.push_back(pFile);
+    return loadBinaryCoreModel(model, pFile->getData(), pFile->getSize());
+  }
+
+  CalMappedFile file;
+  if(!file.open(strFilename))
+  {
+    model->destroy(); return false;
+  }
+
+  return loadBinaryCoreModel(model, file.getData(), file.getSize());
+}
+
+ /*****************************************************************************/
+/** Loads a binary core model.
+  *
+  * This function loads a core model from the memory image of a binary model
+  * file, as written by CalSaver::saveBinaryCoreModel. The header and all
+  * section bounds are checked once; every array of a submesh is then copied
+  * as one block, without parsing single fields. The core submeshes own these
+  * copies, so only the deferred channels are read from the image in place,
+  * and only their pages are shared with other processes that map the file.
+  * The loading mode flags are not applied, since the image holds a model
+  * that was already loaded, with the exception of LOADER_DEFER_CHANNELS and
+  * LOADER_OPTIMIZE_VERTEX_CACHE. With deferred channels the image must stay
+  * valid until the core model is destroyed.
+  *
+  * @param model The core model to load into.
+  * @param pBuffer A pointer to the file image, aligned to 16 bytes.
+  * @param len The size of the file image in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalLoader::loadBinaryCoreModel(CalCoreModel *model, const void *pBuffer, int len)
+{
+  const char *pData = (const char *)pBuffer;
+
+  // check if this is a valid file
+  if((pData == 0) || (len < (int)sizeof(CalBinaryHeader)) || (memcmp(pData, Cal::BINARY_MODEL_FILE_MAGIC, 4) != 0))
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    model->destroy(); return false;
+  }
+
+  CalBinaryHeader header;
+  memcpy(&header, pData, sizeof(header));
+
+  // check if the layout matches the one of this library build
+  if((header.version != Cal::BINARY_FILE_VERSION) || (header.byteOrder != Cal::BINARY_BYTE_ORDER)
+  || (header.boneSize != (int)sizeof(CalBinaryBone)) || (header.submeshSize != (int)sizeof(CalBinarySubmesh))
+  || (header.vertexSize != 16))
+  {
+    CalError::setLastError(CalError::INCOMPATIBLE_FILE_VERSION, __FILE__, __LINE__);
+    model->destroy(); return false;
+  }
+
+  // check all top-level sections
+  if((header.fileSize != len) || (header.boneCount <= 0)
+  || !checkBinarySection(len, header.boneOffset, header.boneCount, sizeof(CalBinaryBone))
+  || !checkBinarySection(len, header.childOffset, header.childCount, sizeof(int))
+  || !checkBinarySection(len, header.submeshOffset, header.submeshCount, sizeof(CalBinarySubmesh))
+  || !checkBinarySection(len, header.stringOffset, header.stringSize, 1)
+  || (header.stringSize == 0) || (pData[header.stringOffset + header.stringSize - 1] != '\0'))
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    model->destroy(); return false;
+  }
+
+  const CalBinaryBone *pBinaryBone = (const CalBinaryBone *)(pData + header.boneOffset);
+  const int *pChildId = (const int *)(pData + header.childOffset);
+  const char *pString = pData + header.stringOffset;
+
+  model->m_vectorCoreBone.reserve(header.boneCount);
+
+  // load all core bones
+  int boneId;
+  for(boneId = 0; boneId < header.boneCount; boneId++)
+  {
+    const CalBinaryBone& binaryBone = pBinaryBone[boneId];
+    if((binaryBone.nameOffset < 0) || (binaryBone.nameOffset >= header.stringSize)
+    || (binaryBone.parentId < -1) || (binaryBone.parentId >= header.boneCount)
+    || (binaryBone.childCount < 0) || (binaryBone.firstChild < 0)
+    || (binaryBone.childCount > header.childCount - binaryBone.firstChild))
+    {
+      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+      model->destroy(); return false;
+    }
+
+    CalCoreBone *pCoreBone;
+    pCoreBone = new CalCoreBone();
+    if(!pCoreBone->create(pString + binaryBone.nameOffset))
+    {
+      delete pCoreBone;
+      model->destroy(); return false;
+    }
+
+    pCoreBone->setParentId(binaryBone.parentId);
+    pCoreBone->setLength(binaryBone.length);
+    pCoreBone->setTranslation(CalVector(binaryBone.translation[0], binaryBone.translation[1], binaryBone.translation[2]));
+    pCoreBone->setRotation(CalQuaternion(binaryBone.rotation[0], binaryBone.rotation[1], binaryBone.rotation[2], binaryBone.rotation[3]));
+    pCoreBone->setTranslationBoneSpace(CalVector(binaryBone.translationBoneSpace[0], binaryBone.translationBoneSpace[1], binaryBone.translationBoneSpace[2]));
+    pCoreBone->setRotationBoneSpace(CalQuaternion(binaryBone.rotationBoneSpace[0], binaryBone.rotationBoneSpace[1], binaryBone.rotationBoneSpace[2], binaryBone.rotationBoneSpace[3]));
+
+    pCoreBone->setCoreModel(model);
+    model->m_vectorCoreBone.push_back(pCoreBone);
+
+    // the children must point back to the bone, or the state update recurses forever
+    int childId;
+    for(childId = 0; childId < binaryBone.childCount; childId++)
+    {
+      int coreBoneId;
+      coreBoneId = pChildId[binaryBone.firstChild + childId];
+      if((coreBoneId < 0) || (coreBoneId >= header.boneCount) || (pBinaryBone[coreBoneId].parentId != boneId))
+      {
+        CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+        model->destroy(); return false;
+      }
+
+      pCoreBone->addChildId(coreBoneId);
+    }
+  }
+
+  // calculate state of the core skeleton
+  model->calculateState();
+
+  const CalBinarySubmesh *pBinarySubmesh = (const CalBinarySubmesh *)(pData + header.submeshOffset);
+
+  model->m_vectorCoreSubmesh.reserve(header.submeshCount);
+
+  // load all core submeshes
+  int submeshId;
+  for(submeshId = 0; submeshId < header.submeshCount; submeshId++)
+  {
+    CalCoreSubmesh *pCoreSubmesh;
+    pCoreSubmesh = loadBinaryCoreSubmesh(pData, len, pBinarySubmesh[submeshId]);
+    if(pCoreSubmesh == 0) { model->destroy(); return false; }
+
+    model->m_vectorCoreSubmesh.push_back(pCoreSubmesh);
+  }
+
+  return true;
 }
 
+ /*****************************************************************************/
+/** Loads a binary core submesh instance.
+  *
+  * This function loads a core submesh instance from the memory image of a
+  * binary model file.
+  *
+  * @param pBuffer A pointer to the file image.
+  * @param len The size of the file image in bytes.
+  * @param binarySubmesh The submesh record of the file.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core submesh
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreSubmesh *CalLoader::loadBinaryCoreSubmesh(const char *pBuffer, int len, const CalBinarySubmesh& binarySubmesh)
+{
+  const int vertexCount = binarySubmesh.vertexCount;
+  const int springCount = binarySubmesh.springCount;
+  const int textureCoordinateCount = binarySubmesh.textureCoordinateCount;
+
+  // check all sections of the submesh
+  if(!checkBinarySection(len, binarySubmesh.channelOffset, textureCoordinateCount, sizeof(CalBinaryChannel))
+  || !checkBinarySection(len, binarySubmesh.vertexOffset, vertexCount, 16)
+  || !checkBinarySection(len, binarySubmesh.lodControlOffset, vertexCount, sizeof(CalCoreSubmesh::LodControl))
+  || !checkBinarySection(len, binarySubmesh.influenceOffset, binarySubmesh.influenceCount, sizeof(CalCoreSubmesh::Influence))
+  || !checkBinarySection(len, binarySubmesh.physicalPropertyOffset, (springCount > 0) ? vertexCount : 0, sizeof(CalCoreSubmesh::PhysicalProperty))
+  || !checkBinarySection(len, binarySubmesh.springOffset, springCount, sizeof(CalCoreSubmesh::Spring))
+  || !checkBinarySection(len, binarySubmesh.faceOffset, binarySubmesh.faceCount, sizeof(CalCoreSubmesh::Face)))
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    return 0;
+  }
+
+  const CalBinaryChannel *pChannel = (const CalBinaryChannel *)(pBuffer + binarySubmesh.channelOffset);
+
+  int textureCoordinateId;
+  for(textureCoordinateId = 0; textureCoordinateId < textureCoordinateCount; textureCoordinateId++)
+  {
+    if(!checkBinarySection(len, pChannel[textureCoordinateId].textureCoordinateOffset, vertexCount, sizeof(CalCoreSubmesh::TextureCoordinate))
+    || !checkBinarySection(len, pChannel[textureCoordinateId].tangentSpaceOffset, vertexCount, sizeof(CalCoreSubmesh::TangentSpace)))
+    {
+      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+      return 0;
+    }
+  }
+
+  // allocate a new core submesh instance
+  CalCoreSubmesh *pCoreSubmesh;
+  pCoreSubmesh = new CalCoreSubmesh();
+  if(pCoreSubmesh == 0)
+  {
+    CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__, "CalLoader::loadBinaryCoreSubmesh");
+    return 0;
+  }
+
+  // create the core submesh instance
+  if(!pCoreSubmesh->create())
+  {
+    delete pCoreSubmesh;
+    return 0;
+  }
+
+  pCoreSubmesh->setLodCount(binarySubmesh.lodCount);
+  pCoreSubmesh->setCoreMaterialThreadId(binarySubmesh.coreMaterialThreadId);
+
+  // the optional channels can be left in the image until they are used
+  bool bDefer = (loadingMode & LOADER_DEFER_CHANNELS) != 0;
+  int loadedTextureCoordinateCount = bDefer ? std::min(textureCoordinateCount, 1) : textureCoordinateCount;
+  int loadedSpringCount = bDefer ? 0 : springCount;
+
+  // reserve memory for all the submesh data
+  if(!pCoreSubmesh->reserve(vertexCount, loadedTextureCoordinateCount, binarySubmesh.faceCount, loadedSpringCount))
+  {
+    CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__);
+    pCoreSubmesh->destroy();
+    delete pCoreSubmesh;
+    return 0;
+  }
+
+  // copy the vertices field by field, the vertex is not a plain struct
+  std::vector<CalCoreSubmesh::Vertex>& vectorVertex = pCoreSubmesh->getVectorVertex();
+  const char *pVertex = pBuffer + binarySubmesh.vertexOffset;
+  int vertexId;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++, pVertex += 16)
+  {
+    float position[3];
+    memcpy(position, pVertex, 12);
+
+    CalCoreSubmesh::Vertex& vertex = vectorVertex[vertexId];
+    vertex.position.x = position[0];
+    vertex.position.y = position[1];
+    vertex.position.z = position[2];
+    vertex.nx = pVertex[12];
+    vertex.ny = pVertex[13];
+    vertex.nz = pVertex[14];
+    vertex.influenceCount = pVertex[15];
+  }
+
+  // copy all other arrays as blocks
+  if(vertexCount > 0)
+  {
+    memcpy(&pCoreSubmesh->getVectorLodControl()[0], pBuffer + binarySubmesh.lodControlOffset, vertexCount * sizeof(CalCoreSubmesh::LodControl));
+    if(loadedSpringCount > 0)
+    {
+      memcpy(&pCoreSubmesh->getVectorPhysicalProperty()[0], pBuffer + binarySubmesh.physicalPropertyOffset, vertexCount * sizeof(CalCoreSubmesh::PhysicalProperty));
+    }
+  }
+
+  if(loadedSpringCount > 0)
+  {
+    memcpy(&pCoreSubmesh->getVectorSpring()[0], pBuffer + binarySubmesh.springOffset, springCount * sizeof(CalCoreSubmesh::Spring));
+  }
+  else if(springCount > 0)
+  {
+    pCoreSubmesh->deferSprings(pBuffer + binarySubmesh.physicalPropertyOffset, pBuffer + binarySubmesh.springOffset, springCount);
+  }
+
+  if(binarySubmesh.faceCount > 0)
+  {
+    memcpy(&pCoreSubmesh->getVectorFace()[0], pBuffer + binarySubmesh.faceOffset, binarySubmesh.faceCount * sizeof(CalCoreSubmesh::Face));
+  }
+
+  // the influences are walked by the influence counts of the vertices
+  int influenceCount = 0;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    influenceCount += vectorVertex[vertexId].influenceCount;
+  }
+
+  if(influenceCount != binarySubmesh.influenceCount)
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__);
+    pCoreSubmesh->destroy();
+    delete pCoreSubmesh;
+    return 0;
+  }
+
+  const CalCoreSubmesh::Influence *pInfluence = (const CalCoreSubmesh::Influence *)(pBuffer + binarySubmesh.influenceOffset);
+  pCoreSubmesh->getVectorInfluence().assign(pInfluence, pInfluence + binarySubmesh.influenceCount);
+
+  for(textureCoordinateId = 0; textureCoordinateId < textureCoordinateCount; textureCoordinateId++)
+  {
+    const CalBinaryChannel& channel = pChannel[textureCoordinateId];
+
+    if(textureCoordinateId >= loadedTextureCoordinateCount)
+    {
+      pCoreSubmesh->deferTextureCoordinates(textureCoordinateId, pBuffer + channel.textureCoordinateOffset);
+    }
+    else if(vertexCount > 0)
+    {
+      memcpy(&pCoreSubmesh->getVectorTextureCoordinate(textureCoordinateId)[0], pBuffer + channel.textureCoordinateOffset, vertexCount * sizeof(CalCoreSubmesh::TextureCoordinate));
+    }
+
+    if((channel.tangentSpaceOffset != 0) && bDefer)
+    {
+      pCoreSubmesh->deferTangentSpaces(textureCoordinateId, pBuffer + channel.tangentSpaceOffset);
+    }
+    else if(channel.tangentSpaceOffset != 0)
+    {
+      pCoreSubmesh->enableTangents(textureCoordinateId, true);
+      if(vertexCount > 0)
+      {
+        memcpy(&pCoreSubmesh->getVectorTangentSpace(textureCoordinateId)[0], pBuffer + channel.tangentSpaceOffset, vertexCount * sizeof(CalCoreSubmesh::TangentSpace));
+      }
+    }
+  }
+
+  // renumbering the vertices would load the deferred channels, the error is
+  // set by the optimizer
+  if((loadingMode & LOADER_OPTIMIZE_VERTEX_CACHE) && !pCoreSubmesh->optimizeVertexCache(!bDefer))
+  {
+    pCoreSubmesh->destroy();
+    delete pCoreSubmesh;
+    return 0;
+  }
+
+  return pCoreSubmesh;
+}
+
+// the incremental loader decodes through these from its own translation unit
+template CalCoreBone *CalLoader::loadCoreBones<CalBufferReader>(CalBufferReader& dataSrc);
+template bool CalLoader::loadCoreKeyframes<CalBufferReader>(CalBufferReader& dataSrc, CalCoreTrack *pCoreTrack, int keyframeCount);
+template bool CalLoader::loadCoreSubmeshFaces<CalBufferReader>(CalBufferReader& dataSrc, CalCoreSubmesh *pCoreSubmesh);
+template CalCoreSubmesh *CalLoader::loadCoreSubmeshHeader<CalBufferReader>(CalBufferReader& dataSrc);
+template bool CalLoader::loadCoreSubmeshVertices<CalBufferReader>(CalBufferReader& dataSrc, CalCoreSubmesh *pCoreSubmesh, int firstVertexId, int vertexCount);
+template CalCoreTrack *CalLoader::loadCoreTrackHeader<CalBufferReader>(CalBufferReader& dataSrc, CalArena *pArena, int& keyframeCount);
+
 //****************************************************************************//
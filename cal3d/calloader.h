@@ -22,17 +22,22 @@
 // Forward declarations                                                       //
 //****************************************************************************//
 
+class CalArena;
+class CalBufferReader;
 class CalCoreModel;
 class CalCoreBone;
 class CalCoreAnimation;
 class CalCoreTrack;
 class CalCoreKeyframe;
 class CalCoreSubmesh;
+struct CalBinarySubmesh;
 
 enum
 {
   LOADER_ROTATE_X_AXIS = 1,
-  LOADER_INVERT_V_COORD = 2
+  LOADER_INVERT_V_COORD = 2,
+  LOADER_DEFER_CHANNELS = 4, // binary (CBF) models only, see CalLoader::setLoadingMode
+  LOADER_OPTIMIZE_VERTEX_CACHE = 8
 };
 
 //****************************************************************************//
@@ -45,6 +50,8 @@ enum
 
 class CAL3D_API CalLoader: public CalLoaderUserData
 {
+  friend class CalAsyncLoader;
+
 // constructors/destructor
 public:
   CalLoader();
@@ -70,18 +77,37 @@ public:
   bool loadCoreModel(CalCoreModel *model, void* inputBuffer1, int len1, const std::string& strFilename1,
 	                                  void* inputBuffer2, int len2, const std::string& strFilename2);
 
+  bool loadBinaryCoreModel(CalCoreModel *model, const std::string& strFilename);
+  bool loadBinaryCoreModel(CalCoreModel *model, const void *pBuffer, int len);
+
   static void setLoadingMode(int flags);
+  static void setLoadingThreadCount(int count);
   
 protected:
-  static CalCoreBone *loadCoreBones(CalDataSource& dataSrc);
-  static CalCoreKeyframe *loadCoreKeyframe(CalDataSource& dataSrc);
-  static CalCoreSubmesh *loadCoreSubmesh(CalDataSource& dataSrc);
-  static CalCoreTrack *loadCoreTrack(CalDataSource& dataSrc);
+  // the readers are instantiated for CalDataSource and for CalBufferReader
+  template<class DataSource> static CalCoreBone *loadCoreBones(DataSource& dataSrc);
+  template<class DataSource> static bool loadCoreKeyframe(DataSource& dataSrc, CalCoreKeyframe& coreKeyframe);
+  template<class DataSource> static bool loadCoreKeyframes(DataSource& dataSrc, CalCoreTrack *pCoreTrack, int keyframeCount);
+  template<class DataSource> static CalCoreSubmesh *loadCoreSubmesh(DataSource& dataSrc);
+  template<class DataSource> static bool loadCoreSubmeshFaces(DataSource& dataSrc, CalCoreSubmesh *pCoreSubmesh);
+  template<class DataSource> static CalCoreSubmesh *loadCoreSubmeshHeader(DataSource& dataSrc);
+  template<class DataSource> static bool loadCoreSubmeshVertices(DataSource& dataSrc, CalCoreSubmesh *pCoreSubmesh, int firstVertexId, int vertexCount);
+  template<class DataSource> static bool loadCoreSubmeshes(CalCoreModel *model, DataSource& dataSrc, int submeshCount);
+  template<class DataSource> static CalCoreTrack *loadCoreTrack(DataSource& dataSrc, CalArena *pArena);
+  template<class DataSource> static CalCoreTrack *loadCoreTrackHeader(DataSource& dataSrc, CalArena *pArena, int& keyframeCount);
+  template<class DataSource> static bool loadCoreAnimationData(CalCoreAnimation *anim, DataSource& dataSrc);
+  template<class DataSource> static bool loadCoreModelData(CalCoreModel *model, DataSource& dataSrc);
+  template<class DataSource> static bool loadCoreModelData(CalCoreModel *model, DataSource& dataSrc1, DataSource& dataSrc2);
+
+  static CalCoreSubmesh *loadBinaryCoreSubmesh(const char *pBuffer, int len, const CalBinarySubmesh& binarySubmesh);
   static bool loadCoreAnimation(CalCoreAnimation *anim, CalDataSource& dataSrc);
   static bool loadCoreModel(CalCoreModel *model, CalDataSource& dataSrc);
   static bool loadCoreModel(CalCoreModel *model, CalDataSource& dataSrc1, CalDataSource& dataSrc2);
+  static bool loadCoreSubmeshes(CalCoreModel *model, CalBufferReader& dataSrc, int submeshCount);
+  static void setWorkerThread(bool bWorkerThread);
 
   static int loadingMode;
+  static int loadingThreadCount;
 };
 
 #endif
@@ -0,0 +1,636 @@
+//****************************************************************************//
+// lod.cpp                                                                    //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "callod.h"
+#include "calerror.h"
+#include "calmodel.h"
+#include "calsub.h"
+#include "calcoresub.h"
+
+ /*****************************************************************************/
+/** Constructs the LOD controller instance.
+  *
+  * This function is the default constructor of the LOD controller instance.
+  *****************************************************************************/
+
+CalLodController::CalLodController()
+{
+  m_projectionScale = 1.0f;
+  m_minScreenSize = 4.0f;
+  m_fullScreenSize = 200.0f;
+  m_hysteresis = 0.25f;
+  m_faceBudget = 0;
+  m_vertexBudget = 0;
+  m_maxUpdateInterval = 4;
+  m_detailScale = 1.0f;
+  m_faceCount = 0;
+  m_vertexCount = 0;
+}
+
+ /*****************************************************************************/
+/** Destructs the LOD controller instance.
+  *
+  * This function is the destructor of the LOD controller instance.
+  *****************************************************************************/
+
+CalLodController::~CalLodController()
+{
+  assert(m_vectorEntry.empty());
+}
+
+ /*****************************************************************************/
+/** Creates the LOD controller instance.
+  *
+  * This function creates the LOD controller instance.
+  *
+  * @param projectionScale The projection scale, see setProjectionScale().
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalLodController::create(float projectionScale)
+{
+  m_projectionScale = projectionScale;
+  m_detailScale = 1.0f;
+  m_faceCount = 0;
+  m_vertexCount = 0;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the LOD controller instance.
+  *
+  * This function unregisters all models. The LOD levels of the models are
+  * left as they are.
+  *****************************************************************************/
+
+void CalLodController::destroy()
+{
+  m_vectorEntry.clear();
+  m_faceCount = 0;
+  m_vertexCount = 0;
+}
+
+ /*****************************************************************************/
+/** Checks if the models fit into the budget.
+  *
+  * This function checks if the faces and vertices of all registered models
+  * fit into the budget at a detail scale.
+  *
+  * @param detailScale The detail scale.
+  *
+  * @return One of the following values:
+  *         \li \b true if the models fit into the budget
+  *         \li \b false if they do not
+  *****************************************************************************/
+
+bool CalLodController::fitsBudget(float detailScale)
+{
+  int faceCount;
+  faceCount = 0;
+
+  int vertexCount;
+  vertexCount = 0;
+
+  int modelId;
+  for(modelId = 0; modelId < (int)m_vectorEntry.size(); modelId++)
+  {
+    const Entry& entry = m_vectorEntry[modelId];
+    if(entry.pModel == 0) continue;
+
+    int lodLevelId;
+    lodLevelId = getBudgetLodLevelId(entry, detailScale);
+
+    faceCount += entry.vectorFaceCount[lodLevelId];
+    vertexCount += entry.vectorVertexCount[lodLevelId];
+  }
+
+  if((m_faceBudget > 0) && (faceCount > m_faceBudget)) return false;
+  if((m_vertexBudget > 0) && (vertexCount > m_vertexBudget)) return false;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Returns the LOD level of a model at a detail scale.
+  *
+  * This function returns the LOD level a model gets with its detail scaled
+  * by the given factor, keeping its current level within the hysteresis.
+  *
+  * @param entry The entry of the model.
+  * @param detailScale The detail scale.
+  *
+  * @return The ID of the LOD level.
+  *****************************************************************************/
+
+int CalLodController::getBudgetLodLevelId(const Entry& entry, float detailScale)
+{
+  int lodLevelCount;
+  lodLevelCount = entry.vectorFaceCount.size();
+
+  int lodLevelId;
+  lodLevelId = getHysteresisBand(entry.lodLevelId, entry.detail * detailScale * (lodLevelCount - 1));
+
+  if(lodLevelId < 0) lodLevelId = 0;
+  if(lodLevelId >= lodLevelCount) lodLevelId = lodLevelCount - 1;
+
+  return lodLevelId;
+}
+
+ /*****************************************************************************/
+/** Returns the detail scale.
+  *
+  * This function returns the factor the detail of all models was scaled by
+  * in the last update to fit into the budget. It is 1.0 if the models fit
+  * without scaling.
+  *
+  * @return The detail scale.
+  *****************************************************************************/
+
+float CalLodController::getDetailScale()
+{
+  return m_detailScale;
+}
+
+ /*****************************************************************************/
+/** Returns the number of faces.
+  *
+  * This function returns the number of faces of all registered models at the
+  * LOD levels picked in the last update. It can exceed the face budget if
+  * the models do not fit even at their lowest levels.
+  *
+  * @return The number of faces.
+  *****************************************************************************/
+
+int CalLodController::getFaceCount()
+{
+  return m_faceCount;
+}
+
+ /*****************************************************************************/
+/** Returns a band with hysteresis.
+  *
+  * This function returns the band a value falls into, where band n covers
+  * the values from n - 0.5 to n + 0.5. The current band is kept as long as
+  * the value is within the hysteresis of its borders.
+  *
+  * @param band The current band, or -1 if there is none.
+  * @param value The value.
+  *
+  * @return The band.
+  *****************************************************************************/
+
+int CalLodController::getHysteresisBand(int band, float value)
+{
+  if((band >= 0) && (value >= band - 0.5f - m_hysteresis) && (value <= band + 0.5f + m_hysteresis)) return band;
+
+  return (int)floor(value + 0.5f);
+}
+
+ /*****************************************************************************/
+/** Returns the LOD level of a model.
+  *
+  * This function returns the LOD level picked for a model in the last update.
+  * The level ID counts from 0, the lowest level, to Cal::LOD_LEVEL_COUNT - 1,
+  * the full level.
+  *
+  * @param modelId The ID of the model.
+  *
+  * @return One of the following values:
+  *         \li the ID of the LOD level
+  *         \li \b -1 if an error happend or the model was not updated yet
+  *****************************************************************************/
+
+int CalLodController::getLodLevelId(int modelId)
+{
+  if(!isValid(modelId)) return -1;
+
+  return m_vectorEntry[modelId].lodLevelId;
+}
+
+ /*****************************************************************************/
+/** Returns a projection scale.
+  *
+  * This function returns the projection scale of a perspective projection,
+  * the height in pixels of an object of unit size at unit distance.
+  *
+  * @param fieldOfView The vertical field of view in radians.
+  * @param viewportHeight The height of the viewport in pixels.
+  *
+  * @return The projection scale.
+  *****************************************************************************/
+
+float CalLodController::getProjectionScale(float fieldOfView, int viewportHeight)
+{
+  return (float)viewportHeight / (2.0f * (float)tan(fieldOfView * 0.5f));
+}
+
+ /*****************************************************************************/
+/** Returns the screen size of a model.
+  *
+  * This function returns the projected bounding radius of a model in pixels
+  * as computed in the last update.
+  *
+  * @param modelId The ID of the model.
+  *
+  * @return One of the following values:
+  *         \li the screen size
+  *         \li \b 0.0 if an error happend
+  *****************************************************************************/
+
+float CalLodController::getScreenSize(int modelId)
+{
+  if(!isValid(modelId)) return 0.0f;
+
+  return m_vectorEntry[modelId].screenSize;
+}
+
+ /*****************************************************************************/
+/** Returns the animation update interval of a model.
+  *
+  * This function returns the number of frames between animation updates of a
+  * model as picked in the last update. It is 1 for models at or above the
+  * full screen size, and doubles each time the screen size halves, up to the
+  * maximum update interval.
+  *
+  * @param modelId The ID of the model.
+  *
+  * @return One of the following values:
+  *         \li the update interval
+  *         \li \b 1 if an error happend or the model was not updated yet
+  *****************************************************************************/
+
+int CalLodController::getUpdateInterval(int modelId)
+{
+  if(!isValid(modelId) || (m_vectorEntry[modelId].updateBand < 0)) return 1;
+
+  return 1 << m_vectorEntry[modelId].updateBand;
+}
+
+ /*****************************************************************************/
+/** Returns the number of vertices.
+  *
+  * This function returns the number of vertices of all registered models at
+  * the LOD levels picked in the last update.
+  *
+  * @return The number of vertices.
+  *****************************************************************************/
+
+int CalLodController::getVertexCount()
+{
+  return m_vertexCount;
+}
+
+ /*****************************************************************************/
+/** Checks if a model ID is valid.
+  *
+  * This function checks if a model ID belongs to a registered model, and sets
+  * the last error if it does not.
+  *
+  * @param modelId The ID of the model.
+  *
+  * @return One of the following values:
+  *         \li \b true if the model ID is valid
+  *         \li \b false if it is not
+  *****************************************************************************/
+
+bool CalLodController::isValid(int modelId)
+{
+  if((modelId < 0) || (modelId >= (int)m_vectorEntry.size()) || (m_vectorEntry[modelId].pModel == 0))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalLodController");
+    return false;
+  }
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Registers a model.
+  *
+  * This function registers a created model with its bounding radius. The
+  * faces and vertices of every LOD level of the model are counted here, so
+  * the LOD data of its core submeshes is built if it is not yet. The model
+  * is placed at distance 0.0, which gives it the full level, until
+  * setDistance() is called. The IDs of unregistered models are reused.
+  *
+  * @param pModel A pointer to the model.
+  * @param radius The bounding radius of the model.
+  *
+  * @return One of the following values:
+  *         \li the ID of the model
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalLodController::registerModel(CalModel *pModel, float radius)
+{
+  if(pModel == 0)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalLodController::registerModel");
+    return -1;
+  }
+
+  Entry entry;
+  entry.pModel = pModel;
+  entry.radius = radius;
+  entry.distance = 0.0f;
+  entry.screenSize = 0.0f;
+  entry.detail = 1.0f;
+  entry.lodLevelId = -1;
+  entry.updateBand = -1;
+  entry.vectorFaceCount.resize(Cal::LOD_LEVEL_COUNT, 0);
+  entry.vectorVertexCount.resize(Cal::LOD_LEVEL_COUNT, 0);
+
+  // count the faces and vertices the way CalModel::setLodLevel() picks the levels
+  int lodLevelId;
+  for(lodLevelId = 0; lodLevelId < Cal::LOD_LEVEL_COUNT; lodLevelId++)
+  {
+    float lodLevel;
+    lodLevel = (float)lodLevelId / (Cal::LOD_LEVEL_COUNT - 1);
+
+    int submeshId;
+    for(submeshId = 0; submeshId < pModel->getSubmeshCount(); submeshId++)
+    {
+      CalCoreSubmesh *pCoreSubmesh;
+      pCoreSubmesh = pModel->getSubmesh(submeshId)->getCoreSubmesh();
+
+      int coreLodLevelId;
+      coreLodLevelId = pCoreSubmesh->getLodLevelId(lodLevel);
+
+      entry.vectorFaceCount[lodLevelId] += pCoreSubmesh->getLodFaceCount(coreLodLevelId);
+      entry.vectorVertexCount[lodLevelId] += pCoreSubmesh->getLodVertexCount(coreLodLevelId);
+    }
+  }
+
+  int modelId;
+  for(modelId = 0; modelId < (int)m_vectorEntry.size(); modelId++)
+  {
+    if(m_vectorEntry[modelId].pModel == 0)
+    {
+      m_vectorEntry[modelId] = entry;
+      return modelId;
+    }
+  }
+
+  m_vectorEntry.push_back(entry);
+
+  return modelId;
+}
+
+ /*****************************************************************************/
+/** Sets the budget.
+  *
+  * This function sets the number of faces and vertices all registered models
+  * may have together. A budget of 0 is unlimited.
+  *
+  * @param faceBudget The face budget.
+  * @param vertexBudget The vertex budget.
+  *****************************************************************************/
+
+void CalLodController::setBudget(int faceBudget, int vertexBudget)
+{
+  m_faceBudget = faceBudget;
+  m_vertexBudget = vertexBudget;
+}
+
+ /*****************************************************************************/
+/** Sets the camera distance of a model.
+  *
+  * This function sets the distance from the camera to the center of the
+  * bounding sphere of a model. It takes effect in the next update.
+  *
+  * @param modelId The ID of the model.
+  * @param distance The camera distance.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalLodController::setDistance(int modelId, float distance)
+{
+  if(!isValid(modelId)) return false;
+
+  m_vectorEntry[modelId].distance = distance;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Sets the hysteresis.
+  *
+  * This function sets how far, in LOD levels, the screen size of a model has
+  * to move past the border of its current level before the level changes.
+  * The same hysteresis, in halvings of the screen size, applies to the
+  * update interval. It is clamped to [0.0, 0.5].
+  *
+  * @param hysteresis The hysteresis.
+  *****************************************************************************/
+
+void CalLodController::setHysteresis(float hysteresis)
+{
+  if(hysteresis < 0.0f) hysteresis = 0.0f;
+  if(hysteresis > 0.5f) hysteresis = 0.5f;
+
+  m_hysteresis = hysteresis;
+}
+
+ /*****************************************************************************/
+/** Sets the maximum update interval.
+  *
+  * This function sets the largest number of frames between animation updates
+  * of a model. It is rounded down to a power of two.
+  *
+  * @param maxUpdateInterval The maximum update interval.
+  *****************************************************************************/
+
+void CalLodController::setMaxUpdateInterval(int maxUpdateInterval)
+{
+  if(maxUpdateInterval < 1) maxUpdateInterval = 1;
+
+  m_maxUpdateInterval = maxUpdateInterval;
+}
+
+ /*****************************************************************************/
+/** Sets the projection scale.
+  *
+  * This function sets the factor that turns a bounding radius divided by a
+  * camera distance into a screen size in pixels. See getProjectionScale().
+  *
+  * @param projectionScale The projection scale.
+  *****************************************************************************/
+
+void CalLodController::setProjectionScale(float projectionScale)
+{
+  m_projectionScale = projectionScale;
+}
+
+ /*****************************************************************************/
+/** Sets the bounding radius of a model.
+  *
+  * This function sets the radius of the bounding sphere of a model. It takes
+  * effect in the next update.
+  *
+  * @param modelId The ID of the model.
+  * @param radius The bounding radius.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalLodController::setRadius(int modelId, float radius)
+{
+  if(!isValid(modelId)) return false;
+
+  m_vectorEntry[modelId].radius = radius;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Sets the screen sizes.
+  *
+  * This function sets the screen sizes, in pixels of projected bounding
+  * radius, at which a model gets the lowest and the full LOD level. The
+  * levels in between are spread evenly over the screen sizes in between.
+  *
+  * @param minScreenSize The screen size of the lowest level.
+  * @param fullScreenSize The screen size of the full level.
+  *****************************************************************************/
+
+void CalLodController::setScreenSizes(float minScreenSize, float fullScreenSize)
+{
+  m_minScreenSize = minScreenSize;
+  m_fullScreenSize = fullScreenSize;
+}
+
+ /*****************************************************************************/
+/** Unregisters a model.
+  *
+  * This function unregisters a model. Its ID is reused by the next model
+  * that is registered.
+  *
+  * @param modelId The ID of the model.
+  *****************************************************************************/
+
+void CalLodController::unregisterModel(int modelId)
+{
+  if(!isValid(modelId)) return;
+
+  m_vectorEntry[modelId].pModel = 0;
+  m_vectorEntry[modelId].vectorFaceCount.clear();
+  m_vectorEntry[modelId].vectorVertexCount.clear();
+}
+
+ /*****************************************************************************/
+/** Updates the LOD levels.
+  *
+  * This function picks the LOD level and update interval of every registered
+  * model and sets the LOD level of the models. If the models do not fit into
+  * the budget, the detail of all models is scaled down by the largest factor
+  * that fits, so the smallest models drop to their lowest levels first. This
+  * function should be called once per frame, after the camera distances are
+  * set.
+  *****************************************************************************/
+
+void CalLodController::update()
+{
+  int maxUpdateBand;
+  maxUpdateBand = 0;
+  while((2 << maxUpdateBand) <= m_maxUpdateInterval) maxUpdateBand++;
+
+  // compute the screen size and detail of every model
+  int modelId;
+  for(modelId = 0; modelId < (int)m_vectorEntry.size(); modelId++)
+  {
+    Entry& entry = m_vectorEntry[modelId];
+    if(entry.pModel == 0) continue;
+
+    // a camera inside the bounding sphere sees the model at its largest
+    float distance;
+    distance = (entry.distance > entry.radius) ? entry.distance : entry.radius;
+
+    entry.screenSize = (distance > 0.0f) ? entry.radius * m_projectionScale / distance : 0.0f;
+
+    if(m_fullScreenSize > m_minScreenSize)
+    {
+      entry.detail = (entry.screenSize - m_minScreenSize) / (m_fullScreenSize - m_minScreenSize);
+      if(entry.detail < 0.0f) entry.detail = 0.0f;
+      if(entry.detail > 1.0f) entry.detail = 1.0f;
+    }
+    else
+    {
+      entry.detail = (entry.screenSize >= m_fullScreenSize) ? 1.0f : 0.0f;
+    }
+
+    // the update interval doubles with every halving below the full screen size
+    int updateBand;
+    if(entry.screenSize >= m_fullScreenSize) updateBand = getHysteresisBand(entry.updateBand, -0.5f);
+    else if(entry.screenSize <= 0.0f) updateBand = maxUpdateBand;
+    else updateBand = getHysteresisBand(entry.updateBand, (float)(log(m_fullScreenSize / entry.screenSize) / log(2.0)) - 0.5f);
+
+    if(updateBand < 0) updateBand = 0;
+    if(updateBand > maxUpdateBand) updateBand = maxUpdateBand;
+    entry.updateBand = updateBand;
+  }
+
+  // find the largest detail scale that fits into the budget
+  m_detailScale = 1.0f;
+  if(!fitsBudget(1.0f))
+  {
+    float minDetailScale;
+    minDetailScale = 0.0f;
+
+    float maxDetailScale;
+    maxDetailScale = 1.0f;
+
+    int iteration;
+    for(iteration = 0; iteration < 16; iteration++)
+    {
+      float detailScale;
+      detailScale = 0.5f * (minDetailScale + maxDetailScale);
+
+      if(fitsBudget(detailScale)) minDetailScale = detailScale;
+      else maxDetailScale = detailScale;
+    }
+
+    m_detailScale = minDetailScale;
+  }
+
+  // set the LOD level of every model
+  m_faceCount = 0;
+  m_vertexCount = 0;
+
+  for(modelId = 0; modelId < (int)m_vectorEntry.size(); modelId++)
+  {
+    Entry& entry = m_vectorEntry[modelId];
+    if(entry.pModel == 0) continue;
+
+    entry.lodLevelId = getBudgetLodLevelId(entry, m_detailScale);
+    entry.pModel->setLodLevel((float)entry.lodLevelId / (Cal::LOD_LEVEL_COUNT - 1));
+
+    m_faceCount += entry.vectorFaceCount[entry.lodLevelId];
+    m_vertexCount += entry.vectorVertexCount[entry.lodLevelId];
+  }
+}
+
+//****************************************************************************//
@@ -0,0 +1,113 @@
+//****************************************************************************//
+// lod.h                                                                      //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_LOD_H
+#define CAL_LOD_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalModel;
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The LOD controller class.
+  *
+  * A LOD controller picks the LOD level of every registered model from its
+  * size on screen, the bounding radius projected at its camera distance. A
+  * model gets the lowest level below the minimum screen size and the full
+  * level above the full screen size. A level only changes once the screen
+  * size leaves the band of the current level by the hysteresis, so models
+  * near a band border do not switch levels every frame. The sum of the faces
+  * and vertices of all models is kept within a per-frame budget by scaling
+  * down the detail of all models together. Besides the mesh level, every
+  * model gets an animation update interval that doubles each time its screen
+  * size halves below the full screen size; the application applies it by
+  * updating the model every that many frames.
+  *****************************************************************************/
+
+class CAL3D_API CalLodController
+{
+// misc
+protected:
+  struct Entry
+  {
+    CalModel *pModel;
+    float radius;
+    float distance;
+    float screenSize;
+    float detail;
+    int lodLevelId;
+    int updateBand;
+    std::vector<int> vectorFaceCount;
+    std::vector<int> vectorVertexCount;
+  };
+
+// member variables
+protected:
+  std::vector<Entry> m_vectorEntry;
+  float m_projectionScale;
+  float m_minScreenSize;
+  float m_fullScreenSize;
+  float m_hysteresis;
+  int m_faceBudget;
+  int m_vertexBudget;
+  int m_maxUpdateInterval;
+  float m_detailScale;
+  int m_faceCount;
+  int m_vertexCount;
+
+// constructors/destructor
+public:
+  CalLodController();
+  virtual ~CalLodController();
+
+// member functions
+public:
+  bool create(float projectionScale);
+  void destroy();
+  float getDetailScale();
+  int getFaceCount();
+  int getLodLevelId(int modelId);
+  static float getProjectionScale(float fieldOfView, int viewportHeight);
+  float getScreenSize(int modelId);
+  int getUpdateInterval(int modelId);
+  int getVertexCount();
+  int registerModel(CalModel *pModel, float radius);
+  void setBudget(int faceBudget, int vertexBudget);
+  bool setDistance(int modelId, float distance);
+  void setHysteresis(float hysteresis);
+  void setMaxUpdateInterval(int maxUpdateInterval);
+  void setProjectionScale(float projectionScale);
+  bool setRadius(int modelId, float radius);
+  void setScreenSizes(float minScreenSize, float fullScreenSize);
+  void unregisterModel(int modelId);
+  void update();
+
+protected:
+  bool fitsBudget(float detailScale);
+  int getBudgetLodLevelId(const Entry& entry, float detailScale);
+  int getHysteresisBand(int band, float value);
+  bool isValid(int modelId);
+};
+
+#endif
+
+//****************************************************************************//
@@ -0,0 +1,255 @@
+//****************************************************************************//
+// mapfile.cpp                                                                //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calmapfile.h"
+#include "calerror.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ /*****************************************************************************/
+/** Constructs the mapped file instance.
+  *
+  * This function is the default constructor of the mapped file instance.
+  *****************************************************************************/
+
+CalMappedFile::CalMappedFile()
+{
+  m_pData = 0;
+  m_size = 0;
+  m_bMapped = false;
+#ifdef _WIN32
+  m_hFile = INVALID_HANDLE_VALUE;
+  m_hMapping = 0;
+#endif
+}
+
+ /*****************************************************************************/
+/** Destructs the mapped file instance.
+  *
+  * This function is the destructor of the mapped file instance.
+  *****************************************************************************/
+
+CalMappedFile::~CalMappedFile()
+{
+  close();
+}
+
+ /*****************************************************************************/
+/** Closes the file.
+  *
+  * This function unmaps the file or frees its buffer. All pointers into the
+  * data become invalid.
+  *****************************************************************************/
+
+void CalMappedFile::close()
+{
+  if(m_pData != 0)
+  {
+#ifdef _WIN32
+    if(m_bMapped) UnmapViewOfFile(m_pData);
+    else free(m_pData);
+#else
+    if(m_bMapped) munmap(m_pData, m_size);
+    else free(m_pData);
+#endif
+  }
+
+#ifdef _WIN32
+  if(m_hMapping != 0) CloseHandle((HANDLE)m_hMapping);
+  if(m_hFile != INVALID_HANDLE_VALUE) CloseHandle((HANDLE)m_hFile);
+  m_hFile = INVALID_HANDLE_VALUE;
+  m_hMapping = 0;
+#endif
+
+  m_pData = 0;
+  m_size = 0;
+  m_bMapped = false;
+}
+
+ /*****************************************************************************/
+/** Provides access to the file data.
+  *
+  * This function returns the contents of the file.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the file data
+  *         \li \b 0 if no file is open
+  *****************************************************************************/
+
+const void *CalMappedFile::getData()
+{
+  return m_pData;
+}
+
+ /*****************************************************************************/
+/** Returns the file size.
+  *
+  * This function returns the size of the file.
+  *
+  * @return The size in bytes.
+  *****************************************************************************/
+
+int CalMappedFile::getSize()
+{
+  return m_size;
+}
+
+ /*****************************************************************************/
+/** Returns the mapping state.
+  *
+  * This function returns whether the file is mapped into memory or was read
+  * into a private buffer.
+  *
+  * @return One of the following values:
+  *         \li \b true if the file is mapped
+  *         \li \b false if not
+  *****************************************************************************/
+
+bool CalMappedFile::isMapped()
+{
+  return m_bMapped;
+}
+
+ /*****************************************************************************/
+/** Opens a file.
+  *
+  * This function maps a file read-only into memory. If the file cannot be
+  * mapped, it is read into a buffer instead.
+  *
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalMappedFile::open(const std::string& strFilename)
+{
+  close();
+
+#ifdef _WIN32
+  HANDLE hFile;
+  hFile = CreateFileA(strFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+  if(hFile == INVALID_HANDLE_VALUE)
+  {
+    CalError::setLastError(CalError::FILE_NOT_FOUND, __FILE__, __LINE__, strFilename);
+    return false;
+  }
+  m_hFile = hFile;
+
+  DWORD sizeHigh;
+  DWORD size;
+  size = GetFileSize(hFile, &sizeHigh);
+  if((size == INVALID_FILE_SIZE) || (sizeHigh != 0) || (size == 0) || (size > 0x7fffffff))
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__, strFilename);
+    close();
+    return false;
+  }
+  m_size = (int)size;
+
+  HANDLE hMapping;
+  hMapping = CreateFileMappingA(hFile, 0, PAGE_READONLY, 0, 0, 0);
+  if(hMapping != 0)
+  {
+    m_hMapping = hMapping;
+    m_pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if(m_pData != 0)
+    {
+      m_bMapped = true;
+      return true;
+    }
+  }
+
+  // fall back to a private copy of the file
+  m_pData = malloc(m_size);
+  DWORD bytesRead;
+  if((m_pData == 0) || !ReadFile(hFile, m_pData, size, &bytesRead, 0) || (bytesRead != size))
+  {
+    CalError::setLastError(CalError::FILE_PARSER_FAILED, __FILE__, __LINE__, strFilename);
+    close();
+    return false;
+  }
+#else
+  int fd;
+  fd = ::open(strFilename.c_str(), O_RDONLY);
+  if(fd < 0)
+  {
+    CalError::setLastError(CalError::FILE_NOT_FOUND, __FILE__, __LINE__, strFilename);
+    return false;
+  }
+
+  struct stat fileStat;
+  if((fstat(fd, &fileStat) != 0) || (fileStat.st_size == 0) || (fileStat.st_size > 0x7fffffff))
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__, strFilename);
+    ::close(fd);
+    return false;
+  }
+  m_size = (int)fileStat.st_size;
+
+  void *pData;
+  pData = mmap(0, m_size, PROT_READ, MAP_SHARED, fd, 0);
+  if(pData != MAP_FAILED)
+  {
+    ::close(fd);
+    m_pData = pData;
+    m_bMapped = true;
+    return true;
+  }
+
+  // fall back to a private copy of the file
+  m_pData = malloc(m_size);
+  if(m_pData == 0)
+  {
+    CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__, strFilename);
+    ::close(fd);
+    m_size = 0;
+    return false;
+  }
+
+  int offset;
+  for(offset = 0; offset < m_size; )
+  {
+    ssize_t bytesRead;
+    bytesRead = ::read(fd, (char *)m_pData + offset, m_size - offset);
+    if(bytesRead <= 0)
+    {
+      CalError::setLastError(CalError::FILE_PARSER_FAILED, __FILE__, __LINE__, strFilename);
+      ::close(fd);
+      close();
+      return false;
+    }
+    offset += (int)bytesRead;
+  }
+
+  ::close(fd);
+#endif
+
+  return true;
+}
+
+//****************************************************************************//
@@ -0,0 +1,62 @@
+//****************************************************************************//
+// mapfile.h                                                                  //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_MAPFILE_H
+#define CAL_MAPFILE_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The mapped file class.
+  *
+  * A mapped file makes the contents of a file available as one read-only
+  * memory block. The file is mapped into the address space where the platform
+  * supports it, so its pages come straight from the page cache and are shared
+  * by every process that maps the same file. Elsewhere the file is read into
+  * a private buffer.
+  *****************************************************************************/
+
+class CAL3D_API CalMappedFile
+{
+// member variables
+protected:
+  void *m_pData;
+  int m_size;
+  bool m_bMapped;
+#ifdef _WIN32
+  void *m_hFile;
+  void *m_hMapping;
+#endif
+
+// constructors/destructor
+public:
+  CalMappedFile();
+  virtual ~CalMappedFile();
+
+// member functions
+public:
+  void close();
+  const void *getData();
+  int getSize();
+  bool isMapped();
+  bool open(const std::string& strFilename);
+};
+
+#endif
+
+//****************************************************************************//
@@ -25,6 +25,10 @@
 #include "calcoretrack.h"
 #include "calcorebone.h"
 #include "calcoresub.h"
+#include "calbake.h"
+#include "calnametable.h"
+
+int CalModel::defaultInterpolationMode = INTERPOLATE_SLERP;
 
  /*****************************************************************************/
 /** Constructs the model instance.
@@ -37,6 +41,12 @@ CalModel::CalModel(void)
   m_pCoreModel = 0;
   m_translation.clear();
   m_rotation.clear();
+  m_interpolationMode = defaultInterpolationMode;
+  m_bMergedBuffers = false;
+  m_mergedMapId = -1;
+  m_mergedVertexCount = 0;
+  m_mergedFaceCount = 0;
+  m_mergedFaceRevision = 0;
 }
 
 CalModel::~CalModel(void)
@@ -153,6 +163,20 @@ void CalModel::destroy(void)
     m_vectorBone[boneId].destroy();
   m_vectorBone.clear();
 
+  m_pose.destroy();
+
+  // free the merged buffers
+  m_bMergedBuffers = false;
+  m_vectorMergedVertex.clear();
+  m_vectorMergedNormal.clear();
+  m_vectorMergedTextureCoordinate.clear();
+  m_vectorMergedFace.clear();
+  m_vectorMergedShortFace.clear();
+  m_vectorDrawRange.clear();
+  m_vectorMergedLodLevelId.clear();
+  m_mergedVertexCount = 0;
+  m_mergedFaceCount = 0;
+
   m_pCoreModel = 0;
 }
 
@@ -235,10 +259,33 @@ CalBone *CalModel::getBone(int boneId)
   *****************************************************************************/
 
 int CalModel::findBone(const std::string& name, int hint)
+{
+  // A name that was never interned cannot belong to a bone.
+  int nameId = CalNameTable::getNameId(name);
+  if (nameId < 0) return -1;
+
+  return findBone(nameId, hint);
+}
+
+ /*****************************************************************************/
+/** Given a bone name ID, returns the bone's ID.
+  *
+  * This function accepts the ID of a bone name in the name table, and returns
+  * the bone's ID. Names are compared by their IDs.
+  *
+  * @param nameId The ID of the name of the bone that should be returned.
+  * @param hint A bone ID to try first.
+  *
+  * @return One of the following values:
+  *         \li the ID of the bone
+  *         \li \b -1 if an error happend
+  *****************************************************************************/
+
+int CalModel::findBone(int nameId, int hint)
 {
   // See if the hint helps.
   if ((hint >= 0) && (hint < m_vectorBone.size()))
-    if (m_vectorBone[hint].getCoreBone()->getName().compare(name) == 0)
+    if (m_vectorBone[hint].getCoreBone()->getNameId() == nameId)
       return hint;
   
   // If not, do a brute scan.
@@ -246,7 +293,7 @@ int CalModel::findBone(const std::string& name, int hint)
   int boneCount = m_vectorBone.size();
   for (boneId = 0; boneId < boneCount; boneId++)
   {
-    if (m_vectorBone[boneId].getCoreBone()->getName().compare(name) == 0)
+    if (m_vectorBone[boneId].getCoreBone()->getNameId() == nameId)
       return boneId;
   }
   
@@ -391,29 +438,58 @@ void CalModel::lockState(void)
 
 void CalModel::blendState(CalCoreAnimation *pCoreAnimation, float weight, float time)
 {
-  // get the duration of the core animation
-  float duration;
-  duration = pCoreAnimation->getDuration();
-  
-  // get the list of core tracks of above core animation
-  std::list<CalCoreTrack *>& listCoreTrack = pCoreAnimation->getListCoreTrack();
+  // get the interpolation mode, the animation may override the model
+  int mode;
+  mode = pCoreAnimation->getInterpolationMode();
+  if(mode == INTERPOLATE_DEFAULT) mode = m_interpolationMode;
+
+  // sample all core tracks at once, then blend the result into the bones
+  if(!pCoreAnimation->samplePose(time, m_pose, mode)) return;
+
+  blendPose(pCoreAnimation, m_pose, weight);
+}
+
+ /*****************************************************************************/
+/** Blends a sampled pose into the skeleton's state.
+  *
+  * This function blends a pose, sampled from a core animation with
+  * CalCoreAnimation::samplePose(), into the skeleton's state. It can be used
+  * in place of blendState when the caller wants to keep or modify the pose.
+  *
+  * @param pCoreAnimation The core animation the pose was sampled from.
+  * @param pose The sampled pose.
+  * @param weight The blending weight.
+  *****************************************************************************/
+
+void CalModel::blendPose(CalCoreAnimation *pCoreAnimation, CalPose& pose, float weight)
+{
+  // get the vector of core tracks of above core animation
+  std::vector<CalCoreTrack *>& vectorCoreTrack = pCoreAnimation->getVectorCoreTrack();
   
   // loop through all core tracks of the core animation
-  std::list<CalCoreTrack *>::iterator iteratorCoreTrack;
-  for(iteratorCoreTrack = listCoreTrack.begin(); iteratorCoreTrack != listCoreTrack.end(); ++iteratorCoreTrack)
+  int trackId;
+  int trackCount = pose.getTrackCount();
+  if(trackCount > (int)vectorCoreTrack.size()) trackCount = vectorCoreTrack.size();
+  for(trackId = 0; trackId < trackCount; trackId++)
   {
+    // a track without keyframes leaves its bone alone
+    if(!pose.isSampled(trackId)) continue;
+
+    CalCoreTrack *pCoreTrack = vectorCoreTrack[trackId];
+
     // get the appropriate bone
-    int boneId = findBone((*iteratorCoreTrack)->getCoreBoneName(), (*iteratorCoreTrack)->getCoreBoneHint());
-    (*iteratorCoreTrack)->setCoreBoneHint(boneId);
+    int boneId = findBone(pCoreTrack->getCoreBoneNameId(), pCoreTrack->getCoreBoneHint());
+    pCoreTrack->setCoreBoneHint(boneId);
     
     if (boneId >= 0)
     {
       CalBone &bone = m_vectorBone[boneId];
 
-      // get the current translation and rotation
+      // get the sampled translation and rotation
       CalVector orientation;
       CalQuaternion rotation;
-      (*iteratorCoreTrack)->getState(time, duration, orientation, rotation);
+      pose.getOrientation(trackId, orientation);
+      pose.getRotation(trackId, rotation);
       CalVector translation = orientation * bone.getCoreBone()->getLength();
       
       // blend the bone state with the new state
@@ -455,6 +531,75 @@ bool CalModel::mimicSkeleton(CalModel *pModel)
   return true;
 }
 
+ /*****************************************************************************/
+/** Sets the skinning transforms from a baked animation.
+  *
+  * This function copies (or blends) the bone transforms of a baked animation
+  * straight into the transforms used by updateVertices. It replaces the whole
+  * clearState, blendState, lockState, calculateState sequence; the bone
+  * states themselves are not updated.
+  *
+  * @param pBakedAnimation A pointer to a baked animation of the core model.
+  * @param time The time in seconds.
+  * @param bInterpolate \b true to blend between frames, \b false to pick the
+  *                     frame before the time.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalModel::setBakedState(CalBakedAnimation *pBakedAnimation, float time, bool bInterpolate)
+{
+  if((pBakedAnimation == 0) || (pBakedAnimation->getBoneCount() != (int)m_vectorBone.size()) || (pBakedAnimation->getFrameCount() == 0))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalModel::setBakedState");
+    return false;
+  }
+
+  // a skeleton of another core model may have the same bone count
+  if(pBakedAnimation->getCoreModel() != m_pCoreModel)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalModel::setBakedState");
+    return false;
+  }
+
+  int frameId0, frameId1;
+  float factor;
+  pBakedAnimation->findFrames(time, frameId0, frameId1, factor);
+  if(!bInterpolate) factor = 0.0f;
+
+  const float *p0 = pBakedAnimation->getFrame(frameId0);
+  const float *p1 = pBakedAnimation->getFrame(frameId1);
+
+  // blend the 3x4 palette entries into the cached transforms
+  int boneId;
+  int boneCount = m_vectorBone.size();
+  for(boneId = 0; boneId < boneCount; boneId++)
+  {
+    CalMatrix& r = m_vectorTransformMatrix[boneId];
+    CalVector& t = m_vectorTransformVector[boneId];
+
+    r.dxdx = p0[0] + factor * (p1[0] - p0[0]);
+    r.dxdy = p0[1] + factor * (p1[1] - p0[1]);
+    r.dxdz = p0[2] + factor * (p1[2] - p0[2]);
+    t.x    = p0[3] + factor * (p1[3] - p0[3]);
+    r.dydx = p0[4] + factor * (p1[4] - p0[4]);
+    r.dydy = p0[5] + factor * (p1[5] - p0[5]);
+    r.dydz = p0[6] + factor * (p1[6] - p0[6]);
+    t.y    = p0[7] + factor * (p1[7] - p0[7]);
+    r.dzdx = p0[8] + factor * (p1[8] - p0[8]);
+    r.dzdy = p0[9] + factor * (p1[9] - p0[9]);
+    r.dzdz = p0[10] + factor * (p1[10] - p0[10]);
+    t.z    = p0[11] + factor * (p1[11] - p0[11]);
+
+    p0 += 12;
+    p1 += 12;
+  }
+
+  return true;
+}
+
  /*****************************************************************************/
 /** Provides access to the core model.
   *
@@ -490,6 +635,52 @@ void CalModel::setLodLevel(float lodLevel)
   }
 }
 
+ /*****************************************************************************/
+/** Returns the interpolation mode.
+  *
+  * This function returns the quaternion interpolation mode of the model
+  * instance.
+  *
+  * @return The interpolation mode.
+  *****************************************************************************/
+
+int CalModel::getInterpolationMode(void)
+{
+  return m_interpolationMode;
+}
+
+ /*****************************************************************************/
+/** Sets the interpolation mode.
+  *
+  * This function sets the quaternion interpolation mode of the model instance.
+  * It is used to blend bone states and to sample every animation that does not
+  * set a mode of its own. See INTERPOLATE_SLERP in calquat.h for the accuracy
+  * of each mode.
+  *
+  * @param mode One of INTERPOLATE_SLERP, INTERPOLATE_NLERP or
+  *             INTERPOLATE_FAST_SLERP.
+  *****************************************************************************/
+
+void CalModel::setInterpolationMode(int mode)
+{
+  m_interpolationMode = mode;
+}
+
+ /*****************************************************************************/
+/** Sets the default interpolation mode.
+  *
+  * This function sets the quaternion interpolation mode given to every model
+  * instance constructed afterwards.
+  *
+  * @param mode One of INTERPOLATE_SLERP, INTERPOLATE_NLERP or
+  *             INTERPOLATE_FAST_SLERP.
+  *****************************************************************************/
+
+void CalModel::setDefaultInterpolationMode(int mode)
+{
+  defaultInterpolationMode = mode;
+}
+
  /*****************************************************************************/
 /** Updates the spring system
   *
@@ -524,4 +715,322 @@ void CalModel::updateVertices(void)
   }
 }
 
+ /*****************************************************************************/
+/** Builds the merged face buffer.
+  *
+  * This function packs the vertex ranges of all submeshes at their current
+  * LOD levels, and copies their faces and texture coordinates into the merged
+  * buffers with the vertex indices offset to the ranges.
+  *****************************************************************************/
+
+void CalModel::buildMergedFaces(void)
+{
+  m_mergedVertexCount = 0;
+  m_mergedFaceCount = 0;
+
+  int submeshId;
+  for(submeshId = 0; submeshId < (int)m_vectorSubmesh.size(); submeshId++)
+  {
+    CalSubmesh *pSubmesh = m_vectorSubmesh[submeshId];
+
+    DrawRange& drawRange = m_vectorDrawRange[submeshId];
+    drawRange.vertexOffset = m_mergedVertexCount;
+    drawRange.vertexCount = pSubmesh->getVertexCount();
+    drawRange.faceOffset = m_mergedFaceCount;
+    drawRange.faceCount = pSubmesh->getFaceCount();
+
+    if(drawRange.faceCount > 0)
+    {
+      if(!m_vectorMergedShortFace.empty()) pSubmesh->getFaces(&m_vectorMergedShortFace[drawRange.faceOffset * 3], drawRange.vertexOffset);
+      else pSubmesh->getFaces(&m_vectorMergedFace[drawRange.faceOffset * 3], drawRange.vertexOffset);
+    }
+
+    if((m_mergedMapId >= 0) && (drawRange.vertexCount > 0))
+    {
+      memcpy(&m_vectorMergedTextureCoordinate[drawRange.vertexOffset * 2], pSubmesh->getCoreSubmesh()->getTextureCoordinates(m_mergedMapId), drawRange.vertexCount * 2 * sizeof(float));
+    }
+
+    m_vectorMergedLodLevelId[submeshId] = pSubmesh->getLodLevelId();
+    m_mergedVertexCount += drawRange.vertexCount;
+    m_mergedFaceCount += drawRange.faceCount;
+  }
+
+  m_mergedFaceRevision++;
+}
+
+ /*****************************************************************************/
+/** Enables the merged buffers.
+  *
+  * This function makes the model instance keep one vertex, normal and
+  * texture coordinate buffer and one face buffer for all its submeshes, with
+  * a draw range for every submesh. The faces have 16-bit indices if the full
+  * levels of all submeshes have no more than Cal::SHORT_FACE_VERTEX_COUNT
+  * vertices together, and 32-bit indices otherwise. The buffers are
+  * allocated for the full levels, so their addresses stay the same when the
+  * LOD level changes.
+  *
+  * @param mapId The ID of the texture coordinate map to merge, which every
+  *              submesh must have, or -1 to merge no texture coordinates,
+  *              for example for models without any.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalModel::enableMergedBuffers(int mapId)
+{
+  // count the vertices and faces of the full levels
+  int vertexCount;
+  vertexCount = 0;
+
+  int faceCount;
+  faceCount = 0;
+
+  int submeshId;
+  for(submeshId = 0; submeshId < (int)m_vectorSubmesh.size(); submeshId++)
+  {
+    CalCoreSubmesh *pCoreSubmesh = m_vectorSubmesh[submeshId]->getCoreSubmesh();
+
+    if(mapId >= pCoreSubmesh->getTextureCoordinateCount())
+    {
+      CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalModel::enableMergedBuffers");
+      return false;
+    }
+
+    vertexCount += pCoreSubmesh->getVertexCount();
+    faceCount += pCoreSubmesh->getFaceCount();
+  }
+
+  m_mergedMapId = (mapId >= 0) ? mapId : -1;
+
+  m_vectorMergedVertex.resize(vertexCount);
+  m_vectorMergedNormal.resize(vertexCount);
+  m_vectorMergedTextureCoordinate.resize((m_mergedMapId >= 0) ? vertexCount * 2 : 0);
+
+  if(vertexCount <= Cal::SHORT_FACE_VERTEX_COUNT)
+  {
+    m_vectorMergedShortFace.resize(faceCount * 3);
+    m_vectorMergedFace.clear();
+  }
+  else
+  {
+    m_vectorMergedFace.resize(faceCount * 3);
+    m_vectorMergedShortFace.clear();
+  }
+
+  m_vectorDrawRange.resize(m_vectorSubmesh.size());
+  m_vectorMergedLodLevelId.assign(m_vectorSubmesh.size(), -1);
+  m_bMergedBuffers = true;
+
+  buildMergedFaces();
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Returns the draw range of a submesh.
+  *
+  * This function returns the ranges of the merged vertex and face buffers
+  * that hold a submesh at its current LOD level.
+  *
+  * @param submeshId The ID of the submesh.
+  *
+  * @return A reference to the draw range.
+  *****************************************************************************/
+
+const CalModel::DrawRange& CalModel::getDrawRange(int submeshId)
+{
+  return m_vectorDrawRange[submeshId];
+}
+
+ /*****************************************************************************/
+/** Returns the number of merged faces.
+  *
+  * This function returns the number of faces of all submeshes at their LOD
+  * levels of the last updateMergedBuffers() call.
+  *
+  * @return The number of faces.
+  *****************************************************************************/
+
+int CalModel::getMergedFaceCount(void)
+{
+  return m_mergedFaceCount;
+}
+
+ /*****************************************************************************/
+/** Returns the revision of the merged faces.
+  *
+  * This function returns a number that changes every time the merged face
+  * and texture coordinate buffers are rebuilt, so a renderer knows when to
+  * upload them again.
+  *
+  * @return The revision.
+  *****************************************************************************/
+
+int CalModel::getMergedFaceRevision(void)
+{
+  return m_mergedFaceRevision;
+}
+
+ /*****************************************************************************/
+/** Provides access to the merged faces.
+  *
+  * This function returns the merged face buffer with 32-bit indices.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the faces
+  *         \li \b 0 if the merged faces have 16-bit indices or are disabled
+  *****************************************************************************/
+
+int *CalModel::getMergedFaces(void)
+{
+  if(m_vectorMergedFace.empty()) return 0;
+
+  return &m_vectorMergedFace[0];
+}
+
+ /*****************************************************************************/
+/** Provides access to the merged normals.
+  *
+  * This function returns the merged normal buffer.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the normals
+  *         \li \b 0 if the merged buffers are disabled
+  *****************************************************************************/
+
+float *CalModel::getMergedNormals(void)
+{
+  if(m_vectorMergedNormal.empty()) return 0;
+
+  return &m_vectorMergedNormal[0].x;
+}
+
+ /*****************************************************************************/
+/** Provides access to the merged faces with 16-bit indices.
+  *
+  * This function returns the merged face buffer with 16-bit indices.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the faces
+  *         \li \b 0 if the merged faces have 32-bit indices or are disabled
+  *****************************************************************************/
+
+unsigned short *CalModel::getMergedShortFaces(void)
+{
+  if(m_vectorMergedShortFace.empty()) return 0;
+
+  return &m_vectorMergedShortFace[0];
+}
+
+ /*****************************************************************************/
+/** Provides access to the merged texture coordinates.
+  *
+  * This function returns the merged texture coordinate buffer.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the texture coordinates
+  *         \li \b 0 if no map is merged
+  *****************************************************************************/
+
+float *CalModel::getMergedTextureCoordinates(void)
+{
+  if(m_vectorMergedTextureCoordinate.empty()) return 0;
+
+  return &m_vectorMergedTextureCoordinate[0];
+}
+
+ /*****************************************************************************/
+/** Returns the number of merged vertices.
+  *
+  * This function returns the number of vertices of all submeshes at their
+  * LOD levels of the last updateMergedBuffers() call.
+  *
+  * @return The number of vertices.
+  *****************************************************************************/
+
+int CalModel::getMergedVertexCount(void)
+{
+  return m_mergedVertexCount;
+}
+
+ /*****************************************************************************/
+/** Provides access to the merged vertices.
+  *
+  * This function returns the merged vertex buffer.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the vertices
+  *         \li \b 0 if the merged buffers are disabled
+  *****************************************************************************/
+
+float *CalModel::getMergedVertices(void)
+{
+  if(m_vectorMergedVertex.empty()) return 0;
+
+  return &m_vectorMergedVertex[0].x;
+}
+
+ /*****************************************************************************/
+/** Returns true if the merged buffers are enabled.
+  *
+  * This function returns true if the model instance keeps merged buffers.
+  *
+  * @return True if the merged buffers are enabled.
+  *****************************************************************************/
+
+bool CalModel::mergedBuffersEnabled(void)
+{
+  return m_bMergedBuffers;
+}
+
+ /*****************************************************************************/
+/** Updates the merged buffers.
+  *
+  * This function rebuilds the merged faces and texture coordinates if the
+  * LOD level of a submesh changed, and skins the vertices and normals of all
+  * submeshes straight into the merged buffers. Submeshes with springs handle
+  * their vertices internally, so theirs are updated and copied. It replaces
+  * updateVertices() for a model instance that draws from merged buffers.
+  *****************************************************************************/
+
+void CalModel::updateMergedBuffers(void)
+{
+  if(!m_bMergedBuffers) return;
+
+  // rebuild the faces only when a lod level changed
+  int submeshId;
+  for(submeshId = 0; submeshId < (int)m_vectorSubmesh.size(); submeshId++)
+  {
+    if(m_vectorSubmesh[submeshId]->getLodLevelId() != m_vectorMergedLodLevelId[submeshId])
+    {
+      buildMergedFaces();
+      break;
+    }
+  }
+
+  for(submeshId = 0; submeshId < (int)m_vectorSubmesh.size(); submeshId++)
+  {
+    CalSubmesh *pSubmesh = m_vectorSubmesh[submeshId];
+
+    const DrawRange& drawRange = m_vectorDrawRange[submeshId];
+    if(drawRange.vertexCount <= 0) continue;
+
+    float *pVertexBuffer = &m_vectorMergedVertex[drawRange.vertexOffset].x;
+    float *pNormalBuffer = &m_vectorMergedNormal[drawRange.vertexOffset].x;
+
+    if(pSubmesh->hasInternalData())
+    {
+      pSubmesh->updateVertices();
+      memcpy(pVertexBuffer, &pSubmesh->getVectorVertex()[0], drawRange.vertexCount * sizeof(CalVector));
+      memcpy(pNormalBuffer, &pSubmesh->getVectorNormal()[0], drawRange.vertexCount * sizeof(CalVector));
+    }
+    else
+    {
+      pSubmesh->calculateVN(pVertexBuffer, pNormalBuffer);
+    }
+  }
+}
+
 //****************************************************************************//
@@ -19,6 +19,7 @@
 #include "calvector.h"
 #include "calbone.h"
 #include "calquat.h"
+#include "calpose.h"
 
 //****************************************************************************//
 // Forward declarations                                                       //
@@ -26,6 +27,7 @@
 
 class CalCoreModel;
 class CalCoreAnimation;
+class CalBakedAnimation;
 class CalBone;
 class CalSubmesh;
 
@@ -40,8 +42,20 @@ class CalSubmesh;
 class CAL3D_API CalModel: public CalModelUserData
 {
   friend class CalSubmesh;
+  friend class CalBakedAnimation;
   friend CalModel *CalModelNew(void);
   
+// misc
+public:
+  /// The model DrawRange.
+  struct DrawRange
+  {
+    int vertexOffset;
+    int vertexCount;
+    int faceOffset;
+    int faceCount;
+  };
+
 // member variables
 protected:
   CalCoreModel *m_pCoreModel;
@@ -51,6 +65,21 @@ protected:
   std::vector<CalMatrix> m_vectorTransformMatrix;
   std::vector<CalVector> m_vectorTransformVector;
   std::vector<CalSubmesh *> m_vectorSubmesh;
+  int m_interpolationMode;
+  CalPose m_pose;
+  bool m_bMergedBuffers;
+  int m_mergedMapId;
+  int m_mergedVertexCount;
+  int m_mergedFaceCount;
+  int m_mergedFaceRevision;
+  std::vector<CalVector> m_vectorMergedVertex;
+  std::vector<CalVector> m_vectorMergedNormal;
+  std::vector<float> m_vectorMergedTextureCoordinate;
+  std::vector<int> m_vectorMergedFace;
+  std::vector<unsigned short> m_vectorMergedShortFace;
+  std::vector<DrawRange> m_vectorDrawRange;
+  std::vector<int> m_vectorMergedLodLevelId;
+  static int defaultInterpolationMode;
   
 // constructors/destructor
 public: 
@@ -65,6 +94,9 @@ public:
   void destroy(void);
   CalCoreModel *getCoreModel(void);
   void setLodLevel(float lodLevel);
+  int getInterpolationMode(void);
+  void setInterpolationMode(int mode);
+  static void setDefaultInterpolationMode(int mode);
 
   // State queries
   const CalVector &getTranslation(void);
@@ -72,12 +104,14 @@ public:
   int getBoneCount(void);
   CalBone *getBone(int boneId);
   int findBone(const std::string& name, int hint=(-1));
+  int findBone(int nameId, int hint=(-1));
   
   // functions to set the pose using animations.
   void setTranslation(const CalVector &translation);
   void setRotation(const CalQuaternion &rotation);
   void clearState(void);
   void blendState(CalCoreAnimation *pCoreAnimation, float weight, float time);
+  void blendPose(CalCoreAnimation *pCoreAnimation, CalPose& pose, float weight);
   void blendSavedState(float weight);
   void lockState(void);
   void saveState(void);
@@ -86,6 +120,9 @@ public:
   // function to set the pose by copying another model.
   bool mimicSkeleton(CalModel *pModel);
   
+  // function to set the skinning transforms from a baked animation.
+  bool setBakedState(CalBakedAnimation *pBakedAnimation, float time, bool bInterpolate = true);
+  
   // function to update the spring system
   void updateSpringSystem(float delta);
   
@@ -95,6 +132,23 @@ public:
   // functions to loop over the submeshes.
   int getSubmeshCount(void);
   CalSubmesh *getSubmesh(int id);
+
+  // functions to draw all submeshes from merged buffers.
+  bool enableMergedBuffers(int mapId);
+  bool mergedBuffersEnabled(void);
+  void updateMergedBuffers(void);
+  const DrawRange& getDrawRange(int submeshId);
+  int getMergedFaceCount(void);
+  int getMergedFaceRevision(void);
+  int *getMergedFaces(void);
+  float *getMergedNormals(void);
+  unsigned short *getMergedShortFaces(void);
+  float *getMergedTextureCoordinates(void);
+  int getMergedVertexCount(void);
+  float *getMergedVertices(void);
+
+protected:
+  void buildMergedFaces(void);
 };
 
 
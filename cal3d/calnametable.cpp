@@ -0,0 +1,216 @@
+//****************************************************************************//
+// nametable.cpp                                                              //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calnametable.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+// The names live in chunks that are never moved or freed, so getName can read
+// them without the lock once their count is published. A name ID picks the
+// chunk with its high bits and the name in the chunk with its low bits.
+
+static const int NAME_CHUNK_SHIFT = 10;
+static const int NAME_CHUNK_SIZE = 1 << NAME_CHUNK_SHIFT;
+static const int NAME_CHUNK_COUNT = 4096;
+
+// The hash map is keyed by the characters of the stored names, so a lookup
+// with a pointer and a length needs no temporary string.
+
+struct CalNameKey
+{
+  const char *pName;
+  int len;
+};
+
+struct CalNameKeyHash
+{
+  size_t operator()(const CalNameKey& key) const
+  {
+    // FNV-1a
+    size_t hash = 2166136261u;
+    int i;
+    for(i = 0; i < key.len; i++)
+    {
+      hash = (hash ^ (unsigned char)key.pName[i]) * 16777619u;
+    }
+    return hash;
+  }
+};
+
+struct CalNameKeyEqual
+{
+  bool operator()(const CalNameKey& a, const CalNameKey& b) const
+  {
+    return (a.len == b.len) && (memcmp(a.pName, b.pName, a.len) == 0);
+  }
+};
+
+struct CalNameTableData
+{
+  std::mutex mutex;
+  std::atomic<std::string *> chunk[NAME_CHUNK_COUNT];
+  std::atomic<int> nameCount;
+  std::unordered_map<CalNameKey, int, CalNameKeyHash, CalNameKeyEqual> mapNameId;
+
+  CalNameTableData()
+  {
+    int chunkId;
+    for(chunkId = 0; chunkId < NAME_CHUNK_COUNT; chunkId++) chunk[chunkId] = 0;
+    nameCount = 0;
+  }
+
+  ~CalNameTableData()
+  {
+    int chunkId;
+    for(chunkId = 0; chunkId < NAME_CHUNK_COUNT; chunkId++) delete [] chunk[chunkId].load();
+  }
+};
+
+static CalNameTableData& getNameTableData()
+{
+  static CalNameTableData data;
+  return data;
+}
+
+ /*****************************************************************************/
+/** Returns a name.
+  *
+  * This function returns the name with a given name ID.
+  *
+  * @param nameId The ID of the name.
+  *
+  * @return The name, or an empty string if the ID is not valid.
+  *****************************************************************************/
+
+const std::string& CalNameTable::getName(int nameId)
+{
+  static const std::string strEmpty;
+
+  CalNameTableData& data = getNameTableData();
+  if((nameId < 0) || (nameId >= data.nameCount.load(std::memory_order_acquire))) return strEmpty;
+
+  return data.chunk[nameId >> NAME_CHUNK_SHIFT].load(std::memory_order_relaxed)[nameId & (NAME_CHUNK_SIZE - 1)];
+}
+
+ /*****************************************************************************/
+/** Returns the number of names.
+  *
+  * This function returns the number of distinct names interned so far.
+  *
+  * @return The number of names.
+  *****************************************************************************/
+
+int CalNameTable::getNameCount()
+{
+  return getNameTableData().nameCount.load(std::memory_order_acquire);
+}
+
+ /*****************************************************************************/
+/** Returns the ID of a name.
+  *
+  * This function looks up a name without adding it.
+  *
+  * @param strName The name.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the name
+  *         \li \b -1 if the name was never interned
+  *****************************************************************************/
+
+int CalNameTable::getNameId(const std::string& strName)
+{
+  CalNameTableData& data = getNameTableData();
+  std::lock_guard<std::mutex> lock(data.mutex);
+
+  CalNameKey key = { strName.data(), (int)strName.size() };
+  std::unordered_map<CalNameKey, int, CalNameKeyHash, CalNameKeyEqual>::iterator iteratorNameId;
+  iteratorNameId = data.mapNameId.find(key);
+  if(iteratorNameId == data.mapNameId.end()) return -1;
+
+  return iteratorNameId->second;
+}
+
+ /*****************************************************************************/
+/** Interns a name.
+  *
+  * This function returns the ID of a name, and adds the name to the table if
+  * it is not in it yet.
+  *
+  * @param pName A pointer to the characters of the name.
+  * @param len The number of characters.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the name
+  *         \li \b -1 if the table is full
+  *****************************************************************************/
+
+int CalNameTable::intern(const char *pName, int len)
+{
+  CalNameTableData& data = getNameTableData();
+  std::lock_guard<std::mutex> lock(data.mutex);
+
+  CalNameKey key = { pName, len };
+  std::unordered_map<CalNameKey, int, CalNameKeyHash, CalNameKeyEqual>::iterator iteratorNameId;
+  iteratorNameId = data.mapNameId.find(key);
+  if(iteratorNameId != data.mapNameId.end()) return iteratorNameId->second;
+
+  int nameId = data.nameCount.load(std::memory_order_relaxed);
+  int chunkId = nameId >> NAME_CHUNK_SHIFT;
+  if(chunkId >= NAME_CHUNK_COUNT) return -1;
+
+  std::string *pChunk = data.chunk[chunkId].load(std::memory_order_relaxed);
+  if(pChunk == 0)
+  {
+    pChunk = new std::string[NAME_CHUNK_SIZE];
+    data.chunk[chunkId].store(pChunk, std::memory_order_relaxed);
+  }
+
+  // the key points into the stored name, which never moves
+  std::string& strStoredName = pChunk[nameId & (NAME_CHUNK_SIZE - 1)];
+  strStoredName.assign(pName, len);
+  key.pName = strStoredName.data();
+  data.mapNameId[key] = nameId;
+
+  // publish the name to getName
+  data.nameCount.store(nameId + 1, std::memory_order_release);
+
+  return nameId;
+}
+
+ /*****************************************************************************/
+/** Interns a name.
+  *
+  * This function returns the ID of a name, and adds the name to the table if
+  * it is not in it yet.
+  *
+  * @param strName The name.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the name
+  *         \li \b -1 if the table is full
+  *****************************************************************************/
+
+int CalNameTable::intern(const std::string& strName)
+{
+  return intern(strName.data(), strName.size());
+}
+
+//****************************************************************************//
@@ -0,0 +1,49 @@
+//****************************************************************************//
+// nametable.h                                                                //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_NAMETABLE_H
+#define CAL_NAMETABLE_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The name table class.
+  *
+  * The name table interns the bone names of all core bones and core tracks
+  * of the process. Every distinct name is stored once and identified by a
+  * name ID, so tracks and bones hold an integer instead of a string, and
+  * names are compared by their IDs. Names are never removed, so a name ID
+  * and the string returned for it stay valid for the lifetime of the
+  * process. All functions are thread-safe; getName and getNameCount do not
+  * take the lock.
+  *****************************************************************************/
+
+class CAL3D_API CalNameTable
+{
+// member functions
+public:
+  static const std::string& getName(int nameId);
+  static int getNameCount();
+  static int getNameId(const std::string& strName);
+  static int intern(const char *pName, int len);
+  static int intern(const std::string& strName);
+};
+
+#endif
+
+//****************************************************************************//
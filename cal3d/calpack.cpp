@@ -0,0 +1,517 @@
+//****************************************************************************//
+// pack.cpp                                                                   //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calpack.h"
+#include "calerror.h"
+#include "calbinary.h"
+#include "calloader.h"
+#include "calcoremodel.h"
+#include "calcoreanim.h"
+
+// Checks that a section of count records of the given size lies inside the
+// file.
+
+static bool checkPackSection(int len, int offset, int count, int size)
+{
+  if((count < 0) || (offset < 0)) return false;
+  if(count == 0) return true;
+
+  return (offset <= len) && (count <= (len - offset) / size);
+}
+
+ /*****************************************************************************/
+/** Constructs the pack instance.
+  *
+  * This function is the default constructor of the pack instance.
+  *****************************************************************************/
+
+CalPack::CalPack()
+{
+  m_pPackEntry = 0;
+  m_pStrings = 0;
+  m_entryCount = 0;
+}
+
+ /*****************************************************************************/
+/** Destructs the pack instance.
+  *
+  * This function is the destructor of the pack instance.
+  *****************************************************************************/
+
+CalPack::~CalPack()
+{
+  close();
+}
+
+ /*****************************************************************************/
+/** Checks an entry ID.
+  *
+  * This function checks that an entry ID is valid, and sets the error if not.
+  *
+  * @param entryId The ID of the entry.
+  *
+  * @return One of the following values:
+  *         \li \b true if the entry exists
+  *         \li \b false if not
+  *****************************************************************************/
+
+bool CalPack::checkEntryId(int entryId)
+{
+  if((entryId < 0) || (entryId >= m_entryCount))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalPack");
+    return false;
+  }
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Closes the pack.
+  *
+  * This function destroys all decoded core animations and core models of the
+  * pack and unmaps the pack file.
+  *****************************************************************************/
+
+void CalPack::close()
+{
+  int entryId;
+  for(entryId = 0; entryId < (int)m_vectorEntry.size(); entryId++)
+  {
+    unload(entryId);
+  }
+  m_vectorEntry.clear();
+
+  m_file.close();
+
+  m_pPackEntry = 0;
+  m_pStrings = 0;
+  m_entryCount = 0;
+}
+
+ /*****************************************************************************/
+/** Finds an entry.
+  *
+  * This function looks up an entry by its name with a binary search over the
+  * sorted index.
+  *
+  * @param strName The name of the entry.
+  *
+  * @return One of the following values:
+  *         \li the \b ID of the entry
+  *         \li \b -1 if there is no such entry
+  *****************************************************************************/
+
+int CalPack::findEntry(const std::string& strName)
+{
+  int low = 0;
+  int high = m_entryCount - 1;
+
+  while(low <= high)
+  {
+    int middle = (low + high) / 2;
+
+    int result;
+    result = strcmp(&m_pStrings[m_pPackEntry[middle].nameOffset], strName.c_str());
+
+    if(result == 0) return middle;
+    if(result < 0) low = middle + 1;
+    else high = middle - 1;
+  }
+
+  CalError::setLastError(CalError::FILE_NOT_FOUND, __FILE__, __LINE__, strName);
+  return -1;
+}
+
+ /*****************************************************************************/
+/** Provides access to the core animation of an entry.
+  *
+  * This function returns the core animation of an entry, and decodes it from
+  * the entry data on the first call.
+  *
+  * @param entryId The ID of the entry.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core animation
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreAnimation *CalPack::getCoreAnimation(int entryId)
+{
+  if(!checkEntryId(entryId)) return 0;
+
+  Entry& entry = m_vectorEntry[entryId];
+  if(entry.pCoreAnimation != 0) return entry.pCoreAnimation;
+
+  CalCoreAnimation *pCoreAnimation;
+  pCoreAnimation = CalCoreAnimation::Alloc();
+  if(!pCoreAnimation->create(getEntryName(entryId)))
+  {
+    CalCoreAnimation::Free(pCoreAnimation);
+    return 0;
+  }
+
+  CalLoader loader;
+  if(!loader.loadCoreAnimation(pCoreAnimation, (void *)getEntryData(entryId), getEntrySize(entryId), getEntryName(entryId)))
+  {
+    pCoreAnimation->destroy();
+    CalCoreAnimation::Free(pCoreAnimation);
+    return 0;
+  }
+
+  entry.pCoreAnimation = pCoreAnimation;
+
+  return pCoreAnimation;
+}
+
+ /*****************************************************************************/
+/** Provides access to the core animation of an entry.
+  *
+  * This function returns the core animation of the entry with the given name.
+  * See getCoreAnimation(int).
+  *
+  * @param strName The name of the entry.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core animation
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreAnimation *CalPack::getCoreAnimation(const std::string& strName)
+{
+  int entryId;
+  entryId = findEntry(strName);
+  if(entryId == -1) return 0;
+
+  return getCoreAnimation(entryId);
+}
+
+ /*****************************************************************************/
+/** Provides access to the core model of an entry.
+  *
+  * This function returns the core model of an entry, and decodes it from the
+  * entry data on the first call. The entry can hold a model file, a binary
+  * model file or a mesh file; a mesh file is loaded together with the
+  * skeleton file of a second entry.
+  *
+  * @param entryId The ID of the entry.
+  * @param skeletonEntryId The ID of the skeleton entry of a mesh entry, or -1
+  *                        for other entries. A mesh entry without a skeleton
+  *                        entry fails with INVALID_HANDLE.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core model
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreModel *CalPack::getCoreModel(int entryId, int skeletonEntryId)
+{
+  if(!checkEntryId(entryId)) return 0;
+
+  Entry& entry = m_vectorEntry[entryId];
+  if(entry.pCoreModel != 0) return entry.pCoreModel;
+
+  const char *pData = (const char *)getEntryData(entryId);
+  int size = getEntrySize(entryId);
+  if(size < 4)
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__, getEntryName(entryId));
+    return 0;
+  }
+
+  CalCoreModel *pCoreModel;
+  pCoreModel = CalCoreModel::Alloc();
+  if(!pCoreModel->create(getEntryName(entryId)))
+  {
+    CalCoreModel::Free(pCoreModel);
+    return 0;
+  }
+
+  // pick the loader from the file magic
+  CalLoader loader;
+  bool bLoaded = false;
+  if(memcmp(pData, Cal::BINARY_MODEL_FILE_MAGIC, 4) == 0)
+  {
+    bLoaded = loader.loadBinaryCoreModel(pCoreModel, pData, size);
+  }
+  else if(memcmp(pData, Cal::MESH_FILE_MAGIC, 4) == 0)
+  {
+    if(skeletonEntryId == -1)
+    {
+      CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalPack: mesh entry " + std::string(getEntryName(entryId)) + " needs a skeleton entry");
+    }
+    else if(checkEntryId(skeletonEntryId))
+    {
+      bLoaded = loader.loadCoreModel(pCoreModel,
+        (void *)getEntryData(skeletonEntryId), getEntrySize(skeletonEntryId), getEntryName(skeletonEntryId),
+        (void *)pData, size, getEntryName(entryId));
+    }
+  }
+  else
+  {
+    bLoaded = loader.loadCoreModel(pCoreModel, (void *)pData, size, getEntryName(entryId));
+  }
+
+  if(!bLoaded)
+  {
+    pCoreModel->destroy();
+    CalCoreModel::Free(pCoreModel);
+    return 0;
+  }
+
+  entry.pCoreModel = pCoreModel;
+
+  return pCoreModel;
+}
+
+ /*****************************************************************************/
+/** Provides access to the core model of an entry.
+  *
+  * This function returns the core model of the entry with the given name.
+  * See getCoreModel(int, int).
+  *
+  * @param strName The name of the entry.
+  * @param strSkeletonName The name of the skeleton entry of a mesh entry, or
+  *                        an empty string for other entries.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the core model
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+CalCoreModel *CalPack::getCoreModel(const std::string& strName, const std::string& strSkeletonName)
+{
+  int entryId;
+  entryId = findEntry(strName);
+  if(entryId == -1) return 0;
+
+  int skeletonEntryId;
+  skeletonEntryId = -1;
+  if(!strSkeletonName.empty())
+  {
+    skeletonEntryId = findEntry(strSkeletonName);
+    if(skeletonEntryId == -1) return 0;
+  }
+
+  return getCoreModel(entryId, skeletonEntryId);
+}
+
+ /*****************************************************************************/
+/** Returns the number of entries.
+  *
+  * This function returns the number of entries in the pack.
+  *
+  * @return The number of entries.
+  *****************************************************************************/
+
+int CalPack::getEntryCount()
+{
+  return m_entryCount;
+}
+
+ /*****************************************************************************/
+/** Provides access to the data of an entry.
+  *
+  * This function returns the file data of an entry. It points into the mapped
+  * pack file and stays valid until the pack is closed.
+  *
+  * @param entryId The ID of the entry.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the data
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+const void *CalPack::getEntryData(int entryId)
+{
+  if(!checkEntryId(entryId)) return 0;
+
+  return (const char *)m_file.getData() + m_pPackEntry[entryId].dataOffset;
+}
+
+ /*****************************************************************************/
+/** Returns the name of an entry.
+  *
+  * This function returns the name of an entry.
+  *
+  * @param entryId The ID of the entry.
+  *
+  * @return One of the following values:
+  *         \li the name of the entry
+  *         \li \b 0 if an error happend
+  *****************************************************************************/
+
+const char *CalPack::getEntryName(int entryId)
+{
+  if(!checkEntryId(entryId)) return 0;
+
+  return &m_pStrings[m_pPackEntry[entryId].nameOffset];
+}
+
+ /*****************************************************************************/
+/** Returns the size of an entry.
+  *
+  * This function returns the size of the file data of an entry.
+  *
+  * @param entryId The ID of the entry.
+  *
+  * @return The size in bytes, or 0 if an error happend.
+  *****************************************************************************/
+
+int CalPack::getEntrySize(int entryId)
+{
+  if(!checkEntryId(entryId)) return 0;
+
+  return m_pPackEntry[entryId].dataSize;
+}
+
+ /*****************************************************************************/
+/** Returns the load state of an entry.
+  *
+  * This function returns whether the core animation or the core model of an
+  * entry was decoded.
+  *
+  * @param entryId The ID of the entry.
+  *
+  * @return One of the following values:
+  *         \li \b true if the entry is decoded
+  *         \li \b false if not
+  *****************************************************************************/
+
+bool CalPack::isLoaded(int entryId)
+{
+  if((entryId < 0) || (entryId >= m_entryCount)) return false;
+
+  return (m_vectorEntry[entryId].pCoreAnimation != 0) || (m_vectorEntry[entryId].pCoreModel != 0);
+}
+
+ /*****************************************************************************/
+/** Opens a pack file.
+  *
+  * This function maps a pack file into memory and checks its header and
+  * index. No entry is decoded.
+  *
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalPack::open(const std::string& strFilename)
+{
+  close();
+
+  if(!m_file.open(strFilename)) return false;
+
+  const char *pData = (const char *)m_file.getData();
+  int len = m_file.getSize();
+
+  // check if this is a valid file
+  CalPackHeader header;
+  if((len < (int)sizeof(CalPackHeader)) || (memcmp(pData, Cal::PACK_FILE_MAGIC, 4) != 0))
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__, strFilename);
+    close();
+    return false;
+  }
+  memcpy(&header, pData, sizeof(header));
+
+  // check if the layout is the one of this library build
+  if((header.version != Cal::PACK_FILE_VERSION) || (header.byteOrder != Cal::BINARY_BYTE_ORDER)
+  || (header.entrySize != (int)sizeof(CalPackEntry)))
+  {
+    CalError::setLastError(CalError::INCOMPATIBLE_FILE_VERSION, __FILE__, __LINE__, strFilename);
+    close();
+    return false;
+  }
+
+  // check the bounds of the index and the names
+  if((header.fileSize > len) || (header.entryOffset % Cal::PACK_ALIGNMENT != 0)
+  || !checkPackSection(len, header.entryOffset, header.entryCount, sizeof(CalPackEntry))
+  || !checkPackSection(len, header.stringOffset, header.stringSize, 1)
+  || ((header.stringSize > 0) && (pData[header.stringOffset + header.stringSize - 1] != '\0')))
+  {
+    CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__, strFilename);
+    close();
+    return false;
+  }
+
+  m_pPackEntry = (const CalPackEntry *)(pData + header.entryOffset);
+  m_pStrings = pData + header.stringOffset;
+
+  // check every entry, and that the names are sorted
+  int entryId;
+  for(entryId = 0; entryId < header.entryCount; entryId++)
+  {
+    const CalPackEntry& packEntry = m_pPackEntry[entryId];
+
+    if((packEntry.nameOffset < 0) || (packEntry.nameLength < 0)
+    || (packEntry.nameLength >= header.stringSize - packEntry.nameOffset)
+    || (m_pStrings[packEntry.nameOffset + packEntry.nameLength] != '\0')
+    || !checkPackSection(len, packEntry.dataOffset, packEntry.dataSize, 1)
+    || (packEntry.dataOffset % Cal::PACK_ALIGNMENT != 0)
+    || ((entryId > 0) && (strcmp(&m_pStrings[m_pPackEntry[entryId - 1].nameOffset], &m_pStrings[packEntry.nameOffset]) >= 0)))
+    {
+      CalError::setLastError(CalError::INVALID_FILE_FORMAT, __FILE__, __LINE__, strFilename);
+      close();
+      return false;
+    }
+  }
+
+  m_entryCount = header.entryCount;
+
+  Entry entry;
+  entry.pCoreAnimation = 0;
+  entry.pCoreModel = 0;
+  m_vectorEntry.assign(m_entryCount, entry);
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Unloads an entry.
+  *
+  * This function destroys the decoded core animation or core model of an
+  * entry. The next access decodes it again.
+  *
+  * @param entryId The ID of the entry.
+  *****************************************************************************/
+
+void CalPack::unload(int entryId)
+{
+  if((entryId < 0) || (entryId >= (int)m_vectorEntry.size())) return;
+
+  Entry& entry = m_vectorEntry[entryId];
+
+  if(entry.pCoreAnimation != 0)
+  {
+    entry.pCoreAnimation->destroy();
+    CalCoreAnimation::Free(entry.pCoreAnimation);
+    entry.pCoreAnimation = 0;
+  }
+
+  if(entry.pCoreModel != 0)
+  {
+    entry.pCoreModel->destroy();
+    CalCoreModel::Free(entry.pCoreModel);
+    entry.pCoreModel = 0;
+  }
+}
+
+//****************************************************************************//
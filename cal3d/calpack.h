@@ -0,0 +1,132 @@
+//****************************************************************************//
+// pack.h                                                                     //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_PACK_H
+#define CAL_PACK_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+#include "calmapfile.h"
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalCoreModel;
+class CalCoreAnimation;
+
+//****************************************************************************//
+// Pack file layout                                                           //
+//****************************************************************************//
+
+// A pack file (Cal::PACK_FILE_MAGIC) holds many asset files. It starts with a
+// CalPackHeader, followed by the entry index, the entry names and the entry
+// data. The index is sorted by name (compared bytewise), so an entry is found
+// with a binary search. The data of every entry is aligned to PACK_ALIGNMENT
+// bytes, which keeps binary model files loadable straight from the pack.
+
+namespace Cal
+{
+  const int PACK_ALIGNMENT = 16;
+};
+
+ /*****************************************************************************/
+/** The pack file header.
+  *****************************************************************************/
+
+struct CalPackHeader
+{
+  char magic[4];
+  int version;
+  int byteOrder;
+  int fileSize;
+  int entrySize;            // sizeof(CalPackEntry)
+  int entryCount;
+  int entryOffset;          // entryCount CalPackEntry
+  int stringSize;
+  int stringOffset;         // zero-terminated entry names
+  int reserved[3];
+};
+
+ /*****************************************************************************/
+/** The pack file entry record.
+  *****************************************************************************/
+
+struct CalPackEntry
+{
+  int nameOffset;           // relative to the string section
+  int nameLength;
+  int dataOffset;           // relative to the start of the file
+  int dataSize;
+};
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The pack class.
+  *
+  * A pack maps a pack file into memory with a single open, and hands out the
+  * data of its entries without copying them. The core animations and core
+  * models of the entries are decoded on first use and owned by the pack
+  * until they are unloaded or the pack is closed. A pack is not meant to be
+  * used by several threads at once.
+  *****************************************************************************/
+
+class CAL3D_API CalPack
+{
+// misc
+protected:
+  struct Entry
+  {
+    CalCoreAnimation *pCoreAnimation;
+    CalCoreModel *pCoreModel;
+  };
+
+// member variables
+protected:
+  CalMappedFile m_file;
+  const CalPackEntry *m_pPackEntry;
+  const char *m_pStrings;
+  int m_entryCount;
+  std::vector<Entry> m_vectorEntry;
+
+// constructors/destructor
+public:
+  CalPack();
+  virtual ~CalPack();
+
+// member functions
+public:
+  void close();
+  int findEntry(const std::string& strName);
+  CalCoreAnimation *getCoreAnimation(int entryId);
+  CalCoreAnimation *getCoreAnimation(const std::string& strName);
+  CalCoreModel *getCoreModel(int entryId, int skeletonEntryId = -1);
+  CalCoreModel *getCoreModel(const std::string& strName, const std::string& strSkeletonName = "");
+  int getEntryCount();
+  const void *getEntryData(int entryId);
+  const char *getEntryName(int entryId);
+  int getEntrySize(int entryId);
+  bool isLoaded(int entryId);
+  bool open(const std::string& strFilename);
+  void unload(int entryId);
+
+protected:
+  bool checkEntryId(int entryId);
+};
+
+#endif
+
+//****************************************************************************//
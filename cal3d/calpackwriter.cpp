@@ -0,0 +1,244 @@
+//****************************************************************************//
+// packwriter.cpp                                                             //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calpackwriter.h"
+#include "calpack.h"
+#include "calbinary.h"
+#include "calerror.h"
+#include "calmapfile.h"
+
+#include <algorithm>
+#include <fstream>
+
+// Appends a block to the pack image at the next aligned offset.
+
+static int appendPackSection(std::vector<char>& image, const void *pData, int size)
+{
+  int offset;
+  offset = (image.size() + Cal::PACK_ALIGNMENT - 1) & ~(Cal::PACK_ALIGNMENT - 1);
+
+  image.resize(offset + size);
+  if((pData != 0) && (size > 0)) memcpy(&image[offset], pData, size);
+
+  return offset;
+}
+
+ /*****************************************************************************/
+/** Constructs the pack writer instance.
+  *
+  * This function is the default constructor of the pack writer instance.
+  *****************************************************************************/
+
+CalPackWriter::CalPackWriter()
+{
+}
+
+ /*****************************************************************************/
+/** Destructs the pack writer instance.
+  *
+  * This function is the destructor of the pack writer instance.
+  *****************************************************************************/
+
+CalPackWriter::~CalPackWriter()
+{
+}
+
+ /*****************************************************************************/
+/** Adds an entry from memory.
+  *
+  * This function adds a copy of a memory buffer as an entry.
+  *
+  * @param strName The name of the entry.
+  * @param pData A pointer to the data.
+  * @param len The size of the data in bytes.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalPackWriter::addBuffer(const std::string& strName, const void *pData, int len)
+{
+  if(strName.empty() || (strName.find('\0') != std::string::npos) || (len < 0) || ((pData == 0) && (len > 0)))
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, "CalPackWriter::addBuffer");
+    return false;
+  }
+
+  m_vectorEntry.push_back(Entry());
+
+  Entry& entry = m_vectorEntry.back();
+  entry.strName = strName;
+  entry.vectorData.assign((const char *)pData, (const char *)pData + len);
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Adds an entry from a file.
+  *
+  * This function adds the contents of a file as an entry.
+  *
+  * @param strName The name of the entry.
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalPackWriter::addFile(const std::string& strName, const std::string& strFilename)
+{
+  CalMappedFile file;
+  if(!file.open(strFilename)) return false;
+
+  return addBuffer(strName, file.getData(), file.getSize());
+}
+
+ /*****************************************************************************/
+/** Removes all entries.
+  *
+  * This function removes all entries from the pack writer.
+  *****************************************************************************/
+
+void CalPackWriter::clear()
+{
+  m_vectorEntry.clear();
+}
+
+ /*****************************************************************************/
+/** Compares two entries.
+  *
+  * This function orders the entries bytewise by name, as the pack index
+  * expects.
+  *
+  * @param entry1 The first entry.
+  * @param entry2 The second entry.
+  *
+  * @return \b true if the first entry comes first.
+  *****************************************************************************/
+
+bool CalPackWriter::compareEntry(const Entry& entry1, const Entry& entry2)
+{
+  return strcmp(entry1.strName.c_str(), entry2.strName.c_str()) < 0;
+}
+
+ /*****************************************************************************/
+/** Returns the number of entries.
+  *
+  * This function returns the number of entries added to the pack writer.
+  *
+  * @return The number of entries.
+  *****************************************************************************/
+
+int CalPackWriter::getEntryCount()
+{
+  return m_vectorEntry.size();
+}
+
+ /*****************************************************************************/
+/** Saves a pack file.
+  *
+  * This function writes all entries into a pack file, with the index sorted
+  * by name. Entry names must be unique.
+  *
+  * @param strFilename The name of the file.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalPackWriter::save(const std::string& strFilename)
+{
+  // sort the entries by name
+  std::sort(m_vectorEntry.begin(), m_vectorEntry.end(), compareEntry);
+
+  int entryId;
+  for(entryId = 1; entryId < (int)m_vectorEntry.size(); entryId++)
+  {
+    if(m_vectorEntry[entryId - 1].strName == m_vectorEntry[entryId].strName)
+    {
+      CalError::setLastError(CalError::INVALID_ATTRIBUTE_VALUE, __FILE__, __LINE__, m_vectorEntry[entryId].strName);
+      return false;
+    }
+  }
+
+  CalPackHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, Cal::PACK_FILE_MAGIC, 4);
+  header.version = Cal::PACK_FILE_VERSION;
+  header.byteOrder = Cal::BINARY_BYTE_ORDER;
+  header.entrySize = sizeof(CalPackEntry);
+  header.entryCount = m_vectorEntry.size();
+
+  // build the names, in index order
+  std::vector<CalPackEntry> vectorPackEntry(header.entryCount);
+  std::string strStrings;
+  for(entryId = 0; entryId < header.entryCount; entryId++)
+  {
+    vectorPackEntry[entryId].nameOffset = strStrings.size();
+    vectorPackEntry[entryId].nameLength = m_vectorEntry[entryId].strName.size();
+    strStrings.append(m_vectorEntry[entryId].strName.c_str(), m_vectorEntry[entryId].strName.size() + 1);
+  }
+  header.stringSize = strStrings.size();
+
+  // reserve the header and the index, then add the names and the data
+  std::vector<char> image;
+  appendPackSection(image, 0, sizeof(header));
+  header.entryOffset = appendPackSection(image, 0, header.entryCount * sizeof(CalPackEntry));
+  header.stringOffset = appendPackSection(image, strStrings.data(), header.stringSize);
+
+  for(entryId = 0; entryId < header.entryCount; entryId++)
+  {
+    const std::vector<char>& vectorData = m_vectorEntry[entryId].vectorData;
+
+    vectorPackEntry[entryId].dataSize = vectorData.size();
+    vectorPackEntry[entryId].dataOffset = appendPackSection(image, vectorData.empty() ? 0 : &vectorData[0], vectorData.size());
+  }
+
+  // pad the end so that the file size is aligned as well
+  appendPackSection(image, 0, 0);
+  header.fileSize = image.size();
+
+  memcpy(&image[0], &header, sizeof(header));
+  if(header.entryCount > 0) memcpy(&image[header.entryOffset], &vectorPackEntry[0], header.entryCount * sizeof(CalPackEntry));
+
+  // write the image
+  std::ofstream file;
+  file.open(strFilename.c_str(), std::ios::out | std::ios::binary);
+  if(!file)
+  {
+    CalError::setLastError(CalError::FILE_CREATION_FAILED, __FILE__, __LINE__, strFilename);
+    return false;
+  }
+
+  file.write(&image[0], image.size());
+  if(!file)
+  {
+    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
+    return false;
+  }
+
+  // explicitly close the file
+  file.close();
+
+  return true;
+}
+
+//****************************************************************************//
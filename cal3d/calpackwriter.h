@@ -0,0 +1,64 @@
+//****************************************************************************//
+// packwriter.h                                                               //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_PACKWRITER_H
+#define CAL_PACKWRITER_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The pack writer class.
+  *
+  * A pack writer collects asset files under their names and writes them into
+  * one pack file, which is read with CalPack.
+  *****************************************************************************/
+
+class CAL3D_API CalPackWriter
+{
+// misc
+protected:
+  struct Entry
+  {
+    std::string strName;
+    std::vector<char> vectorData;
+  };
+
+// member variables
+protected:
+  std::vector<Entry> m_vectorEntry;
+
+// constructors/destructor
+public:
+  CalPackWriter();
+  virtual ~CalPackWriter();
+
+// member functions
+public:
+  bool addBuffer(const std::string& strName, const void *pData, int len);
+  bool addFile(const std::string& strName, const std::string& strFilename);
+  void clear();
+  int getEntryCount();
+  bool save(const std::string& strFilename);
+
+protected:
+  static bool compareEntry(const Entry& entry1, const Entry& entry2);
+};
+
+#endif
+
+//****************************************************************************//
@@ -394,4 +394,33 @@ bool CalPlatform::writeString(std::ostream& output, const std::string& strValue)
   return !output ? false : true;
 }
 
+ /*****************************************************************************/
+/** Swaps the byte order of 32 bit words.
+  *
+  * This function converts a block of 32 bit words, integers or floats, from
+  * the little-endian file byte order to the byte order of the machine. On
+  * little-endian machines it does nothing.
+  *
+  * @param pBuffer A pointer to the words.
+  * @param count The number of words.
+  *****************************************************************************/
+
+void CalPlatform::swapWords(void *pBuffer, int count)
+{
+#ifdef CAL3D_BIG_ENDIAN
+  char *p = (char *)pBuffer;
+
+  int i;
+  for(i = 0; i < count; i++, p += 4)
+  {
+    char x;
+    x = p[0]; p[0] = p[3]; p[3] = x;
+    x = p[1]; p[1] = p[2]; p[2] = x;
+  }
+#else
+  (void)pBuffer;
+  (void)count;
+#endif
+}
+
 //****************************************************************************//
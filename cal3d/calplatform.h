@@ -74,6 +74,7 @@
 // standard includes
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
 // debug includes
 #include <assert.h>
@@ -118,6 +119,8 @@ public:
   static bool writeFloat(std::ostream& output, float value);
   static bool writeInteger(std::ostream& output, int value);
   static bool writeString(std::ostream& output, const std::string& strValue);
+
+  static void swapWords(void *pBuffer, int count);
 };
 
 #endif
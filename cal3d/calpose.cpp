@@ -0,0 +1,443 @@
+//****************************************************************************//
+// pose.cpp                                                                   //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calpose.h"
+#include "calerror.h"
+#include "calcorekey.h"
+
+// sine of an angle in [0, pi/2], as a polynomial the loops can inline
+static inline float sinPolynomial(float angle)
+{
+  float angle2 = angle * angle;
+  return angle * (1.0f + angle2 * (-1.0f / 6.0f + angle2 * (1.0f / 120.0f + angle2 * (-1.0f / 5040.0f + angle2 * (1.0f / 362880.0f - angle2 * (1.0f / 39916800.0f))))));
+}
+
+ /*****************************************************************************/
+/** Constructs the pose instance.
+  *
+  * This function is the default constructor of the pose instance.
+  *****************************************************************************/
+
+CalPose::CalPose()
+{
+  m_trackCount = 0;
+}
+
+ /*****************************************************************************/
+/** Destructs the pose instance.
+  *
+  * This function is the destructor of the pose instance.
+  *****************************************************************************/
+
+CalPose::~CalPose()
+{
+}
+
+ /*****************************************************************************/
+/** Creates the pose instance.
+  *
+  * This function creates the pose instance.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalPose::create()
+{
+  m_trackCount = 0;
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Destroys the pose instance.
+  *
+  * This function destroys all data stored in the pose instance and frees all
+  * allocated memory.
+  *****************************************************************************/
+
+void CalPose::destroy()
+{
+  m_vectorOrientationX.clear();
+  m_vectorOrientationY.clear();
+  m_vectorOrientationZ.clear();
+  m_vectorRotationX.clear();
+  m_vectorRotationY.clear();
+  m_vectorRotationZ.clear();
+  m_vectorRotationW.clear();
+
+  m_vectorTargetOrientationX.clear();
+  m_vectorTargetOrientationY.clear();
+  m_vectorTargetOrientationZ.clear();
+  m_vectorTargetRotationX.clear();
+  m_vectorTargetRotationY.clear();
+  m_vectorTargetRotationZ.clear();
+  m_vectorTargetRotationW.clear();
+  m_vectorBlendFactor.clear();
+  m_vectorSampled.clear();
+  m_vectorWeightBefore.clear();
+  m_vectorWeightAfter.clear();
+
+  m_trackCount = 0;
+}
+
+ /*****************************************************************************/
+/** Reserves memory for the pose.
+  *
+  * This function reserves memory for a given number of tracks, so that later
+  * calls to setTrackCount() up to this size do not allocate.
+  *
+  * @param trackCount The number of tracks.
+  *****************************************************************************/
+
+void CalPose::reserve(int trackCount)
+{
+  m_vectorOrientationX.reserve(trackCount);
+  m_vectorOrientationY.reserve(trackCount);
+  m_vectorOrientationZ.reserve(trackCount);
+  m_vectorRotationX.reserve(trackCount);
+  m_vectorRotationY.reserve(trackCount);
+  m_vectorRotationZ.reserve(trackCount);
+  m_vectorRotationW.reserve(trackCount);
+
+  m_vectorTargetOrientationX.reserve(trackCount);
+  m_vectorTargetOrientationY.reserve(trackCount);
+  m_vectorTargetOrientationZ.reserve(trackCount);
+  m_vectorTargetRotationX.reserve(trackCount);
+  m_vectorTargetRotationY.reserve(trackCount);
+  m_vectorTargetRotationZ.reserve(trackCount);
+  m_vectorTargetRotationW.reserve(trackCount);
+  m_vectorBlendFactor.reserve(trackCount);
+  m_vectorSampled.reserve(trackCount);
+  m_vectorWeightBefore.reserve(trackCount);
+  m_vectorWeightAfter.reserve(trackCount);
+}
+
+ /*****************************************************************************/
+/** Sets the number of tracks.
+  *
+  * This function sets the number of tracks held by the pose instance. The
+  * storage only grows, so a pose reused for several animations settles on the
+  * size of the largest one.
+  *
+  * @param trackCount The number of tracks.
+  *****************************************************************************/
+
+void CalPose::setTrackCount(int trackCount)
+{
+  if(trackCount > (int)m_vectorOrientationX.size())
+  {
+    m_vectorOrientationX.resize(trackCount);
+    m_vectorOrientationY.resize(trackCount);
+    m_vectorOrientationZ.resize(trackCount);
+    m_vectorRotationX.resize(trackCount);
+    m_vectorRotationY.resize(trackCount);
+    m_vectorRotationZ.resize(trackCount);
+    m_vectorRotationW.resize(trackCount);
+
+    m_vectorTargetOrientationX.resize(trackCount);
+    m_vectorTargetOrientationY.resize(trackCount);
+    m_vectorTargetOrientationZ.resize(trackCount);
+    m_vectorTargetRotationX.resize(trackCount);
+    m_vectorTargetRotationY.resize(trackCount);
+    m_vectorTargetRotationZ.resize(trackCount);
+    m_vectorTargetRotationW.resize(trackCount);
+    m_vectorBlendFactor.resize(trackCount);
+    m_vectorSampled.resize(trackCount);
+    m_vectorWeightBefore.resize(trackCount);
+    m_vectorWeightAfter.resize(trackCount);
+  }
+
+  m_trackCount = trackCount;
+}
+
+ /*****************************************************************************/
+/** Returns the number of tracks.
+  *
+  * This function returns the number of tracks held by the pose instance.
+  *
+  * @return The number of tracks.
+  *****************************************************************************/
+
+int CalPose::getTrackCount()
+{
+  return m_trackCount;
+}
+
+ /*****************************************************************************/
+/** Clears the keyframes of a track.
+  *
+  * This function leaves a track that has no keyframes at the identity, and
+  * marks it as not sampled, so that it is skipped when the pose is blended.
+  *
+  * @param trackId The index of the track.
+  *****************************************************************************/
+
+void CalPose::clearKeyframes(int trackId)
+{
+  m_vectorOrientationX[trackId] = 0.0f;
+  m_vectorOrientationY[trackId] = 0.0f;
+  m_vectorOrientationZ[trackId] = 0.0f;
+  m_vectorRotationX[trackId] = 0.0f;
+  m_vectorRotationY[trackId] = 0.0f;
+  m_vectorRotationZ[trackId] = 0.0f;
+  m_vectorRotationW[trackId] = 1.0f;
+
+  m_vectorTargetOrientationX[trackId] = 0.0f;
+  m_vectorTargetOrientationY[trackId] = 0.0f;
+  m_vectorTargetOrientationZ[trackId] = 0.0f;
+  m_vectorTargetRotationX[trackId] = 0.0f;
+  m_vectorTargetRotationY[trackId] = 0.0f;
+  m_vectorTargetRotationZ[trackId] = 0.0f;
+  m_vectorTargetRotationW[trackId] = 1.0f;
+
+  m_vectorBlendFactor[trackId] = 0.0f;
+  m_vectorSampled[trackId] = false;
+}
+
+ /*****************************************************************************/
+/** Returns whether a track is sampled.
+  *
+  * This function returns whether a track holds a sampled state, or was left
+  * at the identity because it has no keyframes.
+  *
+  * @param trackId The index of the track.
+  *
+  * @return One of the following values:
+  *         \li \b true if the track is sampled
+  *         \li \b false if it is not
+  *****************************************************************************/
+
+bool CalPose::isSampled(int trackId)
+{
+  return m_vectorSampled[trackId];
+}
+
+ /*****************************************************************************/
+/** Sets the keyframes of a track.
+  *
+  * This function stores the two keyframes enclosing the sample time of a
+  * track, and the blending factor between them, for a following call to
+  * interpolate().
+  *
+  * @param trackId The index of the track.
+  * @param pCoreKeyframeBefore The keyframe before the sample time.
+  * @param pCoreKeyframeAfter The keyframe after the sample time.
+  * @param blendFactor The blending factor between the two keyframes.
+  *****************************************************************************/
+
+void CalPose::setKeyframes(int trackId, CalCoreKeyframe *pCoreKeyframeBefore, CalCoreKeyframe *pCoreKeyframeAfter, float blendFactor)
+{
+  const CalVector& orientationBefore = pCoreKeyframeBefore->getOrientation();
+  const CalQuaternion& rotationBefore = pCoreKeyframeBefore->getRotation();
+  m_vectorOrientationX[trackId] = orientationBefore.x;
+  m_vectorOrientationY[trackId] = orientationBefore.y;
+  m_vectorOrientationZ[trackId] = orientationBefore.z;
+  m_vectorRotationX[trackId] = rotationBefore.x;
+  m_vectorRotationY[trackId] = rotationBefore.y;
+  m_vectorRotationZ[trackId] = rotationBefore.z;
+  m_vectorRotationW[trackId] = rotationBefore.w;
+
+  const CalVector& orientationAfter = pCoreKeyframeAfter->getOrientation();
+  const CalQuaternion& rotationAfter = pCoreKeyframeAfter->getRotation();
+  m_vectorTargetOrientationX[trackId] = orientationAfter.x;
+  m_vectorTargetOrientationY[trackId] = orientationAfter.y;
+  m_vectorTargetOrientationZ[trackId] = orientationAfter.z;
+  m_vectorTargetRotationX[trackId] = rotationAfter.x;
+  m_vectorTargetRotationY[trackId] = rotationAfter.y;
+  m_vectorTargetRotationZ[trackId] = rotationAfter.z;
+  m_vectorTargetRotationW[trackId] = rotationAfter.w;
+
+  m_vectorBlendFactor[trackId] = blendFactor;
+  m_vectorSampled[trackId] = true;
+}
+
+ /*****************************************************************************/
+/** Interpolates all tracks.
+  *
+  * This function blends the state of every track from the keyframe before the
+  * sample time to the keyframe after it. The nlerp and fast-slerp modes run
+  * without branches or library calls, so each loop handles all tracks at
+  * once in the SIMD registers. The exact slerp runs as three flat passes over
+  * all tracks: the cosines, the weights and the weighted sums. The weights use
+  * polynomial approximations of acos and sin instead of the math library, but
+  * their clamps and selects keep that pass scalar unless the compiler may
+  * relax the floating point semantics.
+  *
+  * @param mode One of INTERPOLATE_SLERP, INTERPOLATE_NLERP or
+  *             INTERPOLATE_FAST_SLERP.
+  *****************************************************************************/
+
+void CalPose::interpolate(int mode)
+{
+  if(m_trackCount == 0) return;
+
+  const int trackCount = m_trackCount;
+  const float *f = &m_vectorBlendFactor[0];
+
+  // blend the orientations
+  {
+    float *ox = &m_vectorOrientationX[0];
+    float *oy = &m_vectorOrientationY[0];
+    float *oz = &m_vectorOrientationZ[0];
+    const float *tx = &m_vectorTargetOrientationX[0];
+    const float *ty = &m_vectorTargetOrientationY[0];
+    const float *tz = &m_vectorTargetOrientationZ[0];
+
+    int trackId;
+    for(trackId = 0; trackId < trackCount; trackId++)
+    {
+      ox[trackId] += f[trackId] * (tx[trackId] - ox[trackId]);
+      oy[trackId] += f[trackId] * (ty[trackId] - oy[trackId]);
+      oz[trackId] += f[trackId] * (tz[trackId] - oz[trackId]);
+    }
+  }
+
+  float *rx = &m_vectorRotationX[0];
+  float *ry = &m_vectorRotationY[0];
+  float *rz = &m_vectorRotationZ[0];
+  float *rw = &m_vectorRotationW[0];
+  const float *qx = &m_vectorTargetRotationX[0];
+  const float *qy = &m_vectorTargetRotationY[0];
+  const float *qz = &m_vectorTargetRotationZ[0];
+  const float *qw = &m_vectorTargetRotationW[0];
+
+  int trackId;
+  if((mode != INTERPOLATE_NLERP) && (mode != INTERPOLATE_FAST_SLERP))
+  {
+    float *wb = &m_vectorWeightBefore[0];
+    float *wa = &m_vectorWeightAfter[0];
+
+    // the cosine of the angle between the keyframes
+    for(trackId = 0; trackId < trackCount; trackId++)
+    {
+      wb[trackId] = rx[trackId] * qx[trackId] + ry[trackId] * qy[trackId] + rz[trackId] * qz[trackId] + rw[trackId] * qw[trackId];
+    }
+
+    // the slerp weights along the shorter arc, linear where the keyframes
+    // are too close for the trigonometric ones (see CalQuaternion::blend);
+    // acos and sin are polynomials accurate to float precision on the
+    // ranges used, so the loop has no library calls
+    for(trackId = 0; trackId < trackCount; trackId++)
+    {
+      float norm = wb[trackId];
+      float sign = (norm < 0.0f) ? -1.0f : 1.0f;
+      norm *= sign;
+      if(norm > 1.0f) norm = 1.0f;
+
+      float theta = (float)sqrt(1.0f - norm) * (1.5707963050f + norm * (-0.2145988016f + norm * (0.0889789874f + norm * (-0.0501743046f + norm * (0.0308918810f + norm * (-0.0170881256f + norm * (0.0066700901f - norm * 0.0012624911f)))))));
+
+      float d = f[trackId];
+      float angleBefore = (1.0f - d) * theta;
+      float angleAfter = d * theta;
+
+      float sinTheta = sinPolynomial(theta);
+      float weightBefore = sinPolynomial(angleBefore) / sinTheta;
+      float weightAfter = sinPolynomial(angleAfter) / sinTheta;
+
+      bool bLinear = (1.0f - norm < 0.000001f);
+      wb[trackId] = bLinear ? 1.0f - d : weightBefore;
+      wa[trackId] = (bLinear ? d : weightAfter) * sign;
+    }
+
+    // the weighted sums
+    for(trackId = 0; trackId < trackCount; trackId++)
+    {
+      rx[trackId] = wb[trackId] * rx[trackId] + wa[trackId] * qx[trackId];
+      ry[trackId] = wb[trackId] * ry[trackId] + wa[trackId] * qy[trackId];
+      rz[trackId] = wb[trackId] * rz[trackId] + wa[trackId] * qz[trackId];
+      rw[trackId] = wb[trackId] * rw[trackId] + wa[trackId] * qw[trackId];
+    }
+
+    return;
+  }
+
+  const bool bFast = (mode == INTERPOLATE_FAST_SLERP);
+
+  for(trackId = 0; trackId < trackCount; trackId++)
+  {
+    float norm;
+    norm = rx[trackId] * qx[trackId] + ry[trackId] * qy[trackId] + rz[trackId] * qz[trackId] + rw[trackId] * qw[trackId];
+
+    float sign;
+    sign = (norm < 0.0f) ? -1.0f : 1.0f;
+    norm *= sign;
+
+    float d;
+    d = f[trackId];
+
+    // see CalQuaternion::blendFast for the correction polynomial
+    float a, b, c;
+    a = 1.0904f + norm * (-3.2452f + norm * (3.55645f - norm * 1.43519f));
+    b = 0.848013f + norm * (-1.06021f + norm * 0.215638f);
+    c = d - 0.5f;
+    d = bFast ? d + d * c * (d - 1.0f) * (a * c * c + b) : d;
+
+    float inv_d;
+    inv_d = 1.0f - d;
+    d *= sign;
+
+    float x, y, z, w;
+    x = inv_d * rx[trackId] + d * qx[trackId];
+    y = inv_d * ry[trackId] + d * qy[trackId];
+    z = inv_d * rz[trackId] + d * qz[trackId];
+    w = inv_d * rw[trackId] + d * qw[trackId];
+
+    float inv_length;
+    inv_length = 1.0f / sqrtf(x * x + y * y + z * z + w * w);
+
+    rx[trackId] = x * inv_length;
+    ry[trackId] = y * inv_length;
+    rz[trackId] = z * inv_length;
+    rw[trackId] = w * inv_length;
+  }
+}
+
+ /*****************************************************************************/
+/** Returns the orientation of a track.
+  *
+  * This function returns the interpolated orientation of a track. It has to
+  * be scaled by the length of the core bone to get a translation.
+  *
+  * @param trackId The index of the track.
+  * @param orientation A reference to the vector that will be filled with the
+  *                    orientation.
+  *****************************************************************************/
+
+void CalPose::getOrientation(int trackId, CalVector& orientation)
+{
+  orientation.set(m_vectorOrientationX[trackId], m_vectorOrientationY[trackId], m_vectorOrientationZ[trackId]);
+}
+
+ /*****************************************************************************/
+/** Returns the rotation of a track.
+  *
+  * This function returns the interpolated rotation of a track.
+  *
+  * @param trackId The index of the track.
+  * @param rotation A reference to the quaternion that will be filled with the
+  *                 rotation.
+  *****************************************************************************/
+
+void CalPose::getRotation(int trackId, CalQuaternion& rotation)
+{
+  rotation.set(m_vectorRotationX[trackId], m_vectorRotationY[trackId], m_vectorRotationZ[trackId], m_vectorRotationW[trackId]);
+}
+
+//****************************************************************************//
@@ -0,0 +1,92 @@
+//****************************************************************************//
+// pose.h                                                                     //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_POSE_H
+#define CAL_POSE_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+#include "calvector.h"
+#include "calquat.h"
+
+//****************************************************************************//
+// Forward declarations                                                       //
+//****************************************************************************//
+
+class CalCoreKeyframe;
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The pose class.
+  *
+  * A pose holds one sampled state (orientation and rotation) per core track
+  * of a core animation, in track order. The components are stored as separate
+  * arrays, so that the interpolation of all tracks runs as a few flat loops
+  * the compiler can vectorize. A track without keyframes is left at the
+  * identity and marked as not sampled.
+  *****************************************************************************/
+
+class CAL3D_API CalPose
+{
+// member variables
+protected:
+  int m_trackCount;
+  std::vector<float> m_vectorOrientationX;
+  std::vector<float> m_vectorOrientationY;
+  std::vector<float> m_vectorOrientationZ;
+  std::vector<float> m_vectorRotationX;
+  std::vector<float> m_vectorRotationY;
+  std::vector<float> m_vectorRotationZ;
+  std::vector<float> m_vectorRotationW;
+
+  // keyframe after the sample time and blending factor, per track
+  std::vector<float> m_vectorTargetOrientationX;
+  std::vector<float> m_vectorTargetOrientationY;
+  std::vector<float> m_vectorTargetOrientationZ;
+  std::vector<float> m_vectorTargetRotationX;
+  std::vector<float> m_vectorTargetRotationY;
+  std::vector<float> m_vectorTargetRotationZ;
+  std::vector<float> m_vectorTargetRotationW;
+  std::vector<float> m_vectorBlendFactor;
+  std::vector<bool> m_vectorSampled;
+
+  // slerp weights of the two keyframes, per track
+  std::vector<float> m_vectorWeightBefore;
+  std::vector<float> m_vectorWeightAfter;
+
+// constructors/destructor
+public:
+  CalPose();
+  virtual ~CalPose();
+
+// member functions
+public:
+  bool create();
+  void destroy();
+  void reserve(int trackCount);
+  void setTrackCount(int trackCount);
+  int getTrackCount();
+  void clearKeyframes(int trackId);
+  bool isSampled(int trackId);
+  void setKeyframes(int trackId, CalCoreKeyframe *pCoreKeyframeBefore, CalCoreKeyframe *pCoreKeyframeAfter, float blendFactor);
+  void interpolate(int mode);
+  void getOrientation(int trackId, CalVector& orientation);
+  void getRotation(int trackId, CalQuaternion& rotation);
+};
+
+#endif
+
+//****************************************************************************//
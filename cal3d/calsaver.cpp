@@ -26,6 +26,8 @@
 #include "calcoretrack.h"
 #include "calcorekey.h"
 #include "calcoresub.h"
+#include "calbinary.h"
+#include "buffersource.h"
 
  /*****************************************************************************/
 /** Constructs the saver instance.
@@ -47,6 +49,41 @@ CalSaver::~CalSaver()
 {
 }
 
+ /*****************************************************************************/
+/** Writes a section to a file.
+  *
+  * This function writes a serialized section to a file in one write and
+  * empties the section buffer. Without a file the section stays in the
+  * buffer, so that the whole file is assembled in memory.
+  *
+  * @param pFile A pointer to the file stream, or 0 to keep the section.
+  * @param strFilename The name of the file stream.
+  * @param vectorBuffer The section buffer.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalSaver::flushSection(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer)
+{
+  if((pFile == 0) || vectorBuffer.empty())
+  {
+    return true;
+  }
+
+  pFile->write(&vectorBuffer[0], vectorBuffer.size());
+  if(!*pFile)
+  {
+    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
+    return false;
+  }
+
+  vectorBuffer.clear();
+
+  return true;
+}
+
  /*****************************************************************************/
 /** Saves a core animation instance.
   *
@@ -73,232 +110,316 @@ bool CalSaver::saveCoreAnimation(const std::string& strFilename, CalCoreAnimatio
     return false;
   }
 
-  // write magic tag
-  file.write((char *)&Cal::ANIMATION_FILE_MAGIC, sizeof(Cal::ANIMATION_FILE_MAGIC));
-  if(!file)
+  std::vector<char> vectorBuffer;
+  if(!saveCoreAnimationData(&file, strFilename, vectorBuffer, pCoreAnimation))
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
     return false;
   }
 
-  // write version info
-  file.write((char *)&Cal::CURRENT_FILE_VERSION, sizeof(Cal::CURRENT_FILE_VERSION));
-  if(!file)
-  {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-    return false;
-  }
+  // explicitly close the file
+  file.close();
 
-  // write the duration of the core animation
-  float duration;
-  duration = pCoreAnimation->getDuration();
+  return true;
+}
 
-  file.write((char *)&duration, 4);
-  if(!file)
+ /*****************************************************************************/
+/** Saves a core animation instance to memory.
+  *
+  * This function saves a core animation instance to a memory buffer, in the
+  * same format as to a file. The buffer can be passed to
+  * CalLoader::loadCoreAnimation directly.
+  *
+  * @param vectorBuffer The buffer to save the core animation instance to. Its
+  *                     previous contents are replaced.
+  * @param pCoreAnimation A pointer to the core animation instance that should
+  *                       be saved.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalSaver::saveCoreAnimation(std::vector<char>& vectorBuffer, CalCoreAnimation *pCoreAnimation)
+{
+  vectorBuffer.clear();
+
+  return saveCoreAnimationData(0, "", vectorBuffer, pCoreAnimation);
+}
+
+ /*****************************************************************************/
+/** Serializes a core animation instance.
+  *
+  * This function serializes a core animation instance section by section. The
+  * header and each track are written to the file in one write each.
+  *
+  * @param pFile A pointer to the file stream, or 0 to keep everything in the
+  *              buffer.
+  * @param strFilename The name of the file stream.
+  * @param vectorBuffer The section buffer.
+  * @param pCoreAnimation A pointer to the core animation instance that should
+  *                       be saved.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalSaver::saveCoreAnimationData(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer, CalCoreAnimation *pCoreAnimation)
+{
+  if(pCoreAnimation == 0)
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, strFilename);
     return false;
   }
 
-  // get core track list
-  std::list<CalCoreTrack *>& listCoreTrack = pCoreAnimation->getListCoreTrack();
+  CalBufferWriter buffer(vectorBuffer);
+
+  // write magic tag and version info
+  buffer.writeBytes(&Cal::ANIMATION_FILE_MAGIC, sizeof(Cal::ANIMATION_FILE_MAGIC));
+  buffer.writeInteger(Cal::CURRENT_FILE_VERSION);
+
+  // write the duration of the core animation
+  buffer.writeFloat(pCoreAnimation->getDuration());
+
+  // get core track vector
+  std::vector<CalCoreTrack *>& vectorCoreTrack = pCoreAnimation->getVectorCoreTrack();
 
   // write the number of tracks
-  int trackCount;
-  trackCount = listCoreTrack.size();
+  buffer.writeInteger(vectorCoreTrack.size());
 
-  file.write((char *)&trackCount, 4);
-  if(!file)
+  if(!flushSection(pFile, strFilename, vectorBuffer))
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-    return 0;
+    return false;
   }
 
-  // write all core bones
-  std::list<CalCoreTrack *>::iterator iteratorCoreTrack;
-  for(iteratorCoreTrack = listCoreTrack.begin(); iteratorCoreTrack != listCoreTrack.end(); ++iteratorCoreTrack)
+  // write all core tracks
+  std::vector<CalCoreTrack *>::iterator iteratorCoreTrack;
+  for(iteratorCoreTrack = vectorCoreTrack.begin(); iteratorCoreTrack != vectorCoreTrack.end(); ++iteratorCoreTrack)
   {
-    // save core track
-    if(!saveCoreTrack(file, strFilename, *iteratorCoreTrack))
+    saveCoreTrack(buffer, *iteratorCoreTrack);
+
+    if(!flushSection(pFile, strFilename, vectorBuffer))
     {
       return false;
     }
   }
 
-  // explicitly close the file
-  file.close();
-
   return true;
 }
 
  /*****************************************************************************/
 /** Saves a core bone instance.
   *
-  * This function saves a core bone instance to a file stream.
+  * This function serializes a core bone instance into a section buffer.
   *
-  * @param file The file stream to save the core bone instance to.
-  * @param strFilename The name of the file stream.
+  * @param buffer The section buffer to save the core bone instance to.
   * @param pCoreBone A pointer to the core bone instance that should be saved.
-  *
-  * @return One of the following values:
-  *         \li \b true if successful
-  *         \li \b false if an error happend
   *****************************************************************************/
 
-bool CalSaver::saveCoreBones(std::ofstream& file, const std::string& strFilename, CalCoreBone *pCoreBone)
+void CalSaver::saveCoreBones(CalBufferWriter& buffer, CalCoreBone *pCoreBone)
 {
-  if(!file)
-  {
-    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, strFilename);
-    return false;
-  }
-
   // write the name of the bone
-  int len;
-  len = pCoreBone->getName().size() + 1;
-  file.write((char *)&len, 4);
-  file.write(pCoreBone->getName().c_str(), len);
-  if(!file)
-  {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-    return false;
-  }
+  buffer.writeString(pCoreBone->getName());
 
-  // write the length of the bone.
-  float length = pCoreBone->getLength();
-  file.write((char *)&length, 4);
+  // write the length of the bone
+  buffer.writeFloat(pCoreBone->getLength());
 
-  // write the translation of the bone
+  // write the translation and the rotation of the bone
   const CalVector& translation = pCoreBone->getTranslation();
-  file.write((char *)&translation[0], 4);
-  file.write((char *)&translation[1], 4);
-  file.write((char *)&translation[2], 4);
-
-  // write the rotation of the bone
   const CalQuaternion& rotation = pCoreBone->getRotation();
-  file.write((char *)&rotation[0], 4);
-  file.write((char *)&rotation[1], 4);
-  file.write((char *)&rotation[2], 4);
-  file.write((char *)&rotation[3], 4);
 
-  // write the translation of the bone
+  // write the translation and the rotation of the bone in bone space
   const CalVector& translationBoneSpace = pCoreBone->getTranslationBoneSpace();
-  file.write((char *)&translationBoneSpace[0], 4);
-  file.write((char *)&translationBoneSpace[1], 4);
-  file.write((char *)&translationBoneSpace[2], 4);
-
-  // write the rotation of the bone
   const CalQuaternion& rotationBoneSpace = pCoreBone->getRotationBoneSpace();
-  file.write((char *)&rotationBoneSpace[0], 4);
-  file.write((char *)&rotationBoneSpace[1], 4);
-  file.write((char *)&rotationBoneSpace[2], 4);
-  file.write((char *)&rotationBoneSpace[3], 4);
 
-  // write the parent bone id
-  int parentId;
-  parentId = pCoreBone->getParentId();
-  file.write((char *)&parentId, 4);
+  float transform[14];
+  transform[0] = translation.x;
+  transform[1] = translation.y;
+  transform[2] = translation.z;
+  transform[3] = rotation.x;
+  transform[4] = rotation.y;
+  transform[5] = rotation.z;
+  transform[6] = rotation.w;
+  transform[7] = translationBoneSpace.x;
+  transform[8] = translationBoneSpace.y;
+  transform[9] = translationBoneSpace.z;
+  transform[10] = rotationBoneSpace.x;
+  transform[11] = rotationBoneSpace.y;
+  transform[12] = rotationBoneSpace.z;
+  transform[13] = rotationBoneSpace.w;
+  buffer.writeWords(transform, 14);
 
-  // check if an error happend
-  if(!file)
-  {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-    return false;
-  }
+  // write the parent bone id
+  buffer.writeInteger(pCoreBone->getParentId());
 
   // get children list
   std::list<int>& listChildId = pCoreBone->getListChildId();
 
   // write the number of children
-  int childCount;
-  childCount = listChildId.size();
+  buffer.writeInteger(listChildId.size());
+
+  // write all children ids
+  std::list<int>::iterator iteratorChildId;
+  for(iteratorChildId = listChildId.begin(); iteratorChildId != listChildId.end(); ++iteratorChildId)
+  {
+    buffer.writeInteger(*iteratorChildId);
+  }
+}
+
+ /*****************************************************************************/
+/** Saves a core keyframe instance.
+  *
+  * This function serializes a core keyframe instance into a section buffer.
+  *
+  * @param buffer The section buffer to save the core keyframe instance to.
+  * @param pCoreKeyframe A pointer to the core keyframe instance that should be
+  *                      saved.
+  *****************************************************************************/
+
+void CalSaver::saveCoreKeyframe(CalBufferWriter& buffer, CalCoreKeyframe *pCoreKeyframe)
+{
+  // write the time, the translation and the rotation of the keyframe
+  const CalVector& translation = pCoreKeyframe->getOrientation();
+  const CalQuaternion& rotation = pCoreKeyframe->getRotation();
+
+  float keyframe[8];
+  keyframe[0] = pCoreKeyframe->getTime();
+  keyframe[1] = translation.x;
+  keyframe[2] = translation.y;
+  keyframe[3] = translation.z;
+  keyframe[4] = rotation.x;
+  keyframe[5] = rotation.y;
+  keyframe[6] = rotation.z;
+  keyframe[7] = rotation.w;
+  buffer.writeWords(keyframe, 8);
+}
+
+ /*****************************************************************************/
+/** Saves the submeshes of a core model instance as a mesh file.
+  *
+  * This function saves the submeshes of a core model instance to a mesh file,
+  * which is loaded together with a skeleton file.
+  *
+  * @param strFilename The name of the file to save the submeshes to.
+  * @param pCoreModel A pointer to the core model instance whose submeshes
+  *                   should be saved.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
 
-  file.write((char *)&childCount, 4);
+bool CalSaver::saveCoreMesh(const std::string& strFilename, CalCoreModel *pCoreModel)
+{
+  // open the file
+  std::ofstream file;
+  file.open(strFilename.c_str(), std::ios::out | std::ios::binary);
   if(!file)
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
+    CalError::setLastError(CalError::FILE_CREATION_FAILED, __FILE__, __LINE__, strFilename);
     return false;
   }
 
-  // write all children ids
-  std::list<int>::iterator iteratorChildId;
-  for(iteratorChildId = listChildId.begin(); iteratorChildId != listChildId.end(); ++iteratorChildId)
+  std::vector<char> vectorBuffer;
+  if(!saveCoreMeshData(&file, strFilename, vectorBuffer, pCoreModel))
   {
-    // get child id
-    int childId;
-    childId = *iteratorChildId;
-
-    // write child id
-    file.write((char *)&childId, 4);
-    if(!file)
-    {
-      CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-      return false;
-    }
+    return false;
   }
 
+  // explicitly close the file
+  file.close();
+
   return true;
 }
 
  /*****************************************************************************/
-/** Saves a core keyframe instance.
+/** Saves the submeshes of a core model instance to memory.
+  *
+  * This function saves the submeshes of a core model instance to a memory
+  * buffer, in the same format as to a mesh file.
+  *
+  * @param vectorBuffer The buffer to save the submeshes to. Its previous
+  *                     contents are replaced.
+  * @param pCoreModel A pointer to the core model instance whose submeshes
+  *                   should be saved.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalSaver::saveCoreMesh(std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel)
+{
+  vectorBuffer.clear();
+
+  return saveCoreMeshData(0, "", vectorBuffer, pCoreModel);
+}
+
+ /*****************************************************************************/
+/** Serializes the submeshes of a core model instance.
   *
-  * This function saves a core keyframe instance to a file stream.
+  * This function serializes the submeshes of a core model instance as a mesh
+  * file. The header and each submesh are written to the file in one write
+  * each.
   *
-  * @param file The file stream to save the core keyframe instance to.
+  * @param pFile A pointer to the file stream, or 0 to keep everything in the
+  *              buffer.
   * @param strFilename The name of the file stream.
-  * @param pCoreKeyframe A pointer to the core keyframe instance that should be
-  *                      saved.
+  * @param vectorBuffer The section buffer.
+  * @param pCoreModel A pointer to the core model instance whose submeshes
+  *                   should be saved.
   *
   * @return One of the following values:
   *         \li \b true if successful
   *         \li \b false if an error happend
   *****************************************************************************/
 
-bool CalSaver::saveCoreKeyframe(std::ofstream& file, const std::string& strFilename, CalCoreKeyframe *pCoreKeyframe)
+bool CalSaver::saveCoreMeshData(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel)
 {
-  if(!file)
+  if(pCoreModel == 0)
   {
     CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, strFilename);
     return false;
   }
 
-  // write the time of the keyframe
-  float time;
-  time = pCoreKeyframe->getTime();
-  file.write((char *)&time, 4);
+  CalBufferWriter buffer(vectorBuffer);
 
-  // write the orientation of the keyframe
-  const CalVector& translation = pCoreKeyframe->getOrientation();
-  file.write((char *)&translation[0], 4);
-  file.write((char *)&translation[1], 4);
-  file.write((char *)&translation[2], 4);
+  // write magic tag and version info
+  buffer.writeBytes(&Cal::MESH_FILE_MAGIC, sizeof(Cal::MESH_FILE_MAGIC));
+  buffer.writeInteger(Cal::CURRENT_FILE_VERSION);
 
-  // write the rotation of the keyframe
-  const CalQuaternion& rotation = pCoreKeyframe->getRotation();
-  file.write((char *)&rotation[0], 4);
-  file.write((char *)&rotation[1], 4);
-  file.write((char *)&rotation[2], 4);
-  file.write((char *)&rotation[3], 4);
+  // write the number of submeshes
+  int submeshCount;
+  submeshCount = pCoreModel->getCoreSubmeshCount();
+  buffer.writeInteger(submeshCount);
 
-  // check if an error happend
-  if(!file)
+  if(!flushSection(pFile, strFilename, vectorBuffer))
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
     return false;
   }
 
+  // write all core submeshes
+  int submeshId;
+  for(submeshId = 0; submeshId < submeshCount; submeshId++)
+  {
+    saveCoreSubmesh(buffer, pCoreModel->getCoreSubmesh(submeshId));
+
+    if(!flushSection(pFile, strFilename, vectorBuffer))
+    {
+      return false;
+    }
+  }
+
   return true;
 }
 
-
  /*****************************************************************************/
 /** Saves a core model instance.
   *
   * This function saves a core model instance to a file.
   *
   * @param strFilename The name of the file to save the core mesh instance to.
-  * @param pCoreMesh A pointer to the core mesh instance that should be saved.
+  * @param pCoreModel A pointer to the core model instance that should be saved.
   *
   * @return One of the following values:
   *         \li \b true if successful
@@ -316,30 +437,80 @@ bool CalSaver::saveCoreModel(const std::string& strFilename, CalCoreModel *pCore
     return false;
   }
 
-  // write magic tag
-  file.write((char *)&Cal::MODEL_FILE_MAGIC, sizeof(Cal::MODEL_FILE_MAGIC));
-  if(!file)
+  std::vector<char> vectorBuffer;
+  if(!saveCoreModelData(&file, strFilename, vectorBuffer, pCoreModel))
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
     return false;
   }
 
-  // write version info
-  file.write((char *)&Cal::CURRENT_FILE_VERSION, sizeof(Cal::CURRENT_FILE_VERSION));
-  if(!file)
+  // explicitly close the file
+  file.close();
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Saves a core model instance to memory.
+  *
+  * This function saves a core model instance to a memory buffer, in the same
+  * format as to a file. The buffer can be passed to CalLoader::loadCoreModel
+  * directly.
+  *
+  * @param vectorBuffer The buffer to save the core model instance to. Its
+  *                     previous contents are replaced.
+  * @param pCoreModel A pointer to the core model instance that should be saved.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalSaver::saveCoreModel(std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel)
+{
+  vectorBuffer.clear();
+
+  return saveCoreModelData(0, "", vectorBuffer, pCoreModel);
+}
+
+ /*****************************************************************************/
+/** Serializes a core model instance.
+  *
+  * This function serializes a core model instance section by section. The
+  * header, each bone and each submesh are written to the file in one write
+  * each.
+  *
+  * @param pFile A pointer to the file stream, or 0 to keep everything in the
+  *              buffer.
+  * @param strFilename The name of the file stream.
+  * @param vectorBuffer The section buffer.
+  * @param pCoreModel A pointer to the core model instance that should be saved.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalSaver::saveCoreModelData(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel)
+{
+  if(pCoreModel == 0)
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, strFilename);
     return false;
   }
 
+  CalBufferWriter buffer(vectorBuffer);
+
+  // write magic tag and version info
+  buffer.writeBytes(&Cal::MODEL_FILE_MAGIC, sizeof(Cal::MODEL_FILE_MAGIC));
+  buffer.writeInteger(Cal::CURRENT_FILE_VERSION);
+
   // write the number of bones
   int boneCount;
   boneCount = pCoreModel->getCoreBoneCount();
+  buffer.writeInteger(boneCount);
 
-  file.write((char *)&boneCount, 4);
-  if(!file)
+  if(!flushSection(pFile, strFilename, vectorBuffer))
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
     return false;
   }
 
@@ -347,8 +518,9 @@ bool CalSaver::saveCoreModel(const std::string& strFilename, CalCoreModel *pCore
   int boneId;
   for(boneId = 0; boneId < boneCount; boneId++)
   {
-    // write the core bone
-    if(!saveCoreBones(file, strFilename, pCoreModel->getCoreBone(boneId)))
+    saveCoreBones(buffer, pCoreModel->getCoreBone(boneId));
+
+    if(!flushSection(pFile, strFilename, vectorBuffer))
     {
       return false;
     }
@@ -357,66 +529,37 @@ bool CalSaver::saveCoreModel(const std::string& strFilename, CalCoreModel *pCore
   // write the number of submeshes
   int submeshCount;
   submeshCount = pCoreModel->getCoreSubmeshCount();
-
-  file.write((char *)&submeshCount, 4);
-  if(!file)
-  {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-    return false;
-  }
+  buffer.writeInteger(submeshCount);
 
   // write all core submeshes
   int submeshId;
   for(submeshId = 0; submeshId < submeshCount; submeshId++)
   {
-    // write the core submesh
-    if(!saveCoreSubmesh(file, strFilename, pCoreModel->getCoreSubmesh(submeshId)))
+    saveCoreSubmesh(buffer, pCoreModel->getCoreSubmesh(submeshId));
+
+    if(!flushSection(pFile, strFilename, vectorBuffer))
     {
       return false;
     }
   }
 
-  // explicitly close the file
-  file.close();
-
-  return true;
+  return flushSection(pFile, strFilename, vectorBuffer);
 }
 
-
  /*****************************************************************************/
 /** Saves a core submesh instance.
   *
-  * This function saves a core submesh instance to a file stream.
+  * This function serializes a core submesh instance into a section buffer.
   *
-  * @param file The file stream to save the core submesh instance to.
-  * @param strFilename The name of the file stream.
+  * @param buffer The section buffer to save the core submesh instance to.
   * @param pCoreSubmesh A pointer to the core submesh instance that should be
   *                     saved.
-  *
-  * @return One of the following values:
-  *         \li \b true if successful
-  *         \li \b false if an error happend
   *****************************************************************************/
 
-bool CalSaver::saveCoreSubmesh(std::ofstream& file, const std::string& strFilename, CalCoreSubmesh *pCoreSubmesh)
+void CalSaver::saveCoreSubmesh(CalBufferWriter& buffer, CalCoreSubmesh *pCoreSubmesh)
 {
-  if(!file)
-  {
-    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, strFilename);
-    return false;
-  }
-
   // write the core material thread id
-  int coreMaterialThreadId;
-  coreMaterialThreadId = pCoreSubmesh->getCoreMaterialThreadId();
-  file.write((char *)&coreMaterialThreadId, 4);
-
-  // check if an error happend
-  if(!file)
-  {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-    return false;
-  }
+  buffer.writeInteger(pCoreSubmesh->getCoreMaterialThreadId());
 
   // get the vertex, face, physical property, and spring vector
   std::vector<CalCoreSubmesh::Vertex>& vectorVertex = pCoreSubmesh->getVectorVertex();
@@ -424,49 +567,42 @@ bool CalSaver::saveCoreSubmesh(std::ofstream& file, const std::string& strFilena
   std::vector<CalCoreSubmesh::PhysicalProperty>& vectorPhysicalProperty = pCoreSubmesh->getVectorPhysicalProperty();
   std::vector<CalCoreSubmesh::Spring>& vectorSpring = pCoreSubmesh->getVectorSpring();
   std::vector<CalCoreSubmesh::LodControl>& vectorLodControl = pCoreSubmesh->getVectorLodControl();
-  
+
   // write the number of vertices, faces, level-of-details, springs, and maps
   int vertexCount;
   vertexCount = vectorVertex.size();
-  file.write((char *)&vertexCount, 4);
 
   int faceCount;
   faceCount = vectorFace.size();
-  file.write((char *)&faceCount, 4);
-
-  int lodCount;
-  lodCount = pCoreSubmesh->getLodCount();
-  file.write((char *)&lodCount, 4);
 
   int springCount;
   springCount = pCoreSubmesh->getSpringCount();
-  file.write((char *)&springCount, 4);
 
   int textureCoordinateCount;
   textureCoordinateCount = pCoreSubmesh->getTextureCoordinateCount();
-  file.write((char *)&textureCoordinateCount, 4);
 
-  // Write the tangent-space enabled flags.
+  int counts[5];
+  counts[0] = vertexCount;
+  counts[1] = faceCount;
+  counts[2] = pCoreSubmesh->getLodCount();
+  counts[3] = springCount;
+  counts[4] = textureCoordinateCount;
+  buffer.writeWords(counts, 5);
+
+  // write the tangent-space enabled flags
   int textureCoordinateId;
-  for (textureCoordinateId = 0; textureCoordinateId < textureCoordinateCount; textureCoordinateId++)
+  for(textureCoordinateId = 0; textureCoordinateId < textureCoordinateCount; textureCoordinateId++)
   {
     bool enabled = pCoreSubmesh->tangentsEnabled(textureCoordinateId);
-    file.write((char *)&enabled, 1);
-  }
-  
-  // check if an error happend
-  if(!file)
-  {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-    return false;
+    buffer.writeBytes(&enabled, 1);
   }
-  
+
   std::vector<std::vector<CalCoreSubmesh::TextureCoordinate> >
     &vectorvectorTextureCoordinate = pCoreSubmesh->getVectorVectorTextureCoordinate();
   std::vector<std::vector<CalCoreSubmesh::TangentSpace> >
     &vectorvectorTangentSpace = pCoreSubmesh->getVectorVectorTangentSpace();
 
-  // Get the influence vector.
+  // get the influence vector
   std::vector<CalCoreSubmesh::Influence>& vectorInfluence = pCoreSubmesh->getVectorInfluence();
   int nextInfluence = 0;
 
@@ -476,199 +612,350 @@ bool CalSaver::saveCoreSubmesh(std::ofstream& file, const std::string& strFilena
   {
     CalCoreSubmesh::Vertex& vertex = vectorVertex[vertexId];
     CalCoreSubmesh::LodControl& lodcontrol = vectorLodControl[vertexId];
-    
+
     // write the vertex data
-    file.write((char *)&vertex.position.x, 4);
-    file.write((char *)&vertex.position.y, 4);
-    file.write((char *)&vertex.position.z, 4);
+    buffer.writeWords(&vertex.position, 3);
     char nxyz[3];
     nxyz[0] = vertex.nx;
     nxyz[1] = vertex.ny;
     nxyz[2] = vertex.nz;
-    file.write((char *)nxyz, 3);
-    
-    // write the LOD control information.
-    int collapseId = lodcontrol.collapseId;
-    int faceCollapseCount = lodcontrol.faceCollapseCount;
-    file.write((char *)&collapseId, 4);
-    file.write((char *)&faceCollapseCount, 4);
-    
+    buffer.writeBytes(nxyz, 3);
+
+    // write the LOD control information
+    int lod[2];
+    lod[0] = lodcontrol.collapseId;
+    lod[1] = lodcontrol.faceCollapseCount;
+    buffer.writeWords(lod, 2);
+
     // write all texture coordinates of this vertex
     for(textureCoordinateId = 0; textureCoordinateId < textureCoordinateCount; textureCoordinateId++)
     {
       CalCoreSubmesh::TextureCoordinate& textureCoordinate = vectorvectorTextureCoordinate[textureCoordinateId][vertexId];
 
       // write the texture coordinate data
-      file.write((char *)&textureCoordinate.u, 4);
-      file.write((char *)&textureCoordinate.v, 4);
-      
-      if (pCoreSubmesh->tangentsEnabled(textureCoordinateId))
-      {
-	CalCoreSubmesh::TangentSpace& tangentSpace = vectorvectorTangentSpace[textureCoordinateId][vertexId];
-	char tanspace[4];
-	tanspace[0] = tangentSpace.tx;
-	tanspace[1] = tangentSpace.ty;
-	tanspace[2] = tangentSpace.tz;
-	tanspace[3] = tangentSpace.crossFactor;
-	file.write((char *)tanspace, 4);
-      }
-      
-      // check if an error happend
-      if(!file)
+      float uv[2];
+      uv[0] = textureCoordinate.u;
+      uv[1] = textureCoordinate.v;
+      buffer.writeWords(uv, 2);
+
+      if(pCoreSubmesh->tangentsEnabled(textureCoordinateId))
       {
-        CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-        return false;
+        CalCoreSubmesh::TangentSpace& tangentSpace = vectorvectorTangentSpace[textureCoordinateId][vertexId];
+        char tanspace[4];
+        tanspace[0] = tangentSpace.tx;
+        tanspace[1] = tangentSpace.ty;
+        tanspace[2] = tangentSpace.tz;
+        tanspace[3] = tangentSpace.crossFactor;
+        buffer.writeBytes(tanspace, 4);
       }
     }
-    
+
     // write the number of influences
-    int influenceCount = vertex.influenceCount;
-    file.write((char *)&influenceCount, 4);
-    
-    // check if an error happend
-    if(!file)
-    {
-      CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-      return false;
-    }
-    
-     // write all influences of this vertex
+    buffer.writeInteger(vertex.influenceCount);
+
+    // write all influences of this vertex
     int influenceId;
     for(influenceId = 0; influenceId < vertex.influenceCount; influenceId++)
     {
       CalCoreSubmesh::Influence& influence = vectorInfluence[nextInfluence + influenceId];
 
       // write the influence data
-      file.write((char *)&influence.boneId, 4);
-      file.write((char *)&influence.weight, 4);
-
-      // check if an error happend
-      if(!file)
-      {
-        CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-        return false;
-      }
+      buffer.writeInteger(influence.boneId);
+      buffer.writeFloat(influence.weight);
     }
     nextInfluence += vertex.influenceCount;
 
-    // save the physical property of the vertex if there are springs in the core submesh
+    // write the physical property of this vertex if there are springs in the core submesh
     if(springCount > 0)
     {
-      // write the physical property of this vertex if there are springs in the core submesh
-      CalCoreSubmesh::PhysicalProperty& physicalProperty = vectorPhysicalProperty[vertexId];
-
-      // write the physical property data
-      file.write((char *)&physicalProperty.weight, 4);
-
-      // check if an error happend
-      if(!file)
-      {
-        CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-        return false;
-      }
+      buffer.writeFloat(vectorPhysicalProperty[vertexId].weight);
     }
   }
 
   // write all springs
-  int springId;
-  for(springId = 0; springId < springCount; springId++)
+  if(springCount > 0)
   {
-    CalCoreSubmesh::Spring& spring = vectorSpring[springId];
-
-    // write the spring data
-    file.write((char *)&spring.vertexId[0], 4);
-    file.write((char *)&spring.vertexId[1], 4);
-    file.write((char *)&spring.springCoefficient, 4);
-    file.write((char *)&spring.idleLength, 4);
-
-    // check if an error happend
-    if(!file)
-    {
-      CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-      return false;
-    }
+    buffer.writeWords(&vectorSpring[0], springCount * 4);
   }
 
   // write all faces
-  int faceId;
-  for(faceId = 0; faceId < faceCount; faceId++)
+  if(faceCount > 0)
   {
-    CalCoreSubmesh::Face& face = vectorFace[faceId];
+    buffer.writeWords(&vectorFace[0], faceCount * 3);
+  }
+}
 
-    // write the face data
-    file.write((char *)&face.vertexId[0], 4);
-    file.write((char *)&face.vertexId[1], 4);
-    file.write((char *)&face.vertexId[2], 4);
+ /*****************************************************************************/
+/** Saves a core track instance.
+  *
+  * This function serializes a core track instance into a section buffer.
+  *
+  * @param buffer The section buffer to save the core track instance to.
+  * @param pCoreTrack A pointer to the core track instance that should be saved.
+  *****************************************************************************/
 
-    // check if an error happend
-    if(!file)
-    {
-      CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
-      return false;
-    }
+void CalSaver::saveCoreTrack(CalBufferWriter& buffer, CalCoreTrack *pCoreTrack)
+{
+  // write the name of the bone
+  buffer.writeString(pCoreTrack->getCoreBoneName());
+
+  // write the number of keyframes
+  int keyframeCount;
+  keyframeCount = pCoreTrack->getCoreKeyframeCount();
+  buffer.writeInteger(keyframeCount);
+
+  // save all core keyframes
+  int keyframeId;
+  for(keyframeId = 0; keyframeId < keyframeCount; ++keyframeId)
+  {
+    saveCoreKeyframe(buffer, pCoreTrack->getCoreKeyframe(keyframeId));
   }
+}
 
-  return true;
+ /*****************************************************************************/
+/** Appends a section to a binary model image.
+  *
+  * This function pads a binary model image to the section alignment and
+  * appends a block of data to it.
+  *
+  * @param image The binary model image.
+  * @param pData A pointer to the data.
+  * @param size The size of the data in bytes.
+  *
+  * @return The offset of the section.
+  *****************************************************************************/
+
+static int appendBinarySection(std::vector<char>& image, const void *pData, int size)
+{
+  int offset;
+  offset = (image.size() + Cal::BINARY_ALIGNMENT - 1) & ~(Cal::BINARY_ALIGNMENT - 1);
+
+  image.resize(offset + size);
+  if((pData != 0) && (size > 0)) memcpy(&image[offset], pData, size);
+
+  return offset;
 }
 
  /*****************************************************************************/
-/** Saves a core track instance.
+/** Saves a core model instance as a binary model file.
   *
-  * This function saves a core track instance to a file stream.
+  * This function saves a core model instance, skeleton and submeshes, as a
+  * binary model file that CalLoader::loadBinaryCoreModel can load without
+  * parsing. The file is assembled in memory and written at once.
   *
-  * @param file The file stream to save the core track instance to.
-  * @param strFilename The name of the file stream.
-  * @param pCoreTrack A pointer to the core track instance that should be saved.
+  * @param strFilename The name of the file to save the core model instance to.
+  * @param pCoreModel A pointer to the core model instance that should be saved.
   *
   * @return One of the following values:
   *         \li \b true if successful
   *         \li \b false if an error happend
   *****************************************************************************/
 
-bool CalSaver::saveCoreTrack(std::ofstream& file, const std::string& strFilename, CalCoreTrack *pCoreTrack)
+bool CalSaver::saveBinaryCoreModel(const std::string& strFilename, CalCoreModel *pCoreModel)
 {
+  std::vector<char> image;
+  if(!saveBinaryCoreModel(image, pCoreModel))
+  {
+    return false;
+  }
+
+  // write the image
+  std::ofstream file;
+  file.open(strFilename.c_str(), std::ios::out | std::ios::binary);
   if(!file)
   {
-    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__, strFilename);
+    CalError::setLastError(CalError::FILE_CREATION_FAILED, __FILE__, __LINE__, strFilename);
     return false;
   }
-  
-  // write the name of the bone
-  int len;
-  len = pCoreTrack->getCoreBoneName().size() + 1;
-  file.write((char *)&len, 4);
-  file.write(pCoreTrack->getCoreBoneName().c_str(), len);
+
+  file.write(&image[0], image.size());
   if(!file)
   {
     CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
     return false;
   }
-  
-  // get core keyframe map
-  std::map<float, CalCoreKeyframe *>& mapCoreKeyframe = pCoreTrack->getMapCoreKeyframe();
 
-  // read the number of keyframes
-  int keyframeCount;
-  keyframeCount = mapCoreKeyframe.size();
+  // explicitly close the file
+  file.close();
 
-  file.write((char *)&keyframeCount, 4);
-  if(!file)
+  return true;
+}
+
+ /*****************************************************************************/
+/** Saves a core model instance as a binary model image in memory.
+  *
+  * This function assembles the binary model file of a core model instance in
+  * a memory buffer. The buffer can be passed to CalLoader::loadBinaryCoreModel
+  * directly.
+  *
+  * @param image The buffer to save the core model instance to. Its previous
+  *              contents are replaced.
+  * @param pCoreModel A pointer to the core model instance that should be saved.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalSaver::saveBinaryCoreModel(std::vector<char>& image, CalCoreModel *pCoreModel)
+{
+  if(pCoreModel == 0)
   {
-    CalError::setLastError(CalError::FILE_WRITING_FAILED, __FILE__, __LINE__, strFilename);
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
     return false;
   }
 
-  // save all core keyframes
-  std::map<float, CalCoreKeyframe *>::iterator iteratorCoreKeyframe;
-  for(iteratorCoreKeyframe = mapCoreKeyframe.begin(); iteratorCoreKeyframe != mapCoreKeyframe.end(); ++iteratorCoreKeyframe)
+  CalBinaryHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, Cal::BINARY_MODEL_FILE_MAGIC, sizeof(header.magic));
+  header.version = Cal::BINARY_FILE_VERSION;
+  header.byteOrder = Cal::BINARY_BYTE_ORDER;
+  header.boneSize = sizeof(CalBinaryBone);
+  header.submeshSize = sizeof(CalBinarySubmesh);
+  header.vertexSize = 16;
+
+  image.clear();
+  image.resize(sizeof(header));
+
+  // collect the bones, their children and their names
+  header.boneCount = pCoreModel->getCoreBoneCount();
+
+  std::vector<CalBinaryBone> vectorBinaryBone(header.boneCount);
+  std::vector<int> vectorChildId;
+  std::string strNames;
+
+  int boneId;
+  for(boneId = 0; boneId < header.boneCount; boneId++)
+  {
+    CalCoreBone *pCoreBone;
+    pCoreBone = pCoreModel->getCoreBone(boneId);
+
+    CalBinaryBone& binaryBone = vectorBinaryBone[boneId];
+    memset(&binaryBone, 0, sizeof(binaryBone));
+
+    binaryBone.nameOffset = strNames.size();
+    strNames += pCoreBone->getName();
+    strNames += '\0';
+
+    binaryBone.parentId = pCoreBone->getParentId();
+    binaryBone.length = pCoreBone->getLength();
+
+    const CalVector& translation = pCoreBone->getTranslation();
+    binaryBone.translation[0] = translation.x;
+    binaryBone.translation[1] = translation.y;
+    binaryBone.translation[2] = translation.z;
+
+    const CalQuaternion& rotation = pCoreBone->getRotation();
+    binaryBone.rotation[0] = rotation.x;
+    binaryBone.rotation[1] = rotation.y;
+    binaryBone.rotation[2] = rotation.z;
+    binaryBone.rotation[3] = rotation.w;
+
+    const CalVector& translationBoneSpace = pCoreBone->getTranslationBoneSpace();
+    binaryBone.translationBoneSpace[0] = translationBoneSpace.x;
+    binaryBone.translationBoneSpace[1] = translationBoneSpace.y;
+    binaryBone.translationBoneSpace[2] = translationBoneSpace.z;
+
+    const CalQuaternion& rotationBoneSpace = pCoreBone->getRotationBoneSpace();
+    binaryBone.rotationBoneSpace[0] = rotationBoneSpace.x;
+    binaryBone.rotationBoneSpace[1] = rotationBoneSpace.y;
+    binaryBone.rotationBoneSpace[2] = rotationBoneSpace.z;
+    binaryBone.rotationBoneSpace[3] = rotationBoneSpace.w;
+
+    std::list<int>& listChildId = pCoreBone->getListChildId();
+    binaryBone.firstChild = vectorChildId.size();
+    binaryBone.childCount = listChildId.size();
+    vectorChildId.insert(vectorChildId.end(), listChildId.begin(), listChildId.end());
+  }
+
+  header.boneOffset = appendBinarySection(image, &vectorBinaryBone[0], header.boneCount * sizeof(CalBinaryBone));
+  header.childCount = vectorChildId.size();
+  header.childOffset = appendBinarySection(image, vectorChildId.empty() ? 0 : &vectorChildId[0], header.childCount * sizeof(int));
+  header.stringSize = strNames.size();
+  header.stringOffset = appendBinarySection(image, strNames.data(), header.stringSize);
+
+  // write the arrays of all submeshes
+  header.submeshCount = pCoreModel->getCoreSubmeshCount();
+
+  std::vector<CalBinarySubmesh> vectorBinarySubmesh(header.submeshCount);
+
+  int submeshId;
+  for(submeshId = 0; submeshId < header.submeshCount; submeshId++)
   {
-    // save the core keyframe
-    if(!saveCoreKeyframe(file, strFilename, iteratorCoreKeyframe->second))
+    CalCoreSubmesh *pCoreSubmesh;
+    pCoreSubmesh = pCoreModel->getCoreSubmesh(submeshId);
+
+    CalBinarySubmesh& binarySubmesh = vectorBinarySubmesh[submeshId];
+    memset(&binarySubmesh, 0, sizeof(binarySubmesh));
+
+    binarySubmesh.coreMaterialThreadId = pCoreSubmesh->getCoreMaterialThreadId();
+    binarySubmesh.lodCount = pCoreSubmesh->getLodCount();
+    binarySubmesh.vertexCount = pCoreSubmesh->getVertexCount();
+    binarySubmesh.faceCount = pCoreSubmesh->getFaceCount();
+    binarySubmesh.springCount = pCoreSubmesh->getSpringCount();
+    binarySubmesh.influenceCount = pCoreSubmesh->getVectorInfluence().size();
+    binarySubmesh.textureCoordinateCount = pCoreSubmesh->getTextureCoordinateCount();
+
+    const int vertexCount = binarySubmesh.vertexCount;
+
+    // write the vertex records, field by field only if the vertex carries user data
+    std::vector<CalCoreSubmesh::Vertex>& vectorVertex = pCoreSubmesh->getVectorVertex();
+    if(sizeof(CalCoreSubmesh::Vertex) == 16)
     {
-      return false;
+      binarySubmesh.vertexOffset = appendBinarySection(image, vertexCount ? &vectorVertex[0] : 0, vertexCount * 16);
+    }
+    else
+    {
+      binarySubmesh.vertexOffset = appendBinarySection(image, 0, vertexCount * 16);
+
+      int vertexId;
+      for(vertexId = 0; vertexId < vertexCount; vertexId++)
+      {
+        char *pVertex = &image[binarySubmesh.vertexOffset + vertexId * 16];
+        memcpy(pVertex, &vectorVertex[vertexId].position, 12);
+        pVertex[12] = vectorVertex[vertexId].nx;
+        pVertex[13] = vectorVertex[vertexId].ny;
+        pVertex[14] = vectorVertex[vertexId].nz;
+        pVertex[15] = vectorVertex[vertexId].influenceCount;
+      }
+    }
+
+    binarySubmesh.lodControlOffset = appendBinarySection(image, vertexCount ? &pCoreSubmesh->getVectorLodControl()[0] : 0, vertexCount * sizeof(CalCoreSubmesh::LodControl));
+    binarySubmesh.influenceOffset = appendBinarySection(image, binarySubmesh.influenceCount ? &pCoreSubmesh->getVectorInfluence()[0] : 0, binarySubmesh.influenceCount * sizeof(CalCoreSubmesh::Influence));
+    if(binarySubmesh.springCount > 0)
+    {
+      binarySubmesh.physicalPropertyOffset = appendBinarySection(image, vertexCount ? &pCoreSubmesh->getVectorPhysicalProperty()[0] : 0, vertexCount * sizeof(CalCoreSubmesh::PhysicalProperty));
+      binarySubmesh.springOffset = appendBinarySection(image, &pCoreSubmesh->getVectorSpring()[0], binarySubmesh.springCount * sizeof(CalCoreSubmesh::Spring));
     }
+    binarySubmesh.faceOffset = appendBinarySection(image, binarySubmesh.faceCount ? &pCoreSubmesh->getVectorFace()[0] : 0, binarySubmesh.faceCount * sizeof(CalCoreSubmesh::Face));
+
+    // write the texture coordinate channels
+    std::vector<CalBinaryChannel> vectorChannel(binarySubmesh.textureCoordinateCount);
+
+    int textureCoordinateId;
+    for(textureCoordinateId = 0; textureCoordinateId < binarySubmesh.textureCoordinateCount; textureCoordinateId++)
+    {
+      CalBinaryChannel& channel = vectorChannel[textureCoordinateId];
+
+      channel.textureCoordinateOffset = appendBinarySection(image, vertexCount ? &pCoreSubmesh->getVectorTextureCoordinate(textureCoordinateId)[0] : 0, vertexCount * sizeof(CalCoreSubmesh::TextureCoordinate));
+
+      channel.tangentSpaceOffset = 0;
+      if(pCoreSubmesh->tangentsEnabled(textureCoordinateId))
+      {
+        channel.tangentSpaceOffset = appendBinarySection(image, vertexCount ? &pCoreSubmesh->getVectorTangentSpace(textureCoordinateId)[0] : 0, vertexCount * sizeof(CalCoreSubmesh::TangentSpace));
+      }
+    }
+
+    binarySubmesh.channelOffset = appendBinarySection(image, vectorChannel.empty() ? 0 : &vectorChannel[0], vectorChannel.size() * sizeof(CalBinaryChannel));
   }
 
+  header.submeshOffset = appendBinarySection(image, vectorBinarySubmesh.empty() ? 0 : &vectorBinarySubmesh[0], header.submeshCount * sizeof(CalBinarySubmesh));
+
+  // pad the end so that the file size is aligned as well
+  appendBinarySection(image, 0, 0);
+  header.fileSize = image.size();
+  memcpy(&image[0], &header, sizeof(header));
+
   return true;
 }
 
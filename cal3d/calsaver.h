@@ -27,13 +27,18 @@ class CalCoreAnimation;
 class CalCoreTrack;
 class CalCoreKeyframe;
 class CalCoreSubmesh;
+class CalBufferWriter;
 
 //****************************************************************************//
 // Class declaration                                                          //
 //****************************************************************************//
 
  /*****************************************************************************/
-/** The loader class.
+/** The saver class.
+  *
+  * A saver writes core models and core animations to files or to memory
+  * buffers. Each bone, submesh and track is serialized into a section buffer
+  * first and written to the file in one write.
   *****************************************************************************/
 
 class CAL3D_API CalSaver: public CalSaverUserData
@@ -46,13 +51,23 @@ public:
 // member functions
 public:
   bool saveCoreAnimation(const std::string& strFilename, CalCoreAnimation *pCoreAnimation);
+  bool saveCoreAnimation(std::vector<char>& vectorBuffer, CalCoreAnimation *pCoreAnimation);
+  bool saveCoreMesh(const std::string& strFilename, CalCoreModel *pCoreModel);
+  bool saveCoreMesh(std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel);
   bool saveCoreModel(const std::string& strFilename, CalCoreModel *pCoreModel);
+  bool saveCoreModel(std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel);
+  bool saveBinaryCoreModel(const std::string& strFilename, CalCoreModel *pCoreModel);
+  bool saveBinaryCoreModel(std::vector<char>& image, CalCoreModel *pCoreModel);
 
 protected:
-  bool saveCoreBones(std::ofstream& file, const std::string& strFilename, CalCoreBone *pCoreBone);
-  bool saveCoreKeyframe(std::ofstream& file, const std::string& strFilename, CalCoreKeyframe *pCoreKeyframe);
-  bool saveCoreSubmesh(std::ofstream& file, const std::string& strFilename, CalCoreSubmesh *pCoreSubmesh);
-  bool saveCoreTrack(std::ofstream& file, const std::string& strFilename, CalCoreTrack *pCoreTrack);
+  static bool flushSection(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer);
+  bool saveCoreAnimationData(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer, CalCoreAnimation *pCoreAnimation);
+  void saveCoreBones(CalBufferWriter& buffer, CalCoreBone *pCoreBone);
+  void saveCoreKeyframe(CalBufferWriter& buffer, CalCoreKeyframe *pCoreKeyframe);
+  bool saveCoreMeshData(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel);
+  bool saveCoreModelData(std::ofstream *pFile, const std::string& strFilename, std::vector<char>& vectorBuffer, CalCoreModel *pCoreModel);
+  void saveCoreSubmesh(CalBufferWriter& buffer, CalCoreSubmesh *pCoreSubmesh);
+  void saveCoreTrack(CalBufferWriter& buffer, CalCoreTrack *pCoreTrack);
 };
 
 #endif
@@ -20,6 +20,7 @@
 #include "calerror.h"
 #include "calcoresub.h"
 #include "calmodel.h"
+#include "calcloth.h"
 
 
  /*****************************************************************************/
@@ -31,10 +32,17 @@
 CalSubmesh::CalSubmesh()
 {
   m_pCoreSubmesh = 0;
+  m_lodLevelId = 0;
+  m_vertexCount = 0;
+  m_faceCount = 0;
+  m_bInternalData = false;
+  m_springTime = 0.0f;
+  m_pCloth = 0;
 }
 
 CalSubmesh::~CalSubmesh()
 {
+  assert(m_pCloth == 0);
 }
 
  /*****************************************************************************/
@@ -151,10 +159,6 @@ bool CalSubmesh::create(CalCoreSubmesh *pCoreSubmesh, CalModel *pModel)
   m_pCoreSubmesh = pCoreSubmesh;
   m_pModel = pModel;
   
-  // reserve memory for the face vector
-  m_vectorFace.reserve(m_pCoreSubmesh->getFaceCount());
-  m_vectorFace.resize(m_pCoreSubmesh->getFaceCount());
-
   // set the initial lod level
   setLodLevel(1.0f);
 
@@ -163,6 +167,24 @@ bool CalSubmesh::create(CalCoreSubmesh *pCoreSubmesh, CalModel *pModel)
   if(m_pCoreSubmesh->getSpringCount() > 0)
   {
     enableInternalData();
+
+    // create the cloth solver of the spring system at the rest positions
+    CalCoreCloth *pCoreCloth = m_pCoreSubmesh->getCoreCloth();
+    if(pCoreCloth == 0) return false;
+
+    m_pCloth = new CalCloth();
+    if(m_pCloth == 0)
+    {
+      CalError::setLastError(CalError::MEMORY_ALLOCATION_FAILED, __FILE__, __LINE__, "CalSubmesh::create");
+      return false;
+    }
+
+    if(!m_pCloth->create(pCoreCloth, &m_vectorVertex[0]))
+    {
+      delete m_pCloth;
+      m_pCloth = 0;
+      return false;
+    }
   }
 
   return true;
@@ -177,9 +199,32 @@ bool CalSubmesh::create(CalCoreSubmesh *pCoreSubmesh, CalModel *pModel)
 
 void CalSubmesh::destroy()
 {
+  if(m_pCloth != 0)
+  {
+    m_pCloth->destroy();
+    delete m_pCloth;
+    m_pCloth = 0;
+  }
+
   m_pCoreSubmesh = 0;
 }
 
+ /*****************************************************************************/
+/** Provides access to the cloth.
+  *
+  * This function returns the cloth solver of the spring system of the
+  * submesh instance, for example to set its iteration count.
+  *
+  * @return One of the following values:
+  *         \li a pointer to the cloth
+  *         \li \b 0 if the submesh has no springs
+  *****************************************************************************/
+
+CalCloth *CalSubmesh::getCloth()
+{
+  return m_pCloth;
+}
+
  /*****************************************************************************/
 /** Provides access to the core submesh.
   *
@@ -217,14 +262,23 @@ int CalSubmesh::getFaceCount()
   *
   * @param pFaceBuffer A pointer to the user-provided buffer where the face
   *                    data is written to.
+  * @param offset The value added to every vertex index.
   *
   * @return The number of faces written to the buffer.
   *****************************************************************************/
 
 int CalSubmesh::getFaces(int *pFaceBuffer, int offset)
 {
-  // copy the face vector to the face buffer
-  int *src = (int*)&m_vectorFace[0];
+  // 16-bit faces are widened here, so the core submesh keeps only those
+  unsigned short *shortSrc = (unsigned short*)m_pCoreSubmesh->getLodShortFaces(m_lodLevelId);
+  if (shortSrc!=0) {
+    for (int i=0; i<m_faceCount*3; i++) pFaceBuffer[i]=shortSrc[i]+offset;
+    return m_faceCount;
+  }
+
+  // copy the shared faces of the lod level to the face buffer
+  int *src = (int*)m_pCoreSubmesh->getLodFaces(m_lodLevelId);
+  if (src==0) return 0;
   if (offset==0) {
     memcpy(pFaceBuffer, src, m_faceCount * sizeof(Face));
   } else {
@@ -233,19 +287,77 @@ int CalSubmesh::getFaces(int *pFaceBuffer, int offset)
   return m_faceCount;
 }
 
+ /*****************************************************************************/
+/** Provides access to the face data with 16-bit indices.
+  *
+  * This function returns the face data (vertex indices) of the submesh
+  * instance as 16-bit indices. The LOD setting of the submesh instance is
+  * taken into account. It works whether or not the core submesh stores short
+  * faces, as long as all indices plus the offset fit into 16 bits.
+  *
+  * @param pFaceBuffer A pointer to the user-provided buffer where the face
+  *                    data is written to.
+  * @param offset The value added to every vertex index.
+  *
+  * @return The number of faces written to the buffer, or 0 if the indices
+  *         do not fit into 16 bits.
+  *****************************************************************************/
+
+int CalSubmesh::getFaces(unsigned short *pFaceBuffer, int offset)
+{
+  if ((offset < 0) || (m_vertexCount + offset > Cal::SHORT_FACE_VERTEX_COUNT)) return 0;
+
+  unsigned short *shortSrc = (unsigned short*)m_pCoreSubmesh->getLodShortFaces(m_lodLevelId);
+  if (shortSrc!=0) {
+    if (offset==0) {
+      memcpy(pFaceBuffer, shortSrc, m_faceCount * sizeof(CalCoreSubmesh::ShortFace));
+    } else {
+      for (int i=0; i<m_faceCount*3; i++) pFaceBuffer[i]=(unsigned short)(shortSrc[i]+offset);
+    }
+    return m_faceCount;
+  }
+
+  // narrow the 32-bit faces of the lod level
+  int *src = (int*)m_pCoreSubmesh->getLodFaces(m_lodLevelId);
+  if (src==0) return 0;
+  for (int i=0; i<m_faceCount*3; i++) pFaceBuffer[i]=(unsigned short)(src[i]+offset);
+  return m_faceCount;
+}
+
  /*****************************************************************************/
 /** Provides access to the face data.
   *
   * This function returns the face data (vertex indices) of the submesh
   * instance. The LOD setting of the submesh instance is taken into account.
+  * The faces are shared by all instances of the core submesh and must not be
+  * modified.
   *
   * @return A pointer to a buffer containing the faces.  The data is
-  *         guaranteed good until you modify the submesh.
+  *         guaranteed good until you modify the core submesh.
   *****************************************************************************/
 
 int *CalSubmesh::getBufferedFaces()
 {
-  return (int*)&(m_vectorFace[0]);
+  return (int*)m_pCoreSubmesh->getLodFaces(m_lodLevelId);
+}
+
+ /*****************************************************************************/
+/** Provides access to the face data with 16-bit indices.
+  *
+  * This function returns the face data (vertex indices) of the submesh
+  * instance as 16-bit indices, if the core submesh stores short faces (see
+  * CalCoreSubmesh::enableShortFaces()). The LOD setting of the submesh
+  * instance is taken into account. The faces are shared by all instances of
+  * the core submesh and must not be modified.
+  *
+  * @return One of the following values:
+  *         \li a pointer to a buffer containing the faces
+  *         \li \b 0 if the core submesh does not store short faces
+  *****************************************************************************/
+
+unsigned short *CalSubmesh::getBufferedShortFaces()
+{
+  return (unsigned short*)m_pCoreSubmesh->getLodShortFaces(m_lodLevelId);
 }
 
  /*****************************************************************************/
@@ -386,154 +498,18 @@ int CalSubmesh::calculateTangentSpaces(int textureCoordinateId, float *pTangentB
 #include "calphysop.h"
 }
 
- /*****************************************************************************/
-/** Calculates the forces on each unbound vertex.
-  *
-  * This function calculates the forces on each unbound vertex of a specific
-  * submesh.
-  *
-  * @param deltaTime The elapsed time in seconds since the last calculation.
-  *****************************************************************************/
-
-void CalSubmesh::calculateSpringForces(float deltaTime)
-{
-  // get the physical property vector of the core submesh
-  std::vector<CalCoreSubmesh::PhysicalProperty>& vectorCorePhysicalProperty = m_pCoreSubmesh->getVectorPhysicalProperty();
-  
-  // loop through all the vertices
-  int vertexId;
-  for(vertexId = 0; vertexId < (int)m_vectorVertex.size(); vertexId++)
-  {
-    // get the physical property of the vertex
-    PhysicalProperty& physicalProperty = m_vectorPhysicalProperty[vertexId];
-
-    // get the physical property of the core vertex
-    CalCoreSubmesh::PhysicalProperty& corePhysicalProperty = vectorCorePhysicalProperty[vertexId];
-
-    // only take vertices with a weight > 0 into account
-    if(corePhysicalProperty.weight > 0.0f)
-    {
-      physicalProperty.force.set(0.0f, 0.5f, corePhysicalProperty.weight * -98.1f);
-    }
-  }
-}
-
- /*****************************************************************************/
-/** Calculates the vertices influenced by the spring system instance.
-  *
-  * This function calculates the vertices influenced by the spring system
-  * instance.
-  *
-  * @param deltaTime The elapsed time in seconds since the last calculation.
-  *****************************************************************************/
-
-void CalSubmesh::calculateSpringVertices(float deltaTime)
-{
-  // get the physical property vector of the core submesh
-  std::vector<CalCoreSubmesh::PhysicalProperty>& vectorCorePhysicalProperty = m_pCoreSubmesh->getVectorPhysicalProperty();
-
-  // loop through all the vertices
-  int vertexId;
-  for(vertexId = 0; vertexId < (int)m_vectorVertex.size(); vertexId++)
-  {
-    // get the vertex
-    CalVector& vertex = m_vectorVertex[vertexId];
-
-    // get the physical property of the vertex
-    CalSubmesh::PhysicalProperty& physicalProperty = m_vectorPhysicalProperty[vertexId];
-
-    // get the physical property of the core vertex
-    CalCoreSubmesh::PhysicalProperty& corePhysicalProperty = vectorCorePhysicalProperty[vertexId];
-
-    // store current position for later use
-    CalVector position;
-    position = physicalProperty.position;
-
-    // only take vertices with a weight > 0 into account
-    if(corePhysicalProperty.weight > 0.0f)
-    {
-      // do the Verlet step
-      physicalProperty.position += (position - physicalProperty.positionOld) * 0.99f + physicalProperty.force / corePhysicalProperty.weight * deltaTime * deltaTime;
-    }
-    else
-    {
-      physicalProperty.position = m_vectorVertex[vertexId];
-    }
-
-    // make the current position the old one
-    physicalProperty.positionOld = position;
-
-    // set the new position of the vertex
-    vertex = physicalProperty.position;
-
-    // clear the accumulated force on the vertex
-    physicalProperty.force.clear();
-  }
-
-  // get the spring vector of the core submesh
-  std::vector<CalCoreSubmesh::Spring>& vectorSpring = m_pCoreSubmesh->getVectorSpring();
-
-  // iterate a few times to relax the constraints
-  int iterationCount;
-#define ITERATION_COUNT 2
-  for(iterationCount = 0; iterationCount < ITERATION_COUNT; iterationCount++)
-  {
-    // loop through all the springs
-    std::vector<CalCoreSubmesh::Spring>::iterator iteratorSpring;
-    for(iteratorSpring = vectorSpring.begin(); iteratorSpring != vectorSpring.end(); ++iteratorSpring)
-    {
-      // get the spring
-      CalCoreSubmesh::Spring& spring = *iteratorSpring;
-
-      // compute the difference between the two spring vertices
-      CalVector distance;
-      distance = m_vectorVertex[spring.vertexId[1]] - m_vectorVertex[spring.vertexId[0]];
-
-      // get the current length of the spring
-      float length;
-      length = distance.length();
-
-      if(length > 0.0f)
-      {
-        float factor[2];
-        factor[0] = (length - spring.idleLength) / length;
-        factor[1] = factor[0];
-
-        if(vectorCorePhysicalProperty[spring.vertexId[0]].weight > 0.0f)
-        {
-          factor[0] /= 2.0f;
-          factor[1] /= 2.0f;
-        }
-        else
-        {
-          factor[0] = 0.0f;
-        }
-
-        if(vectorCorePhysicalProperty[spring.vertexId[1]].weight <= 0.0f)
-        {
-          factor[0] *= 2.0f;
-          factor[1] = 0.0f;
-        }
-
-        m_vectorVertex[spring.vertexId[0]] += distance * factor[0];
-        m_vectorPhysicalProperty[spring.vertexId[0]].position = m_vectorVertex[spring.vertexId[0]];
-
-        m_vectorVertex[spring.vertexId[1]] -= distance * factor[1];
-        m_vectorPhysicalProperty[spring.vertexId[1]].position = m_vectorVertex[spring.vertexId[1]];
-      }
-    }
-  }
-}
-
  /*****************************************************************************/
 /** Updates the spring system for the submesh.
+  *
+  * The time is added up until the next vertex update, where the cloth spends
+  * it in fixed steps (see CalCloth::update).
   *
   * @param t The amount of time to elapse for the spring system.
   *****************************************************************************/
 
 void CalSubmesh::updateSpringSystem(float t)
 {
-  m_springTime = t;
+  m_springTime += t;
 }
 
  /*****************************************************************************/
@@ -584,10 +560,9 @@ void CalSubmesh::updateVertices(void)
     }
   }
   
-  if (m_pCoreSubmesh->getSpringCount() > 0)
+  if (m_pCloth != 0)
   {
-    calculateSpringForces(m_springTime);
-    calculateSpringVertices(m_springTime);
+    m_pCloth->update(&m_vectorVertex[0], m_springTime);
     m_springTime = 0.0;
   }
 }
@@ -800,7 +775,7 @@ float *CalSubmesh::getBufferedTextureCoordinates(int mapId)
   }
 
   // copy the texture coordinate vector to the face buffer
-  return (float*)&(m_pCoreSubmesh->m_vectorvectorTextureCoordinate[mapId][0]);
+  return m_pCoreSubmesh->getTextureCoordinates(mapId);
 }
 
  /*****************************************************************************/
@@ -835,13 +810,29 @@ std::vector<CalSubmesh::TangentSpace>& CalSubmesh::getVectorTangentSpace(int tex
 /** Returns the physical property vector.
   *
   * This function returns the vector that contains all physical properties of
-  * the submesh instance.
+  * the submesh instance. The cloth solver keeps the state of the spring
+  * system itself, so the vector is filled from it on every call.
   *
   * @return A reference to the physical property vector.
   *****************************************************************************/
 
 std::vector<CalSubmesh::PhysicalProperty>& CalSubmesh::getVectorPhysicalProperty()
 {
+  if(m_pCloth != 0)
+  {
+    CalCoreCloth *pCoreCloth = m_pCloth->getCoreCloth();
+    const int *pVertexId = pCoreCloth->getVertexIds();
+
+    int slotId;
+    for(slotId = 0; slotId < pCoreCloth->getSlotCount(); slotId++)
+    {
+      PhysicalProperty& physicalProperty = m_vectorPhysicalProperty[pVertexId[slotId]];
+      m_pCloth->getPosition(slotId, physicalProperty.position);
+      m_pCloth->getOldPosition(slotId, physicalProperty.positionOld);
+      physicalProperty.force.clear();
+    }
+  }
+
   return m_vectorPhysicalProperty;
 }
 
@@ -888,63 +879,53 @@ bool CalSubmesh::hasInternalData()
   return m_bInternalData;
 }
 
+ /*****************************************************************************/
+/** Returns the LOD level ID.
+  *
+  * This function returns the ID of the precomputed LOD level of the core
+  * submesh that the submesh instance uses.
+  *
+  * @return The ID of the LOD level.
+  *****************************************************************************/
+
+int CalSubmesh::getLodLevelId()
+{
+  return m_lodLevelId;
+}
+
  /*****************************************************************************/
 /** Sets the LOD level.
   *
-  * This function sets the LOD level of the submesh instance.
+  * This function sets the LOD level of the submesh instance. The level is
+  * quantized to the closest precomputed LOD level of the core submesh, so
+  * that only the face and vertex counts change.
   *
   * @param lodLevel The LOD level in the range [0.0, 1.0].
   *****************************************************************************/
 
 void CalSubmesh::setLodLevel(float lodLevel)
 {
-  // clamp the lod level to [0.0, 1.0]
-  if(lodLevel < 0.0f) lodLevel = 0.0f;
-  if(lodLevel > 1.0f) lodLevel = 1.0f;
-
-  // get the lod count of the core submesh
-  int lodCount;
-  lodCount = m_pCoreSubmesh->getLodCount();
-
-  // calculate the target lod count
-  lodCount = (int)((1.0f - lodLevel) * lodCount);
-
-  // calculate the new number of vertices
-  m_vertexCount = m_pCoreSubmesh->getVertexCount() - lodCount;
-
-  // get face vector of the core submesh
-  std::vector<CalCoreSubmesh::Face>& vectorFace = m_pCoreSubmesh->getVectorFace();
-
-  // get face vector of the core submesh
-  std::vector<CalCoreSubmesh::LodControl>& vectorLodControl = m_pCoreSubmesh->getVectorLodControl();
-  
-  // calculate the new number of faces
-  m_faceCount = vectorFace.size();
+  setLodLevelId(m_pCoreSubmesh->getLodLevelId(lodLevel));
+}
 
-  int vertexId;
-  for(vertexId = vectorLodControl.size() - 1; vertexId >= m_vertexCount; vertexId--)
-  {
-    m_faceCount -= vectorLodControl[vertexId].faceCollapseCount;
-  }
-  
-  // fill the face vector with the collapsed vertex ids
-  int faceId;
-  for(faceId = 0; faceId < m_faceCount; faceId++)
-  {
-    int vertexId;
-    for(vertexId = 0; vertexId < 3; vertexId++)
-    {
-      // get the vertex id
-      int collapsedVertexId;
-      collapsedVertexId = vectorFace[faceId].vertexId[vertexId];
+ /*****************************************************************************/
+/** Sets the LOD level ID.
+  *
+  * This function selects a precomputed LOD level of the core submesh for the
+  * submesh instance.
+  *
+  * @param lodLevelId The ID of the LOD level.
+  *****************************************************************************/
 
-      // collapse the vertex id until it fits into the current lod level
-      while(collapsedVertexId >= m_vertexCount) collapsedVertexId = vectorLodControl[collapsedVertexId].collapseId;
+void CalSubmesh::setLodLevelId(int lodLevelId)
+{
+  // clamp the lod level id to the precomputed levels
+  if(lodLevelId < 0) lodLevelId = 0;
+  if(lodLevelId >= m_pCoreSubmesh->getLodLevelCount()) lodLevelId = m_pCoreSubmesh->getLodLevelCount() - 1;
 
-      // store the collapse vertex id in the submesh face vector
-      m_vectorFace[faceId].vertexId[vertexId] = collapsedVertexId;
-    }
-  }
+  m_lodLevelId = lodLevelId;
+  m_vertexCount = m_pCoreSubmesh->getLodVertexCount(lodLevelId);
+  m_faceCount = m_pCoreSubmesh->getLodFaceCount(lodLevelId);
 }
 
 //****************************************************************************//
@@ -24,6 +24,7 @@
 
 class CalCoreSubmesh;
 class CalModel;
+class CalCloth;
 
 //****************************************************************************//
 // Class declaration                                                          //
@@ -67,16 +68,15 @@ protected:
   std::vector<CalVector> m_vectorVertex;
   std::vector<CalVector> m_vectorNormal;
   std::vector<std::vector<TangentSpace> > m_vectorvectorTangentSpace;
-  std::vector<Face> m_vectorFace;
   std::vector<PhysicalProperty> m_vectorPhysicalProperty;
+  int m_lodLevelId;
   int m_vertexCount;
   int m_faceCount;
   bool m_bInternalData;
   float m_springTime;
+  CalCloth *m_pCloth;
   
   void updateVertices(void);
-  void calculateSpringForces(float deltaTime);
-  void calculateSpringVertices(float deltaTime);
 
 // Because of Win32 DLL Heap Weirdness, Constructors/Destructor must be private. Use Alloc and Free.
 
@@ -88,6 +88,7 @@ protected:
  public:
   bool create(CalCoreSubmesh *pCoreSubmesh, CalModel *pModel);
   void destroy();
+  CalCloth *getCloth();
   CalCoreSubmesh *getCoreSubmesh();
   int getVertexCount();
   int getFaceCount();
@@ -106,14 +107,18 @@ protected:
   int calculateVNT(float *pVertexBuffer, float *pNormalBuffer, int channel, float *pTangentBuffer);
 
   int   *getBufferedFaces();
+  unsigned short *getBufferedShortFaces();
   float *getBufferedVertices();
   float *getBufferedNormals();
   float *getBufferedTangentSpaces(int mapId);
   float *getBufferedTextureCoordinates(int mapId);
 
   int getFaces(int *pFaceBuffer, int offset);
+  int getFaces(unsigned short *pFaceBuffer, int offset);
   void enableInternalData(void);
+  int getLodLevelId();
   void setLodLevel(float lodLevel);
+  void setLodLevelId(int lodLevelId);
 };
 
 #endif
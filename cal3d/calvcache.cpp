@@ -0,0 +1,357 @@
+//****************************************************************************//
+// vcache.cpp                                                                 //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calvcache.h"
+#include "calerror.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Weights of the vertex score, as given by Tom Forsyth.
+
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_FACE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+// Vertices with more faces left than this score the same.
+
+static const int MAX_SCORED_FACE_COUNT = 32;
+
+// Finds the number of vertices referenced by a face array, or -1 if a face
+// has a negative vertex id.
+
+static int getReferencedVertexCount(const CalCoreSubmesh::Face *pFace, int faceCount)
+{
+  int vertexCount = 0;
+
+  int faceId;
+  for(faceId = 0; faceId < faceCount; faceId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      int vertexId = pFace[faceId].vertexId[cornerId];
+      if(vertexId < 0) return -1;
+      if(vertexId >= vertexCount) vertexCount = vertexId + 1;
+    }
+  }
+
+  return vertexCount;
+}
+
+ /*****************************************************************************/
+/** Returns the average cache miss ratio of a face array.
+  *
+  * This function simulates a FIFO vertex cache while the faces are drawn in
+  * order, and returns the number of cache misses per face. It lies between
+  * 0.5 for an ideal order of a large closed mesh and 3.0 for the worst order.
+  *
+  * @param pFace A pointer to the faces.
+  * @param faceCount The number of faces.
+  * @param cacheSize The number of vertices in the cache.
+  *
+  * @return The average cache miss ratio.
+  *****************************************************************************/
+
+float CalVertexCache::getAcmr(const CalCoreSubmesh::Face *pFace, int faceCount, int cacheSize)
+{
+  if((faceCount <= 0) || (cacheSize <= 0)) return 0.0f;
+
+  int vertexCount = getReferencedVertexCount(pFace, faceCount);
+  if(vertexCount < 0) return 0.0f;
+
+  // a vertex is in the cache if fewer than cacheSize misses followed its own
+  std::vector<int> vectorMissId(vertexCount, -1);
+  int missCount = 0;
+
+  int faceId;
+  for(faceId = 0; faceId < faceCount; faceId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      int vertexId = pFace[faceId].vertexId[cornerId];
+      if((vectorMissId[vertexId] >= 0) && (missCount - vectorMissId[vertexId] < cacheSize)) continue;
+
+      missCount++;
+      vectorMissId[vertexId] = missCount;
+    }
+  }
+
+  return (float)missCount / (float)faceCount;
+}
+
+ /*****************************************************************************/
+/** Returns the score of a vertex.
+  *
+  * This function returns how much drawing a face of a vertex is favoured. It
+  * grows with the position of the vertex in the cache, and with the number of
+  * faces the vertex has left, so that lone faces are not left behind.
+  *
+  * @param cachePosition The position in the cache, or -1 if not cached.
+  * @param faceCount The number of faces left to draw.
+  *
+  * @return The score of the vertex.
+  *****************************************************************************/
+
+float CalVertexCache::getVertexScore(int cachePosition, int faceCount)
+{
+  if(faceCount <= 0) return -1.0f;
+
+  float score = 0.0f;
+  if(cachePosition >= 0)
+  {
+    // the vertices of the last face score the same, whatever their order
+    if(cachePosition < 3)
+    {
+      score = LAST_FACE_SCORE;
+    }
+    else
+    {
+      float scaler = 1.0f / (float)(Cal::VERTEX_CACHE_SIZE - 3);
+      score = powf(1.0f - (float)(cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+    }
+  }
+
+  score += VALENCE_BOOST_SCALE * powf((float)faceCount, -VALENCE_BOOST_POWER);
+
+  return score;
+}
+
+ /*****************************************************************************/
+/** Returns the vertex cache order of faces.
+  *
+  * This function finds the order in which a face array is drawn with few
+  * vertex cache misses, without changing the faces.
+  *
+  * @param pFace A pointer to the faces.
+  * @param faceCount The number of faces.
+  * @param vectorFaceId A vector to store the face IDs in drawing order in.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalVertexCache::getFaceOrder(const CalCoreSubmesh::Face *pFace, int faceCount, std::vector<int>& vectorFaceId)
+{
+  vectorFaceId.clear();
+  if(faceCount <= 0) return true;
+
+  int vertexCount = getReferencedVertexCount(pFace, faceCount);
+  if(vertexCount < 0)
+  {
+    CalError::setLastError(CalError::INVALID_HANDLE, __FILE__, __LINE__);
+    return false;
+  }
+
+  // list the faces of every vertex; the faces left to draw come first
+  std::vector<int> vectorFirstFace(vertexCount + 1, 0);
+  std::vector<int> vectorActiveFaceCount(vertexCount, 0);
+
+  int faceId;
+  for(faceId = 0; faceId < faceCount; faceId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      vectorActiveFaceCount[pFace[faceId].vertexId[cornerId]]++;
+    }
+  }
+
+  int vertexId;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    vectorFirstFace[vertexId + 1] = vectorFirstFace[vertexId] + vectorActiveFaceCount[vertexId];
+    vectorActiveFaceCount[vertexId] = 0;
+  }
+
+  std::vector<int> vectorVertexFace(faceCount * 3);
+  for(faceId = 0; faceId < faceCount; faceId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      vertexId = pFace[faceId].vertexId[cornerId];
+      vectorVertexFace[vectorFirstFace[vertexId] + vectorActiveFaceCount[vertexId]++] = faceId;
+    }
+  }
+
+  // tabulate the vertex scores by cache position and faces left
+  float scoreTable[Cal::VERTEX_CACHE_SIZE + 1][MAX_SCORED_FACE_COUNT + 1];
+
+  int cachePosition;
+  for(cachePosition = -1; cachePosition < Cal::VERTEX_CACHE_SIZE; cachePosition++)
+  {
+    int activeFaceCount;
+    for(activeFaceCount = 0; activeFaceCount <= MAX_SCORED_FACE_COUNT; activeFaceCount++)
+    {
+      scoreTable[cachePosition + 1][activeFaceCount] = getVertexScore(cachePosition, activeFaceCount);
+    }
+  }
+
+  // score all vertices
+  std::vector<int> vectorCachePosition(vertexCount, -1);
+  std::vector<float> vectorVertexScore(vertexCount);
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    vectorVertexScore[vertexId] = scoreTable[0][std::min(vectorActiveFaceCount[vertexId], MAX_SCORED_FACE_COUNT)];
+  }
+
+  std::vector<bool> vectorFaceDrawn(faceCount, false);
+
+  // draw the faces one by one
+  vectorFaceId.reserve(faceCount);
+
+  int cache[Cal::VERTEX_CACHE_SIZE + 3];
+  int cacheCount = 0;
+
+  int bestFaceId = -1;
+  int nextFaceId = 0;
+
+  while((int)vectorFaceId.size() < faceCount)
+  {
+    // without a candidate next to the cache, start at the next face in order
+    if(bestFaceId < 0)
+    {
+      while(vectorFaceDrawn[nextFaceId]) nextFaceId++;
+      bestFaceId = nextFaceId;
+    }
+
+    const CalCoreSubmesh::Face& bestFace = pFace[bestFaceId];
+    vectorFaceId.push_back(bestFaceId);
+    vectorFaceDrawn[bestFaceId] = true;
+
+    // move the vertices of the face to the front of the cache
+    int newCache[Cal::VERTEX_CACHE_SIZE + 3];
+    int newCacheCount = 0;
+
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      vertexId = bestFace.vertexId[cornerId];
+
+      // remove the face from the faces left to draw of the vertex
+      int *pVertexFace = &vectorVertexFace[vectorFirstFace[vertexId]];
+      int activeFaceCount = vectorActiveFaceCount[vertexId];
+
+      int vertexFaceId;
+      for(vertexFaceId = 0; vertexFaceId < activeFaceCount; vertexFaceId++)
+      {
+        if(pVertexFace[vertexFaceId] == bestFaceId)
+        {
+          pVertexFace[vertexFaceId] = pVertexFace[activeFaceCount - 1];
+          pVertexFace[activeFaceCount - 1] = bestFaceId;
+          vectorActiveFaceCount[vertexId]--;
+          break;
+        }
+      }
+
+      int cacheId;
+      for(cacheId = 0; (cacheId < newCacheCount) && (newCache[cacheId] != vertexId); cacheId++);
+      if(cacheId == newCacheCount) newCache[newCacheCount++] = vertexId;
+    }
+
+    int cacheId;
+    for(cacheId = 0; cacheId < cacheCount; cacheId++)
+    {
+      vertexId = cache[cacheId];
+      if((vertexId != bestFace.vertexId[0]) && (vertexId != bestFace.vertexId[1]) && (vertexId != bestFace.vertexId[2]))
+      {
+        newCache[newCacheCount++] = vertexId;
+      }
+    }
+
+    // rescore the vertices that moved, including the ones that dropped out
+    for(cacheId = 0; cacheId < newCacheCount; cacheId++)
+    {
+      vertexId = newCache[cacheId];
+      vectorCachePosition[vertexId] = (cacheId < Cal::VERTEX_CACHE_SIZE) ? cacheId : -1;
+      vectorVertexScore[vertexId] = scoreTable[vectorCachePosition[vertexId] + 1][std::min(vectorActiveFaceCount[vertexId], MAX_SCORED_FACE_COUNT)];
+    }
+
+    // score their faces and pick the best one as the next face
+    bestFaceId = -1;
+    float bestScore = -1.0f;
+
+    for(cacheId = 0; cacheId < newCacheCount; cacheId++)
+    {
+      vertexId = newCache[cacheId];
+
+      const int *pVertexFace = &vectorVertexFace[vectorFirstFace[vertexId]];
+      int activeFaceCount = vectorActiveFaceCount[vertexId];
+
+      int vertexFaceId;
+      for(vertexFaceId = 0; vertexFaceId < activeFaceCount; vertexFaceId++)
+      {
+        faceId = pVertexFace[vertexFaceId];
+
+        const CalCoreSubmesh::Face& face = pFace[faceId];
+        float score = vectorVertexScore[face.vertexId[0]] + vectorVertexScore[face.vertexId[1]] + vectorVertexScore[face.vertexId[2]];
+
+        if(score > bestScore)
+        {
+          bestScore = score;
+          bestFaceId = faceId;
+        }
+      }
+    }
+
+    cacheCount = (newCacheCount < Cal::VERTEX_CACHE_SIZE) ? newCacheCount : Cal::VERTEX_CACHE_SIZE;
+    for(cacheId = 0; cacheId < cacheCount; cacheId++)
+    {
+      cache[cacheId] = newCache[cacheId];
+    }
+  }
+
+  return true;
+}
+
+ /*****************************************************************************/
+/** Sorts faces for the vertex cache.
+  *
+  * This function reorders a face array so that it is drawn with few vertex
+  * cache misses. Only the order of the faces changes, the faces themselves
+  * and the winding of their vertices stay the same.
+  *
+  * @param pFace A pointer to the faces.
+  * @param faceCount The number of faces.
+  *
+  * @return One of the following values:
+  *         \li \b true if successful
+  *         \li \b false if an error happend
+  *****************************************************************************/
+
+bool CalVertexCache::sortFaces(CalCoreSubmesh::Face *pFace, int faceCount)
+{
+  std::vector<int> vectorFaceId;
+  if(!getFaceOrder(pFace, faceCount, vectorFaceId)) return false;
+
+  std::vector<CalCoreSubmesh::Face> vectorFace(pFace, pFace + faceCount);
+
+  int faceId;
+  for(faceId = 0; faceId < faceCount; faceId++)
+  {
+    pFace[faceId] = vectorFace[vectorFaceId[faceId]];
+  }
+
+  return true;
+}
+
+//****************************************************************************//
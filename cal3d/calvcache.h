@@ -0,0 +1,50 @@
+//****************************************************************************//
+// vcache.h                                                                   //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//****************************************************************************//
+// This library is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU Lesser General Public License as published by   //
+// the Free Software Foundation; either version 2.1 of the License, or (at    //
+// your option) any later version.                                            //
+//****************************************************************************//
+
+#ifndef CAL_VCACHE_H
+#define CAL_VCACHE_H
+
+//****************************************************************************//
+// Includes                                                                   //
+//****************************************************************************//
+
+#include "calglobal.h"
+#include "calcoresub.h"
+
+//****************************************************************************//
+// Class declaration                                                          //
+//****************************************************************************//
+
+ /*****************************************************************************/
+/** The vertex cache class.
+  *
+  * The vertex cache class orders faces for the post-transform vertex cache of
+  * the graphics hardware, using Tom Forsyth's linear-speed vertex cache
+  * optimisation: faces whose vertices are in a simulated LRU cache, or whose
+  * vertices have few faces left, are emitted first. It also measures the
+  * average cache miss ratio (ACMR), the number of transformed vertices per
+  * face, of a face array.
+  *****************************************************************************/
+
+class CAL3D_API CalVertexCache
+{
+// member functions
+public:
+  static float getAcmr(const CalCoreSubmesh::Face *pFace, int faceCount, int cacheSize = Cal::VERTEX_CACHE_SIZE);
+  static bool getFaceOrder(const CalCoreSubmesh::Face *pFace, int faceCount, std::vector<int>& vectorFaceId);
+  static bool sortFaces(CalCoreSubmesh::Face *pFace, int faceCount);
+
+protected:
+  static float getVertexScore(int cachePosition, int faceCount);
+};
+
+#endif
+
+//****************************************************************************//
@@ -20,6 +20,9 @@
 #include "calerror.h"
 #include "calplatform.h"
 
+// size of the read-ahead buffer
+static const int STREAM_BUFFER_SIZE = 65536;
+
  /*****************************************************************************/
 /** Constructs a stream source instance from an existing istream.
   *
@@ -30,24 +33,57 @@
   *****************************************************************************/
 
 CalStreamSource::CalStreamSource(std::istream& inputStream)
-  : mInputStream(&inputStream)
+  : mInputStream(&inputStream), mBufferPos(0), mBufferEnd(0), mOk(true)
 {
+   mBuffer = new char[STREAM_BUFFER_SIZE];
 }
 
 
 /**
  * Destruct the CalStreamSource. Note that input stream is not closed here;
- * this should be handled externally.
+ * this should be handled externally. The bytes that were read ahead but not
+ * consumed are given back to the stream by seeking backwards, so that it is
+ * left right after the loaded data.
  */
 
 CalStreamSource::~CalStreamSource()
 {
+   int unused = mBufferEnd - mBufferPos;
+   if (unused > 0)
+   {
+      mInputStream->clear();
+      mInputStream->seekg(-unused, std::ios::cur);
+   }
+
+   delete [] mBuffer;
+}
+
+ /*****************************************************************************/
+/** Fills the read-ahead buffer.
+  *
+  * This function reads the next chunk of the stream into the buffer. It must
+  * only be called when the buffer is used up.
+  *
+  * @return One of the following values:
+  *         \li \b true if at least one byte was read
+  *         \li \b false if the stream is at its end or failed
+  *****************************************************************************/
+
+bool CalStreamSource::fill()
+{
+   mInputStream->read(mBuffer, STREAM_BUFFER_SIZE);
+
+   mBufferPos = 0;
+   mBufferEnd = (int)mInputStream->gcount();
+
+   return mBufferEnd > 0;
 }
 
  /*****************************************************************************/
 /** Checks whether the data source is in a good state.
   *
-  * This function checks if the istream can be used.
+  * This function checks if the istream can be used, and that no read has
+  * run past its end.
   *
   * @return One of the following values:
   *         \li \b true if data source is in a good state
@@ -56,7 +92,7 @@ CalStreamSource::~CalStreamSource()
 
 bool CalStreamSource::ok() const
 {
-   if (!mInputStream)
+   if (!mInputStream || !mOk)
       return false;
 
    return true;
@@ -91,8 +127,46 @@ bool CalStreamSource::readBytes(void* pBuffer, int length)
    //Check that the stream is usable
    if (!ok()) return false;
 
-   return CalPlatform::readBytes( *mInputStream, pBuffer, length );
+   if (length < 0)
+   {
+      mOk = false;
+      return false;
+   }
+
+   char* pDest = (char*)pBuffer;
+   while (length > 0)
+   {
+      if (mBufferPos == mBufferEnd)
+      {
+         // large blocks go straight into the destination
+         if (length >= STREAM_BUFFER_SIZE)
+         {
+            mInputStream->read(pDest, length);
+            if (mInputStream->gcount() != length)
+            {
+               mOk = false;
+               return false;
+            }
+            return true;
+         }
+
+         if (!fill())
+         {
+            mOk = false;
+            return false;
+         }
+      }
+
+      int count = mBufferEnd - mBufferPos;
+      if (count > length) count = length;
+
+      memcpy(pDest, mBuffer + mBufferPos, count);
+      mBufferPos += count;
+      pDest += count;
+      length -= count;
+   }
 
+   return true;
 }
 
  /*****************************************************************************/
@@ -109,10 +183,13 @@ bool CalStreamSource::readBytes(void* pBuffer, int length)
 
 bool CalStreamSource::readFloat(float& value)
 {
-   //Check that the stream is usable
-   if (!ok()) return false;
+   if (!readBytes(&value, 4)) return false;
 
-   return CalPlatform::readFloat( *mInputStream, value );
+#ifdef CAL3D_BIG_ENDIAN
+   CalPlatform::swapWords(&value, 1);
+#endif
+
+   return true;
 }
 
  /*****************************************************************************/
@@ -129,10 +206,13 @@ bool CalStreamSource::readFloat(float& value)
 
 bool CalStreamSource::readInteger(int& value)
 {
-   //Check that the stream is usable
-   if (!ok()) return false;
+   if (!readBytes(&value, 4)) return false;
+
+#ifdef CAL3D_BIG_ENDIAN
+   CalPlatform::swapWords(&value, 1);
+#endif
 
-   return CalPlatform::readInteger( *mInputStream, value );
+   return true;
 }
 
  /*****************************************************************************/
@@ -149,8 +229,21 @@ bool CalStreamSource::readInteger(int& value)
 
 bool CalStreamSource::readString(std::string& strValue)
 {
-   //Check that the stream is usable
-   if (!ok()) return false;
+   // get the string length
+   int length;
+   if (!readInteger(length)) return false;
+
+   if (length < 0)
+   {
+      mOk = false;
+      return false;
+   }
 
-   return CalPlatform::readString( *mInputStream, strValue );
+   // read the string, up to its null-terminator
+   std::string strBuffer(length, '\0');
+   if (length > 0 && !readBytes(&strBuffer[0], length)) return false;
+
+   strValue.assign(strBuffer.c_str());
+
+   return true;
 }
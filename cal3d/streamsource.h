@@ -29,6 +29,11 @@
  *
  * This is an object designed to represent a source of Cal3d data as coming from
  * a standard input stream.
+ *
+ * The stream is read in large chunks into an internal buffer, and the single
+ * fields are served from there. The stream is therefore read ahead of the data
+ * that was consumed; the destructor seeks back over the unused bytes where the
+ * stream supports it.
  */
 
 
@@ -47,10 +52,17 @@ public:
 
 protected:
 
+   bool fill();
+
    std::istream* mInputStream;
+   char* mBuffer;
+   int mBufferPos;
+   int mBufferEnd;
+   bool mOk;
 
 private:
    CalStreamSource(); //Can't use this
+   CalStreamSource(const CalStreamSource&); //Can't copy the buffer
 };
 
 #endif
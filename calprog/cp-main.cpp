@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------//
+// main.cpp                                                                   //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//----------------------------------------------------------------------------//
+// This program is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU General Public License as published by the Free //
+// Software Foundation; either version 2 of the License, or (at your option)  //
+// any later version.                                                         //
+//----------------------------------------------------------------------------//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//----------------------------------------------------------------------------//
+// Includes                                                                   //
+//----------------------------------------------------------------------------//
+
+#include "cp-global.h"
+#include "cp-progmesh.h"
+
+//----------------------------------------------------------------------------//
+// Print the usage information                                                //
+//----------------------------------------------------------------------------//
+
+static void printUsage()
+{
+  std::cout << "Usage: calprog [options] input.cdf output.cdf" << std::endl;
+  std::cout << "       calprog [options] --skeleton input.csf input.cmf output.cmf" << std::endl;
+  std::cout << std::endl;
+  std::cout << "Generates the progressive mesh LOD data of every submesh, and optionally" << std::endl;
+  std::cout << "sorts it for the vertex cache, reporting the average cache miss ratio." << std::endl;
+  std::cout << "An output file ending in .cbf is saved as a binary model file." << std::endl;
+  std::cout << std::endl;
+  std::cout << "  --ratio r            fraction of faces left at the lowest LOD (0.1)" << std::endl;
+  std::cout << "  --max-error e        stop at this error, in mean edge lengths (none)" << std::endl;
+  std::cout << "  --normal-weight w    cost of normal differences (1.0)" << std::endl;
+  std::cout << "  --influence-weight w cost of bone influence differences (1.0)" << std::endl;
+  std::cout << "  --boundary-weight w  cost of moving open borders (10.0)" << std::endl;
+  std::cout << "  --vertex-cache       sort faces and vertices for the vertex cache" << std::endl;
+  std::cout << "  --no-lod             keep the LOD data of the input file" << std::endl;
+}
+
+//----------------------------------------------------------------------------//
+// Check if a file name ends with an extension                                //
+//----------------------------------------------------------------------------//
+
+static bool hasExtension(const std::string& strFilename, const std::string& strExtension)
+{
+  if(strFilename.size() < strExtension.size()) return false;
+
+  std::string strEnd = strFilename.substr(strFilename.size() - strExtension.size());
+
+  unsigned int charId;
+  for(charId = 0; charId < strEnd.size(); charId++)
+  {
+    if(tolower(strEnd[charId]) != strExtension[charId]) return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Get the average cache miss ratio of the full level of a submesh            //
+//----------------------------------------------------------------------------//
+
+static float getAcmr(CalCoreSubmesh *pCoreSubmesh)
+{
+  int lodLevelId = pCoreSubmesh->getLodLevelCount() - 1;
+
+  return CalVertexCache::getAcmr(pCoreSubmesh->getLodFaces(lodLevelId), pCoreSubmesh->getLodFaceCount(lodLevelId));
+}
+
+//----------------------------------------------------------------------------//
+// Main entry point of the application                                        //
+//----------------------------------------------------------------------------//
+
+int main(int argc, char *argv[])
+{
+  ProgressiveMesh progressiveMesh;
+  bool bLod = true;
+  bool bVertexCache = false;
+  std::string strSkeletonFilename;
+  std::vector<std::string> vectorFilename;
+
+  // parse the command line arguments
+  int arg;
+  for(arg = 1; arg < argc; arg++)
+  {
+    if((strcmp(argv[arg], "--ratio") == 0) && (argc - arg > 1)) progressiveMesh.setRatio(atof(argv[++arg]));
+    else if((strcmp(argv[arg], "--max-error") == 0) && (argc - arg > 1)) progressiveMesh.setMaxError(atof(argv[++arg]));
+    else if((strcmp(argv[arg], "--normal-weight") == 0) && (argc - arg > 1)) progressiveMesh.setNormalWeight(atof(argv[++arg]));
+    else if((strcmp(argv[arg], "--influence-weight") == 0) && (argc - arg > 1)) progressiveMesh.setInfluenceWeight(atof(argv[++arg]));
+    else if((strcmp(argv[arg], "--boundary-weight") == 0) && (argc - arg > 1)) progressiveMesh.setBoundaryWeight(atof(argv[++arg]));
+    else if(strcmp(argv[arg], "--vertex-cache") == 0) bVertexCache = true;
+    else if(strcmp(argv[arg], "--no-lod") == 0) bLod = false;
+    else if((strcmp(argv[arg], "--skeleton") == 0) && (argc - arg > 1)) strSkeletonFilename = argv[++arg];
+    else if(strncmp(argv[arg], "--", 2) == 0)
+    {
+      printUsage();
+      return -1;
+    }
+    else vectorFilename.push_back(argv[arg]);
+  }
+
+  if(vectorFilename.size() != 2)
+  {
+    printUsage();
+    return -1;
+  }
+
+  // load the core model
+  CalCoreModel *pCoreModel = CalCoreModel::Alloc();
+  if(!pCoreModel->create("calprog"))
+  {
+    CalError::printLastError();
+    return -1;
+  }
+
+  CalLoader loader;
+  bool bLoaded;
+  if(!strSkeletonFilename.empty()) bLoaded = loader.loadCoreModel(pCoreModel, strSkeletonFilename, vectorFilename[0]);
+  else if(hasExtension(vectorFilename[0], ".cbf")) bLoaded = loader.loadBinaryCoreModel(pCoreModel, vectorFilename[0]);
+  else bLoaded = loader.loadCoreModel(pCoreModel, vectorFilename[0]);
+
+  if(!bLoaded)
+  {
+    std::cerr << "Could not load " << vectorFilename[0] << ":" << std::endl;
+    CalError::printLastError();
+    return -1;
+  }
+
+  // generate the LOD data of all submeshes, then sort them
+  int submeshId;
+  for(submeshId = 0; submeshId < pCoreModel->getCoreSubmeshCount(); submeshId++)
+  {
+    CalCoreSubmesh *pCoreSubmesh = pCoreModel->getCoreSubmesh(submeshId);
+
+    std::cout << "Submesh " << submeshId << ": " << pCoreSubmesh->getVertexCount() << " vertices";
+
+    if(bLod)
+    {
+      int faceCount = pCoreSubmesh->getFaceCount();
+      if(!progressiveMesh.build(pCoreSubmesh))
+      {
+        std::cout << std::endl;
+        std::cerr << "Could not build the progressive mesh of submesh " << submeshId << "." << std::endl;
+        return -1;
+      }
+
+      std::cout << ", " << progressiveMesh.getCollapseCount() << " collapses, "
+                << faceCount << " -> " << progressiveMesh.getMinFaceCount() << " faces";
+    }
+
+    if(bVertexCache)
+    {
+      float acmr = getAcmr(pCoreSubmesh);
+      if(!pCoreSubmesh->optimizeVertexCache())
+      {
+        std::cout << std::endl;
+        std::cerr << "Could not sort submesh " << submeshId << " for the vertex cache:" << std::endl;
+        CalError::printLastError();
+        return -1;
+      }
+
+      std::cout << ", ACMR " << acmr << " -> " << getAcmr(pCoreSubmesh);
+    }
+
+    std::cout << std::endl;
+  }
+
+  // save the core model
+  CalSaver saver;
+  bool bSaved;
+  if(!strSkeletonFilename.empty()) bSaved = saver.saveCoreMesh(vectorFilename[1], pCoreModel);
+  else if(hasExtension(vectorFilename[1], ".cbf")) bSaved = saver.saveBinaryCoreModel(vectorFilename[1], pCoreModel);
+  else bSaved = saver.saveCoreModel(vectorFilename[1], pCoreModel);
+
+  if(!bSaved)
+  {
+    std::cerr << "Could not save " << vectorFilename[1] << ":" << std::endl;
+    CalError::printLastError();
+    return -1;
+  }
+
+  pCoreModel->destroy();
+  CalCoreModel::Free(pCoreModel);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------//
@@ -0,0 +1,797 @@
+//----------------------------------------------------------------------------//
+// progmesh.cpp                                                               //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//----------------------------------------------------------------------------//
+// This program is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU General Public License as published by the Free //
+// Software Foundation; either version 2 of the License, or (at your option)  //
+// any later version.                                                         //
+//----------------------------------------------------------------------------//
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+//----------------------------------------------------------------------------//
+// Includes                                                                   //
+//----------------------------------------------------------------------------//
+
+#include "cp-progmesh.h"
+
+//----------------------------------------------------------------------------//
+// Constructors                                                               //
+//----------------------------------------------------------------------------//
+
+ProgressiveMesh::ProgressiveMesh()
+{
+  m_pCoreSubmesh = 0;
+  m_ratio = 0.1f;
+  m_maxError = 0.0f;
+  m_normalWeight = 1.0f;
+  m_influenceWeight = 1.0f;
+  m_boundaryWeight = 10.0f;
+  m_scale = 1.0;
+  m_faceCount = 0;
+}
+
+//----------------------------------------------------------------------------//
+// Destructor                                                                 //
+//----------------------------------------------------------------------------//
+
+ProgressiveMesh::~ProgressiveMesh()
+{
+}
+
+//----------------------------------------------------------------------------//
+// Add the quadric of a plane, weighted, to a quadric                         //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::addPlane(Quadric& quadric, const CalVector& normal, float d, double weight)
+{
+  double a = normal.x, b = normal.y, c = normal.z;
+
+  quadric.a[0] += weight * a * a;
+  quadric.a[1] += weight * a * b;
+  quadric.a[2] += weight * a * c;
+  quadric.a[3] += weight * a * d;
+  quadric.a[4] += weight * b * b;
+  quadric.a[5] += weight * b * c;
+  quadric.a[6] += weight * b * d;
+  quadric.a[7] += weight * c * c;
+  quadric.a[8] += weight * c * d;
+  quadric.a[9] += weight * d * d;
+}
+
+//----------------------------------------------------------------------------//
+// Write the collapse sequence into the core submesh                          //
+//----------------------------------------------------------------------------//
+
+bool ProgressiveMesh::apply()
+{
+  const int vertexCount = m_vectorPosition.size();
+  const int collapseCount = m_vectorCollapseVertexId.size();
+
+  // vertices that are never collapsed keep their order, the others are
+  // placed at the end in reverse collapse order
+  std::vector<int> vectorNewVertexId(vertexCount, -1);
+
+  int collapseId;
+  for(collapseId = 0; collapseId < collapseCount; collapseId++)
+  {
+    vectorNewVertexId[m_vectorCollapseVertexId[collapseId]] = vertexCount - 1 - collapseId;
+  }
+
+  int nextVertexId = 0;
+  int vertexId;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    if(vectorNewVertexId[vertexId] == -1) vectorNewVertexId[vertexId] = nextVertexId++;
+  }
+
+  // the remaining faces come first, then the faces removed by the latest
+  // collapse, down to the faces removed by the first collapse
+  std::vector<CalCoreSubmesh::Face>& vectorFace = m_pCoreSubmesh->getVectorFace();
+  std::vector<CalCoreSubmesh::Face> vectorNewFace;
+  vectorNewFace.reserve(vectorFace.size());
+
+  int faceId;
+  for(faceId = 0; faceId < (int)vectorFace.size(); faceId++)
+  {
+    if(m_vectorFaceAlive[faceId]) vectorNewFace.push_back(vectorFace[faceId]);
+  }
+
+  for(collapseId = collapseCount - 1; collapseId >= 0; collapseId--)
+  {
+    std::vector<int>& vectorRemovedFace = m_vectorvectorRemovedFace[m_vectorCollapseVertexId[collapseId]];
+    for(faceId = 0; faceId < (int)vectorRemovedFace.size(); faceId++)
+    {
+      vectorNewFace.push_back(vectorFace[vectorRemovedFace[faceId]]);
+    }
+  }
+
+  if(vectorNewFace.size() != vectorFace.size())
+  {
+    std::cerr << "Face order mismatch." << std::endl;
+    return false;
+  }
+
+  vectorFace.swap(vectorNewFace);
+
+  // store the collapse information in the old vertex numbering
+  std::vector<CalCoreSubmesh::LodControl>& vectorLodControl = m_pCoreSubmesh->getVectorLodControl();
+  vectorLodControl.resize(vertexCount);
+
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    vectorLodControl[vertexId].faceCollapseCount = 0;
+    vectorLodControl[vertexId].collapseId = vertexId;
+  }
+
+  for(collapseId = 0; collapseId < collapseCount; collapseId++)
+  {
+    int collapseVertexId = m_vectorCollapseVertexId[collapseId];
+    vectorLodControl[collapseVertexId].faceCollapseCount = m_vectorvectorRemovedFace[collapseVertexId].size();
+    vectorLodControl[collapseVertexId].collapseId = m_vectorCollapseTargetId[collapseId];
+  }
+
+  // renumber everything, then publish the number of collapses
+  if(!m_pCoreSubmesh->reorderVertices(vectorNewVertexId))
+  {
+    CalError::printLastError();
+    return false;
+  }
+
+  m_pCoreSubmesh->setLodCount(collapseCount);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Build the progressive mesh of a core submesh                               //
+//----------------------------------------------------------------------------//
+
+bool ProgressiveMesh::build(CalCoreSubmesh *pCoreSubmesh)
+{
+  if(!initialize(pCoreSubmesh)) return false;
+
+  computeQuadrics();
+
+  // queue the cheapest collapse of every vertex group
+  int groupId;
+  for(groupId = 0; groupId < (int)m_vectorvectorGroupVertex.size(); groupId++)
+  {
+    evaluate(groupId);
+  }
+
+  int minFaceCount;
+  minFaceCount = (int)(m_ratio * m_faceCount);
+
+  double maxCost;
+  maxCost = (m_maxError > 0.0f) ? m_maxError * m_maxError * m_scale : -1.0;
+
+  // collapse the cheapest vertex group until the face count is reached
+  std::vector<int> vectorTargetId;
+  while(!m_queueCandidate.empty() && (m_faceCount > minFaceCount))
+  {
+    Candidate candidate = m_queueCandidate.top();
+    m_queueCandidate.pop();
+
+    if(!m_vectorGroupAlive[candidate.groupId] || !m_vectorGroupAlive[candidate.targetGroupId]) continue;
+    if(candidate.version != m_vectorGroupVersion[candidate.groupId]) continue;
+
+    if((maxCost >= 0.0) && (candidate.cost > maxCost)) break;
+
+    // the neighbourhood is unchanged since the evaluation, so only the
+    // target vertices have to be looked up again
+    if(computeCost(candidate.groupId, candidate.targetGroupId, vectorTargetId) < 0.0) continue;
+
+    std::vector<int> vectorGroupId;
+    getNeighbourGroups(candidate.groupId, vectorGroupId);
+
+    collapse(candidate.groupId, vectorTargetId);
+
+    m_vectorGroupAlive[candidate.groupId] = false;
+    int quadricId;
+    for(quadricId = 0; quadricId < 10; quadricId++)
+    {
+      m_vectorQuadric[candidate.targetGroupId].a[quadricId] += m_vectorQuadric[candidate.groupId].a[quadricId];
+    }
+
+    // evaluate all groups around the collapsed edge again
+    std::vector<int> vectorTargetNeighbourId;
+    getNeighbourGroups(candidate.targetGroupId, vectorTargetNeighbourId);
+    vectorGroupId.insert(vectorGroupId.end(), vectorTargetNeighbourId.begin(), vectorTargetNeighbourId.end());
+    vectorGroupId.push_back(candidate.targetGroupId);
+
+    std::sort(vectorGroupId.begin(), vectorGroupId.end());
+    vectorGroupId.erase(std::unique(vectorGroupId.begin(), vectorGroupId.end()), vectorGroupId.end());
+
+    int neighbourId;
+    for(neighbourId = 0; neighbourId < (int)vectorGroupId.size(); neighbourId++)
+    {
+      evaluate(vectorGroupId[neighbourId]);
+    }
+  }
+
+  return apply();
+}
+
+//----------------------------------------------------------------------------//
+// Collapse all vertices of a group onto their target vertices                //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::collapse(int groupId, const std::vector<int>& vectorTargetId)
+{
+  std::vector<int>& vectorGroupVertex = m_vectorvectorGroupVertex[groupId];
+
+  int groupVertexId;
+  for(groupVertexId = 0; groupVertexId < (int)vectorGroupVertex.size(); groupVertexId++)
+  {
+    int vertexId = vectorGroupVertex[groupVertexId];
+    int targetId = vectorTargetId[groupVertexId];
+
+    std::vector<int>& vectorVertexFace = m_vectorvectorVertexFace[vertexId];
+
+    int vertexFaceId;
+    for(vertexFaceId = 0; vertexFaceId < (int)vectorVertexFace.size(); vertexFaceId++)
+    {
+      int faceId = vectorVertexFace[vertexFaceId];
+      if(!m_vectorFaceAlive[faceId]) continue;
+
+      CalCoreSubmesh::Face& face = m_vectorFace[faceId];
+
+      // faces on the collapsed edge disappear, all others move to the target
+      if((face.vertexId[0] == targetId) || (face.vertexId[1] == targetId) || (face.vertexId[2] == targetId))
+      {
+        m_vectorFaceAlive[faceId] = false;
+        m_vectorvectorRemovedFace[vertexId].push_back(faceId);
+        m_faceCount--;
+      }
+      else
+      {
+        int cornerId;
+        for(cornerId = 0; cornerId < 3; cornerId++)
+        {
+          if(face.vertexId[cornerId] == vertexId) face.vertexId[cornerId] = targetId;
+        }
+        m_vectorvectorVertexFace[targetId].push_back(faceId);
+      }
+    }
+
+    vectorVertexFace.clear();
+
+    m_vectorCollapseVertexId.push_back(vertexId);
+    m_vectorCollapseTargetId.push_back(targetId);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Compute the cost of collapsing a group onto a neighbour group              //
+//----------------------------------------------------------------------------//
+
+double ProgressiveMesh::computeCost(int groupId, int targetGroupId, std::vector<int>& vectorTargetId)
+{
+  std::vector<int>& vectorGroupVertex = m_vectorvectorGroupVertex[groupId];
+  vectorTargetId.assign(vectorGroupVertex.size(), -1);
+
+  const CalVector& targetPosition = m_vectorPosition[m_vectorvectorGroupVertex[targetGroupId][0]];
+
+  // the geometric error of moving the group onto the target position
+  double cost;
+  cost = evaluateQuadric(m_vectorQuadric[groupId], targetPosition) + evaluateQuadric(m_vectorQuadric[targetGroupId], targetPosition);
+
+  int groupVertexId;
+  for(groupVertexId = 0; groupVertexId < (int)vectorGroupVertex.size(); groupVertexId++)
+  {
+    int vertexId = vectorGroupVertex[groupVertexId];
+    if(m_vectorLocked[vertexId]) return -1.0;
+
+    std::vector<int>& vectorVertexFace = m_vectorvectorVertexFace[vertexId];
+
+    // every vertex of a seam must slide along an edge onto a vertex of the
+    // target group, otherwise the seam would open
+    double bestPenalty = -1.0;
+    bool bReferenced = false;
+
+    int vertexFaceId;
+    for(vertexFaceId = 0; vertexFaceId < (int)vectorVertexFace.size(); vertexFaceId++)
+    {
+      int faceId = vectorVertexFace[vertexFaceId];
+      if(!m_vectorFaceAlive[faceId]) continue;
+
+      bReferenced = true;
+
+      int cornerId;
+      for(cornerId = 0; cornerId < 3; cornerId++)
+      {
+        int targetId = m_vectorFace[faceId].vertexId[cornerId];
+        if(m_vectorGroupId[targetId] != targetGroupId) continue;
+
+        // a vertex next to several vertices of the target group straddles
+        // the seam, and would pull faces across it
+        if((vectorTargetId[groupVertexId] != -1) && (vectorTargetId[groupVertexId] != targetId)) return -1.0;
+
+        double penalty;
+        penalty = m_normalWeight * (1.0 - (m_vectorNormal[vertexId] * m_vectorNormal[targetId]));
+        penalty += m_influenceWeight * getInfluenceDistance(vertexId, targetId);
+
+        if((bestPenalty < 0.0) || (penalty < bestPenalty))
+        {
+          bestPenalty = penalty;
+          vectorTargetId[groupVertexId] = targetId;
+        }
+      }
+    }
+
+    // vertices without faces can follow any vertex of the target group
+    if(bestPenalty < 0.0)
+    {
+      if(!bReferenced)
+      {
+        vectorTargetId[groupVertexId] = m_vectorvectorGroupVertex[targetGroupId][0];
+        continue;
+      }
+
+      return -1.0;
+    }
+
+    cost += bestPenalty * m_scale;
+
+    // reject collapses that fold a remaining face over
+    for(vertexFaceId = 0; vertexFaceId < (int)vectorVertexFace.size(); vertexFaceId++)
+    {
+      int faceId = vectorVertexFace[vertexFaceId];
+      if(!m_vectorFaceAlive[faceId]) continue;
+
+      const CalCoreSubmesh::Face& face = m_vectorFace[faceId];
+      if((face.vertexId[0] == vectorTargetId[groupVertexId]) || (face.vertexId[1] == vectorTargetId[groupVertexId]) || (face.vertexId[2] == vectorTargetId[groupVertexId])) continue;
+
+      CalVector corner[3];
+      CalVector movedCorner[3];
+
+      int cornerId;
+      for(cornerId = 0; cornerId < 3; cornerId++)
+      {
+        corner[cornerId] = m_vectorPosition[face.vertexId[cornerId]];
+        movedCorner[cornerId] = (face.vertexId[cornerId] == vertexId) ? targetPosition : corner[cornerId];
+      }
+
+      CalVector normal = (corner[1] - corner[0]) % (corner[2] - corner[0]);
+      CalVector movedNormal = (movedCorner[1] - movedCorner[0]) % (movedCorner[2] - movedCorner[0]);
+
+      float length = normal.length() * movedNormal.length();
+      if((length <= 0.0f) || ((normal * movedNormal) < 0.5f * length)) return -1.0;
+
+      // the same holds in texture space, where a fold would mirror the texture
+      if(!m_vectorTextureCoordinate.empty())
+      {
+        CalCoreSubmesh::TextureCoordinate uv[3];
+        CalCoreSubmesh::TextureCoordinate movedUv[3];
+
+        for(cornerId = 0; cornerId < 3; cornerId++)
+        {
+          uv[cornerId] = m_vectorTextureCoordinate[face.vertexId[cornerId]];
+          movedUv[cornerId] = (face.vertexId[cornerId] == vertexId) ? m_vectorTextureCoordinate[vectorTargetId[groupVertexId]] : uv[cornerId];
+        }
+
+        float area = (uv[1].u - uv[0].u) * (uv[2].v - uv[0].v) - (uv[2].u - uv[0].u) * (uv[1].v - uv[0].v);
+        float movedArea = (movedUv[1].u - movedUv[0].u) * (movedUv[2].v - movedUv[0].v) - (movedUv[2].u - movedUv[0].u) * (movedUv[1].v - movedUv[0].v);
+        if(area * movedArea < 0.0f) return -1.0;
+      }
+    }
+  }
+
+  return cost;
+}
+
+//----------------------------------------------------------------------------//
+// Compute the error quadric of every vertex group                            //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::computeQuadrics()
+{
+  m_vectorQuadric.assign(m_vectorvectorGroupVertex.size(), Quadric());
+  memset(&m_vectorQuadric[0], 0, m_vectorQuadric.size() * sizeof(Quadric));
+
+  // find the mean face area, so that the weights do not depend on the scale
+  double meanArea = 0.0;
+  double meanEdge = 0.0;
+
+  int faceId;
+  for(faceId = 0; faceId < (int)m_vectorFace.size(); faceId++)
+  {
+    const CalCoreSubmesh::Face& face = m_vectorFace[faceId];
+    CalVector edge1 = m_vectorPosition[face.vertexId[1]] - m_vectorPosition[face.vertexId[0]];
+    CalVector edge2 = m_vectorPosition[face.vertexId[2]] - m_vectorPosition[face.vertexId[0]];
+    meanArea += 0.5 * (edge1 % edge2).length();
+    meanEdge += edge1.length();
+  }
+
+  if(!m_vectorFace.empty())
+  {
+    meanArea /= m_vectorFace.size();
+    meanEdge /= m_vectorFace.size();
+  }
+  if(meanArea <= 0.0) meanArea = 1.0;
+
+  // attribute penalties are measured against the squared mean edge length
+  m_scale = (meanEdge > 0.0) ? meanEdge * meanEdge : 1.0;
+
+  // add the plane of every face to the groups of its corners, and count the
+  // faces at every edge between groups
+  std::map<std::pair<int, int>, int> mapEdgeFaceCount;
+
+  for(faceId = 0; faceId < (int)m_vectorFace.size(); faceId++)
+  {
+    const CalCoreSubmesh::Face& face = m_vectorFace[faceId];
+    CalVector normal = (m_vectorPosition[face.vertexId[1]] - m_vectorPosition[face.vertexId[0]]) % (m_vectorPosition[face.vertexId[2]] - m_vectorPosition[face.vertexId[0]]);
+
+    float area = 0.5f * normal.length();
+    if(area <= 0.0f) continue;
+    normal.normalize();
+
+    float d = -(normal * m_vectorPosition[face.vertexId[0]]);
+
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      addPlane(m_vectorQuadric[m_vectorGroupId[face.vertexId[cornerId]]], normal, d, area / meanArea);
+
+      int groupId1 = m_vectorGroupId[face.vertexId[cornerId]];
+      int groupId2 = m_vectorGroupId[face.vertexId[(cornerId + 1) % 3]];
+      mapEdgeFaceCount[std::make_pair(std::min(groupId1, groupId2), std::max(groupId1, groupId2))]++;
+    }
+  }
+
+  // keep open borders in place with planes perpendicular to their faces
+  for(faceId = 0; faceId < (int)m_vectorFace.size(); faceId++)
+  {
+    const CalCoreSubmesh::Face& face = m_vectorFace[faceId];
+    CalVector normal = (m_vectorPosition[face.vertexId[1]] - m_vectorPosition[face.vertexId[0]]) % (m_vectorPosition[face.vertexId[2]] - m_vectorPosition[face.vertexId[0]]);
+    if(normal.length() <= 0.0f) continue;
+    normal.normalize();
+
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      int vertexId1 = face.vertexId[cornerId];
+      int vertexId2 = face.vertexId[(cornerId + 1) % 3];
+      int groupId1 = m_vectorGroupId[vertexId1];
+      int groupId2 = m_vectorGroupId[vertexId2];
+
+      if(mapEdgeFaceCount[std::make_pair(std::min(groupId1, groupId2), std::max(groupId1, groupId2))] != 1) continue;
+
+      CalVector edge = m_vectorPosition[vertexId2] - m_vectorPosition[vertexId1];
+      CalVector borderNormal = edge % normal;
+      if(borderNormal.length() <= 0.0f) continue;
+      borderNormal.normalize();
+
+      float d = -(borderNormal * m_vectorPosition[vertexId1]);
+      double weight = m_boundaryWeight * (edge * edge) / m_scale;
+
+      addPlane(m_vectorQuadric[groupId1], borderNormal, d, weight);
+      addPlane(m_vectorQuadric[groupId2], borderNormal, d, weight);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Queue the cheapest collapse of a vertex group                              //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::evaluate(int groupId)
+{
+  m_vectorGroupVersion[groupId]++;
+  if(!m_vectorGroupAlive[groupId]) return;
+
+  std::vector<int> vectorGroupId;
+  getNeighbourGroups(groupId, vectorGroupId);
+
+  Candidate candidate;
+  candidate.cost = -1.0;
+  candidate.groupId = groupId;
+  candidate.targetGroupId = -1;
+  candidate.version = m_vectorGroupVersion[groupId];
+
+  std::vector<int> vectorTargetId;
+
+  int neighbourId;
+  for(neighbourId = 0; neighbourId < (int)vectorGroupId.size(); neighbourId++)
+  {
+    double cost;
+    cost = computeCost(groupId, vectorGroupId[neighbourId], vectorTargetId);
+    if(cost < 0.0) continue;
+
+    if((candidate.targetGroupId == -1) || (cost < candidate.cost))
+    {
+      candidate.cost = cost;
+      candidate.targetGroupId = vectorGroupId[neighbourId];
+    }
+  }
+
+  if(candidate.targetGroupId != -1) m_queueCandidate.push(candidate);
+}
+
+//----------------------------------------------------------------------------//
+// Evaluate a quadric at a position                                           //
+//----------------------------------------------------------------------------//
+
+double ProgressiveMesh::evaluateQuadric(const Quadric& quadric, const CalVector& position)
+{
+  double x = position.x, y = position.y, z = position.z;
+  const double *a = quadric.a;
+
+  double error;
+  error = a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x
+        + a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y
+        + a[7] * z * z + 2.0 * a[8] * z
+        + a[9];
+
+  return (error > 0.0) ? error : 0.0;
+}
+
+//----------------------------------------------------------------------------//
+// Get the number of collapses                                                //
+//----------------------------------------------------------------------------//
+
+int ProgressiveMesh::getCollapseCount()
+{
+  return m_vectorCollapseVertexId.size();
+}
+
+//----------------------------------------------------------------------------//
+// Get the difference between the influences of two vertices                  //
+//----------------------------------------------------------------------------//
+
+float ProgressiveMesh::getInfluenceDistance(int vertexId, int targetVertexId)
+{
+  std::vector<CalCoreSubmesh::Influence>& vectorInfluence = m_vectorvectorInfluence[vertexId];
+  std::vector<CalCoreSubmesh::Influence>& vectorTargetInfluence = m_vectorvectorInfluence[targetVertexId];
+
+  float distance = 0.0f;
+
+  int influenceId;
+  for(influenceId = 0; influenceId < (int)vectorInfluence.size(); influenceId++)
+  {
+    float weight = 0.0f;
+
+    int targetInfluenceId;
+    for(targetInfluenceId = 0; targetInfluenceId < (int)vectorTargetInfluence.size(); targetInfluenceId++)
+    {
+      if(vectorTargetInfluence[targetInfluenceId].boneId == vectorInfluence[influenceId].boneId) weight += vectorTargetInfluence[targetInfluenceId].weight;
+    }
+
+    distance += fabs(vectorInfluence[influenceId].weight - weight);
+  }
+
+  // add the influences of bones that only the target vertex has
+  int targetInfluenceId;
+  for(targetInfluenceId = 0; targetInfluenceId < (int)vectorTargetInfluence.size(); targetInfluenceId++)
+  {
+    bool bShared = false;
+
+    for(influenceId = 0; influenceId < (int)vectorInfluence.size(); influenceId++)
+    {
+      if(vectorInfluence[influenceId].boneId == vectorTargetInfluence[targetInfluenceId].boneId) bShared = true;
+    }
+
+    if(!bShared) distance += vectorTargetInfluence[targetInfluenceId].weight;
+  }
+
+  return distance;
+}
+
+//----------------------------------------------------------------------------//
+// Get the number of faces at the lowest level of detail                      //
+//----------------------------------------------------------------------------//
+
+int ProgressiveMesh::getMinFaceCount()
+{
+  return m_faceCount;
+}
+
+//----------------------------------------------------------------------------//
+// Get the groups that share a face with a group                              //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::getNeighbourGroups(int groupId, std::vector<int>& vectorGroupId)
+{
+  vectorGroupId.clear();
+
+  std::vector<int>& vectorGroupVertex = m_vectorvectorGroupVertex[groupId];
+
+  int groupVertexId;
+  for(groupVertexId = 0; groupVertexId < (int)vectorGroupVertex.size(); groupVertexId++)
+  {
+    std::vector<int>& vectorVertexFace = m_vectorvectorVertexFace[vectorGroupVertex[groupVertexId]];
+
+    int vertexFaceId;
+    for(vertexFaceId = 0; vertexFaceId < (int)vectorVertexFace.size(); vertexFaceId++)
+    {
+      int faceId = vectorVertexFace[vertexFaceId];
+      if(!m_vectorFaceAlive[faceId]) continue;
+
+      int cornerId;
+      for(cornerId = 0; cornerId < 3; cornerId++)
+      {
+        int neighbourGroupId = m_vectorGroupId[m_vectorFace[faceId].vertexId[cornerId]];
+        if(neighbourGroupId != groupId) vectorGroupId.push_back(neighbourGroupId);
+      }
+    }
+  }
+
+  std::sort(vectorGroupId.begin(), vectorGroupId.end());
+  vectorGroupId.erase(std::unique(vectorGroupId.begin(), vectorGroupId.end()), vectorGroupId.end());
+}
+
+//----------------------------------------------------------------------------//
+// Copy the data of a core submesh into the working arrays                    //
+//----------------------------------------------------------------------------//
+
+bool ProgressiveMesh::initialize(CalCoreSubmesh *pCoreSubmesh)
+{
+  m_pCoreSubmesh = pCoreSubmesh;
+
+  std::vector<CalCoreSubmesh::Vertex>& vectorVertex = pCoreSubmesh->getVectorVertex();
+  const int vertexCount = vectorVertex.size();
+
+  m_vectorFace = pCoreSubmesh->getVectorFace();
+  m_vectorFaceAlive.assign(m_vectorFace.size(), true);
+  m_faceCount = m_vectorFace.size();
+
+  m_vectorPosition.resize(vertexCount);
+  m_vectorNormal.resize(vertexCount);
+  m_vectorvectorInfluence.assign(vertexCount, std::vector<CalCoreSubmesh::Influence>());
+  m_vectorLocked.assign(vertexCount, false);
+  m_vectorvectorVertexFace.assign(vertexCount, std::vector<int>());
+  m_vectorvectorRemovedFace.assign(vertexCount, std::vector<int>());
+  m_vectorCollapseVertexId.clear();
+  m_vectorCollapseTargetId.clear();
+  m_queueCandidate = std::priority_queue<Candidate>();
+
+  // copy the positions, normals and influences
+  std::vector<CalCoreSubmesh::Influence>& vectorInfluence = pCoreSubmesh->getVectorInfluence();
+  int nextInfluence = 0;
+
+  int vertexId;
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    CalCoreSubmesh::Vertex& vertex = vectorVertex[vertexId];
+    m_vectorPosition[vertexId] = vertex.position;
+    m_vectorNormal[vertexId] = CalVector(vertex.nx, vertex.ny, vertex.nz);
+    m_vectorNormal[vertexId].normalize();
+
+    int influenceId;
+    for(influenceId = 0; (influenceId < vertex.influenceCount) && (nextInfluence < (int)vectorInfluence.size()); influenceId++)
+    {
+      m_vectorvectorInfluence[vertexId].push_back(vectorInfluence[nextInfluence++]);
+    }
+  }
+
+  // the first texture map is kept to detect folds in texture space
+  if(pCoreSubmesh->getVectorVectorTextureCoordinate().empty())
+  {
+    m_vectorTextureCoordinate.clear();
+  }
+  else
+  {
+    m_vectorTextureCoordinate = pCoreSubmesh->getVectorVectorTextureCoordinate()[0];
+    if((int)m_vectorTextureCoordinate.size() != vertexCount) m_vectorTextureCoordinate.clear();
+  }
+
+  // vertices of the spring system must stay where they are
+  if(pCoreSubmesh->getSpringCount() > 0)
+  {
+    std::vector<CalCoreSubmesh::PhysicalProperty>& vectorPhysicalProperty = pCoreSubmesh->getVectorPhysicalProperty();
+    for(vertexId = 0; vertexId < vertexCount; vertexId++)
+    {
+      if((vertexId < (int)vectorPhysicalProperty.size()) && (vectorPhysicalProperty[vertexId].weight > 0.0f)) m_vectorLocked[vertexId] = true;
+    }
+
+    std::vector<CalCoreSubmesh::Spring>& vectorSpring = pCoreSubmesh->getVectorSpring();
+    int springId;
+    for(springId = 0; springId < (int)vectorSpring.size(); springId++)
+    {
+      int cornerId;
+      for(cornerId = 0; cornerId < 2; cornerId++)
+      {
+        int springVertexId = vectorSpring[springId].vertexId[cornerId];
+        if((springVertexId >= 0) && (springVertexId < vertexCount)) m_vectorLocked[springVertexId] = true;
+      }
+    }
+  }
+
+  // build the vertex to face adjacency
+  int faceId;
+  for(faceId = 0; faceId < (int)m_vectorFace.size(); faceId++)
+  {
+    int cornerId;
+    for(cornerId = 0; cornerId < 3; cornerId++)
+    {
+      int faceVertexId = m_vectorFace[faceId].vertexId[cornerId];
+      if((faceVertexId < 0) || (faceVertexId >= vertexCount))
+      {
+        std::cerr << "Face " << faceId << " references an invalid vertex." << std::endl;
+        return false;
+      }
+
+      m_vectorvectorVertexFace[faceVertexId].push_back(faceId);
+    }
+  }
+
+  // vertices at the same position are split along a seam and collapse as a
+  // group, so that the seam stays closed
+  std::map<std::vector<float>, int> mapGroupId;
+  m_vectorGroupId.resize(vertexCount);
+  m_vectorvectorGroupVertex.clear();
+
+  for(vertexId = 0; vertexId < vertexCount; vertexId++)
+  {
+    std::vector<float> key(3);
+    key[0] = m_vectorPosition[vertexId].x;
+    key[1] = m_vectorPosition[vertexId].y;
+    key[2] = m_vectorPosition[vertexId].z;
+
+    std::map<std::vector<float>, int>::iterator iteratorGroupId = mapGroupId.find(key);
+    if(iteratorGroupId == mapGroupId.end())
+    {
+      iteratorGroupId = mapGroupId.insert(std::make_pair(key, (int)m_vectorvectorGroupVertex.size())).first;
+      m_vectorvectorGroupVertex.push_back(std::vector<int>());
+    }
+
+    m_vectorGroupId[vertexId] = iteratorGroupId->second;
+    m_vectorvectorGroupVertex[iteratorGroupId->second].push_back(vertexId);
+  }
+
+  m_vectorGroupVersion.assign(m_vectorvectorGroupVertex.size(), 0);
+  m_vectorGroupAlive.assign(m_vectorvectorGroupVertex.size(), true);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Set the weight of open borders                                             //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::setBoundaryWeight(float weight)
+{
+  m_boundaryWeight = weight;
+}
+
+//----------------------------------------------------------------------------//
+// Set the weight of bone influence differences                               //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::setInfluenceWeight(float weight)
+{
+  m_influenceWeight = weight;
+}
+
+//----------------------------------------------------------------------------//
+// Set the maximal error relative to the mean edge length                     //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::setMaxError(float maxError)
+{
+  m_maxError = maxError;
+}
+
+//----------------------------------------------------------------------------//
+// Set the weight of normal differences                                       //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::setNormalWeight(float weight)
+{
+  m_normalWeight = weight;
+}
+
+//----------------------------------------------------------------------------//
+// Set the fraction of faces left at the lowest level of detail               //
+//----------------------------------------------------------------------------//
+
+void ProgressiveMesh::setRatio(float ratio)
+{
+  m_ratio = ratio;
+}
+
+//----------------------------------------------------------------------------//
@@ -0,0 +1,102 @@
+//----------------------------------------------------------------------------//
+// progmesh.h                                                                 //
+// Copyright (C) 2001, 2002 Bruno 'Beosil' Heidelberger                       //
+//----------------------------------------------------------------------------//
+// This program is free software; you can redistribute it and/or modify it    //
+// under the terms of the GNU General Public License as published by the Free //
+// Software Foundation; either version 2 of the License, or (at your option)  //
+// any later version.                                                         //
+//----------------------------------------------------------------------------//
+
+#ifndef PROGMESH_H
+#define PROGMESH_H
+
+//----------------------------------------------------------------------------//
+// Includes                                                                   //
+//----------------------------------------------------------------------------//
+
+#include "cp-global.h"
+
+//----------------------------------------------------------------------------//
+// Class declaration                                                          //
+//----------------------------------------------------------------------------//
+
+class ProgressiveMesh
+{
+// misc
+protected:
+  struct Quadric
+  {
+    double a[10];
+  };
+
+  struct Candidate
+  {
+    double cost;
+    int groupId;
+    int targetGroupId;
+    int version;
+
+    bool operator<(const Candidate& candidate) const { return cost > candidate.cost; }
+  };
+
+// member variables
+protected:
+  CalCoreSubmesh *m_pCoreSubmesh;
+  float m_ratio;
+  float m_maxError;
+  float m_normalWeight;
+  float m_influenceWeight;
+  float m_boundaryWeight;
+  double m_scale;
+  int m_faceCount;
+  std::vector<CalVector> m_vectorPosition;
+  std::vector<CalVector> m_vectorNormal;
+  std::vector<CalCoreSubmesh::TextureCoordinate> m_vectorTextureCoordinate;
+  std::vector<std::vector<CalCoreSubmesh::Influence> > m_vectorvectorInfluence;
+  std::vector<bool> m_vectorLocked;
+  std::vector<std::vector<int> > m_vectorvectorVertexFace;
+  std::vector<CalCoreSubmesh::Face> m_vectorFace;
+  std::vector<bool> m_vectorFaceAlive;
+  std::vector<int> m_vectorGroupId;
+  std::vector<std::vector<int> > m_vectorvectorGroupVertex;
+  std::vector<Quadric> m_vectorQuadric;
+  std::vector<int> m_vectorGroupVersion;
+  std::vector<bool> m_vectorGroupAlive;
+  std::priority_queue<Candidate> m_queueCandidate;
+  std::vector<int> m_vectorCollapseVertexId;
+  std::vector<int> m_vectorCollapseTargetId;
+  std::vector<std::vector<int> > m_vectorvectorRemovedFace;
+
+// constructors/destructor
+public:
+  ProgressiveMesh();
+  virtual ~ProgressiveMesh();
+
+// member functions
+public:
+  bool build(CalCoreSubmesh *pCoreSubmesh);
+  int getCollapseCount();
+  int getMinFaceCount();
+  void setBoundaryWeight(float weight);
+  void setInfluenceWeight(float weight);
+  void setMaxError(float maxError);
+  void setNormalWeight(float weight);
+  void setRatio(float ratio);
+
+protected:
+  static void addPlane(Quadric& quadric, const CalVector& normal, float d, double weight);
+  static double evaluateQuadric(const Quadric& quadric, const CalVector& position);
+  bool apply();
+  void collapse(int groupId, const std::vector<int>& vectorTargetId);
+  double computeCost(int groupId, int targetGroupId, std::vector<int>& vectorTargetId);
+  void computeQuadrics();
+  void evaluate(int groupId);
+  void getNeighbourGroups(int groupId, std::vector<int>& vectorGroupId);
+  float getInfluenceDistance(int vertexId, int targetVertexId);
+  bool initialize(CalCoreSubmesh *pCoreSubmesh);
+};
+
+#endif
+
+//----------------------------------------------------------------------------//
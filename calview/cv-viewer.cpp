@@ -216,6 +216,14 @@ bool Viewer::onCreate(int argc, char *argv[])
     CalError::printLastError();
     return false;
   }
+
+  // draw all submeshes from one vertex and face buffer, the faces have
+  // 16-bit indices whenever the whole model is small enough
+  if(!m_calModel.enableMergedBuffers(-1))
+  {
+    CalError::printLastError();
+    return false;
+  }
   
   return true;
 }
@@ -246,7 +254,7 @@ void Viewer::onIdle()
   m_calModel.lockState();
   m_calModel.calculateState();
   m_calModel.updateSpringSystem(elapsedSeconds);
-  m_calModel.updateVertices();
+  m_calModel.updateMergedBuffers();
   
   // current tick will be last tick next round
   m_lastTick = tick;
@@ -515,32 +523,19 @@ void Viewer::renderModel()
   glEnableClientState(GL_VERTEX_ARRAY);
   glEnableClientState(GL_NORMAL_ARRAY);
 
-  // get the number of meshes
-  int submeshCount = m_calModel.getSubmeshCount();
+  // set the merged vertex and normal buffers
+  glVertexPointer(3, GL_FLOAT, 0, m_calModel.getMergedVertices());
+  glNormalPointer(GL_FLOAT, 0, m_calModel.getMergedNormals());
 
-  // render all meshes of the model
-  int submeshId;
-  for(submeshId = 0; submeshId < submeshCount; submeshId++)
-  {
-    CalSubmesh *submesh = m_calModel.getSubmesh(submeshId);
-    
-    int vertexCount = submesh->getVertexCount();
-    int faceCount = submesh->getFaceCount();
-    int *faces = submesh->getBufferedFaces();
-    float *vertices = submesh->getBufferedVertices();
-    float *normals = submesh->getBufferedNormals();
-    
-    // set the vertex and normal buffers
-    glVertexPointer(3, GL_FLOAT, 0, vertices);
-    glNormalPointer(GL_FLOAT, 0, normals);
-    
-    // draw the submesh
-    glDrawElements(GL_TRIANGLES, faceCount * 3, GL_UNSIGNED_INT, faces);
-    
-    // adjust the vertex and face counter
-    m_vertexCount += vertexCount;
-    m_faceCount += faceCount;
-  }
+  // draw all submeshes at once, since they share the same states
+  int faceCount = m_calModel.getMergedFaceCount();
+  unsigned short *shortFaces = m_calModel.getMergedShortFaces();
+  if(shortFaces != 0) glDrawElements(GL_TRIANGLES, faceCount * 3, GL_UNSIGNED_SHORT, shortFaces);
+  else glDrawElements(GL_TRIANGLES, faceCount * 3, GL_UNSIGNED_INT, m_calModel.getMergedFaces());
+
+  // adjust the vertex and face counter
+  m_vertexCount += m_calModel.getMergedVertexCount();
+  m_faceCount += faceCount;
 
   // clear vertex array state
   glDisableClientState(GL_NORMAL_ARRAY);